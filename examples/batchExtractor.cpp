@@ -0,0 +1,509 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <boost/filesystem.hpp>
+
+#include <nlgeometry/nlgeometry.h>
+#include <nlgenerator/nlgenerator.h>
+#include <nlrender/nlrender.h>
+#include <reto/reto.h>
+#include <nsol/nsol.h>
+
+//OpenGL
+#ifndef NEUROLOTS_SKIP_GLEW_INCLUDE
+  #include <GL/glew.h>
+#endif
+#include <GL/gl.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "Shaders.h"
+
+// Headless batch extractor. Morphologies are loaded, simplified and meshed by
+// worker threads, extracted by the thread owning the offscreen OpenGL context
+// and written by a writer thread, so the three stages overlap
+
+typedef std::chrono::steady_clock TClock;
+
+typedef struct
+{
+  std::string inFile;
+  std::string outFile;
+  nlgeometry::MeshPtr mesh;
+  double load;
+  double generate;
+  double extract;
+  double write;
+  unsigned int triangles;
+  std::string error;
+} TJob;
+
+template < class T > class BlockingQueue
+{
+public:
+
+  BlockingQueue( size_t capacity_ )
+    : _capacity( capacity_ )
+    , _closed( false )
+  {
+  }
+
+  void push( T value_ )
+  {
+    std::unique_lock< std::mutex > lock( _mutex );
+    _notFull.wait( lock, [ this ]( ){ return _queue.size( ) < _capacity; });
+    _queue.push_back( value_ );
+    _notEmpty.notify_one( );
+  }
+
+  bool pop( T& value_ )
+  {
+    std::unique_lock< std::mutex > lock( _mutex );
+    _notEmpty.wait( lock, [ this ]( ){ return !_queue.empty( ) || _closed; });
+    if ( _queue.empty( ))
+      return false;
+    value_ = _queue.front( );
+    _queue.pop_front( );
+    _notFull.notify_one( );
+    return true;
+  }
+
+  void close( void )
+  {
+    std::unique_lock< std::mutex > lock( _mutex );
+    _closed = true;
+    _notEmpty.notify_all( );
+  }
+
+protected:
+
+  size_t _capacity;
+  bool _closed;
+  std::deque< T > _queue;
+  std::mutex _mutex;
+  std::condition_variable _notEmpty;
+  std::condition_variable _notFull;
+};
+
+static double seconds( TClock::time_point start_ )
+{
+  return std::chrono::duration< double >( TClock::now( ) - start_ ).count( );
+}
+
+bool initContext( void );
+std::vector< std::string > inputFiles( const std::string& input_ );
+void generate( TJob* job_, float resampleAngle_,
+               nlgenerator::MeshCache* cache_ );
+void usage( const char* program_ );
+
+std::mutex simplifierMutex;
+
+int main( int argc, char* argv[] )
+{
+  std::cout << "neurolots example: Batch Extractor" << std::endl;
+  if ( argc < 2 )
+  {
+    usage( argv[0] );
+    return 1;
+  }
+  std::string input( argv[1] );
+  std::string outDir( "." );
+  std::string format( ".obj" );
+  float lod = 1.0f;
+  unsigned int threads = std::max( 1u, std::thread::hardware_concurrency( ));
+  float resampleAngle = 0.0f;
+  std::string cacheDir;
+  for ( int i = 2; i < argc; ++i )
+  {
+    std::string option( argv[i] );
+    if ( i + 1 >= argc )
+    {
+      usage( argv[0] );
+      return 1;
+    }
+    if ( option.compare( "-lod" ) == 0 )
+      lod = float( std::atof( argv[++i] ));
+    else if ( option.compare( "-out" ) == 0 )
+      outDir = std::string( argv[++i] );
+    else if ( option.compare( "-format" ) == 0 )
+      format = "." + std::string( argv[++i] );
+    else if ( option.compare( "-threads" ) == 0 )
+      threads = std::max( 1, std::atoi( argv[++i] ));
+    else if ( option.compare( "-resample" ) == 0 )
+      resampleAngle = float( std::atof( argv[++i] ));
+    else if ( option.compare( "-cache" ) == 0 )
+      cacheDir = std::string( argv[++i] );
+    else
+    {
+      usage( argv[0] );
+      return 1;
+    }
+  }
+  if ( format.compare( ".obj" ) != 0 && format.compare( ".off" ) != 0 )
+  {
+    usage( argv[0] );
+    return 1;
+  }
+
+  std::vector< std::string > files = inputFiles( input );
+  if ( files.empty( ))
+  {
+    std::cerr << "Error: no morphologies found in " << input << std::endl;
+    return 1;
+  }
+  boost::filesystem::create_directories( outDir );
+
+  // The simplifier and resampler settings change the generated meshes
+  nlgenerator::MeshCache* cache = nullptr;
+  try
+  {
+    if ( !cacheDir.empty( ))
+      cache = new nlgenerator::MeshCache(
+        cacheDir, 1024ull * 1024ull * 1024ull,
+        "DIST_NODES_RADIUS resample " + std::to_string( resampleAngle ));
+  }
+  catch ( std::exception& e )
+  {
+    std::cerr << "Error: " << e.what( ) << std::endl;
+    return 1;
+  }
+
+  if ( !initContext( ))
+    return 1;
+
+  std::vector< TJob > jobs( files.size( ));
+  for ( size_t i = 0; i < files.size( ); i++ )
+  {
+    TJob& job = jobs[i];
+    job.inFile = files[i];
+    job.outFile = ( boost::filesystem::path( outDir ) /
+                    boost::filesystem::path( files[i] ).stem( )).string( ) +
+      format;
+    job.mesh = nullptr;
+    job.load = job.generate = job.extract = job.write = 0.0;
+    job.triangles = 0;
+  }
+
+  // The queues are bounded so only a few meshes are kept in memory
+  BlockingQueue< TJob* > generated( threads );
+  BlockingQueue< TJob* > extracted( 2 );
+
+  std::mutex nextMutex;
+  size_t next = 0;
+  std::vector< std::thread > workers;
+  unsigned int running = threads;
+  for ( unsigned int i = 0; i < threads; i++ )
+    workers.push_back( std::thread( [ & ]( )
+    {
+      while ( true )
+      {
+        TJob* job;
+        {
+          std::unique_lock< std::mutex > lock( nextMutex );
+          if ( next >= jobs.size( ))
+          {
+            if ( --running == 0 )
+              generated.close( );
+            return;
+          }
+          job = &jobs[ next++ ];
+        }
+        generate( job, resampleAngle, cache );
+        generated.push( job );
+      }
+    }));
+
+  std::thread writer( [ & ]( )
+  {
+    TJob* job;
+    while ( extracted.pop( job ))
+    {
+      auto start = TClock::now( );
+      try
+      {
+        if ( format.compare( ".obj" ) == 0 )
+          nlgeometry::ObjWriter::writeMesh( job->mesh, job->outFile );
+        else
+          nlgeometry::OffWriter::writeMesh( job->mesh, job->outFile );
+      }
+      catch ( std::exception& e )
+      {
+        job->error = e.what( );
+      }
+      job->write = seconds( start );
+      delete job->mesh;
+      job->mesh = nullptr;
+    }
+  });
+
+  // Extraction in the thread of the OpenGL context
+  reto::Camera camera;
+  nlrender::Renderer renderer;
+  renderer.lod( ) = lod;
+  renderer.projectionMatrix( ) = camera.projectionMatrix( );
+  renderer.viewMatrix( ) = camera.viewMatrix( );
+  nlgeometry::AttribsFormat attribsFormat( 3 );
+  attribsFormat[0] = nlgeometry::TAttribType::POSITION;
+  attribsFormat[1] = nlgeometry::TAttribType::COLOR;
+  attribsFormat[2] = nlgeometry::TAttribType::CENTER;
+
+  auto batchStart = TClock::now( );
+  TJob* job;
+  while ( generated.pop( job ))
+  {
+    if ( !job->mesh )
+      continue;
+    auto start = TClock::now( );
+    auto mesh = job->mesh;
+    job->mesh = nullptr;
+    try
+    {
+      mesh->uploadGPU( attribsFormat, nlgeometry::Facet::PATCHES );
+      mesh->clearCPUData( );
+      job->mesh = renderer.extract( mesh, mesh->modelMatrix( ));
+      job->triangles = ( unsigned int ) job->mesh->triangles( ).size( );
+    }
+    catch ( std::exception& e )
+    {
+      // A failed morphology does not stop the rest of the batch
+      job->error = e.what( );
+      delete job->mesh;
+      job->mesh = nullptr;
+    }
+    delete mesh;
+    job->extract = seconds( start );
+    if ( job->mesh )
+      extracted.push( job );
+  }
+  extracted.close( );
+
+  for ( auto& worker: workers )
+    worker.join( );
+  writer.join( );
+  delete cache;
+  double total = seconds( batchStart );
+
+  std::cout << std::fixed << std::setprecision( 3 );
+  std::cout << "file load generate extract write triangles" << std::endl;
+  unsigned int failed = 0;
+  for ( auto& result: jobs )
+  {
+    std::cout << result.inFile << " ";
+    if ( !result.error.empty( ))
+    {
+      std::cout << "error: " << result.error << std::endl;
+      failed++;
+      continue;
+    }
+    std::cout << result.load << " " << result.generate << " "
+              << result.extract << " " << result.write << " "
+              << result.triangles << std::endl;
+  }
+  std::cout << jobs.size( ) - failed << " of " << jobs.size( )
+            << " morphologies extracted in " << total << "s with "
+            << threads << " threads" << std::endl;
+  return failed == 0 ? 0 : 1;
+}
+
+bool initContext( void )
+{
+  // Surfaceless display when available, so no window system is needed and
+  // software implementations as llvmpipe can be used
+  EGLDisplay display = EGL_NO_DISPLAY;
+  auto getPlatformDisplay = ( PFNEGLGETPLATFORMDISPLAYEXTPROC )
+    eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+  if ( getPlatformDisplay )
+    display = getPlatformDisplay( EGL_PLATFORM_SURFACELESS_MESA,
+                                  EGL_DEFAULT_DISPLAY, nullptr );
+  if ( display == EGL_NO_DISPLAY )
+    display = eglGetDisplay( EGL_DEFAULT_DISPLAY );
+  if ( display == EGL_NO_DISPLAY || !eglInitialize( display, nullptr, nullptr ))
+  {
+    std::cerr << "Error: no EGL display available" << std::endl;
+    return false;
+  }
+  eglBindAPI( EGL_OPENGL_API );
+  EGLint attribs[] = { EGL_CONTEXT_MAJOR_VERSION_KHR, 4,
+                       EGL_CONTEXT_MINOR_VERSION_KHR, 0,
+                       EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR,
+                       EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT_KHR,
+                       EGL_NONE };
+  EGLContext context = eglCreateContext( display, ( EGLConfig ) 0,
+                                         EGL_NO_CONTEXT, attribs );
+  if ( context == EGL_NO_CONTEXT ||
+       !eglMakeCurrent( display, EGL_NO_SURFACE, EGL_NO_SURFACE, context ))
+  {
+    std::cerr << "Error: OpenGL 4.0 context creation failed" << std::endl;
+    return false;
+  }
+
+  glewExperimental = GL_TRUE;
+  GLenum error = glewInit( );
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+  // GLEW built for GLX reports a missing display after loading the core
+  // entry points of an EGL context
+  if ( error == GLEW_ERROR_NO_GLX_DISPLAY )
+    error = GLEW_OK;
+#endif
+  if ( error != GLEW_OK )
+  {
+    std::cerr << "Error: " << glewGetErrorString( error ) << std::endl;
+    return false;
+  }
+
+  // Without default framebuffer a small one is bound for the draw calls
+  GLuint framebuffer, renderbuffer;
+  glGenRenderbuffers( 1, &renderbuffer );
+  glBindRenderbuffer( GL_RENDERBUFFER, renderbuffer );
+  glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, 1, 1 );
+  glGenFramebuffers( 1, &framebuffer );
+  glBindFramebuffer( GL_FRAMEBUFFER, framebuffer );
+  glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                             GL_RENDERBUFFER, renderbuffer );
+  glViewport( 0, 0, 1, 1 );
+
+  std::cout << "Context: " << glGetString( GL_RENDERER ) << std::endl;
+  return true;
+}
+
+std::vector< std::string > inputFiles( const std::string& input_ )
+{
+  std::vector< std::string > files;
+  if ( boost::filesystem::is_directory( input_ ))
+  {
+    for ( auto& entry: boost::filesystem::directory_iterator( input_ ))
+    {
+      auto fileExt = boost::filesystem::extension( entry.path( ));
+      if ( fileExt.compare( ".swc" ) == 0 || fileExt.compare( ".h5" ) == 0 )
+        files.push_back( entry.path( ).string( ));
+    }
+    std::sort( files.begin( ), files.end( ));
+  }
+  else
+  {
+    // Manifest with a morphology path per line
+    std::ifstream manifest( input_.c_str( ));
+    std::string line;
+    while ( std::getline( manifest, line ))
+      if ( !line.empty( ) && line[0] != '#' )
+        files.push_back( line );
+  }
+  return files;
+}
+
+void generate( TJob* job_, float resampleAngle_,
+               nlgenerator::MeshCache* cache_ )
+{
+  auto start = TClock::now( );
+  nsol::SwcReader swcr;
+#ifdef NSOL_USE_HDF5
+  nsol::VasculatureReader vascur;
+#endif
+  auto fileExt = boost::filesystem::extension( job_->inFile );
+  nsol::MorphologyPtr morphology = nullptr;
+  try
+  {
+    if ( fileExt.compare( ".swc" ) == 0 )
+      morphology = swcr.readMorphology( job_->inFile );
+#ifdef NSOL_USE_HDF5
+    else if ( fileExt.compare( ".h5" ) == 0 )
+      morphology = vascur.loadMorphology( job_->inFile );
+#endif
+  }
+  catch ( std::exception& e )
+  {
+    job_->error = e.what( );
+    return;
+  }
+  if ( !morphology )
+  {
+    job_->error = "unsupported or unreadable morphology";
+    return;
+  }
+  try
+  {
+    // The key is taken from the loaded morphology and the settings, so a
+    // cached mesh skips the simplifier and the resampler too
+    std::string key;
+    if ( cache_ )
+    {
+      key = cache_->key( morphology );
+      job_->mesh = cache_->load( key );
+    }
+    if ( job_->mesh )
+    {
+      job_->load = seconds( start );
+      start = TClock::now( );
+      nlgeometry::MeshOptimizer::optimize( job_->mesh );
+      job_->generate = seconds( start );
+      delete morphology;
+      return;
+    }
+
+    {
+      // The simplifier is a shared instance
+      std::unique_lock< std::mutex > lock( simplifierMutex );
+      auto neuronMorphology =
+        dynamic_cast< nsol::NeuronMorphologyPtr >( morphology );
+      if ( neuronMorphology )
+        nsol::Simplifier::Instance( )->simplify(
+          neuronMorphology, nsol::Simplifier::DIST_NODES_RADIUS );
+      else
+        nsol::Simplifier::Instance( )->simplify(
+          morphology, nsol::Simplifier::DIST_NODES_RADIUS );
+    }
+    if ( resampleAngle_ > 0.0f )
+      nlgenerator::Resampler::resample( morphology, resampleAngle_ );
+    job_->load = seconds( start );
+
+    start = TClock::now( );
+    job_->mesh = nlgenerator::MeshGenerator::generateMesh( morphology );
+    if ( cache_ )
+      cache_->store( key, job_->mesh );
+    nlgeometry::MeshOptimizer::optimize( job_->mesh );
+    job_->generate = seconds( start );
+  }
+  catch ( std::exception& e )
+  {
+    job_->error = e.what( );
+    delete job_->mesh;
+    job_->mesh = nullptr;
+  }
+  delete morphology;
+}
+
+void usage( const char* program_ )
+{
+  std::cerr << "Error: Usage: " << program_
+            << " directory|manifest -out [directory] -format [obj|off]"
+            << " -lod [float] -threads [int] -resample [radians]"
+            << " -cache [directory]"
+            << std::endl;
+}
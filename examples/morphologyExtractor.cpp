@@ -122,6 +122,7 @@ int main( int argc, char* argv[] )
   if ( morphology )
   {
     mesh = nlgenerator::MeshGenerator::generateMesh( morphology );
+    nlgeometry::MeshOptimizer::optimize( mesh );
     mesh->uploadGPU( format, nlgeometry::Facet::PATCHES );
     mesh->clearCPUData( );
     Eigen::Matrix4f projection( camera.projectionMatrix( ));
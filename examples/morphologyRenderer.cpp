@@ -122,26 +122,43 @@ int main( int argc, char* argv[] )
                 << mesh->triangles( ).size( ) << " triangles and "
                 << mesh->quads( ).size( ) << " quads" << std::endl;
 
-      mesh->uploadGPU( format, nlgeometry::Facet::PATCHES );
-      mesh->computeBoundingBox( );
-      mesh->clearCPUData( );
-      meshes.push_back( mesh );
-      models.push_back( Eigen::Matrix4f::Identity( ));
+      auto stats = nlgeometry::MeshOptimizer::optimize( mesh );
+      std::cout << "Quads ACMR: " << stats.quadsBefore << " -> "
+                << stats.quadsAfter << ", triangles ACMR: "
+                << stats.trianglesBefore << " -> " << stats.trianglesAfter
+                << std::endl;
 
-      nlgeometry::AxisAlignedBoundingBox meshAABB = mesh->aaBoundingBox( );
+      // Meshes over 64k vertices are split so they use 16 bits indices
+      nlgeometry::Meshes parts( 1, mesh );
+      if ( mesh->vertices( ).size( ) > 65536 )
+      {
+        parts = mesh->split( );
+        delete mesh;
+      }
+      for ( auto part: parts )
+      {
+        mesh = part;
+        mesh->uploadGPU( format, nlgeometry::Facet::PATCHES );
+        mesh->computeBoundingBox( );
+        mesh->clearCPUData( );
+        meshes.push_back( mesh );
+        models.push_back( Eigen::Matrix4f::Identity( ));
 
-      if ( meshAABB.minimum( ).x( ) < aabb.minimum( ).x( ))
-        aabb.minimum( ).x( ) = meshAABB.minimum( ).x();
-      if ( meshAABB.minimum( ).y( ) < aabb.minimum( ).y( ))
-        aabb.minimum( ).y( ) = meshAABB.minimum( ).y();
-      if ( meshAABB.minimum( ).z( ) < aabb.minimum( ).z( ))
-        aabb.minimum( ).z( ) = meshAABB.minimum( ).z();
-      if ( meshAABB.maximum( ).x( ) > aabb.maximum( ).x( ))
-        aabb.maximum( ).x( ) = meshAABB.maximum( ).x();
-      if ( meshAABB.maximum( ).y( ) > aabb.maximum( ).y( ))
-        aabb.maximum( ).y( ) = meshAABB.maximum( ).y();
-      if ( meshAABB.maximum( ).z( ) > aabb.maximum( ).z( ))
-        aabb.maximum( ).z( ) = meshAABB.maximum( ).z();
+        nlgeometry::AxisAlignedBoundingBox meshAABB = mesh->aaBoundingBox( );
+
+        if ( meshAABB.minimum( ).x( ) < aabb.minimum( ).x( ))
+          aabb.minimum( ).x( ) = meshAABB.minimum( ).x();
+        if ( meshAABB.minimum( ).y( ) < aabb.minimum( ).y( ))
+          aabb.minimum( ).y( ) = meshAABB.minimum( ).y();
+        if ( meshAABB.minimum( ).z( ) < aabb.minimum( ).z( ))
+          aabb.minimum( ).z( ) = meshAABB.minimum( ).z();
+        if ( meshAABB.maximum( ).x( ) > aabb.maximum( ).x( ))
+          aabb.maximum( ).x( ) = meshAABB.maximum( ).x();
+        if ( meshAABB.maximum( ).y( ) > aabb.maximum( ).y( ))
+          aabb.maximum( ).y( ) = meshAABB.maximum( ).y();
+        if ( meshAABB.maximum( ).z( ) > aabb.maximum( ).z( ))
+          aabb.maximum( ).z( ) = meshAABB.maximum( ).z();
+      }
     }
   }
   camera->position( aabb.center( ));
@@ -195,6 +212,8 @@ void renderFunc( void )
   renderer->viewMatrix( ) = view;
   Eigen::Matrix4f projection( camera->camera()->projectionMatrix( ));
   renderer->projectionMatrix( ) = projection;
+  renderer->viewport( glutGet( GLUT_WINDOW_WIDTH ),
+                      glutGet( GLUT_WINDOW_HEIGHT ));
   renderer->render( meshes, models, Eigen::Vector3f( 0.3f, 0.3f, 0.8f ));
   // for ( auto m: meshes )
   //   renderer->render( m, m->modelMatrix( ),
@@ -244,6 +263,12 @@ void keyboardFunc( unsigned char key, int, int )
     else
       renderer->tessCriteria( nlrender::Renderer::HOMOGENEOUS );
     break;
+  case 'e':
+    adaptiveCriteria = false;
+    renderer->tessCriteria( nlrender::Renderer::SCREEN_SPACE );
+    std::cout << "Screen space criteria with edges of "
+              << renderer->edgePixels( ) << " pixels" << std::endl;
+    break;
   case 'x':
     for ( auto mesh: meshes )
     {
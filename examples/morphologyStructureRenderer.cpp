@@ -19,6 +19,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  *
  */
+#include <algorithm>
 #include <iostream>
 #include <boost/filesystem.hpp>
 
@@ -62,10 +63,12 @@ bool wireframe = false;
 bool adaptiveCriteria = false;
 
 Eigen::Vector3f currentColor = Eigen::Vector3f( 0.0, 0.0, 1.0 );
-nlgenerator::NodeIdToVerticesIds nodeIdToVerticesIds;
+nlgenerator::NodeVertexTable nodeVertexTable;
 
 float nodeId = 0.0f;
 std::vector< unsigned int > nodeIds;
+unsigned int highlightedNode = 0;
+unsigned int numNodes = 0;
 
 void renderFunc( void );
 void initContext( int argc, char* argv[ ]);
@@ -97,10 +100,11 @@ int main( int argc, char* argv[] )
   renderer->alpha( ) = 0.2f;
 
   nlgeometry::MeshPtr mesh;
-  nlgeometry::AttribsFormat format( 3 );
+  nlgeometry::AttribsFormat format( 4 );
   format[0] = nlgeometry::TAttribType::POSITION;
   format[1] = nlgeometry::TAttribType::COLOR;
   format[2] = nlgeometry::TAttribType::CENTER;
+  format[3] = nlgeometry::TAttribType::NODE_ID;
 
   nsol::SwcReader swcr;
 
@@ -131,9 +135,8 @@ int main( int argc, char* argv[] )
 #endif
     if ( morphology )
     {
-      nlgenerator::NodeIdToVertices nodeIdToVertices;
       mesh = nlgenerator::MeshGenerator::generateStructureMesh(
-        morphology, nodeIdToVertices, Eigen::Vector3f( 0.0f, 0.5f,0.8f ),
+        morphology, nodeVertexTable, Eigen::Vector3f( 0.0f, 0.5f, 0.5f ),
         true );
       std::cout << "Loaded morphology with: "
                 << mesh->vertices( ).size( ) << " vertices, "
@@ -141,15 +144,26 @@ int main( int argc, char* argv[] )
                 << mesh->triangles( ).size( ) << " triangles and "
                 << mesh->quads( ).size( ) << " quads" << std::endl;
 
+      mesh->shadowAttrib( nlgeometry::COLOR );
       mesh->uploadGPU( format, nlgeometry::Facet::PATCHES );
-      nlgenerator::MeshGenerator::verticesToIndices( nodeIdToVertices,
-                                                     nodeIdToVerticesIds );
+      if ( nodeVertexTable.numberNodes( ) > 0 )
+        numNodes = std::max( numNodes, nodeVertexTable.nodeIds( ).back( ) + 1 );
       mesh->clearCPUData( );
 
       meshes.push_back( mesh );
       models.push_back( Eigen::Matrix4f::Identity( ));
 
       mesh = nlgenerator::MeshGenerator::generateMesh( morphology );
+      nlgeometry::MeshOptimizer::optimize( mesh );
+      // Base color mixed with the node color table when rendering per node
+      for ( auto facet: mesh->quads( ))
+        for ( auto vertex: { facet->vertex0( ), facet->vertex1( ),
+                             facet->vertex2( ), facet->vertex3( )})
+          vertex->color( ) = Eigen::Vector3f( 0.0f, 0.0f, 1.0f );
+      for ( auto facet: mesh->triangles( ))
+        for ( auto vertex: { facet->vertex0( ), facet->vertex1( ),
+                             facet->vertex2( )})
+          vertex->color( ) = Eigen::Vector3f( 0.0f, 0.0f, 1.0f );
       mesh->uploadGPU( format, nlgeometry::Facet::PATCHES );
       mesh->computeBoundingBox( );
       mesh->clearCPUData( );
@@ -173,6 +187,9 @@ int main( int argc, char* argv[] )
         aabb.maximum( ).z( ) = meshAABB.maximum( ).z();
     }
   }
+  // The neuron mesh is colored per node through its node id attribute
+  renderer->nodeColors( )->resize( numNodes );
+
   camera->position( aabb.center( ));
   camera->radius( aabb.radius( ) / sin( camera->camera()->fieldOfView( )));
   // camera->pivot( Eigen::Vector3f::Zero( ));
@@ -229,20 +246,22 @@ void renderFunc( void )
       glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
   }
 
+  // Only the vertices of the newly highlighted node are uploaded
   auto mesh = meshes[0];
-  std::vector< float > buffer( mesh->verticesSize( )*3);
-  for ( unsigned int i = 0; i < mesh->verticesSize( ); i++ )
-  {
-    buffer[i*3] = 0.0f;
-    buffer[i*3+1] = 0.5f;
-    buffer[i*3+2] = 0.5f;
-  }
   nodeId += 0.005;
-  nodeIds.push_back( std::trunc(nodeId) );
+  nodeIds.assign( 1, ( unsigned int )std::trunc( nodeId ));
   currentColor = Eigen::Vector3f( 1.0f, 0.0f, 0.0f );
-  nlgenerator::MeshGenerator::conformBuffer( nodeIds, nodeIdToVerticesIds,
-                                               buffer, currentColor );
-  mesh->uploadBuffer( nlgeometry::COLOR, buffer );
+  nlgenerator::MeshGenerator::conformBuffer( nodeIds, nodeVertexTable,
+                                             mesh, currentColor );
+  mesh->flushBuffers( );
+
+  if ( nodeIds[0] < numNodes && nodeIds[0] != highlightedNode )
+  {
+    renderer->nodeColors( )->color( highlightedNode, Eigen::Vector4f::Zero( ));
+    highlightedNode = nodeIds[0];
+    renderer->nodeColors( )->color( highlightedNode,
+                                    Eigen::Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ));
+  }
 
   renderer->setUpOpaqueTransparencyScene( Eigen::Vector3f( 1.0f, 1.0f, 1.0f ),
                                           width, height );
@@ -258,7 +277,7 @@ void renderFunc( void )
 
   renderer->setUpTransparentTransparencyScene( );
 
-  renderer->colorFunc( nlrender::Renderer::GLOBAL );
+  renderer->colorFunc( nlrender::Renderer::PERNODE );
   renderer->render( meshes[1], models[1], Eigen::Vector3f( 0.0f, 0.0f, 1.0f ),
                     true, true, true );
 
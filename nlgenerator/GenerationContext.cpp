@@ -0,0 +1,166 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "GenerationContext.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace nlgenerator
+{
+
+  GenerationContext::GenerationContext( void )
+    : _temporaryBytes( 0 )
+    , _peakTemporaryBytes( 0 )
+    , _retainedBytes( 0 )
+  {
+  }
+
+  GenerationContext::~GenerationContext( void )
+  {
+    _release( );
+  }
+
+  void GenerationContext::begin( void )
+  {
+    _release( );
+    _temporaryBytes = 0;
+    _peakTemporaryBytes = 0;
+    _retainedBytes = 0;
+  }
+
+  void GenerationContext::end( nlgeometry::MeshPtr mesh_ )
+  {
+    _release( );
+    _retainedBytes = meshBytes( mesh_ );
+  }
+
+  JointNodePtr GenerationContext::joint( const Eigen::Vector3f& position_,
+                                         float radius_ )
+  {
+    auto joint = new JointNode( position_, radius_ );
+    _joints.push_back( joint );
+    allocated( sizeof( JointNode ));
+    return joint;
+  }
+
+  nlgeometry::SectionQuadPtr GenerationContext::sectionQuad(
+    nlgeometry::SectionQuadPtr quad_ )
+  {
+    _sectionQuads.push_back( quad_ );
+    allocated( sizeof( nlgeometry::SectionQuad ));
+    return quad_;
+  }
+
+  void GenerationContext::addBackwardNode( nsol::SectionPtr section_,
+                                           nsol::NodePtr node_ )
+  {
+    section_->addBackwardNode( node_ );
+    _addedNodes.push_back( std::make_pair( section_, node_ ));
+    allocated( sizeof( nsol::Node ));
+  }
+
+  nsol::SectionPtr GenerationContext::section( nsol::SectionPtr section_ )
+  {
+    _sections.push_back( section_ );
+    return section_;
+  }
+
+  void GenerationContext::allocated( long long bytes_ )
+  {
+    _temporaryBytes += bytes_;
+    _peakTemporaryBytes = std::max( _peakTemporaryBytes, _temporaryBytes );
+  }
+
+  size_t GenerationContext::temporaryBytes( void ) const
+  {
+    return size_t( std::max( _temporaryBytes, 0ll ));
+  }
+
+  size_t GenerationContext::peakBytes( void ) const
+  {
+    return size_t( _peakTemporaryBytes ) + _retainedBytes;
+  }
+
+  size_t GenerationContext::retainedBytes( void ) const
+  {
+    return _retainedBytes;
+  }
+
+  size_t GenerationContext::meshBytes( nlgeometry::MeshPtr mesh_ )
+  {
+    if ( !mesh_ )
+      return 0;
+    std::unordered_set< nlgeometry::VertexPtr > vertices(
+      mesh_->vertices( ).begin( ), mesh_->vertices( ).end( ));
+    size_t facets = 0;
+    for ( auto facetsList: { &mesh_->lines( ), &mesh_->triangles( ),
+                             &mesh_->quads( )})
+    {
+      for ( auto facet: *facetsList )
+      {
+        vertices.insert( facet->vertex0( ));
+        vertices.insert( facet->vertex1( ));
+        vertices.insert( facet->vertex2( ));
+        vertices.insert( facet->vertex3( ));
+      }
+      facets += facetsList->size( );
+    }
+    vertices.erase( nullptr );
+    return vertices.size( ) * ( sizeof( nlgeometry::OrbitalVertex ) +
+                                sizeof( nlgeometry::VertexPtr )) +
+      facets * ( sizeof( nlgeometry::Facet ) + sizeof( nlgeometry::FacetPtr ));
+  }
+
+  void GenerationContext::_release( void )
+  {
+    for ( auto joint: _joints )
+      delete joint;
+    _joints.clear( );
+
+    for ( auto quad: _sectionQuads )
+      delete quad;
+    _sectionQuads.clear( );
+
+    // Restores the sections in reverse order of extension
+    for ( auto added = _addedNodes.rbegin( ); added != _addedNodes.rend( );
+          added++ )
+    {
+      auto& nodes = added->first->nodes( );
+      auto node = std::find( nodes.begin( ), nodes.end( ), added->second );
+      if ( node != nodes.end( ))
+        nodes.erase( node );
+      delete added->second;
+    }
+    _addedNodes.clear( );
+
+    // Temporary sections do not own the nodes of the morphology
+    for ( auto section: _sections )
+    {
+      section->nodes( ).clear( );
+      delete section;
+    }
+    _sections.clear( );
+
+    _temporaryBytes = 0;
+  }
+
+} // namespace nlgenerator
@@ -0,0 +1,177 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLGENERATOR_GENERATION_CONTEXT__
+#define __NLGENERATOR_GENERATION_CONTEXT__
+
+#include "../nlgeometry/Mesh.h"
+#include "../nlgeometry/SectionQuad.h"
+#include "JointNode.h"
+
+#include <nsol/nsol.h>
+
+#include <nlgenerator/api.h>
+
+namespace nlgenerator
+{
+
+  /* \class GenerationContext
+   * Owns the temporaries of a mesh generation: joint nodes, section quads
+   * and the nodes added to the morphology sections. All of them are freed in
+   * bulk when the generation ends, leaving the morphology as it was. It also
+   * keeps an estimate of the memory used by the last generation
+   */
+  class GenerationContext
+  {
+
+  public:
+
+    /**
+     * Default constructor
+     */
+    NLGENERATOR_API
+    GenerationContext( void );
+
+    /**
+     * Default destructor, frees the temporaries not freed yet
+     */
+    NLGENERATOR_API
+    ~GenerationContext( void );
+
+    /**
+     * Method that frees the temporaries of a previous generation and resets
+     * the memory counters
+     */
+    NLGENERATOR_API
+    void begin( void );
+
+    /**
+     * Method that frees the temporaries and accounts the generated mesh as
+     * retained memory
+     * @param mesh_ generated mesh, owned by the caller
+     */
+    NLGENERATOR_API
+    void end( nlgeometry::MeshPtr mesh_ );
+
+    /**
+     * Method that creates a joint node owned by the context
+     * @param position_ position of the joint node
+     * @param radius_ radius of the joint node
+     * @return the joint node
+     */
+    NLGENERATOR_API
+    JointNodePtr joint( const Eigen::Vector3f& position_, float radius_ );
+
+    /**
+     * Method that takes the ownership of a temporary section quad, whose
+     * vertices are owned by the mesh facets
+     * @param quad_ section quad
+     * @return the same section quad
+     */
+    NLGENERATOR_API
+    nlgeometry::SectionQuadPtr sectionQuad( nlgeometry::SectionQuadPtr quad_ );
+
+    /**
+     * Method that adds a node at the beginning of a section. The node is
+     * removed and deleted when the generation ends
+     * @param section_ section to extend
+     * @param node_ node to add, owned by the context
+     */
+    NLGENERATOR_API
+    void addBackwardNode( nsol::SectionPtr section_, nsol::NodePtr node_ );
+
+    /**
+     * Method that takes the ownership of a temporary section whose nodes are
+     * owned by the morphology
+     * @param section_ temporary section
+     * @return the same section
+     */
+    NLGENERATOR_API
+    nsol::SectionPtr section( nsol::SectionPtr section_ );
+
+    /**
+     * Method that accounts temporary memory not owned by the context
+     * @param bytes_ bytes allocated, or freed when negative
+     */
+    NLGENERATOR_API
+    void allocated( long long bytes_ );
+
+    /**
+     * Method that returns the temporary bytes currently held
+     * @return the temporary bytes currently held
+     */
+    NLGENERATOR_API
+    size_t temporaryBytes( void ) const;
+
+    /**
+     * Method that returns the bound of the memory used by the last generation,
+     * the maximum of temporary bytes held at once plus the retained bytes
+     * @return the peak bytes of the last generation
+     */
+    NLGENERATOR_API
+    size_t peakBytes( void ) const;
+
+    /**
+     * Method that returns the bytes of the mesh of the last generation
+     * @return the retained bytes of the last generation
+     */
+    NLGENERATOR_API
+    size_t retainedBytes( void ) const;
+
+    /**
+     * Static method that estimates the memory used by the vertices and facets
+     * of a mesh, including the vertices only referenced by its facets
+     * @param mesh_ mesh to measure
+     * @return the bytes of the mesh
+     */
+    NLGENERATOR_API
+    static size_t meshBytes( nlgeometry::MeshPtr mesh_ );
+
+  protected:
+
+    void _release( void );
+
+    //! Joint nodes of the generation
+    JointNodes _joints;
+
+    //! Temporary section quads
+    std::vector< nlgeometry::SectionQuadPtr > _sectionQuads;
+
+    //! Sections extended with a backward node
+    std::vector< std::pair< nsol::SectionPtr, nsol::NodePtr >> _addedNodes;
+
+    //! Temporary sections
+    nsol::Sections _sections;
+
+    //! Temporary bytes currently held
+    long long _temporaryBytes;
+
+    //! Maximum temporary bytes held at once
+    long long _peakTemporaryBytes;
+
+    //! Bytes of the generated mesh
+    size_t _retainedBytes;
+
+  }; // class GenerationContext
+
+} // namespace nlgenerator
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "GenerationSink.h"
+#include "MeshCache.h"
+
+#include <stdexcept>
+
+namespace nlgenerator
+{
+
+  ObjGenerationSink::ObjGenerationSink( const std::string& fileName_,
+                                        const std::string& headerString_ )
+    : _writer( fileName_, headerString_ )
+  {
+  }
+
+  void ObjGenerationSink::write( nlgeometry::MeshPtr batch_ )
+  {
+    _writer.writeMesh( batch_ );
+  }
+
+  nlgeometry::ObjStreamWriter& ObjGenerationSink::writer( void )
+  {
+    return _writer;
+  }
+
+  BinaryGenerationSink::BinaryGenerationSink( const std::string& fileName_ )
+    : _stream( fileName_, std::ios::binary )
+    , _batches( 0 )
+  {
+    if ( !_stream.is_open( ))
+      throw std::runtime_error( fileName_ + ": Error creating the file" );
+  }
+
+  void BinaryGenerationSink::write( nlgeometry::MeshPtr batch_ )
+  {
+    MeshCache::writeMesh( _stream, batch_ );
+    _stream.flush( );
+    _batches++;
+  }
+
+  unsigned int BinaryGenerationSink::batches( void ) const
+  {
+    return _batches;
+  }
+
+} // namespace nlgenerator
@@ -0,0 +1,132 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLGENERATOR_GENERATION_SINK__
+#define __NLGENERATOR_GENERATION_SINK__
+
+#include "../nlgeometry/Mesh.h"
+#include "../nlgeometry/Writer/ObjStreamWriter.h"
+
+#include <fstream>
+
+#include <nlgenerator/api.h>
+
+namespace nlgenerator
+{
+
+  /*! \class GenerationSink
+   * Receives the batches of a streaming generation as they are generated, so
+   * the whole generated mesh never has to be kept in memory
+   */
+  class GenerationSink
+  {
+
+  public:
+
+    NLGENERATOR_API
+    virtual ~GenerationSink( void ) { }
+
+    /**
+     * Method called with each generated batch, which is deleted by the
+     * generator after the call
+     * @param batch_ generated mesh of the batch
+     */
+    NLGENERATOR_API
+    virtual void write( nlgeometry::MeshPtr batch_ ) = 0;
+
+  }; // class GenerationSink
+
+  /*! \class ObjGenerationSink
+   * Generation sink that appends every batch to an obj file. Batches only
+   * hold their vertices in the facets, so each batch writes the vertices
+   * its facets use, numbered by first use
+   */
+  class ObjGenerationSink : public GenerationSink
+  {
+
+  public:
+
+    /**
+     * Default constructor
+     * @param fileName_ path of the obj file
+     * @param headerString_ text written at the start of the file
+     */
+    NLGENERATOR_API
+    ObjGenerationSink( const std::string& fileName_,
+                       const std::string& headerString_ = "" );
+
+    NLGENERATOR_API
+    virtual void write( nlgeometry::MeshPtr batch_ );
+
+    /**
+     * Method that returns the writer of the obj file
+     * @return the obj writer
+     */
+    NLGENERATOR_API
+    nlgeometry::ObjStreamWriter& writer( void );
+
+  protected:
+
+    //! Writer of the obj file
+    nlgeometry::ObjStreamWriter _writer;
+
+  }; // class ObjGenerationSink
+
+  /*! \class BinaryGenerationSink
+   * Generation sink that appends every batch to a binary file in the mesh
+   * cache format. The batches are read back calling MeshCache::readMesh until
+   * it returns nullptr
+   */
+  class BinaryGenerationSink : public GenerationSink
+  {
+
+  public:
+
+    /**
+     * Default constructor
+     * @param fileName_ path of the binary file
+     */
+    NLGENERATOR_API
+    BinaryGenerationSink( const std::string& fileName_ );
+
+    NLGENERATOR_API
+    void write( nlgeometry::MeshPtr batch_ );
+
+    /**
+     * Method that returns the number of written batches
+     * @return the number of written batches
+     */
+    NLGENERATOR_API
+    unsigned int batches( void ) const;
+
+  protected:
+
+    //! Binary output file
+    std::ofstream _stream;
+
+    //! Number of written batches
+    unsigned int _batches;
+
+  }; // class BinaryGenerationSink
+
+} // namespace nlgenerator
+
+#endif
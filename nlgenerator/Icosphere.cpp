@@ -33,6 +33,7 @@ namespace nlgenerator
                          unsigned int subdivisionlevel_ )
     : _center( center_ )
     , _radius( radius_ )
+    , _femSystem( nullptr )
   {
 
     Eigen::Vector3f position = Eigen::Vector3f( _center );
@@ -91,7 +92,22 @@ namespace nlgenerator
 
   Icosphere::~Icosphere( void )
   {
+    // Surface nodes and tetrahedra are subsets of the icosphere ones
+    delete _femSystem;
+    for ( auto tetrahedron: _tetrahedra )
+      delete tetrahedron;
+    for ( auto node: _nodes )
+      delete node;
+    for ( auto quad: _surfaceQuads )
+      delete quad;
+  }
 
+  size_t Icosphere::bytes( void ) const
+  {
+    return _nodes.size( ) * sizeof( nlphysics::Node ) +
+      _tetrahedra.size( ) * sizeof( nlphysics::Tetrahedron ) +
+      _surfaceQuads.size( ) * sizeof( Quad ) +
+      ( _femSystem ? sizeof( nlphysics::Fem ) : 0 );
   }
 
   nlgeometry::Facets Icosphere::compute(
@@ -112,6 +128,8 @@ namespace nlgenerator
           quad->node2( )->initialPosition( ) +
           quad->node3( )->initialPosition( )) * 0.25f;
 
+      // Joints connected to the soma with one neighbour are computed without
+      // vertices, the icosphere ones are placed instead
       auto sectionQuad = joint->sectionQuad( );
       auto node = quad->node0( );
       node->position( ) = ( node->initialPosition( ) - quadCenter
@@ -142,6 +160,7 @@ namespace nlgenerator
       sectionQuad->vertex3( ) = _nodeToVertex( node, vertices );
     }
 
+    delete _femSystem;
     _femSystem = new nlphysics::Fem( _nodes, _tetrahedra, 0.3f, 1.0f );
     _femSystem->solve( );
     _computeCenters( );
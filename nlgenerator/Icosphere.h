@@ -153,11 +153,19 @@ namespace nlgenerator
                unsigned int subdivisionlevel_ = 3 );
 
     /**
-     * Default destructor
+     * Default destructor, deletes the icosphere nodes, tetrahedra and finite
+     * element system
      */
     NLGENERATOR_API
     ~Icosphere( );
 
+    /**
+     * Method that estimates the memory used by the icosphere structure
+     * @return the bytes of the icosphere nodes, tetrahedra and quads
+     */
+    NLGENERATOR_API
+    size_t bytes( void ) const;
+
     /**
      * Method that computes the final icospehere shape
      * @param joints_ joint nodes that conects to the icospehere
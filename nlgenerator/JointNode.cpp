@@ -21,6 +21,8 @@
  */
 #include "JointNode.h"
 
+#include "../nlgeometry/CrossSection.h"
+
 namespace nlgenerator
 {
 
@@ -28,11 +30,15 @@ namespace nlgenerator
     : _position( position_ )
     , _radius( radius_ )
     , _connectedSoma( false )
+    , _nodeId( -1 )
   {
   }
 
   JointNode::~JointNode( void )
   {
+    // The vertices of the section quads belong to the generated facets
+    for ( auto neighbour: _neighbors )
+      delete neighbour.second;
     _neighbors.clear( );
   }
 
@@ -51,9 +57,14 @@ namespace nlgenerator
     return _connectedSoma;
   }
 
+  int& JointNode::nodeId( void )
+  {
+    return _nodeId;
+  }
+
   nlgeometry::SectionQuadPtr JointNode::sectionQuad( nsol::NodePtr neighbour_ )
   {
-    auto neigh = _neighbors.find( neighbour_ );
+    auto neigh = _find( neighbour_ );
     if ( neigh != _neighbors.end( ))
       return neigh->second;
     else
@@ -75,6 +86,11 @@ namespace nlgenerator
       return nullptr;
   }
 
+  const NeighbourQuads& JointNode::neighbors( void ) const
+  {
+    return _neighbors;
+  }
+
   unsigned int JointNode::numberNeighbors( void )
   {
     return ( unsigned int )_neighbors.size( );
@@ -82,7 +98,13 @@ namespace nlgenerator
 
   void JointNode::addNeighbour( nsol::NodePtr neighbour_ )
   {
-    _neighbors[ neighbour_ ] = nullptr;
+    if ( _find( neighbour_ ) != _neighbors.end( ))
+      return;
+    auto position = _neighbors.begin( );
+    while ( position != _neighbors.end( ) &&
+            position->first->id( ) <= neighbour_->id( ))
+      position++;
+    _neighbors.insert( position, std::make_pair( neighbour_, nullptr ));
   }
 
   void JointNode::computeGeometry( void )
@@ -101,11 +123,19 @@ namespace nlgenerator
       exe = Eigen::Vector3f( 0.0f, 1.0f, 0.0f );
       q.setFromTwoVectors(exe,tangent);
 
-      auto quad = nlgeometry::SectionQuad::identity( );
-      quad->rotate( q );
-      quad->place( _position );
-      quad->norm( _radius );
-      _neighbors[ neigh->first ] = quad;
+      // The soma icosphere provides the vertices of its first joints
+      if ( _connectedSoma )
+      {
+        neigh->second = new nlgeometry::SectionQuad(
+          nullptr, nullptr, nullptr, nullptr );
+        return;
+      }
+
+      auto section = nlgeometry::CrossSection::identity( );
+      section.rotate( q );
+      section.place( _position );
+      section.norm( _radius );
+      neigh->second = section.materialize( );
     }
     else if ( _neighbors.size( ) == 2 )
     {
@@ -119,12 +149,13 @@ namespace nlgenerator
       exe = Eigen::Vector3f( 0.0f, 1.0f, 0.0f );
       q.setFromTwoVectors(exe,tangent);
 
-      auto quad = nlgeometry::SectionQuad::identity( );
-      quad->rotate( q );
-      quad->place( _position );
-      quad->norm( _radius );
-      _neighbors[ _neighbors.begin( )->first ] = quad->inversed( );
-      _neighbors[ neigh->first ] = quad;
+      auto section = nlgeometry::CrossSection::identity( );
+      section.rotate( q );
+      section.place( _position );
+      section.norm( _radius );
+      auto quad = section.materialize( );
+      _neighbors.begin( )->second = quad->inversed( );
+      neigh->second = quad;
     }
     else if ( _neighbors.size( ) > 2 )
     {
@@ -149,6 +180,7 @@ namespace nlgenerator
 
       std::vector< std::tuple< float, Eigen::Vector3f, nsol::NodePtr >>
         orderedNodes;
+      Eigen::Vector3f referenceDirection;
       for ( neigh = _neighbors.begin( ); neigh != _neighbors.end( );
             neigh++ )
       {
@@ -157,7 +189,6 @@ namespace nlgenerator
         auto dist = v.dot( normal );
         auto projectDirection =
           ( point - dist * normal - _position ).normalized( );
-        Eigen::Vector3f referenceDirection;
         if ( neigh == _neighbors.begin( ))
         {
           referenceDirection = projectDirection;
@@ -259,8 +290,25 @@ namespace nlgenerator
         auto vertex3 = vertices[id];
         auto quad = new nlgeometry::SectionQuad(
           vertex0, vertex1, vertex2, vertex3 );
-        _neighbors[ std::get<2>( orderedNodes[id] )] = quad;
+        _find( std::get<2>( orderedNodes[id] ))->second = quad;
       }
     }
+
+    for ( auto neighbour: _neighbors )
+    {
+      auto quad = neighbour.second;
+      for ( auto vertex: { quad->vertex0( ), quad->vertex1( ),
+                           quad->vertex2( ), quad->vertex3( )})
+        if ( vertex )
+          vertex->nodeId( ) = _nodeId;
+    }
+  }
+
+  NeighbourQuads::iterator JointNode::_find( nsol::NodePtr neighbour_ )
+  {
+    auto neigh = _neighbors.begin( );
+    while ( neigh != _neighbors.end( ) && neigh->first != neighbour_ )
+      neigh++;
+    return neigh;
   }
 }
@@ -34,6 +34,9 @@ namespace nlgenerator
   typedef JointNode* JointNodePtr;
   typedef std::vector< JointNodePtr > JointNodes;
 
+  typedef std::vector< std::pair< nsol::NodePtr, nlgeometry::SectionQuadPtr >>
+    NeighbourQuads;
+
   /* \class JointNode */
   class JointNode
   {
@@ -48,7 +51,7 @@ namespace nlgenerator
     JointNode( const Eigen::Vector3f& position_, float radius_ );
 
     /**
-     * Default destructor
+     * Default destructor, deletes the section quads but not their vertices
      */
     NLGENERATOR_API
     ~JointNode( void );
@@ -74,6 +77,14 @@ namespace nlgenerator
     NLGENERATOR_API
     bool& connectedSoma( void );
 
+    /**
+     * Method that returns the id of the nsol node of the joint, given to the
+     * vertices of its section quads
+     * @return the nsol node id or -1 if it is unknown
+     */
+    NLGENERATOR_API
+    int& nodeId( void );
+
     /**
      * Method that returns the corresponding section quad for each neighbour
      * nsol node
@@ -84,19 +95,28 @@ namespace nlgenerator
     nlgeometry::SectionQuadPtr sectionQuad( nsol::NodePtr neighbour_ );
 
     /**
-     * Method that returns the first section quad
+     * Method that returns the first section quad, the one of the neighbour
+     * with the lowest node id
      * @return the first section quad
      */
     NLGENERATOR_API
     nlgeometry::SectionQuadPtr sectionQuad( void );
 
     /**
-     * Method that return the first neighbour node
+     * Method that return the first neighbour node, the one with the lowest
+     * node id
      * @return the first neigbour node
      */
     NLGENERATOR_API
     nsol::NodePtr neighbour( void );
 
+    /**
+     * Method that returns the neighbour nodes and their section quads
+     * @return the neighbour nodes and section quads sorted by node id
+     */
+    NLGENERATOR_API
+    const NeighbourQuads& neighbors( void ) const;
+
     /**
      * Method that returns the number of neighbors of the joint node
      * @return the number of neighbors of the joint node
@@ -105,7 +125,9 @@ namespace nlgenerator
     unsigned int numberNeighbors( void );
 
     /**
-     * Method that adds a new nsol neighbour node to the joint
+     * Method that adds a new nsol neighbour node to the joint. Neighbours are
+     * kept sorted by node id, and in insertion order for equal ids, so the
+     * generated geometry does not depend on node addresses
      * @param neighbour_ nsol neighbour node
      */
     NLGENERATOR_API
@@ -119,6 +141,13 @@ namespace nlgenerator
 
   protected:
 
+    /**
+     * Method that returns the entry of the given neighbour node
+     * @param neighbour_ nsol neighbour node
+     * @return iterator to the neighbour entry, end if it is not a neighbour
+     */
+    NeighbourQuads::iterator _find( nsol::NodePtr neighbour_ );
+
     //! Joint node position
     Eigen::Vector3f _position;
 
@@ -128,8 +157,11 @@ namespace nlgenerator
     //! Conditional that indicates if the joint node is connected to the soma
     bool _connectedSoma;
 
-    //! Joint node neighbour nodes
-    std::unordered_map< nsol::NodePtr, nlgeometry::SectionQuadPtr > _neighbors;
+    //! Id of the nsol node of the joint node
+    int _nodeId;
+
+    //! Joint node neighbour nodes and their section quads sorted by node id
+    NeighbourQuads _neighbors;
 
   }; // class JointNode
 
@@ -0,0 +1,503 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "MeshCache.h"
+#include "MeshGenerator.h"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+
+namespace nlgenerator
+{
+
+  static const char meshCacheMagic[4] = { 'N', 'L', 'M', 'C' };
+  static const char meshCacheEnd[4] = { 'N', 'L', 'M', 'E' };
+  static const uint32_t meshCacheVersion = 2;
+  static const char* meshCacheExtension = ".nlmc";
+  static const char* meshCacheTemporary = ".tmp";
+  // Temporary files older than this belong to writers that were stopped
+  static const std::time_t meshCacheTemporaryAge = 3600;
+
+  /* \class MeshCacheHasher
+   * Two lanes of 64 bits FNV-1a hashing of the key data
+   */
+  class MeshCacheHasher
+  {
+
+  public:
+
+    MeshCacheHasher( void )
+      : _lane0( 14695981039346656037ull )
+      , _lane1( 9650029242287828579ull )
+    {
+    }
+
+    void add( const void* data_, size_t size_ )
+    {
+      auto bytes = reinterpret_cast< const unsigned char* >( data_ );
+      for ( size_t i = 0; i < size_; i++ )
+      {
+        _lane0 = ( _lane0 ^ bytes[i] ) * 1099511628211ull;
+        _lane1 = ( _lane1 ^ bytes[i] ) * 1099511628211ull;
+        _lane1 ^= _lane1 >> 29;
+      }
+    }
+
+    template< typename T >
+    void add( const T& value_ )
+    {
+      add( &value_, sizeof( T ));
+    }
+
+    void add( const Eigen::Vector3f& vector_ )
+    {
+      add( vector_.x( ));
+      add( vector_.y( ));
+      add( vector_.z( ));
+    }
+
+    void add( nsol::SectionPtr section_, std::set< nsol::SectionPtr >& visited_ )
+    {
+      if ( !section_ || !visited_.insert( section_ ).second )
+        return;
+      auto& nodes = section_->nodes( );
+      add( uint64_t( nodes.size( )));
+      for ( auto node: nodes )
+      {
+        add( int64_t( node->id( )));
+        add( node->point( ));
+        add( node->radius( ));
+      }
+      auto forwardSections = section_->forwardNeighbors( );
+      auto backwardSections = section_->backwardNeighbors( );
+      add( uint64_t( forwardSections.size( )));
+      add( uint64_t( backwardSections.size( )));
+      for ( auto section: backwardSections )
+        add( section, visited_ );
+      for ( auto section: forwardSections )
+        add( section, visited_ );
+    }
+
+    std::string hex( void ) const
+    {
+      std::ostringstream stream;
+      stream << std::hex;
+      stream.fill( '0' );
+      stream.width( 16 );
+      stream << _lane0;
+      stream.width( 16 );
+      stream << _lane1;
+      return stream.str( );
+    }
+
+  protected:
+
+    uint64_t _lane0;
+
+    uint64_t _lane1;
+
+  }; // class MeshCacheHasher
+
+  MeshCache::MeshCache( const std::string& directory_,
+                        unsigned long long maxBytes_,
+                        const std::string& settings_ )
+    : _directory( directory_ )
+    , _maxBytes( maxBytes_ )
+    , _settings( settings_ )
+  {
+    boost::system::error_code error;
+    boost::filesystem::create_directories( _directory, error );
+    if ( !boost::filesystem::is_directory( _directory, error ))
+      throw std::runtime_error( "MeshCache: can not create the directory " +
+                                _directory );
+  }
+
+  const std::string& MeshCache::directory( void ) const
+  {
+    return _directory;
+  }
+
+  unsigned long long MeshCache::maxBytes( void ) const
+  {
+    return _maxBytes;
+  }
+
+  std::string MeshCache::key( nsol::MorphologyPtr morphology_ ) const
+  {
+    return _key( morphology_, std::vector< float >( ));
+  }
+
+  std::string MeshCache::key( nsol::NeuronMorphologyPtr morphology_,
+                              float alphaRadius_,
+                              const std::vector< float >& alphaNeurites_ ) const
+  {
+    std::vector< float > params;
+    params.push_back( alphaRadius_ );
+    params.insert( params.end( ), alphaNeurites_.begin( ),
+                   alphaNeurites_.end( ));
+    return _key( morphology_, params );
+  }
+
+  nlgeometry::MeshPtr MeshCache::load( const std::string& key_ ) const
+  {
+    auto path = _path( key_ );
+    std::ifstream stream( path, std::ios::binary );
+    if ( !stream.is_open( ))
+      return nullptr;
+
+    auto mesh = readMesh( stream );
+    stream.close( );
+
+    boost::system::error_code error;
+    if ( !mesh )
+      boost::filesystem::remove( path, error );
+    else
+      boost::filesystem::last_write_time( path, std::time( nullptr ), error );
+    return mesh;
+  }
+
+  bool MeshCache::store( const std::string& key_,
+                         nlgeometry::MeshPtr mesh_ ) const
+  {
+    boost::system::error_code error;
+    auto temporary = boost::filesystem::path( _directory ) /
+      boost::filesystem::unique_path(
+        std::string( "%%%%-%%%%-%%%%-%%%%" ) + meshCacheTemporary, error );
+    if ( error )
+      return false;
+
+    std::ofstream stream( temporary.string( ), std::ios::binary );
+    if ( !stream.is_open( ))
+      return false;
+    writeMesh( stream, mesh_ );
+    stream.close( );
+    if ( stream.fail( ))
+    {
+      boost::filesystem::remove( temporary, error );
+      return false;
+    }
+
+    // The rename is atomic, readers find the whole file or no file
+    auto path = _path( key_ );
+    boost::filesystem::rename( temporary, path, error );
+    if ( error )
+    {
+      boost::filesystem::remove( temporary, error );
+      if ( !boost::filesystem::exists( path, error ))
+        return false;
+    }
+
+    evict( );
+    return true;
+  }
+
+  void MeshCache::evict( void ) const
+  {
+    std::vector< std::tuple< std::time_t, unsigned long long,
+                             boost::filesystem::path >> files;
+    unsigned long long total = 0;
+    std::time_t now = std::time( nullptr );
+
+    boost::system::error_code error;
+    boost::filesystem::directory_iterator it( _directory, error );
+    for ( ; !error && it != boost::filesystem::directory_iterator( );
+          it.increment( error ))
+    {
+      auto path = it->path( );
+      // Files removed by other processes are skipped
+      boost::system::error_code fileError;
+      auto time = boost::filesystem::last_write_time( path, fileError );
+      if ( fileError )
+        continue;
+      if ( path.extension( ) == meshCacheTemporary )
+      {
+        if ( now - time > meshCacheTemporaryAge )
+          boost::filesystem::remove( path, fileError );
+      }
+      else if ( path.extension( ) == meshCacheExtension )
+      {
+        auto size = boost::filesystem::file_size( path, fileError );
+        if ( fileError )
+          continue;
+        total += size;
+        files.push_back( std::make_tuple( time, size, path ));
+      }
+    }
+
+    if ( total <= _maxBytes )
+      return;
+
+    std::sort( files.begin( ), files.end( ));
+    for ( auto file: files )
+    {
+      if ( total <= _maxBytes )
+        break;
+      boost::system::error_code fileError;
+      boost::filesystem::remove( std::get< 2 >( file ), fileError );
+      total -= std::get< 1 >( file );
+    }
+  }
+
+  unsigned long long MeshCache::bytes( void ) const
+  {
+    unsigned long long total = 0;
+    boost::system::error_code error;
+    boost::filesystem::directory_iterator it( _directory, error );
+    for ( ; !error && it != boost::filesystem::directory_iterator( );
+          it.increment( error ))
+    {
+      if ( it->path( ).extension( ) != meshCacheExtension )
+        continue;
+      boost::system::error_code fileError;
+      auto size = boost::filesystem::file_size( it->path( ), fileError );
+      if ( !fileError )
+        total += size;
+    }
+    return total;
+  }
+
+  void MeshCache::writeMesh( std::ostream& stream_, nlgeometry::MeshPtr mesh_ )
+  {
+    // Vertices indexed by first use, as the mesh conforms them
+    std::unordered_map< nlgeometry::VertexPtr, uint32_t > indices;
+    nlgeometry::Vertices vertices;
+    std::vector< uint32_t > facetIndices;
+    const nlgeometry::Facets* facetLists[3] =
+      { &mesh_->lines( ), &mesh_->triangles( ), &mesh_->quads( ) };
+    const unsigned int facetSizes[3] = { 2, 3, 4 };
+    for ( unsigned int list = 0; list < 3; list++ )
+    {
+      for ( auto facet: *facetLists[list] )
+      {
+        nlgeometry::VertexPtr facetVertices[4] =
+          { facet->vertex0( ), facet->vertex1( ),
+            facet->vertex2( ), facet->vertex3( ) };
+        for ( unsigned int i = 0; i < facetSizes[list]; i++ )
+        {
+          auto inserted = indices.insert( std::make_pair(
+            facetVertices[i], uint32_t( vertices.size( ))));
+          if ( inserted.second )
+            vertices.push_back( facetVertices[i] );
+          facetIndices.push_back( inserted.first->second );
+        }
+      }
+    }
+
+    uint32_t header[5] = { meshCacheVersion, uint32_t( vertices.size( )),
+                           uint32_t( mesh_->lines( ).size( )),
+                           uint32_t( mesh_->triangles( ).size( )),
+                           uint32_t( mesh_->quads( ).size( )) };
+    stream_.write( meshCacheMagic, sizeof( meshCacheMagic ));
+    stream_.write( reinterpret_cast< const char* >( header ), sizeof( header ));
+
+    for ( auto vertex: vertices )
+    {
+      auto orbitalVertex =
+        dynamic_cast< nlgeometry::OrbitalVertexPtr >( vertex );
+      float data[18];
+      unsigned int size = 0;
+      for ( auto vector: { &vertex->position( ), &vertex->normal( ),
+                           &vertex->color( )})
+      {
+        data[size++] = vector->x( );
+        data[size++] = vector->y( );
+        data[size++] = vector->z( );
+      }
+      data[size++] = vertex->uv( ).x( );
+      data[size++] = vertex->uv( ).y( );
+      if ( orbitalVertex )
+      {
+        for ( auto vector: { &orbitalVertex->center( ),
+                             &orbitalVertex->tangent( )})
+        {
+          data[size++] = vector->x( );
+          data[size++] = vector->y( );
+          data[size++] = vector->z( );
+        }
+        // Node ids are exact as floats up to 2^24 nodes
+        data[size++] = float( orbitalVertex->nodeId( ));
+      }
+      char orbital = orbitalVertex ? 1 : 0;
+      stream_.write( &orbital, 1 );
+      stream_.write( reinterpret_cast< const char* >( data ),
+                     size * sizeof( float ));
+    }
+
+    stream_.write( reinterpret_cast< const char* >( facetIndices.data( )),
+                   facetIndices.size( ) * sizeof( uint32_t ));
+    stream_.write( meshCacheEnd, sizeof( meshCacheEnd ));
+  }
+
+  nlgeometry::MeshPtr MeshCache::readMesh( std::istream& stream_ )
+  {
+    char magic[4];
+    uint32_t header[5];
+    stream_.read( magic, sizeof( magic ));
+    stream_.read( reinterpret_cast< char* >( header ), sizeof( header ));
+    if ( !stream_ || !std::equal( magic, magic + 4, meshCacheMagic ) ||
+         header[0] != meshCacheVersion )
+      return nullptr;
+
+    nlgeometry::Vertices vertices;
+    auto mesh = new nlgeometry::Mesh( );
+    bool valid = true;
+
+    for ( uint32_t v = 0; v < header[1] && valid; v++ )
+    {
+      char orbital;
+      float data[18];
+      stream_.read( &orbital, 1 );
+      unsigned int size = orbital ? 18 : 11;
+      stream_.read( reinterpret_cast< char* >( data ), size * sizeof( float ));
+      if ( !stream_ )
+      {
+        valid = false;
+        break;
+      }
+      Eigen::Vector3f position( data[0], data[1], data[2] );
+      nlgeometry::VertexPtr vertex;
+      if ( orbital )
+      {
+        auto orbitalVertex = new nlgeometry::OrbitalVertex(
+          position, Eigen::Vector3f( data[11], data[12], data[13] ),
+          Eigen::Vector3f( data[14], data[15], data[16] ),
+          Eigen::Vector3f( data[6], data[7], data[8] ));
+        orbitalVertex->nodeId( ) = int( data[17] );
+        vertex = orbitalVertex;
+      }
+      else
+        vertex = new nlgeometry::Vertex(
+          position, Eigen::Vector3f( data[3], data[4], data[5] ),
+          Eigen::Vector3f( data[6], data[7], data[8] ));
+      vertex->normal( ) = Eigen::Vector3f( data[3], data[4], data[5] );
+      vertex->uv( ) = Eigen::Vector2f( data[9], data[10] );
+      vertices.push_back( vertex );
+    }
+
+    nlgeometry::Facets* facetLists[3] =
+      { &mesh->lines( ), &mesh->triangles( ), &mesh->quads( ) };
+    const unsigned int facetSizes[3] = { 2, 3, 4 };
+    for ( unsigned int list = 0; list < 3 && valid; list++ )
+    {
+      for ( uint32_t f = 0; f < header[2 + list]; f++ )
+      {
+        uint32_t facetIndices[4];
+        stream_.read( reinterpret_cast< char* >( facetIndices ),
+                      facetSizes[list] * sizeof( uint32_t ));
+        if ( !stream_ )
+        {
+          valid = false;
+          break;
+        }
+        nlgeometry::VertexPtr facetVertices[4] =
+          { nullptr, nullptr, nullptr, nullptr };
+        for ( unsigned int i = 0; i < facetSizes[list]; i++ )
+        {
+          if ( facetIndices[i] >= vertices.size( ))
+            valid = false;
+          else
+            facetVertices[i] = vertices[facetIndices[i]];
+        }
+        if ( !valid )
+          break;
+        facetLists[list]->push_back( new nlgeometry::Facet(
+          facetVertices[0], facetVertices[1],
+          facetVertices[2], facetVertices[3] ));
+      }
+    }
+
+    stream_.read( magic, sizeof( magic ));
+    if ( !stream_ || !std::equal( magic, magic + 4, meshCacheEnd ))
+      valid = false;
+
+    if ( !valid )
+    {
+      for ( auto facets: facetLists )
+      {
+        for ( auto facet: *facets )
+          delete facet;
+        facets->clear( );
+      }
+      delete mesh;
+      for ( auto vertex: vertices )
+        delete vertex;
+      return nullptr;
+    }
+    return mesh;
+  }
+
+  std::string MeshCache::_key( nsol::MorphologyPtr morphology_,
+                               const std::vector< float >& params_ ) const
+  {
+    MeshCacheHasher hasher;
+    hasher.add( meshCacheVersion );
+    hasher.add( uint32_t( MeshGenerator::somaSubdivisions ));
+    hasher.add( uint64_t( _settings.size( )));
+    hasher.add( _settings.data( ), _settings.size( ));
+    hasher.add( uint64_t( params_.size( )));
+    for ( auto param: params_ )
+      hasher.add( param );
+
+    std::set< nsol::SectionPtr > visited;
+    nsol::NeuronMorphologyPtr neuronMorphology =
+      dynamic_cast< nsol::NeuronMorphologyPtr >( morphology_ );
+    if ( neuronMorphology )
+    {
+      auto soma = neuronMorphology->soma( );
+      hasher.add( soma->center( ));
+      hasher.add( soma->meanRadius( ));
+      auto somaNodes = soma->nodes( );
+      hasher.add( uint64_t( somaNodes.size( )));
+      for ( auto node: somaNodes )
+      {
+        hasher.add( int64_t( node->id( )));
+        hasher.add( node->point( ));
+        hasher.add( node->radius( ));
+      }
+      hasher.add( uint64_t( neuronMorphology->neurites( ).size( )));
+      for ( auto neurite: neuronMorphology->neurites( ))
+        hasher.add( neurite->firstSection( ), visited );
+    }
+    else
+    {
+      hasher.add( uint64_t( morphology_->sections( ).size( )));
+      for ( auto section: morphology_->sections( ))
+        hasher.add( section, visited );
+    }
+    return hasher.hex( );
+  }
+
+  std::string MeshCache::_path( const std::string& key_ ) const
+  {
+    return ( boost::filesystem::path( _directory ) /
+             ( key_ + meshCacheExtension )).string( );
+  }
+
+} // namespace nlgenerator
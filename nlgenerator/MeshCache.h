@@ -0,0 +1,170 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLGENERATOR_MESH_CACHE__
+#define __NLGENERATOR_MESH_CACHE__
+
+#include "../nlgeometry/Mesh.h"
+
+#include <nsol/nsol.h>
+
+#include <iostream>
+#include <string>
+
+#include <nlgenerator/api.h>
+
+namespace nlgenerator
+{
+
+  /* \class MeshCache
+   * On-disk cache of generated control meshes. Each mesh is stored in a
+   * compact binary file named after a hash of the morphology nodes and of
+   * the generation parameters, so a morphology that has not changed is
+   * loaded instead of regenerated. Files are written to a temporary name and
+   * renamed, so several processes can share the same directory, and the
+   * least recently used files are removed when the directory grows over its
+   * size limit
+   */
+  class MeshCache
+  {
+
+  public:
+
+    /**
+     * Constructor
+     * @param directory_ directory of the cache files, created if needed
+     * @param maxBytes_ size limit of the cache files
+     * @param settings_ generation settings not kept in the morphology, such
+     * as the simplifier ones, that are added to every key
+     */
+    NLGENERATOR_API
+    MeshCache( const std::string& directory_,
+               unsigned long long maxBytes_ = 1024ull * 1024ull * 1024ull,
+               const std::string& settings_ = "" );
+
+    /**
+     * Method that returns the cache directory
+     * @return the cache directory
+     */
+    NLGENERATOR_API
+    const std::string& directory( void ) const;
+
+    /**
+     * Method that returns the size limit of the cache files
+     * @return the size limit in bytes
+     */
+    NLGENERATOR_API
+    unsigned long long maxBytes( void ) const;
+
+    /**
+     * Method that returns the key of the mesh generated from the given
+     * morphology with the default parameters
+     * @param morphology_ morphology to generate
+     * @return the key of the generated mesh
+     */
+    NLGENERATOR_API
+    std::string key( nsol::MorphologyPtr morphology_ ) const;
+
+    /**
+     * Method that returns the key of the mesh generated from the given
+     * neuron morphology changing some morphology params
+     * @param morphology_ morphology to generate
+     * @param alphaRadius_ param to change the morphology soma radius
+     * @param alphaNeurites_ param to change the distance of the morphology
+     * neurites with the morphology soma
+     * @return the key of the generated mesh
+     */
+    NLGENERATOR_API
+    std::string key( nsol::NeuronMorphologyPtr morphology_,
+                     float alphaRadius_,
+                     const std::vector< float >& alphaNeurites_ ) const;
+
+    /**
+     * Method that loads the mesh stored with the given key and marks it as
+     * recently used
+     * @param key_ key of the mesh
+     * @return the loaded mesh, nullptr if it is not cached or the file is not
+     * valid
+     */
+    NLGENERATOR_API
+    nlgeometry::MeshPtr load( const std::string& key_ ) const;
+
+    /**
+     * Method that stores the mesh with the given key and evicts the least
+     * recently used meshes if the cache is over its size limit
+     * @param key_ key of the mesh
+     * @param mesh_ mesh to store
+     * @return true if the mesh was stored
+     */
+    NLGENERATOR_API
+    bool store( const std::string& key_, nlgeometry::MeshPtr mesh_ ) const;
+
+    /**
+     * Method that removes the least recently used meshes until the cache is
+     * under its size limit, and the temporary files left by stopped writers
+     */
+    NLGENERATOR_API
+    void evict( void ) const;
+
+    /**
+     * Method that returns the size of the cached meshes
+     * @return the size in bytes of the cache files
+     */
+    NLGENERATOR_API
+    unsigned long long bytes( void ) const;
+
+    /**
+     * Static method that writes the mesh in the cache binary format
+     * @param stream_ output binary stream
+     * @param mesh_ mesh to write
+     */
+    NLGENERATOR_API
+    static void writeMesh( std::ostream& stream_, nlgeometry::MeshPtr mesh_ );
+
+    /**
+     * Static method that reads a mesh in the cache binary format
+     * @param stream_ input binary stream
+     * @return the read mesh, nullptr if the stream is not valid
+     */
+    NLGENERATOR_API
+    static nlgeometry::MeshPtr readMesh( std::istream& stream_ );
+
+  protected:
+
+    std::string _key( nsol::MorphologyPtr morphology_,
+                      const std::vector< float >& params_ ) const;
+
+    std::string _path( const std::string& key_ ) const;
+
+    //! Cache directory
+    std::string _directory;
+
+    //! Size limit of the cache files
+    unsigned long long _maxBytes;
+
+    //! Generation settings added to every key
+    std::string _settings;
+
+  }; // class MeshCache
+
+} // namespace nlgenerator
+
+#endif
@@ -23,25 +23,69 @@
 
 #include "Icosphere.h"
 
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
 namespace nlgenerator
 {
 
   nlgeometry::MeshPtr MeshGenerator::generateMesh(
-    nsol::MorphologyPtr morphology_ )
+    nsol::MorphologyPtr morphology_, GenerationContext* context_,
+    MeshCache* cache_ )
   {
+    GenerationContext localContext;
+    GenerationContext& context = context_ ? *context_ : localContext;
+    context.begin( );
+
+    std::string key;
+    if ( cache_ )
+    {
+      key = cache_->key( morphology_ );
+      auto mesh = cache_->load( key );
+      if ( mesh )
+      {
+        context.end( mesh );
+        return mesh;
+      }
+    }
+
+    nlgeometry::MeshPtr mesh;
     nsol::NeuronMorphologyPtr neuronMorphology =
       dynamic_cast< nsol::NeuronMorphologyPtr >( morphology_ );
     if ( neuronMorphology )
-      return _generateMophology( neuronMorphology );
+      mesh = _generateMophology( neuronMorphology, context );
     else
-      return _generateMorphology( morphology_ );
+      mesh = _generateMorphology( morphology_, context );
+
+    context.end( mesh );
+    if ( cache_ )
+      cache_->store( key, mesh );
+    return mesh;
   }
 
   nlgeometry::MeshPtr MeshGenerator::generateMesh(
     nsol::NeuronMorphologyPtr morphology_,
     float alphaRadius_,
-    const std::vector< float >& alphaNeurites_ )
+    const std::vector< float >& alphaNeurites_,
+    GenerationContext* context_, MeshCache* cache_ )
   {
+    GenerationContext localContext;
+    GenerationContext& context = context_ ? *context_ : localContext;
+    context.begin( );
+
+    std::string key;
+    if ( cache_ )
+    {
+      key = cache_->key( morphology_, alphaRadius_, alphaNeurites_ );
+      auto mesh = cache_->load( key );
+      if ( mesh )
+      {
+        context.end( mesh );
+        return mesh;
+      }
+    }
+
     auto mesh = new nlgeometry::Mesh( );
 
     nsol::Sections sections;
@@ -56,12 +100,15 @@ namespace nlgenerator
             ).normalized( ) * firstSecNode->radius( ) + firstSecNode->point( );
         auto newNode = new nsol::Node( position, firstSecNode->id( ),
                                        firstSecNode->radius( ));
-        section->addBackwardNode( newNode );
+        context.addBackwardNode( section, newNode );
       }
       sections.push_back( neurite->firstSection( ));
     }
 
-    auto joints = _vectorizeJoints( sections );
+    // Joints are walked in creation order, which follows the sections, so
+    // the output does not depend on node addresses
+    JointNodes orderedJoints;
+    auto joints = _vectorizeJoints( sections, orderedJoints, context );
 
     JointNodes firstJoints;
     const float somaRadius = morphology_->soma( )->meanRadius( );
@@ -78,21 +125,23 @@ namespace nlgenerator
       firstJoints.push_back( joint );
     }
 
-    for ( auto element: joints )
+    for ( auto joint: orderedJoints )
     {
-      auto &joint = element.second;
       joint->computeGeometry( );
+      context.allocated( joint->numberNeighbors( ) *
+                         sizeof( nlgeometry::SectionQuad ));
     }
 
-    Icosphere icosphere( somaCenter, somaRadius * alphaRadius_, 3 );
+    Icosphere icosphere( somaCenter, somaRadius * alphaRadius_,
+                         somaSubdivisions );
 
     mesh->triangles( ) = icosphere.compute( firstJoints );
+    context.allocated( icosphere.bytes( ));
 
     auto facets = _meshSections( sections, joints );
 
-    for ( auto element: joints )
+    for ( auto joint: orderedJoints )
     {
-      auto joint = element.second;
       if ( joint->numberNeighbors( ) == 1 && !joint->connectedSoma( ))
       {
         auto sectionQuad = joint->sectionQuad( );
@@ -101,6 +150,7 @@ namespace nlgenerator
         Eigen::Vector3f position = ( center - node->point( )
           ).normalized( ) * joint->radius( ) + center;
         auto vertex = new nlgeometry::OrbitalVertex( position, center );
+        vertex->nodeId( ) = joint->nodeId( );
         facets.push_back(
           new nlgeometry::Facet( sectionQuad->vertex0( ),
                                  sectionQuad->vertex1( ),
@@ -121,15 +171,127 @@ namespace nlgenerator
     }
 
     mesh->quads( ) = facets;
+    context.end( mesh );
+    if ( cache_ )
+      cache_->store( key, mesh );
     return mesh;
   }
 
+  unsigned int MeshGenerator::generateMeshStream(
+    nsol::MorphologyPtr morphology_, GenerationSink* sink_,
+    unsigned int sectionsPerBatch_, GenerationContext* context_ )
+  {
+    if ( dynamic_cast< nsol::NeuronMorphologyPtr >( morphology_ ))
+    {
+      auto mesh = generateMesh( morphology_, context_ );
+      sink_->write( mesh );
+      delete mesh;
+      return 1;
+    }
+
+    GenerationContext localContext;
+    GenerationContext& context = context_ ? *context_ : localContext;
+    sectionsPerBatch_ = std::max( 1u, sectionsPerBatch_ );
+
+    nsol::Sections sections;
+    _orderSections( morphology_->sections( ), sections );
+
+    // Neighbour nodes of every joint, enough to rebuild a joint in each
+    // batch that uses it
+    std::unordered_map< nsol::NodePtr, nsol::Nodes > jointNeighbours;
+    for ( auto section: sections )
+    {
+      auto& nodes = section->nodes( );
+      if ( nodes.size( ) > 1 )
+      {
+        jointNeighbours[ nodes.front( )].push_back( nodes[1] );
+        jointNeighbours[ nodes.back( )].push_back( nodes[ nodes.size( ) - 2 ]);
+      }
+    }
+
+    unsigned int batches = 0;
+    for ( size_t first = 0; first < sections.size( );
+          first += sectionsPerBatch_ )
+    {
+      size_t last = std::min( sections.size( ), first + sectionsPerBatch_ );
+      context.begin( );
+
+      std::unordered_map< nsol::NodePtr, JointNodePtr > joints;
+      JointNodes orderedJoints;
+      for ( size_t i = first; i < last; i++ )
+      {
+        auto& nodes = sections[i]->nodes( );
+        if ( nodes.size( ) < 2 )
+          continue;
+        for ( auto node: { nodes.front( ), nodes.back( )})
+        {
+          if ( joints.find( node ) != joints.end( ))
+            continue;
+          auto joint = context.joint( node->point( ), node->radius( ));
+          joint->nodeId( ) = int( node->id( ));
+          for ( auto neighbour: jointNeighbours[ node ])
+            joint->addNeighbour( neighbour );
+          joint->computeGeometry( );
+          context.allocated( joint->numberNeighbors( ) *
+                             sizeof( nlgeometry::SectionQuad ));
+          joints[ node ] = joint;
+          orderedJoints.push_back( joint );
+        }
+      }
+
+      nlgeometry::Facets facets;
+      for ( size_t i = first; i < last; i++ )
+        _meshSection( sections[i], joints, facets );
+      _meshEnds( orderedJoints, facets );
+
+      // The quads of the joints towards sections of other batches are not
+      // used by this batch facets, so their vertices are freed here
+      std::unordered_set< nlgeometry::VertexPtr > used;
+      for ( auto facet: facets )
+      {
+        used.insert( facet->vertex0( ));
+        used.insert( facet->vertex1( ));
+        used.insert( facet->vertex2( ));
+        used.insert( facet->vertex3( ));
+      }
+      std::unordered_set< nlgeometry::VertexPtr > unused;
+      for ( auto joint: orderedJoints )
+      {
+        for ( auto neighbour: joint->neighbors( ))
+        {
+          auto quad = neighbour.second;
+          if ( !quad )
+            continue;
+          for ( nlgeometry::VertexPtr vertex: { quad->vertex0( ),
+                  quad->vertex1( ), quad->vertex2( ), quad->vertex3( )})
+            if ( used.find( vertex ) == used.end( ))
+              unused.insert( vertex );
+        }
+      }
+
+      auto mesh = new nlgeometry::Mesh( );
+      mesh->quads( ) = facets;
+      context.end( mesh );
+      for ( auto vertex: unused )
+        delete vertex;
+
+      sink_->write( mesh );
+      delete mesh;
+      batches++;
+    }
+    return batches;
+  }
+
   nlgeometry::MeshPtr MeshGenerator::generateStructureMesh(
-    nsol::MorphologyPtr morphology_, NodeIdToVertices& nodeIdToVertices_,
-    Eigen::Vector3f color_, bool generateNodes_, float offset_ )
+    nsol::MorphologyPtr morphology_, NodeVertexTable& nodeVertexTable_,
+    Eigen::Vector3f color_, bool generateNodes_, float offset_,
+    GenerationContext* context_ )
   {
+    GenerationContext localContext;
+    GenerationContext& context = context_ ? *context_ : localContext;
+    context.begin( );
+
     auto mesh = new nlgeometry::Mesh(  );
-    nodeIdToVertices_.clear( );
     nsol::Sections firstSections;
 
     nsol::NeuronMorphologyPtr neuronMorphology =
@@ -139,7 +301,8 @@ namespace nlgenerator
       auto somaNodes = neuronMorphology->soma( )->nodes( );
       if ( somaNodes.size( ) > 0 )
       {
-        auto somaSection = new nsol::NeuronMorphologySection( );
+        auto somaSection =
+          context.section( new nsol::NeuronMorphologySection( ));
         nsol::NodePtr firstNode = somaNodes[0];
         somaSection->addNode( firstNode );
         nsol::NodePtr previousNode = nullptr;
@@ -161,59 +324,85 @@ namespace nlgenerator
       firstSections = morphology_->sections( );
     }
 
+    // Vertex of each section end node, shared by the sections joined there
+    std::unordered_map< unsigned int, nlgeometry::OrbitalVertexPtr >
+      nodeVertices;
     std::set< nsol::SectionPtr > uniqueSections;
+    nsol::Sections orderedSections;
 
     for ( auto firstSection: firstSections )
-      _vectorizeSections( mesh, firstSection, uniqueSections, nodeIdToVertices_,
-                          color_, generateNodes_, offset_ );
+      _vectorizeSections( mesh, firstSection, uniqueSections, orderedSections,
+                          nodeVertices, color_, generateNodes_, offset_ );
 
-    for ( auto section: uniqueSections )
+    for ( auto section: orderedSections )
     {
-      if ( nodeIdToVertices_.find( section->backwardNode( )->id( )) !=
-           nodeIdToVertices_.end( ))
+      auto firstVertex = nodeVertices.find( section->backwardNode( )->id( ));
+      auto lastVertex = nodeVertices.find( section->forwardNode( )->id( ));
+      if ( firstVertex == nodeVertices.end( ) ||
+           lastVertex == nodeVertices.end( ))
+        continue;
+      nlgeometry::VertexPtr previousVertex = firstVertex->second;
+      auto nodes = section->nodes( );
+      for ( unsigned int i = 1; i < nodes.size( ) - 1; i++ )
       {
-        auto firstVertex =
-          nodeIdToVertices_[section->backwardNode( )->id( )][0];
-        if ( nodeIdToVertices_.find( section->forwardNode( )->id( )) !=
-             nodeIdToVertices_.end( ))
+        auto currentNode = nodes[i];
+        if ( currentNode != section->forwardNode( ))
         {
-          auto lastVertex =
-            nodeIdToVertices_[section->forwardNode( )->id( )][0];
-          auto previousVertex = firstVertex;
-          auto nodes = section->nodes( );
-          for ( unsigned int i = 1; i < nodes.size( ) - 1; i++ )
+          auto currentVertex = _structureVertex(
+            mesh, currentNode, currentNode->point( ), color_ );
+          mesh->lines( ).push_back(
+            new nlgeometry::Facet( previousVertex, currentVertex ));
+          if ( generateNodes_ )
           {
-            auto currentNode = nodes[i];
-            if ( currentNode != section->forwardNode( ))
-            {
-              auto currentVertex =
-                new nlgeometry::OrbitalVertex(
-                  currentNode->point( ), currentNode->point( ),
-                  Eigen::Vector3f( 0.0f, 0.0f, 0.0f ), color_ );
-              nodeIdToVertices_[currentNode->id( )].push_back( currentVertex );
-              mesh->lines( ).push_back(
-                new nlgeometry::Facet( previousVertex, currentVertex ));
-              if ( generateNodes_ )
-              {
-                auto triangles = _generateCube( currentNode, nodeIdToVertices_,
-                                                color_, offset_ );
-                mesh->triangles().insert(
-                  mesh->triangles( ).end( ), triangles.begin( ),
-                  triangles.end( ));
-              }
-
-              previousVertex = currentVertex;
-            }
+            auto triangles = _generateCube( mesh, currentNode, color_,
+                                            offset_ );
+            mesh->triangles().insert(
+              mesh->triangles( ).end( ), triangles.begin( ),
+              triangles.end( ));
           }
-          mesh->lines( ).push_back(
-            new nlgeometry::Facet( previousVertex, lastVertex ));
+
+          previousVertex = currentVertex;
         }
       }
+      mesh->lines( ).push_back(
+        new nlgeometry::Facet( previousVertex, lastVertex->second ));
     }
 
+    nodeVertexTable_.build( mesh->vertices( ));
+    context.end( mesh );
     return mesh;
   }
 
+  nlgeometry::MeshPtr MeshGenerator::generateStructureMesh(
+    nsol::MorphologyPtr morphology_, NodeIdToVertices& nodeIdToVertices_,
+    Eigen::Vector3f color_, bool generateNodes_, float offset_,
+    GenerationContext* context_ )
+  {
+    NodeVertexTable table;
+    auto mesh = generateStructureMesh( morphology_, table, color_,
+                                       generateNodes_, offset_, context_ );
+
+    nodeIdToVertices_.clear( );
+    const auto& vertices = mesh->vertices( );
+    const auto& offsets = table.offsets( );
+    const auto& vertexIds = table.vertexIds( );
+    for ( unsigned int i = 0; i < table.numberNodes( ); i++ )
+    {
+      auto& nodeVertices = nodeIdToVertices_[table.nodeIds( )[i]];
+      for ( unsigned int j = offsets[i]; j < offsets[i+1]; j++ )
+        nodeVertices.push_back( static_cast< nlgeometry::OrbitalVertexPtr >(
+          vertices[vertexIds[j]] ));
+    }
+    return mesh;
+  }
+
+  void MeshGenerator::clearCPUData( nlgeometry::MeshPtr mesh_,
+                                    NodeIdToVertices& nodeIdToVertices_ )
+  {
+    nodeIdToVertices_.clear( );
+    mesh_->clearCPUData( );
+  }
+
   void MeshGenerator::verticesToIndices(
     NodeIdToVertices& nodeIdToVertices_,
     NodeIdToVerticesIds& nodeIdToVerticesIds_ )
@@ -240,50 +429,62 @@ namespace nlgenerator
     }
   }
 
+  void MeshGenerator::conformBuffer(
+    const std::vector< unsigned int >& nodeIds_,
+    const NodeVertexTable& nodeVertexTable_, std::vector< float >& buffer_,
+    const Eigen::Vector3f& value_ )
+  {
+    const auto& offsets = nodeVertexTable_.offsets( );
+    const auto& vertexIds = nodeVertexTable_.vertexIds( );
+    float* buffer = buffer_.data( );
+    for ( auto nodeId: nodeIds_ )
+    {
+      unsigned int index = nodeVertexTable_.index( nodeId );
+      if ( index == NodeVertexTable::invalidIndex )
+        continue;
+      for ( unsigned int i = offsets[index]; i < offsets[index+1]; i++ )
+      {
+        float* color = buffer + size_t( vertexIds[i] ) * 3;
+        color[0] = value_.x( );
+        color[1] = value_.y( );
+        color[2] = value_.z( );
+      }
+    }
+  }
+
+  void MeshGenerator::conformBuffer(
+    const std::vector< unsigned int >& nodeIds_,
+    const NodeVertexTable& nodeVertexTable_, nlgeometry::MeshPtr mesh_,
+    const Eigen::Vector3f& value_, nlgeometry::TAttribType type_ )
+  {
+    const auto& offsets = nodeVertexTable_.offsets( );
+    const auto& vertexIds = nodeVertexTable_.vertexIds( );
+    for ( auto nodeId: nodeIds_ )
+    {
+      unsigned int index = nodeVertexTable_.index( nodeId );
+      if ( index != NodeVertexTable::invalidIndex )
+        mesh_->updateAttrib( type_, vertexIds.data( ) + offsets[index],
+                             offsets[index+1] - offsets[index], value_ );
+    }
+  }
+
   nlgeometry::MeshPtr MeshGenerator::_generateMorphology(
-    nsol::MorphologyPtr morphology_ )
+    nsol::MorphologyPtr morphology_, GenerationContext& context_ )
   {
     auto mesh = new nlgeometry::Mesh( );
 
     nsol::Sections sections = morphology_->sections( );
 
-    auto joints = _vectorizeJoints( sections );
-    for ( auto element: joints )
+    JointNodes orderedJoints;
+    auto joints = _vectorizeJoints( sections, orderedJoints, context_ );
+    for ( auto joint: orderedJoints )
     {
-      auto &joint = element.second;
       joint->computeGeometry( );
+      context_.allocated( joint->numberNeighbors( ) *
+                         sizeof( nlgeometry::SectionQuad ));
     }
     auto facets = _meshSections( sections, joints );
-
-    for ( auto element: joints )
-    {
-      auto &joint = element.second;
-      if ( joint->numberNeighbors( ) == 1 && !joint->connectedSoma( ))
-      {
-        auto sectionQuad = joint->sectionQuad( );
-        auto node = joint->neighbour( );
-        const auto center = joint->position( );
-        const auto position = (center - node->point( )).normalized( ) * joint->radius( ) + center;
-        auto vertex = new nlgeometry::OrbitalVertex( position, center );
-
-        facets.push_back(
-          new nlgeometry::Facet( sectionQuad->vertex1( ),
-                                 sectionQuad->vertex0( ),
-                                 vertex, vertex ));
-        facets.push_back(
-          new nlgeometry::Facet( sectionQuad->vertex2( ),
-                                 sectionQuad->vertex1( ),
-                                 vertex, vertex ));
-        facets.push_back(
-          new nlgeometry::Facet( sectionQuad->vertex3( ),
-                                 sectionQuad->vertex2( ),
-                                 vertex, vertex ));
-        facets.push_back(
-          new nlgeometry::Facet( sectionQuad->vertex0( ),
-                                 sectionQuad->vertex3( ),
-                                 vertex, vertex ));
-      }
-    }
+    _meshEnds( orderedJoints, facets );
 
     mesh->quads( ) = facets;
 
@@ -291,7 +492,7 @@ namespace nlgenerator
   }
 
   nlgeometry::MeshPtr MeshGenerator::_generateMophology(
-    nsol::NeuronMorphologyPtr morphology_ )
+    nsol::NeuronMorphologyPtr morphology_, GenerationContext& context_ )
   {
     auto mesh = new nlgeometry::Mesh( );
 
@@ -307,12 +508,13 @@ namespace nlgenerator
             ).normalized( ) * firstSecNode->radius( ) + firstSecNode->point( );
         auto newNode = new nsol::Node( position, firstSecNode->id( ),
                                        firstSecNode->radius( ));
-        section->addBackwardNode( newNode );
+        context_.addBackwardNode( section, newNode );
       }
       sections.push_back( neurite->firstSection( ));
     }
 
-    auto joints = _vectorizeJoints( sections );
+    JointNodes orderedJoints;
+    auto joints = _vectorizeJoints( sections, orderedJoints, context_ );
 
     JointNodes firstJoints;
     for ( auto neurite: morphology_->neurites(  ))
@@ -322,55 +524,32 @@ namespace nlgenerator
       firstJoints.push_back( joint );
     }
 
-    for ( auto element: joints )
+    for ( auto joint: orderedJoints )
     {
-      auto &joint = element.second;
       joint->computeGeometry( );
+      context_.allocated( joint->numberNeighbors( ) *
+                         sizeof( nlgeometry::SectionQuad ));
     }
 
     Icosphere icosphere( morphology_->soma( )->center( ),
-                         morphology_->soma( )->meanRadius( ), 3 );
+                         morphology_->soma( )->meanRadius( ),
+                         somaSubdivisions );
 
     mesh->triangles( ) = icosphere.compute( firstJoints );
+    context_.allocated( icosphere.bytes( ));
 
     auto facets = _meshSections( sections, joints );
 
-    for ( auto element: joints )
-    {
-      auto joint = element.second;
-      if ( joint->numberNeighbors( ) == 1 && !joint->connectedSoma( ))
-      {
-        auto sectionQuad = joint->sectionQuad( );
-        auto node = joint->neighbour( );
-        Eigen::Vector3f center = joint->position( );
-        Eigen::Vector3f position = ( center - node->point( )
-          ).normalized( ) * joint->radius( ) + center;
-        auto vertex = new nlgeometry::OrbitalVertex( position, center );
-        facets.push_back(
-          new nlgeometry::Facet( sectionQuad->vertex1( ),
-                                 sectionQuad->vertex0( ),
-                                 vertex, vertex ));
-        facets.push_back(
-          new nlgeometry::Facet( sectionQuad->vertex2( ),
-                                 sectionQuad->vertex1( ),
-                                 vertex, vertex ));
-        facets.push_back(
-          new nlgeometry::Facet( sectionQuad->vertex3( ),
-                                 sectionQuad->vertex2( ),
-                                 vertex, vertex ));
-        facets.push_back(
-          new nlgeometry::Facet( sectionQuad->vertex0( ),
-                                 sectionQuad->vertex3( ),
-                                 vertex, vertex ));
-      }
-    }
+    _meshEnds( orderedJoints, facets );
 
     mesh->quads( ) = facets;
     return mesh;
   }
 
   std::unordered_map< nsol::NodePtr, JointNodePtr >
-  MeshGenerator::_vectorizeJoints( const nsol::Sections& sections_ )
+  MeshGenerator::_vectorizeJoints( const nsol::Sections& sections_,
+                                   JointNodes& orderedJoints_,
+                                   GenerationContext& context_ )
   {
     std::unordered_map< nsol::NodePtr, JointNodePtr > joints;
 
@@ -378,7 +557,8 @@ namespace nlgenerator
 
     for ( auto section: sections_ )
     {
-      _vectorizeJoints( uniqueSections, section, joints );
+      _vectorizeJoints( uniqueSections, section, joints, orderedJoints_,
+                        context_ );
     }
 
     return joints;
@@ -387,7 +567,9 @@ namespace nlgenerator
   void MeshGenerator::_vectorizeJoints(
     std::set< nsol::SectionPtr>& uniqueSections_,
     const nsol::SectionPtr& section_,
-    std::unordered_map< nsol::NodePtr, JointNodePtr >& joints_ )
+    std::unordered_map< nsol::NodePtr, JointNodePtr >& joints_,
+    JointNodes& orderedJoints_,
+    GenerationContext& context_ )
   {
     if ( uniqueSections_.find( section_ ) == uniqueSections_.end( ))
     {
@@ -402,9 +584,10 @@ namespace nlgenerator
 
         if ( joints_.find( nsolJoint ) == joints_.end( ))
         {
-          auto joint = new JointNode( nsolJoint->point( ),
-                                      nsolJoint->radius( ));
-          joints_[nsolJoint] = joint;
+          joints_[nsolJoint] = context_.joint( nsolJoint->point( ),
+                                               nsolJoint->radius( ));
+          joints_[nsolJoint]->nodeId( ) = int( nsolJoint->id( ));
+          orderedJoints_.push_back( joints_[nsolJoint] );
         }
         joints_[nsolJoint]->addNeighbour( nsolNeighbour );
 
@@ -412,16 +595,19 @@ namespace nlgenerator
         nsolNeighbour = section_->nodes( )[ numNodes - 2 ];
         if ( joints_.find( nsolJoint ) == joints_.end( ))
         {
-          auto joint = new JointNode( nsolJoint->point( ),
-                                    nsolJoint->radius( ));
-          joints_[nsolJoint] = joint;
+          joints_[nsolJoint] = context_.joint( nsolJoint->point( ),
+                                               nsolJoint->radius( ));
+          joints_[nsolJoint]->nodeId( ) = int( nsolJoint->id( ));
+          orderedJoints_.push_back( joints_[nsolJoint] );
         }
         joints_[nsolJoint]->addNeighbour( nsolNeighbour );
       }
       for ( auto nextSection: section_->backwardNeighbors( ))
-        _vectorizeJoints( uniqueSections_, nextSection, joints_ );
+        _vectorizeJoints( uniqueSections_, nextSection, joints_,
+                          orderedJoints_, context_ );
       for ( auto nextSection: section_->forwardNeighbors( ))
-        _vectorizeJoints( uniqueSections_, nextSection, joints_ );
+        _vectorizeJoints( uniqueSections_, nextSection, joints_,
+                          orderedJoints_, context_ );
     }
   }
 
@@ -449,112 +635,7 @@ namespace nlgenerator
     {
       uniqueSections_.insert( section_ );
 
-      auto nodes = section_->nodes( );
-      unsigned int numNodes = static_cast<unsigned int>(nodes.size( ));
-
-
-      auto startJointIt = joints_.find( nodes.front( ));
-      auto endJointIt = joints_.find( nodes.back( ));
-      JointNodePtr startJoint;
-      JointNodePtr endJoint;
-      if ( startJointIt != joints_.end( ) && endJointIt != joints_.end( ))
-      {
-        startJoint = startJointIt->second;
-        endJoint = endJointIt->second;
-        nlgeometry::SectionQuadPtr prim0;
-        nlgeometry::SectionQuadPtr prim1;
-        if ( numNodes == 2 )
-        {
-          prim0 = startJoint->sectionQuad( nodes.back( ));
-          prim1 = endJoint->sectionQuad( nodes.front( ));
-          if ( prim0 && prim1 )
-            nlgeometry::SectionQuad::createPipe(
-              prim0, prim1->inversed( ), facets_, true );
-        }
-        else if ( numNodes > 2 )
-        {
-          prim0 = startJoint->sectionQuad( nodes.at( 1 ));
-          prim1 =  endJoint->sectionQuad( nodes.at( numNodes - 2 ));
-          if ( prim0 && prim1 )
-          {
-            float totalDist = 0.0f;
-            nlgeometry::SectionQuadPtr preQuad = prim0->clone( );
-            nlgeometry::SectionQuadPtr quad = prim0->clone( );
-            quad->normalize( );
-            for ( unsigned int nodeId = 1; nodeId < numNodes - 1; nodeId++ )
-            {
-              totalDist +=
-                (nodes[nodeId]->point( ) - nodes[nodeId-1]->point( )).norm( );
-
-              Eigen::Vector3f center = nodes[nodeId]->point( );
-              Eigen::Vector3f exe = ( center - nodes[nodeId-1]->point(
-                                        )).normalized( );
-              Eigen::Vector3f exe1 = ( nodes[nodeId+1]->point( ) -
-                                       center ).normalized( );
-              Eigen::Quaternion< float > q;
-              Eigen::Quaternion< float > qI =
-                Eigen::Quaternion<float>::Identity( );
-              Eigen::Quaternion< float > qSlerp;
-              q.setFromTwoVectors( exe, exe1 );
-              qSlerp = q.slerp( 0.5f, qI );
-              Eigen::Vector3f tangent = qSlerp * exe;
-
-              exe = quad->normal( );
-              q.setFromTwoVectors(exe,tangent);
-              quad->rotate( q );
-            }
-
-            totalDist += (nodes[numNodes - 1]->point( ) -
-                          nodes[numNodes-2]->point( )).norm( );
-
-            float offsetAngle = quad->getZAngle( prim1->inversed( ));
-
-            quad->deleteVertices( );
-            delete quad;
-
-            for ( unsigned int nodeId = 1; nodeId < numNodes - 1; nodeId++ )
-            {
-              Eigen::Vector3f center = nodes[nodeId]->point( );
-              float dist = ( center - nodes[nodeId-1]->point( )).norm( );
-              float radius = nodes[nodeId]->radius( );
-              Eigen::Vector3f exe = ( center - nodes[nodeId-1]->point(
-                                        )).normalized( );
-              Eigen::Vector3f exe1 = ( nodes[nodeId+1]->point( ) -
-                                       center ).normalized( );
-              Eigen::Quaternion< float > q;
-              Eigen::Quaternion< float > qI =
-                Eigen::Quaternion<float>::Identity( );
-              Eigen::Quaternion< float > qSlerp;
-              q.setFromTwoVectors( exe, exe1 );
-              qSlerp = q.slerp( 0.5f, qI );
-              Eigen::Vector3f tangent = qSlerp * exe;
-              quad = preQuad->clone( );
-              quad->normalize( );
-              exe = preQuad->normal( );
-              quad->place( center );
-              q.setFromTwoVectors(exe,tangent);
-              quad->rotate( q );
-
-              float zfactor = dist/totalDist;
-              q = Eigen::Quaternion< float >(
-                Eigen::AngleAxis< float >(
-                  offsetAngle * zfactor, quad->normal( ) ));
-              quad->rotate( q );
-              quad->norm( radius );
-              if ( nodeId == 1 )
-                nlgeometry::SectionQuad::createPipe( prim0, quad, facets_ );
-              else
-                nlgeometry::SectionQuad::createPipe( preQuad, quad, facets_ );
-
-              delete preQuad;
-              preQuad = quad;
-            }
-            nlgeometry::SectionQuad::createPipe(
-              quad, prim1->inversed( ), facets_, true );
-            delete quad;
-          }
-        }
-      }
+      _meshSection( section_, joints_, facets_ );
 
       for ( auto nextSection: section_->forwardNeighbors( ))
         _meshSections( uniqueSections_, nextSection, joints_, facets_ );
@@ -563,11 +644,208 @@ namespace nlgenerator
     }
   }
 
+  void MeshGenerator::_meshSection(
+    const nsol::SectionPtr& section_,
+    std::unordered_map< nsol::NodePtr, JointNodePtr >& joints_,
+    nlgeometry::Facets& facets_ )
+  {
+    auto nodes = section_->nodes( );
+    unsigned int numNodes = static_cast<unsigned int>(nodes.size( ));
+
+
+    auto startJointIt = joints_.find( nodes.front( ));
+    auto endJointIt = joints_.find( nodes.back( ));
+    JointNodePtr startJoint;
+    JointNodePtr endJoint;
+    if ( startJointIt != joints_.end( ) && endJointIt != joints_.end( ))
+    {
+      startJoint = startJointIt->second;
+      endJoint = endJointIt->second;
+      nlgeometry::SectionQuadPtr prim0 = nullptr;
+      nlgeometry::SectionQuadPtr prim1 = nullptr;
+      if ( numNodes == 2 )
+      {
+        prim0 = startJoint->sectionQuad( nodes.back( ));
+        prim1 = endJoint->sectionQuad( nodes.front( ));
+      }
+      else if ( numNodes > 2 )
+      {
+        prim0 = startJoint->sectionQuad( nodes.at( 1 ));
+        prim1 =  endJoint->sectionQuad( nodes.at( numNodes - 2 ));
+      }
+      if ( !prim0 || !prim1 )
+        return;
+
+      // The end quad is only read while sweeping, so it lives on the stack
+      nlgeometry::SectionQuad endQuad( prim1->vertex0( ), prim1->vertex3( ),
+                                       prim1->vertex2( ), prim1->vertex1( ));
+      if ( numNodes == 2 )
+        nlgeometry::SectionQuad::createPipe( prim0, &endQuad, facets_, true );
+      else
+        _meshPipe( nodes, prim0, &endQuad, facets_ );
+    }
+  }
+
+  void MeshGenerator::_meshPipe( const nsol::Nodes& nodes_,
+                                 nlgeometry::SectionQuadPtr startQuad_,
+                                 nlgeometry::SectionQuadPtr endQuad_,
+                                 nlgeometry::Facets& facets_ )
+  {
+    const unsigned int numNodes = ( unsigned int )nodes_.size( );
+    const float epsilon = 1e-12f;
+
+    // Tangents of the end quads and bisectors at the interior nodes
+    std::vector< Eigen::Vector3f > tangents( numNodes );
+    tangents[0] = startQuad_->normal( ).normalized( );
+    tangents[numNodes - 1] = endQuad_->normal( ).normalized( );
+    for ( unsigned int i = 1; i < numNodes - 1; i++ )
+    {
+      Eigen::Vector3f exe =
+        ( nodes_[i]->point( ) - nodes_[i-1]->point( )).normalized( );
+      Eigen::Vector3f exe1 =
+        ( nodes_[i+1]->point( ) - nodes_[i]->point( )).normalized( );
+      Eigen::Vector3f tangent = exe + exe1;
+      tangents[i] = tangent.squaredNorm( ) > epsilon ?
+        tangent.normalized( ) : exe;
+    }
+
+    // Rotation minimizing frames by double reflection: the reference axis is
+    // reflected by the plane bisecting each segment and then by the one that
+    // takes the reflected tangent to the next tangent
+    std::vector< Eigen::Vector3f > references( numNodes );
+    std::vector< float > lengths( numNodes, 0.0f );
+    Eigen::Vector3f reference = startQuad_->axis0( );
+    references[0] = ( reference - reference.dot( tangents[0] ) *
+                      tangents[0] ).normalized( );
+    for ( unsigned int i = 0; i < numNodes - 1; i++ )
+    {
+      Eigen::Vector3f segment = nodes_[i+1]->point( ) - nodes_[i]->point( );
+      float c1 = segment.squaredNorm( );
+      lengths[i+1] = lengths[i] + std::sqrt( c1 );
+      reference = references[i];
+      Eigen::Vector3f tangent = tangents[i];
+      if ( c1 > epsilon )
+      {
+        reference -= ( 2.0f / c1 ) * segment.dot( reference ) * segment;
+        tangent -= ( 2.0f / c1 ) * segment.dot( tangent ) * segment;
+      }
+      Eigen::Vector3f v2 = tangents[i+1] - tangent;
+      float c2 = v2.squaredNorm( );
+      if ( c2 > epsilon )
+        reference -= ( 2.0f / c2 ) * v2.dot( reference ) * v2;
+      references[i+1] = ( reference - reference.dot( tangents[i+1] ) *
+                          tangents[i+1] ).normalized( );
+    }
+
+    // Twist from the transported reference to the nearest axis of the end
+    // quad, spread along the section length
+    const Eigen::Vector3f& endTangent = tangents[numNodes - 1];
+    const Eigen::Vector3f& endReference = references[numNodes - 1];
+    float twist = 0.0f;
+    float maxCos = -2.0f;
+    for ( auto vertex: { endQuad_->vertex0( ), endQuad_->vertex1( ),
+                         endQuad_->vertex2( ), endQuad_->vertex3( )})
+    {
+      Eigen::Vector3f axis = vertex->position( ) - vertex->center( );
+      axis = ( axis - axis.dot( endTangent ) * endTangent ).normalized( );
+      float cos = endReference.dot( axis );
+      if ( cos > maxCos )
+      {
+        maxCos = cos;
+        twist = std::atan2( endReference.cross( axis ).dot( endTangent ),
+                            cos );
+      }
+    }
+    float totalLength = lengths[numNodes - 1];
+
+    nlgeometry::SectionQuad previous = *startQuad_;
+    for ( unsigned int i = 1; i < numNodes - 1; i++ )
+    {
+      float angle =
+        totalLength > 0.0f ? twist * lengths[i] / totalLength : 0.0f;
+      Eigen::Vector3f axis0 = references[i] * std::cos( angle ) +
+        tangents[i].cross( references[i] ) * std::sin( angle );
+      Eigen::Vector3f axis1 = tangents[i].cross( axis0 );
+      Eigen::Vector3f center = nodes_[i]->point( );
+      float radius = nodes_[i]->radius( );
+
+      nlgeometry::SectionQuad quad(
+        new nlgeometry::OrbitalVertex( center + axis0 * radius, center ),
+        new nlgeometry::OrbitalVertex( center + axis1 * radius, center ),
+        new nlgeometry::OrbitalVertex( center - axis0 * radius, center ),
+        new nlgeometry::OrbitalVertex( center - axis1 * radius, center ));
+      for ( auto vertex: { quad.vertex0( ), quad.vertex1( ),
+                           quad.vertex2( ), quad.vertex3( )})
+        vertex->nodeId( ) = int( nodes_[i]->id( ));
+      nlgeometry::SectionQuad::createPipe( &previous, &quad, facets_ );
+      previous = quad;
+    }
+    nlgeometry::SectionQuad::createPipe( &previous, endQuad_, facets_, true );
+  }
+
+  void MeshGenerator::_meshEnds( const JointNodes& joints_,
+                                 nlgeometry::Facets& facets_ )
+  {
+    for ( auto joint: joints_ )
+    {
+      if ( joint->numberNeighbors( ) == 1 && !joint->connectedSoma( ))
+      {
+        auto sectionQuad = joint->sectionQuad( );
+        auto node = joint->neighbour( );
+        Eigen::Vector3f center = joint->position( );
+        Eigen::Vector3f position = ( center - node->point( )
+          ).normalized( ) * joint->radius( ) + center;
+        auto vertex = new nlgeometry::OrbitalVertex( position, center );
+        vertex->nodeId( ) = joint->nodeId( );
+        facets_.push_back(
+          new nlgeometry::Facet( sectionQuad->vertex1( ),
+                                 sectionQuad->vertex0( ),
+                                 vertex, vertex ));
+        facets_.push_back(
+          new nlgeometry::Facet( sectionQuad->vertex2( ),
+                                 sectionQuad->vertex1( ),
+                                 vertex, vertex ));
+        facets_.push_back(
+          new nlgeometry::Facet( sectionQuad->vertex3( ),
+                                 sectionQuad->vertex2( ),
+                                 vertex, vertex ));
+        facets_.push_back(
+          new nlgeometry::Facet( sectionQuad->vertex0( ),
+                                 sectionQuad->vertex3( ),
+                                 vertex, vertex ));
+      }
+    }
+  }
+
+  void MeshGenerator::_orderSections( const nsol::Sections& sections_,
+                                      nsol::Sections& orderedSections_ )
+  {
+    // Same order as the recursive _meshSections, without its recursion depth
+    std::set< nsol::SectionPtr > uniqueSections;
+    nsol::Sections pending( sections_.rbegin( ), sections_.rend( ));
+    while ( !pending.empty( ))
+    {
+      auto section = pending.back( );
+      pending.pop_back( );
+      if ( !uniqueSections.insert( section ).second )
+        continue;
+      orderedSections_.push_back( section );
+      auto backwardSections = section->backwardNeighbors( );
+      auto forwardSections = section->forwardNeighbors( );
+      pending.insert( pending.end( ), backwardSections.rbegin( ),
+                      backwardSections.rend( ));
+      pending.insert( pending.end( ), forwardSections.rbegin( ),
+                      forwardSections.rend( ));
+    }
+  }
+
   void MeshGenerator::_vectorizeSections(
     nlgeometry::MeshPtr mesh_,
     const nsol::SectionPtr section_,
     std::set< nsol::SectionPtr>& uniqueSections_,
-    NodeIdToVertices& nodeIdToVertices_,
+    nsol::Sections& orderedSections_,
+    std::unordered_map< unsigned int,
+                        nlgeometry::OrbitalVertexPtr >& nodeVertices_,
     Eigen::Vector3f color_,
     bool generateNodes_,
     float offset_ )
@@ -575,87 +853,72 @@ namespace nlgenerator
     if ( uniqueSections_.find( section_ ) == uniqueSections_.end( ))
     {
       uniqueSections_.insert( section_ );
+      orderedSections_.push_back( section_ );
 
       auto firstNode = section_->backwardNode( );
-      if ( nodeIdToVertices_.find( firstNode->id()) == nodeIdToVertices_.end( ))
-      {
-        auto firstVertex = new nlgeometry::OrbitalVertex(
-          firstNode->point( ), firstNode->point( ),
-          Eigen::Vector3f( 0.0f, 0.0f, 0.0f), color_ );
-        nodeIdToVertices_[firstNode->id( )].push_back( firstVertex );
-      }
+      if ( nodeVertices_.find( firstNode->id()) == nodeVertices_.end( ))
+        nodeVertices_[firstNode->id( )] =
+          _structureVertex( mesh_, firstNode, firstNode->point( ), color_ );
       if ( generateNodes_ )
       {
-        auto triangles = _generateCube( firstNode, nodeIdToVertices_,
-                                        color_, offset_ );
+        auto triangles = _generateCube( mesh_, firstNode, color_, offset_ );
         mesh_->triangles().insert(
           mesh_->triangles().end( ), triangles.begin( ), triangles.end( ));
       }
 
       auto lastNode = section_->forwardNode( );
-      if ( nodeIdToVertices_.find( lastNode->id( ) ) ==
-           nodeIdToVertices_.end( ))
-      {
-        auto lastVertex = new nlgeometry::OrbitalVertex(
-          lastNode->point( ), lastNode->point( ),
-          Eigen::Vector3f( 0.0f, 0.0f, 0.0f), color_);
-        nodeIdToVertices_[lastNode->id( )].push_back( lastVertex );
-      }
+      if ( nodeVertices_.find( lastNode->id( ) ) == nodeVertices_.end( ))
+        nodeVertices_[lastNode->id( )] =
+          _structureVertex( mesh_, lastNode, lastNode->point( ), color_ );
       if ( generateNodes_ )
       {
-        auto triangles = _generateCube( lastNode, nodeIdToVertices_,
-                                        color_, offset_ );
+        auto triangles = _generateCube( mesh_, lastNode, color_, offset_ );
         mesh_->triangles().insert(
           mesh_->triangles().end( ), triangles.begin( ), triangles.end( ));
       }
 
       for ( auto nextSection: section_->forwardNeighbors( ))
         _vectorizeSections( mesh_, nextSection, uniqueSections_,
-                            nodeIdToVertices_, color_, generateNodes_,
-                            offset_ );
+                            orderedSections_, nodeVertices_, color_,
+                            generateNodes_, offset_ );
       for ( auto nextSection: section_->backwardNeighbors( ))
         _vectorizeSections( mesh_, nextSection, uniqueSections_,
-                            nodeIdToVertices_, color_, generateNodes_,
-                            offset_ );
+                            orderedSections_, nodeVertices_, color_,
+                            generateNodes_, offset_ );
     }
   }
 
+  nlgeometry::OrbitalVertexPtr MeshGenerator::_structureVertex(
+    nlgeometry::MeshPtr mesh_, nsol::NodePtr node_,
+    const Eigen::Vector3f& position_, Eigen::Vector3f color_ )
+  {
+    auto vertex = new nlgeometry::OrbitalVertex(
+      position_, node_->point( ), Eigen::Vector3f( 0.0f, 0.0f, 0.0f ),
+      color_ );
+    vertex->nodeId( ) = int( node_->id( ));
+    mesh_->vertices( ).push_back( vertex );
+    return vertex;
+  }
+
   nlgeometry::Facets MeshGenerator::_generateCube(
-    nsol::NodePtr node_, NodeIdToVertices& nodeIdToVertices_,
+    nlgeometry::MeshPtr mesh_, nsol::NodePtr node_,
     Eigen::Vector3f color_, float offset_ )
   {
     nlgeometry::Facets triangles;
     auto center = node_->point( );
     float radius = node_->radius( ) * offset_;
-    auto vertex0 = new nlgeometry::OrbitalVertex(
-      center + Eigen::Vector3f( radius, 0.0f, 0.0f ), center,
-      Eigen::Vector3f( 0.0f, 0.0f, 0.0f ), color_ );
-    nodeIdToVertices_[node_->id( )].push_back( vertex0 );
-
-    auto vertex1 = new nlgeometry::OrbitalVertex(
-      center + Eigen::Vector3f( -radius, 0.0f, 0.0f ), center,
-      Eigen::Vector3f( 0.0f, 0.0f, 0.0f ), color_ );
-    nodeIdToVertices_[node_->id( )].push_back( vertex1 );
-
-    auto vertex2 = new nlgeometry::OrbitalVertex(
-      center + Eigen::Vector3f( 0.0f, radius, 0.0f ), center,
-      Eigen::Vector3f( 0.0f, 0.0f, 0.0f ), color_ );
-    nodeIdToVertices_[node_->id( )].push_back( vertex2 );
-
-    auto vertex3 = new nlgeometry::OrbitalVertex(
-      center + Eigen::Vector3f( 0.0f, -radius, 0.0f ), center,
-      Eigen::Vector3f( 0.0f, 0.0f, 0.0f ), color_ );
-    nodeIdToVertices_[node_->id( )].push_back( vertex3 );
-
-    auto vertex4 = new nlgeometry::OrbitalVertex(
-      center + Eigen::Vector3f( 0.0f, 0.0f, radius ), center,
-      Eigen::Vector3f( 0.0f, 0.0f, 0.0f ), color_ );
-    nodeIdToVertices_[node_->id( )].push_back( vertex4 );
-
-    auto vertex5 = new nlgeometry::OrbitalVertex(
-      center + Eigen::Vector3f( 0.0f, 0.0f, -radius ), center,
-      Eigen::Vector3f( 0.0f, 0.0f, 0.0f ), color_ );
-    nodeIdToVertices_[node_->id( )].push_back( vertex5 );
+    auto vertex0 = _structureVertex(
+      mesh_, node_, center + Eigen::Vector3f( radius, 0.0f, 0.0f ), color_ );
+    auto vertex1 = _structureVertex(
+      mesh_, node_, center + Eigen::Vector3f( -radius, 0.0f, 0.0f ), color_ );
+    auto vertex2 = _structureVertex(
+      mesh_, node_, center + Eigen::Vector3f( 0.0f, radius, 0.0f ), color_ );
+    auto vertex3 = _structureVertex(
+      mesh_, node_, center + Eigen::Vector3f( 0.0f, -radius, 0.0f ), color_ );
+    auto vertex4 = _structureVertex(
+      mesh_, node_, center + Eigen::Vector3f( 0.0f, 0.0f, radius ), color_ );
+    auto vertex5 = _structureVertex(
+      mesh_, node_, center + Eigen::Vector3f( 0.0f, 0.0f, -radius ), color_ );
 
     triangles.push_back( new nlgeometry::Facet( vertex2, vertex4, vertex0 ));
     triangles.push_back( new nlgeometry::Facet( vertex2, vertex1, vertex4 ));
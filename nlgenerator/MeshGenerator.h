@@ -26,7 +26,11 @@
 #include <nsol/nsol.h>
 
 #include "../nlgeometry/Mesh.h"
+#include "GenerationContext.h"
+#include "GenerationSink.h"
 #include "JointNode.h"
+#include "MeshCache.h"
+#include "NodeVertexTable.h"
 // #include "VectorizedNode.h"
 // #include "Icosphere.h"
 
@@ -35,9 +39,6 @@
 namespace nlgenerator
 {
 
-  typedef std::unordered_map<
-    unsigned int, std::vector< nlgeometry::OrbitalVertexPtr >> NodeIdToVertices;
-
   typedef std::unordered_map<
     unsigned int, std::vector< unsigned int >> NodeIdToVerticesIds;
 
@@ -47,14 +48,23 @@ namespace nlgenerator
 
   public:
 
+    //! Subdivision level of the icosphere that meshes the soma
+    static const unsigned int somaSubdivisions = 3;
+
     /**
      * Static method that return a mesh generated from the given morphology
      * @param moprholgy_ to be reconstructed
+     * @param context_ context that owns the generation temporaries and
+     * measures its memory, nullptr to use a local one
+     * @param cache_ cache that returns the mesh if it was already generated
+     * and keeps the newly generated ones, nullptr to always generate
      * @return a mesh generated from the given morphology
      */
     NLGENERATOR_API
     static nlgeometry::MeshPtr
-    generateMesh( nsol::MorphologyPtr morphology_ );
+    generateMesh( nsol::MorphologyPtr morphology_,
+                  GenerationContext* context_ = nullptr,
+                  MeshCache* cache_ = nullptr );
 
     /**
      * Static method that return a mesh generated from the given morphology
@@ -63,20 +73,71 @@ namespace nlgenerator
      * @param alphaRadius_ param to change the morphology soma radius
      * @param alphaNeurites_ param to change the distance of the morphology
      * neurites with the morphology soma
+     * @param context_ context that owns the generation temporaries and
+     * measures its memory, nullptr to use a local one
+     * @param cache_ cache that returns the mesh if it was already generated
+     * and keeps the newly generated ones, nullptr to always generate
      * @return a mesh generated from the given morphology
      */
     NLGENERATOR_API
     static nlgeometry::MeshPtr
     generateMesh( nsol::NeuronMorphologyPtr morphology_,
                   float alphaRadius_,
-                  const std::vector< float >& alphaNeurites_ );
+                  const std::vector< float >& alphaNeurites_,
+                  GenerationContext* context_ = nullptr,
+                  MeshCache* cache_ = nullptr );
+
+    /**
+     * Static method that generates the mesh of the given morphology in
+     * batches of sections, writing each batch to the sink and freeing it
+     * before generating the next one, so the memory used depends on the
+     * batch size and not on the morphology size. The joints shared by two
+     * batches are built in both with the same geometry. Neuron morphologies
+     * are written in a single batch, since the soma joins all their neurites
+     * @param moprholgy_ to be reconstructed
+     * @param sink_ sink that receives each generated batch
+     * @param sectionsPerBatch_ maximum number of sections of each batch
+     * @param context_ context that owns the generation temporaries and
+     * measures the memory of the last batch, nullptr to use a local one
+     * @return the number of generated batches
+     */
+    NLGENERATOR_API
+    static unsigned int
+    generateMeshStream( nsol::MorphologyPtr morphology_,
+                        GenerationSink* sink_,
+                        unsigned int sectionsPerBatch_ = 4096,
+                        GenerationContext* context_ = nullptr );
+
+    /**
+     * Static method that return a structure mesh generated from the given
+     * morphology. The generated vertices are listed in the mesh with the
+     * index of their node, and the table is filled from them
+     * @param moprholgy_ to be reconstructed
+     * @param nodeVertexTable_ table filled with the relationship between
+     * morphology nodes index and mesh vertices indices. The indices are the
+     * positions in the mesh vertices, which uploadGPU keeps
+     * @param context_ context that owns the generation temporaries and
+     * measures its memory, nullptr to use a local one
+     * @return a structure mesh generated from the given morphology
+     */
+    NLGENERATOR_API
+    static nlgeometry::MeshPtr
+    generateStructureMesh(
+      nsol::MorphologyPtr morphology_, NodeVertexTable& nodeVertexTable_,
+      Eigen::Vector3f color_ = Eigen::Vector3f( 0.0f, 0.0f, 0.0f),
+      bool generateNodes_ = false,
+      float offset_ = 0.9f,
+      GenerationContext* context_ = nullptr );
 
     /**
      * Static method that return a structure mesh generated from the given
      * morphology
      * @param moprholgy_ to be reconstructed
      * @param nodeToVertices_ structure that keeps the relationship between
-     * morphology nodes index and mesh vertices
+     * morphology nodes index and mesh vertices, derived from the node vertex
+     * table of the mesh
+     * @param context_ context that owns the generation temporaries and
+     * measures its memory, nullptr to use a local one
      * @return a structure mesh generated from the given morphology
      */
     NLGENERATOR_API
@@ -85,7 +146,20 @@ namespace nlgenerator
       nsol::MorphologyPtr morphology_, NodeIdToVertices& nodeIdToVertices_,
       Eigen::Vector3f color_ = Eigen::Vector3f( 0.0f, 0.0f, 0.0f),
       bool generateNodes_ = false,
-      float offset_ = 0.9f );
+      float offset_ = 0.9f,
+      GenerationContext* context_ = nullptr );
+
+    /**
+     * Static method that frees the cpu data of a structure mesh and clears
+     * the node to vertices structure filled with it, as the mesh deletes the
+     * vertices the structure points to
+     * @param mesh_ structure mesh which cpu data is freed
+     * @param nodeIdToVertices_ structure filled by generateStructureMesh
+     */
+    NLGENERATOR_API
+    static void
+    clearCPUData( nlgeometry::MeshPtr mesh_,
+                  NodeIdToVertices& nodeIdToVertices_ );
 
     /**
      * Static method that fill the node index to vertices indices structure
@@ -115,20 +189,62 @@ namespace nlgenerator
                    std::vector< float >& buffer_,
                    Eigen::Vector3f value_ );
 
+    /**
+     * Static method that fills the buffer with the given value for the vertices
+     * related to the given node indices, looking them up in a node vertex
+     * table instead of a hash map
+     * @param nodeIds_ vector of morphology node indices
+     * @param nodeVertexTable_ table with the relationship between morphology
+     * node indices and mesh vertices indices
+     * @param buffer_ float buffer to fill
+     * @param value_ value to insert in the buffer
+     */
+    NLGENERATOR_API
+    static void
+    conformBuffer( const std::vector< unsigned int >& nodeIds_,
+                   const NodeVertexTable& nodeVertexTable_,
+                   std::vector< float >& buffer_,
+                   const Eigen::Vector3f& value_ );
+
+    /**
+     * Static method that sets the given value in the cpu copy of a mesh
+     * attribute for the vertices related to the given node indices. Only the
+     * modified ranges are uploaded on the next Mesh::flushBuffers
+     * @param nodeIds_ vector of morphology node indices
+     * @param nodeVertexTable_ table with the relationship between morphology
+     * node indices and mesh vertices indices
+     * @param mesh_ uploaded mesh that keeps a cpu copy of the attribute
+     * @param value_ value to insert in the attribute
+     * @param type_ attribute to modify
+     */
+    NLGENERATOR_API
+    static void
+    conformBuffer( const std::vector< unsigned int >& nodeIds_,
+                   const NodeVertexTable& nodeVertexTable_,
+                   nlgeometry::MeshPtr mesh_,
+                   const Eigen::Vector3f& value_,
+                   nlgeometry::TAttribType type_ = nlgeometry::COLOR );
+
   protected:
     static nlgeometry::MeshPtr
-    _generateMorphology( nsol::MorphologyPtr morphology_ );
+    _generateMorphology( nsol::MorphologyPtr morphology_,
+                         GenerationContext& context_ );
 
     static nlgeometry::MeshPtr
-    _generateMophology( nsol::NeuronMorphologyPtr morphology_ );
+    _generateMophology( nsol::NeuronMorphologyPtr morphology_,
+                        GenerationContext& context_ );
 
     static std::unordered_map< nsol::NodePtr, JointNodePtr >
-    _vectorizeJoints( const nsol::Sections& sections_ );
+    _vectorizeJoints( const nsol::Sections& sections_,
+                      JointNodes& orderedJoints_,
+                      GenerationContext& context_ );
 
     static void _vectorizeJoints(
       std::set< nsol::SectionPtr>& uniqueSections_,
       const nsol::SectionPtr& section_,
-      std::unordered_map< nsol::NodePtr, JointNodePtr >& joints_ );
+      std::unordered_map< nsol::NodePtr, JointNodePtr >& joints_,
+      JointNodes& orderedJoints_,
+      GenerationContext& context_ );
 
     static nlgeometry::Facets _meshSections(
       const nsol::Sections& sections_,
@@ -140,17 +256,39 @@ namespace nlgenerator
       std::unordered_map< nsol::NodePtr, JointNodePtr >& joints_,
       nlgeometry::Facets& facets_ );
 
+    static void _meshSection(
+      const nsol::SectionPtr& section_,
+      std::unordered_map< nsol::NodePtr, JointNodePtr >& joints_,
+      nlgeometry::Facets& facets_ );
+
+    static void _meshPipe( const nsol::Nodes& nodes_,
+                           nlgeometry::SectionQuadPtr startQuad_,
+                           nlgeometry::SectionQuadPtr endQuad_,
+                           nlgeometry::Facets& facets_ );
+
+    static void _meshEnds( const JointNodes& joints_,
+                           nlgeometry::Facets& facets_ );
+
+    static void _orderSections( const nsol::Sections& sections_,
+                                nsol::Sections& orderedSections_ );
+
     static void _vectorizeSections(
       nlgeometry::MeshPtr mesh_,
       const nsol::SectionPtr section_,
       std::set< nsol::SectionPtr>& uniqueSections_,
-      NodeIdToVertices& nodeIdToVertices_,
+      nsol::Sections& orderedSections_,
+      std::unordered_map< unsigned int,
+                          nlgeometry::OrbitalVertexPtr >& nodeVertices_,
       Eigen::Vector3f color_,
       bool generateNodes_,
       float offset_ );
 
+    static nlgeometry::OrbitalVertexPtr _structureVertex(
+      nlgeometry::MeshPtr mesh_, nsol::NodePtr node_,
+      const Eigen::Vector3f& position_, Eigen::Vector3f color_ );
+
     static nlgeometry::Facets _generateCube(
-      nsol::NodePtr node_, NodeIdToVertices& nodeIdToVertices_,
+      nlgeometry::MeshPtr mesh_, nsol::NodePtr node_,
       Eigen::Vector3f color_, float offset_ );
 
   }; // class MeshGenerator
@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "NodeVertexTable.h"
+
+#include <algorithm>
+
+namespace nlgenerator
+{
+
+  const unsigned int NodeVertexTable::invalidIndex;
+
+  NodeVertexTable::NodeVertexTable( void )
+    : _offsets( 1, 0 )
+  {
+  }
+
+  void NodeVertexTable::build( const nlgeometry::Vertices& vertices_ )
+  {
+    clear( );
+
+    auto nodeOf = []( nlgeometry::VertexPtr vertex_ )
+    {
+      auto orbital = dynamic_cast< nlgeometry::OrbitalVertexPtr >( vertex_ );
+      return orbital ? orbital->nodeId( ) : -1;
+    };
+
+    unsigned int numberVertices = 0;
+    int maxNodeId = -1;
+    for ( auto vertex: vertices_ )
+    {
+      int nodeId = nodeOf( vertex );
+      if ( nodeId >= 0 )
+      {
+        numberVertices++;
+        maxNodeId = std::max( maxNodeId, nodeId );
+      }
+    }
+    if ( numberVertices == 0 )
+      return;
+
+    // Vertices are counted per node and the counts accumulated into the
+    // offsets. The direct lookup is used unless the node indices are too
+    // sparse for it, in which case only the distinct node indices are sorted
+    std::vector< unsigned int > counts;
+    if ( size_t( maxNodeId ) < 4 * size_t( numberVertices ) + 1024 )
+    {
+      counts.assign( size_t( maxNodeId ) + 1, 0 );
+      for ( auto vertex: vertices_ )
+      {
+        int nodeId = nodeOf( vertex );
+        if ( nodeId >= 0 )
+          counts[nodeId]++;
+      }
+      _indices.assign( counts.size( ), invalidIndex );
+      for ( unsigned int nodeId = 0; nodeId < counts.size( ); nodeId++ )
+        if ( counts[nodeId] > 0 )
+        {
+          _indices[nodeId] = ( unsigned int )_nodeIds.size( );
+          _nodeIds.push_back( nodeId );
+          _offsets.push_back( _offsets.back( ) + counts[nodeId] );
+        }
+    }
+    else
+    {
+      for ( auto vertex: vertices_ )
+      {
+        int nodeId = nodeOf( vertex );
+        if ( nodeId >= 0 && ( _nodeIds.empty( ) ||
+                              _nodeIds.back( ) != ( unsigned int )nodeId ))
+          _nodeIds.push_back(( unsigned int )nodeId );
+      }
+      std::sort( _nodeIds.begin( ), _nodeIds.end( ));
+      _nodeIds.erase( std::unique( _nodeIds.begin( ), _nodeIds.end( )),
+                      _nodeIds.end( ));
+      counts.assign( _nodeIds.size( ), 0 );
+      for ( auto vertex: vertices_ )
+      {
+        int nodeId = nodeOf( vertex );
+        if ( nodeId >= 0 )
+          counts[index(( unsigned int )nodeId )]++;
+      }
+      for ( auto count: counts )
+        _offsets.push_back( _offsets.back( ) + count );
+    }
+
+    // Each vertex is placed after the previous ones of its node, keeping
+    // their relative order
+    std::vector< unsigned int > cursors( _offsets.begin( ),
+                                         _offsets.end( ) - 1 );
+    _vertexIds.resize( _offsets.back( ));
+    for ( unsigned int i = 0; i < vertices_.size( ); i++ )
+    {
+      int nodeId = nodeOf( vertices_[i] );
+      if ( nodeId >= 0 )
+        _vertexIds[cursors[index(( unsigned int )nodeId )]++] = i;
+    }
+  }
+
+  void NodeVertexTable::clear( void )
+  {
+    _nodeIds.clear( );
+    _offsets.assign( 1, 0 );
+    _vertexIds.clear( );
+    _indices.clear( );
+  }
+
+  unsigned int NodeVertexTable::index( unsigned int nodeId_ ) const
+  {
+    if ( !_indices.empty( ))
+      return nodeId_ < _indices.size( ) ? _indices[nodeId_] : invalidIndex;
+
+    auto position =
+      std::lower_bound( _nodeIds.begin( ), _nodeIds.end( ), nodeId_ );
+    if ( position == _nodeIds.end( ) || *position != nodeId_ )
+      return invalidIndex;
+    return ( unsigned int )( position - _nodeIds.begin( ));
+  }
+
+  unsigned int NodeVertexTable::numberNodes( void ) const
+  {
+    return ( unsigned int )_nodeIds.size( );
+  }
+
+  const std::vector< unsigned int >& NodeVertexTable::nodeIds( void ) const
+  {
+    return _nodeIds;
+  }
+
+  const std::vector< unsigned int >& NodeVertexTable::offsets( void ) const
+  {
+    return _offsets;
+  }
+
+  const std::vector< unsigned int >& NodeVertexTable::vertexIds( void ) const
+  {
+    return _vertexIds;
+  }
+
+} // namespace nlgenerator
@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLGENERATOR_NODE_VERTEX_TABLE__
+#define __NLGENERATOR_NODE_VERTEX_TABLE__
+
+#include "../nlgeometry/OrbitalVertex.h"
+
+#include <unordered_map>
+#include <vector>
+
+#include <nlgenerator/api.h>
+
+namespace nlgenerator
+{
+
+  typedef std::unordered_map<
+    unsigned int, std::vector< nlgeometry::OrbitalVertexPtr >> NodeIdToVertices;
+
+  /*! \class NodeVertexTable
+   * Compressed relationship between morphology node indices and mesh vertex
+   * indices. The vertex indices of the node with dense index i are
+   * vertexIds( )[offsets( )[i]] to vertexIds( )[offsets( )[i+1]-1]
+   */
+  class NodeVertexTable
+  {
+
+  public:
+
+    //! Dense index returned for nodes without vertices
+    static const unsigned int invalidIndex = ~0u;
+
+    /**
+     * Default constructor, an empty table
+     */
+    NLGENERATOR_API
+    NodeVertexTable( void );
+
+    /**
+     * Method that builds the table from the node indices of the given
+     * vertices, using their positions as vertex indices. Vertices of each
+     * node keep their relative order and non orbital vertices or vertices
+     * without node are skipped
+     * @param vertices_ mesh vertices, in the order they are uploaded
+     */
+    NLGENERATOR_API
+    void build( const nlgeometry::Vertices& vertices_ );
+
+    /**
+     * Method that empties the table
+     */
+    NLGENERATOR_API
+    void clear( void );
+
+    /**
+     * Method that returns the dense index of a morphology node
+     * @param nodeId_ morphology node index
+     * @return the dense index of the node or invalidIndex if it has no
+     * vertices
+     */
+    NLGENERATOR_API
+    unsigned int index( unsigned int nodeId_ ) const;
+
+    /**
+     * Method that returns the number of nodes of the table
+     * @return the number of nodes of the table
+     */
+    NLGENERATOR_API
+    unsigned int numberNodes( void ) const;
+
+    /**
+     * Method that returns the morphology node index of every dense index, in
+     * increasing order
+     * @return the morphology node indices
+     */
+    NLGENERATOR_API
+    const std::vector< unsigned int >& nodeIds( void ) const;
+
+    /**
+     * Method that returns the first position in vertexIds of every dense
+     * index, followed by the total number of vertex indices
+     * @return the offsets of the nodes in the vertex indices
+     */
+    NLGENERATOR_API
+    const std::vector< unsigned int >& offsets( void ) const;
+
+    /**
+     * Method that returns the vertex indices of all nodes
+     * @return the vertex indices of all nodes
+     */
+    NLGENERATOR_API
+    const std::vector< unsigned int >& vertexIds( void ) const;
+
+  protected:
+
+    //! Morphology node index of each dense index
+    std::vector< unsigned int > _nodeIds;
+
+    //! Offsets of each dense index in the vertex indices
+    std::vector< unsigned int > _offsets;
+
+    //! Vertex indices grouped by node
+    std::vector< unsigned int > _vertexIds;
+
+    //! Dense index of each morphology node index, empty if they are sparse
+    std::vector< unsigned int > _indices;
+
+  }; // class NodeVertexTable
+
+} // namespace nlgenerator
+
+#endif
@@ -0,0 +1,152 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "Resampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace nlgenerator
+{
+
+  unsigned int Resampler::resample( nsol::MorphologyPtr morphology_,
+                                    float maxAngle_, float maxRadiusChange_ )
+  {
+    nsol::Sections sections;
+    nsol::NeuronMorphologyPtr neuronMorphology =
+      dynamic_cast< nsol::NeuronMorphologyPtr >( morphology_ );
+    if ( neuronMorphology )
+    {
+      for ( auto neurite: neuronMorphology->neurites( ))
+        sections.push_back( neurite->firstSection( ));
+    }
+    else
+      sections = morphology_->sections( );
+
+    unsigned int removed = 0;
+    std::set< nsol::SectionPtr > uniqueSections;
+    for ( auto section: sections )
+      removed += _resample( uniqueSections, section, maxAngle_,
+                            maxRadiusChange_ );
+    return removed;
+  }
+
+  unsigned int Resampler::resample( nsol::SectionPtr section_,
+                                    float maxAngle_, float maxRadiusChange_ )
+  {
+    nsol::Nodes& nodes = section_->nodes( );
+    unsigned int numNodes = static_cast< unsigned int >( nodes.size( ));
+    if ( numNodes < 3 )
+      return 0;
+
+    // Each kept node starts a segment extended while its intermediate nodes
+    // can be merged, the last node that keeps it mergeable is kept next
+    nsol::Nodes resampled;
+    resampled.push_back( nodes.front( ));
+    unsigned int first = 0;
+    unsigned int last = 2;
+    while ( last < numNodes )
+    {
+      if ( !_mergeable( nodes, first, last, maxAngle_, maxRadiusChange_ ))
+      {
+        first = last - 1;
+        resampled.push_back( nodes[ first ]);
+      }
+      last++;
+    }
+    resampled.push_back( nodes.back( ));
+
+    unsigned int removed = numNodes - ( unsigned int ) resampled.size( );
+    if ( removed > 0 )
+    {
+      std::set< nsol::NodePtr > kept( resampled.begin( ), resampled.end( ));
+      for ( auto node: nodes )
+        if ( kept.find( node ) == kept.end( ))
+          delete node;
+      nodes = resampled;
+    }
+    return removed;
+  }
+
+  unsigned int Resampler::_resample(
+    std::set< nsol::SectionPtr >& uniqueSections_,
+    const nsol::SectionPtr& section_, float maxAngle_, float maxRadiusChange_ )
+  {
+    unsigned int removed = 0;
+    if ( uniqueSections_.find( section_ ) == uniqueSections_.end( ))
+    {
+      uniqueSections_.insert( section_ );
+      removed += resample( section_, maxAngle_, maxRadiusChange_ );
+      for ( auto nextSection: section_->backwardNeighbors( ))
+        removed += _resample( uniqueSections_, nextSection, maxAngle_,
+                              maxRadiusChange_ );
+      for ( auto nextSection: section_->forwardNeighbors( ))
+        removed += _resample( uniqueSections_, nextSection, maxAngle_,
+                              maxRadiusChange_ );
+    }
+    return removed;
+  }
+
+  bool Resampler::_mergeable( const nsol::Nodes& nodes_, unsigned int first_,
+                              unsigned int last_, float maxAngle_,
+                              float maxRadiusChange_ )
+  {
+    Eigen::Vector3f start = nodes_[ first_ ]->point( );
+    Eigen::Vector3f end = nodes_[ last_ ]->point( );
+    Eigen::Vector3f axis = end - start;
+    float length = axis.norm( );
+    if ( length <= 0.0f )
+      return false;
+    axis /= length;
+
+    float minCos = std::cos( maxAngle_ );
+    float startRadius = nodes_[ first_ ]->radius( );
+    float endRadius = nodes_[ last_ ]->radius( );
+
+    // Arc length parameter of each intermediate node for the radius
+    float totalDist = 0.0f;
+    for ( unsigned int i = first_ + 1; i <= last_; i++ )
+      totalDist += ( nodes_[i]->point( ) - nodes_[i-1]->point( )).norm( );
+
+    float dist = 0.0f;
+    for ( unsigned int i = first_ + 1; i < last_; i++ )
+    {
+      Eigen::Vector3f point = nodes_[i]->point( );
+      dist += ( point - nodes_[i-1]->point( )).norm( );
+
+      Eigen::Vector3f toPoint = point - start;
+      Eigen::Vector3f fromPoint = end - point;
+      if ( toPoint.norm( ) <= 0.0f || fromPoint.norm( ) <= 0.0f ||
+           toPoint.normalized( ).dot( axis ) < minCos ||
+           fromPoint.normalized( ).dot( axis ) < minCos )
+        return false;
+
+      float t = totalDist > 0.0f ? dist / totalDist : 0.0f;
+      float radius = startRadius * ( 1.0f - t ) + endRadius * t;
+      float nodeRadius = nodes_[i]->radius( );
+      if ( std::abs( nodeRadius - radius ) >
+           maxRadiusChange_ * std::max( nodeRadius, radius ))
+        return false;
+    }
+    return true;
+  }
+
+} // namespace nlgenerator
@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLGENERATOR_RESAMPLER__
+#define __NLGENERATOR_RESAMPLER__
+
+#include <nsol/nsol.h>
+
+#include <set>
+
+#include <nlgenerator/api.h>
+
+namespace nlgenerator
+{
+
+  /* \class Resampler
+   * Removes the section nodes that do not change the generated pipes, before
+   * meshing a morphology. Each section node becomes a ring of quads, so
+   * merging the nodes of straight segments with smooth radius reduces the
+   * control mesh. The first and last nodes of the sections, which are the
+   * bifurcations and terminals, are always kept
+   */
+  class Resampler
+  {
+
+  public:
+
+    /**
+     * Static method that resamples all the sections of the given morphology
+     * @param morphology_ morphology to resample
+     * @param maxAngle_ maximum angle in radians between the direction of a
+     * merged segment and the directions to each of its removed nodes
+     * @param maxRadiusChange_ maximum relative difference between the radius
+     * of a removed node and the radius interpolated along the merged segment
+     * @return the number of nodes removed
+     */
+    NLGENERATOR_API
+    static unsigned int resample( nsol::MorphologyPtr morphology_,
+                                  float maxAngle_ = 0.1f,
+                                  float maxRadiusChange_ = 0.1f );
+
+    /**
+     * Static method that resamples the nodes of a section. The removed nodes
+     * are deleted, the intermediate nodes of a section are only referenced
+     * by it
+     * @param section_ section to resample
+     * @param maxAngle_ maximum angle in radians between the direction of a
+     * merged segment and the directions to each of its removed nodes
+     * @param maxRadiusChange_ maximum relative difference between the radius
+     * of a removed node and the radius interpolated along the merged segment
+     * @return the number of nodes removed
+     */
+    NLGENERATOR_API
+    static unsigned int resample( nsol::SectionPtr section_,
+                                  float maxAngle_ = 0.1f,
+                                  float maxRadiusChange_ = 0.1f );
+
+  protected:
+
+    static unsigned int _resample( std::set< nsol::SectionPtr >& uniqueSections_,
+                                   const nsol::SectionPtr& section_,
+                                   float maxAngle_, float maxRadiusChange_ );
+
+    static bool _mergeable( const nsol::Nodes& nodes_, unsigned int first_,
+                            unsigned int last_, float maxAngle_,
+                            float maxRadiusChange_ );
+
+  }; // class Resampler
+
+} // namespace nlgenerator
+
+#endif
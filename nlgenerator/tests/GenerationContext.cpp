@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <nlgenerator/nlgenerator.h>
+#include <nsol/nsol.h>
+#include "nlgeneratorTests.h"
+
+using namespace nlgenerator;
+
+BOOST_AUTO_TEST_CASE( generationContext_release )
+{
+  auto node0 = new nsol::Node( Eigen::Vector3f( 0.0f, 0.0f, 0.0f ), 0, 1.0f );
+  auto node1 = new nsol::Node( Eigen::Vector3f( 1.0f, 0.0f, 0.0f ), 1, 1.0f );
+  auto section = new nsol::NeuronMorphologySection( );
+  section->addNode( node1 );
+
+  GenerationContext context;
+  context.begin( );
+  auto joint = context.joint( Eigen::Vector3f::Zero( ), 1.0f );
+  joint->addNeighbour( node1 );
+  joint->computeGeometry( );
+  context.addBackwardNode( section, node0 );
+  BOOST_CHECK_EQUAL( section->nodes( ).size( ), 2 );
+  BOOST_CHECK( context.temporaryBytes( ) > 0 );
+
+  auto mesh = new nlgeometry::Mesh( );
+  auto quad = joint->sectionQuad( );
+  mesh->quads( ).push_back( new nlgeometry::Facet(
+    quad->vertex0( ), quad->vertex1( ), quad->vertex2( ), quad->vertex3( )));
+  context.end( mesh );
+
+  // The added node is removed and deleted, the morphology is unchanged
+  BOOST_REQUIRE_EQUAL( section->nodes( ).size( ), 1 );
+  BOOST_CHECK_EQUAL( section->nodes( )[0], node1 );
+  BOOST_CHECK_EQUAL( context.temporaryBytes( ), 0 );
+  BOOST_CHECK_EQUAL( context.retainedBytes( ),
+                     GenerationContext::meshBytes( mesh ));
+  BOOST_CHECK( context.peakBytes( ) > context.retainedBytes( ));
+
+  context.begin( );
+  BOOST_CHECK_EQUAL( context.peakBytes( ), 0 );
+
+  delete mesh;
+  delete section;
+  delete node1;
+}
+
+BOOST_AUTO_TEST_CASE( generationContext_meshBytes )
+{
+  auto mesh = new nlgeometry::Mesh( );
+  BOOST_CHECK_EQUAL( GenerationContext::meshBytes( mesh ), 0 );
+
+  auto vertex0 = new nlgeometry::Vertex( Eigen::Vector3f( 0.0f, 0.0f, 0.0f ));
+  auto vertex1 = new nlgeometry::Vertex( Eigen::Vector3f( 1.0f, 0.0f, 0.0f ));
+  auto vertex2 = new nlgeometry::Vertex( Eigen::Vector3f( 0.0f, 1.0f, 0.0f ));
+  mesh->triangles( ).push_back(
+    new nlgeometry::Facet( vertex0, vertex1, vertex2 ));
+  size_t triangle = GenerationContext::meshBytes( mesh );
+  BOOST_CHECK( triangle > 0 );
+
+  // Shared vertices are only counted once
+  mesh->triangles( ).push_back(
+    new nlgeometry::Facet( vertex2, vertex1, vertex0 ));
+  size_t triangles = GenerationContext::meshBytes( mesh );
+  BOOST_CHECK( triangles > triangle );
+  BOOST_CHECK( triangles < 2 * triangle );
+  delete mesh;
+}
@@ -25,6 +25,8 @@
 #include "nlgeneratorTests.h"
 #include <boost/test/floating_point_comparison.hpp>
 
+#include <sstream>
+
 using namespace nlgenerator;
 
 BOOST_AUTO_TEST_CASE( joint_constructor )
@@ -49,3 +51,103 @@ BOOST_AUTO_TEST_CASE( joint_compute_geometry)
   delete node0;
   delete node1;
 }
+
+BOOST_AUTO_TEST_CASE( joint_neighbour_order )
+{
+  auto node0 = new nsol::Node( Eigen::Vector3f( -1.0f, 0.0f, 0.0f ), 0, 1.0f );
+  auto node1 = new nsol::Node( Eigen::Vector3f( 1.0f, 0.5f, 0.0f ), 1, 1.0f );
+  auto node2 = new nsol::Node( Eigen::Vector3f( 1.0f, -0.5f, 0.5f ), 2, 1.0f );
+  JointNode joint( Eigen::Vector3f::Zero( ), 0.2f );
+  joint.addNeighbour( node2 );
+  joint.addNeighbour( node0 );
+  joint.addNeighbour( node1 );
+  joint.addNeighbour( node0 );
+  BOOST_CHECK_EQUAL( joint.numberNeighbors( ), 3 );
+  BOOST_CHECK_EQUAL( joint.neighbour( ), node0 );
+
+  // The geometry does not depend on the insertion order
+  JointNode other( Eigen::Vector3f::Zero( ), 0.2f );
+  other.addNeighbour( node0 );
+  other.addNeighbour( node1 );
+  other.addNeighbour( node2 );
+  joint.computeGeometry( );
+  other.computeGeometry( );
+  for ( auto node: { node0, node1, node2 })
+  {
+    auto quad = joint.sectionQuad( node );
+    auto otherQuad = other.sectionQuad( node );
+    BOOST_REQUIRE( quad && otherQuad );
+    BOOST_CHECK_EQUAL( quad->vertex1( )->position( ),
+                       otherQuad->vertex1( )->position( ));
+    BOOST_CHECK_EQUAL( quad->vertex3( )->position( ),
+                       otherQuad->vertex3( )->position( ));
+  }
+  delete node0;
+  delete node1;
+  delete node2;
+}
+
+// Branched morphology whose nodes are allocated in index order, or in
+// reverse order between dummy allocations so their addresses are not sorted
+// as the first time
+static std::string generateBranched( bool reverse_ )
+{
+  const std::vector< Eigen::Vector3f > positions = {
+    Eigen::Vector3f( 0.0f, 0.0f, 0.0f ), Eigen::Vector3f( 1.0f, 0.2f, 0.0f ),
+    Eigen::Vector3f( 2.0f, 0.3f, 0.1f ), Eigen::Vector3f( 3.0f, 1.2f, 0.2f ),
+    Eigen::Vector3f( 4.0f, 2.0f, 0.5f ), Eigen::Vector3f( 3.0f, -0.8f, 0.3f ),
+    Eigen::Vector3f( 4.0f, -1.5f, -0.2f ), Eigen::Vector3f( -1.0f, 0.1f, 0.4f ),
+    Eigen::Vector3f( -2.0f, -0.2f, 0.9f )};
+  const std::vector< std::vector< unsigned int >> sections = {
+    { 0, 1, 2 }, { 2, 3, 4 }, { 2, 5, 6 }, { 0, 7, 8 }};
+
+  std::vector< nsol::NodePtr > nodes( positions.size( ), nullptr );
+  std::vector< nsol::NodePtr > dummies;
+  for ( unsigned int i = 0; i < positions.size( ); i++ )
+  {
+    unsigned int index = reverse_ ? ( unsigned int )positions.size( ) - 1 - i :
+      i;
+    if ( reverse_ )
+      dummies.push_back( new nsol::Node( Eigen::Vector3f::Zero( ), -1,
+                                         1.0f ));
+    nodes[index] = new nsol::Node( positions[index], int( index ),
+                                   0.3f + 0.02f * float( index ));
+  }
+
+  nsol::Morphology morphology;
+  for ( const auto& sectionNodes: sections )
+  {
+    auto section = new nsol::NeuronMorphologySection( );
+    for ( auto index: sectionNodes )
+      section->addNode( nodes[index] );
+    morphology.sections( ).push_back( section );
+  }
+
+  auto mesh = MeshGenerator::generateMesh( &morphology );
+  BOOST_CHECK( mesh->quads( ).size( ) > 0 );
+  std::stringstream stream;
+  MeshCache::writeMesh( stream, mesh );
+  delete mesh;
+
+  for ( auto section: morphology.sections( ))
+  {
+    section->nodes( ).clear( );
+    delete section;
+  }
+  morphology.sections( ).clear( );
+  for ( auto node: nodes )
+    delete node;
+  for ( auto node: dummies )
+    delete node;
+  return stream.str( );
+}
+
+BOOST_AUTO_TEST_CASE( joint_reproducible_generation )
+{
+  // The generated mesh does not depend on the node addresses
+  std::string first = generateBranched( false );
+  std::string second = generateBranched( true );
+  BOOST_CHECK( !first.empty( ));
+  BOOST_CHECK_EQUAL( first.size( ), second.size( ));
+  BOOST_CHECK( first == second );
+}
@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <nlgenerator/nlgenerator.h>
+#include <nsol/nsol.h>
+#include "nlgeneratorTests.h"
+
+#include <boost/filesystem.hpp>
+#include <sstream>
+
+using namespace nlgenerator;
+
+static nlgeometry::MeshPtr cacheTestMesh( void )
+{
+  auto mesh = new nlgeometry::Mesh( );
+  auto vertex0 = new nlgeometry::OrbitalVertex(
+    Eigen::Vector3f( 0.0f, 0.0f, 0.0f ), Eigen::Vector3f( 0.0f, 0.0f, 1.0f ));
+  auto vertex1 = new nlgeometry::OrbitalVertex(
+    Eigen::Vector3f( 1.0f, 0.0f, 0.0f ), Eigen::Vector3f( 0.0f, 0.0f, 1.0f ));
+  vertex1->nodeId( ) = 5;
+  auto vertex2 = new nlgeometry::OrbitalVertex(
+    Eigen::Vector3f( 1.0f, 1.0f, 0.0f ), Eigen::Vector3f( 0.0f, 0.0f, 1.0f ));
+  auto vertex3 = new nlgeometry::Vertex( Eigen::Vector3f( 0.0f, 1.0f, 0.0f ));
+  mesh->lines( ).push_back( new nlgeometry::Facet( vertex0, vertex1 ));
+  mesh->triangles( ).push_back(
+    new nlgeometry::Facet( vertex0, vertex1, vertex2 ));
+  mesh->quads( ).push_back(
+    new nlgeometry::Facet( vertex0, vertex1, vertex2, vertex3 ));
+  return mesh;
+}
+
+BOOST_AUTO_TEST_CASE( meshCache_binary )
+{
+  auto mesh = cacheTestMesh( );
+  std::stringstream stream;
+  MeshCache::writeMesh( stream, mesh );
+
+  auto read = MeshCache::readMesh( stream );
+  BOOST_REQUIRE( read );
+  BOOST_REQUIRE_EQUAL( read->lines( ).size( ), 1 );
+  BOOST_REQUIRE_EQUAL( read->triangles( ).size( ), 1 );
+  BOOST_REQUIRE_EQUAL( read->quads( ).size( ), 1 );
+  auto quad = read->quads( )[0];
+  BOOST_CHECK_EQUAL( quad->vertex0( ), read->lines( )[0]->vertex0( ));
+  BOOST_CHECK_EQUAL( quad->vertex2( ), read->triangles( )[0]->vertex2( ));
+  BOOST_CHECK_EQUAL( quad->vertex2( )->position( ),
+                     Eigen::Vector3f( 1.0f, 1.0f, 0.0f ));
+  auto orbitalVertex =
+    dynamic_cast< nlgeometry::OrbitalVertexPtr >( quad->vertex1( ));
+  BOOST_REQUIRE( orbitalVertex );
+  BOOST_CHECK_EQUAL( orbitalVertex->center( ),
+                     Eigen::Vector3f( 0.0f, 0.0f, 1.0f ));
+  BOOST_CHECK_EQUAL( orbitalVertex->nodeId( ), 5 );
+  BOOST_CHECK( !dynamic_cast< nlgeometry::OrbitalVertexPtr >(
+                 quad->vertex3( )));
+
+  // Truncated streams are rejected
+  std::string data = stream.str( );
+  std::stringstream truncated( data.substr( 0, data.size( ) - 8 ));
+  BOOST_CHECK( !MeshCache::readMesh( truncated ));
+
+  delete read;
+  delete mesh;
+}
+
+BOOST_AUTO_TEST_CASE( meshCache_store )
+{
+  auto directory = boost::filesystem::temp_directory_path( ) /
+    boost::filesystem::unique_path( "nlgenerator-cache-%%%%-%%%%" );
+  {
+    MeshCache cache( directory.string( ));
+    BOOST_CHECK( !cache.load( "missing" ));
+
+    auto mesh = cacheTestMesh( );
+    BOOST_CHECK( cache.store( "mesh0", mesh ));
+    auto loaded = cache.load( "mesh0" );
+    BOOST_REQUIRE( loaded );
+    BOOST_CHECK_EQUAL( loaded->quads( ).size( ), 1 );
+    unsigned long long size = cache.bytes( );
+    BOOST_CHECK( size > 0 );
+
+    // The least recently used mesh is evicted over the size limit
+    MeshCache smallCache( directory.string( ), size );
+    boost::filesystem::last_write_time(
+      directory / "mesh0.nlmc", std::time( nullptr ) - 60 );
+    BOOST_CHECK( smallCache.store( "mesh1", mesh ));
+    BOOST_CHECK( !smallCache.load( "mesh0" ));
+    auto recent = smallCache.load( "mesh1" );
+    BOOST_CHECK( recent );
+    BOOST_CHECK_EQUAL( smallCache.bytes( ), size );
+
+    delete recent;
+    delete loaded;
+    delete mesh;
+  }
+  boost::filesystem::remove_all( directory );
+}
+
+BOOST_AUTO_TEST_CASE( meshCache_key )
+{
+  auto node0 = new nsol::Node( Eigen::Vector3f( 0.0f, 0.0f, 0.0f ), 0, 1.0f );
+  auto node1 = new nsol::Node( Eigen::Vector3f( 1.0f, 0.0f, 0.0f ), 1, 1.0f );
+  auto section = new nsol::NeuronMorphologySection( );
+  section->addNode( node0 );
+  section->addNode( node1 );
+  nsol::Morphology morphology;
+  morphology.sections( ).push_back( section );
+
+  auto directory = boost::filesystem::temp_directory_path( ) /
+    boost::filesystem::unique_path( "nlgenerator-cache-%%%%-%%%%" );
+  {
+    MeshCache cache( directory.string( ));
+    MeshCache otherCache( directory.string( ), 1024, "simplified" );
+    auto key = cache.key( &morphology );
+    BOOST_CHECK_EQUAL( key, cache.key( &morphology ));
+    BOOST_CHECK( key != otherCache.key( &morphology ));
+
+    node1->point( ).x( ) = 2.0f;
+    BOOST_CHECK( key != cache.key( &morphology ));
+  }
+  boost::filesystem::remove_all( directory );
+
+  morphology.sections( ).clear( );
+  delete section;
+  delete node0;
+  delete node1;
+}
@@ -0,0 +1,393 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <nlgenerator/nlgenerator.h>
+#include <nsol/nsol.h>
+#include "nlgeneratorTests.h"
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace nlgenerator;
+
+// Obj sink that also counts the facet vertices of each batch
+class CheckedObjSink : public ObjGenerationSink
+{
+public:
+
+  CheckedObjSink( const std::string& fileName_ )
+    : ObjGenerationSink( fileName_ )
+    , batches( 0 )
+    , quads( 0 )
+    , vertices( 0 )
+  {
+  }
+
+  void write( nlgeometry::MeshPtr batch_ )
+  {
+    std::set< nlgeometry::VertexPtr > batchVertices;
+    for ( auto quad: batch_->quads( ))
+      batchVertices.insert( { quad->vertex0( ), quad->vertex1( ),
+                              quad->vertex2( ), quad->vertex3( )});
+    batches++;
+    quads += ( unsigned int )batch_->quads( ).size( );
+    vertices += ( unsigned int )batchVertices.size( );
+    ObjGenerationSink::write( batch_ );
+  }
+
+  unsigned int batches;
+  unsigned int quads;
+  unsigned int vertices;
+};
+
+// Binary sink that also keeps the quad corners of each batch
+class CheckedBinarySink : public BinaryGenerationSink
+{
+public:
+
+  CheckedBinarySink( const std::string& fileName_ )
+    : BinaryGenerationSink( fileName_ )
+  {
+  }
+
+  void write( nlgeometry::MeshPtr batch_ )
+  {
+    std::vector< Eigen::Vector3f > batchCorners;
+    std::set< nlgeometry::VertexPtr > batchVertices;
+    for ( auto quad: batch_->quads( ))
+      for ( auto vertex: { quad->vertex0( ), quad->vertex1( ),
+                           quad->vertex2( ), quad->vertex3( )})
+      {
+        batchCorners.push_back( vertex->position( ));
+        batchVertices.insert( vertex );
+      }
+    corners.push_back( batchCorners );
+    vertices.push_back(( unsigned int )batchVertices.size( ));
+    BinaryGenerationSink::write( batch_ );
+  }
+
+  std::vector< std::vector< Eigen::Vector3f >> corners;
+  std::vector< unsigned int > vertices;
+};
+
+// Checks that every face of an obj file refers to a written vertex
+static void checkObjFile( const std::string& fileName_,
+                          unsigned int vertices_, unsigned int triangles_ )
+{
+  std::ifstream stream( fileName_.c_str( ));
+  std::string line;
+  unsigned int vertices = 0;
+  unsigned int normals = 0;
+  unsigned int triangles = 0;
+  while ( std::getline( stream, line ))
+  {
+    if ( line.compare( 0, 2, "v " ) == 0 )
+      vertices++;
+    else if ( line.compare( 0, 3, "vn " ) == 0 )
+      normals++;
+    else if ( line.compare( 0, 2, "f " ) == 0 )
+    {
+      triangles++;
+      std::istringstream face( line.substr( 2 ));
+      std::string corner;
+      while ( face >> corner )
+      {
+        unsigned int index = std::stoul( corner.substr( 0, corner.find( '/' )));
+        BOOST_CHECK( index >= 1 && index <= vertices );
+      }
+    }
+  }
+  BOOST_CHECK_EQUAL( vertices, vertices_ );
+  BOOST_CHECK_EQUAL( normals, vertices_ );
+  BOOST_CHECK_EQUAL( triangles, triangles_ );
+}
+
+// Star of four sections sharing their first node
+static void starMorphology( nsol::Morphology& morphology_,
+                            std::vector< nsol::NodePtr >& nodes_ )
+{
+  auto center = new nsol::Node( Eigen::Vector3f::Zero( ), 0, 0.5f );
+  nodes_.push_back( center );
+  for ( unsigned int i = 0; i < 4; i++ )
+  {
+    auto section = new nsol::NeuronMorphologySection( );
+    section->addNode( center );
+    Eigen::Vector3f direction( i == 0 ? 1.0f : ( i == 1 ? -1.0f : 0.0f ),
+                               i == 2 ? 1.0f : ( i == 3 ? -1.0f : 0.0f ),
+                               0.0f );
+    for ( unsigned int j = 1; j < 4; j++ )
+    {
+      auto node = new nsol::Node( direction * float( j ),
+                                  int( nodes_.size( )), 0.5f );
+      nodes_.push_back( node );
+      section->addNode( node );
+    }
+    morphology_.sections( ).push_back( section );
+  }
+}
+
+static void freeMorphology( nsol::Morphology& morphology_,
+                            std::vector< nsol::NodePtr >& nodes_ )
+{
+  for ( auto section: morphology_.sections( ))
+  {
+    section->nodes( ).clear( );
+    delete section;
+  }
+  morphology_.sections( ).clear( );
+  for ( auto node: nodes_ )
+    delete node;
+}
+
+BOOST_AUTO_TEST_CASE( meshGenerator_stream )
+{
+  std::vector< nsol::NodePtr > nodes;
+  nsol::Morphology morphology;
+  starMorphology( morphology, nodes );
+
+  auto mesh = MeshGenerator::generateMesh( &morphology );
+  unsigned int quads = ( unsigned int )mesh->quads( ).size( );
+  BOOST_CHECK( quads > 0 );
+  delete mesh;
+
+  std::string fileName( "meshGenerator_stream.obj" );
+  {
+    CheckedObjSink single( fileName );
+    BOOST_CHECK_EQUAL(
+      MeshGenerator::generateMeshStream( &morphology, &single ), 1 );
+    BOOST_CHECK_EQUAL( single.quads, quads );
+    BOOST_CHECK( single.vertices > 0 );
+    single.writer( ).close( );
+    checkObjFile( fileName, single.vertices, quads * 2 );
+  }
+
+  // The joint shared by the batches is rebuilt in each one, and each batch
+  // writes the vertices of its own facets
+  {
+    CheckedObjSink batched( fileName );
+    GenerationContext context;
+    BOOST_CHECK_EQUAL(
+      MeshGenerator::generateMeshStream( &morphology, &batched, 1, &context ),
+      4 );
+    BOOST_CHECK_EQUAL( batched.batches, 4 );
+    BOOST_CHECK_EQUAL( batched.quads, quads );
+    BOOST_CHECK_EQUAL( batched.writer( ).vertices( ), batched.vertices );
+    BOOST_CHECK_EQUAL( context.temporaryBytes( ), 0 );
+    batched.writer( ).close( );
+    checkObjFile( fileName, batched.vertices, quads * 2 );
+  }
+  std::remove( fileName.c_str( ));
+
+  freeMorphology( morphology, nodes );
+}
+
+BOOST_AUTO_TEST_CASE( meshGenerator_streamBinary )
+{
+  std::vector< nsol::NodePtr > nodes;
+  nsol::Morphology morphology;
+  starMorphology( morphology, nodes );
+
+  auto mesh = MeshGenerator::generateMesh( &morphology );
+  unsigned int quads = ( unsigned int )mesh->quads( ).size( );
+  delete mesh;
+
+  std::string fileName( "meshGenerator_streamBinary.nlmc" );
+  CheckedBinarySink* sink = new CheckedBinarySink( fileName );
+  BOOST_CHECK_EQUAL(
+    MeshGenerator::generateMeshStream( &morphology, sink, 1 ), 4 );
+  BOOST_CHECK_EQUAL( sink->batches( ), 4 );
+  auto corners = sink->corners;
+  auto vertices = sink->vertices;
+  delete sink;
+
+  // Each batch is read back on its own, its indices referring to the
+  // vertices written with it
+  std::ifstream stream( fileName.c_str( ), std::ios::binary );
+  unsigned int batches = 0;
+  unsigned int readQuads = 0;
+  unsigned int readVertices = 0;
+  while ( auto batch = MeshCache::readMesh( stream ))
+  {
+    BOOST_REQUIRE( batches < corners.size( ));
+    BOOST_REQUIRE_EQUAL( batch->quads( ).size( ) * 4,
+                         corners[batches].size( ));
+    std::set< nlgeometry::VertexPtr > batchVertices;
+    unsigned int corner = 0;
+    for ( auto quad: batch->quads( ))
+      for ( auto vertex: { quad->vertex0( ), quad->vertex1( ),
+                           quad->vertex2( ), quad->vertex3( )})
+      {
+        BOOST_CHECK_EQUAL( vertex->position( ),
+                           corners[batches][corner++] );
+        batchVertices.insert( vertex );
+      }
+    BOOST_CHECK_EQUAL( batchVertices.size( ), vertices[batches] );
+    readQuads += ( unsigned int )batch->quads( ).size( );
+    readVertices += ( unsigned int )batchVertices.size( );
+    batches++;
+    delete batch;
+  }
+  BOOST_CHECK_EQUAL( batches, 4 );
+  BOOST_CHECK_EQUAL( readQuads, quads );
+  BOOST_CHECK_EQUAL( readVertices, std::accumulate( vertices.begin( ),
+                                                     vertices.end( ), 0u ));
+  stream.close( );
+  std::remove( fileName.c_str( ));
+
+  freeMorphology( morphology, nodes );
+}
+
+// Angle between the axes of two ring vertices seen along a tangent
+static float ringAngle( nlgeometry::OrbitalVertexPtr vertex0_,
+                        nlgeometry::OrbitalVertexPtr vertex1_,
+                        const Eigen::Vector3f& tangent_ )
+{
+  Eigen::Vector3f axis0 = vertex0_->position( ) - vertex0_->center( );
+  Eigen::Vector3f axis1 = vertex1_->position( ) - vertex1_->center( );
+  axis0 = ( axis0 - axis0.dot( tangent_ ) * tangent_ ).normalized( );
+  axis1 = ( axis1 - axis1.dot( tangent_ ) * tangent_ ).normalized( );
+  return std::atan2( axis0.cross( axis1 ).norm( ), axis0.dot( axis1 ));
+}
+
+BOOST_AUTO_TEST_CASE( meshGenerator_pipe )
+{
+  // Single section bent along a helix
+  const unsigned int numNodes = 7;
+  std::vector< nsol::NodePtr > nodes;
+  auto section = new nsol::NeuronMorphologySection( );
+  for ( unsigned int i = 0; i < numNodes; i++ )
+  {
+    float angle = float( i ) * float( M_PI ) / 8.0f;
+    auto node = new nsol::Node(
+      Eigen::Vector3f( 4.0f * std::cos( angle ), 4.0f * std::sin( angle ),
+                       0.6f * float( i )), int( i ),
+      0.5f - 0.03f * float( i ));
+    nodes.push_back( node );
+    section->addNode( node );
+  }
+  nsol::Morphology morphology;
+  morphology.sections( ).push_back( section );
+
+  auto bisector = [ &nodes ]( unsigned int i_ )
+  {
+    Eigen::Vector3f exe =
+      ( nodes[i_]->point( ) - nodes[i_-1]->point( )).normalized( );
+    Eigen::Vector3f exe1 =
+      ( nodes[i_+1]->point( ) - nodes[i_]->point( )).normalized( );
+    return Eigen::Vector3f(( exe + exe1 ).normalized( ));
+  };
+
+  auto mesh = MeshGenerator::generateMesh( &morphology );
+  std::vector< float > steps( numNodes, 0.0f );
+  unsigned int ringVertices = 0;
+  for ( auto quad: mesh->quads( ))
+  {
+    auto vertex0 = dynamic_cast< nlgeometry::OrbitalVertexPtr >(
+      quad->vertex0( ));
+    auto vertex2 = dynamic_cast< nlgeometry::OrbitalVertexPtr >(
+      quad->vertex2( ));
+    BOOST_REQUIRE( vertex0 && vertex2 );
+    int node = vertex0->nodeId( );
+    if ( node < 1 || node > int( numNodes ) - 2 ||
+         vertex2->nodeId( ) != node + 1 )
+      continue;
+
+    // Each ring is at the node radius and perpendicular to the bisector
+    ringVertices++;
+    Eigen::Vector3f axis = vertex0->position( ) - nodes[node]->point( );
+    BOOST_CHECK_CLOSE( axis.norm( ), nodes[node]->radius( ), 1e-3f );
+    BOOST_CHECK_SMALL( axis.normalized( ).dot( bisector( node )), 1e-4f );
+
+    // Vertices joined along the pipe keep their angular position
+    Eigen::Vector3f tangent = node + 1 < int( numNodes ) - 1 ?
+      bisector( node + 1 ) :
+      Eigen::Vector3f(( nodes[node+1]->point( ) -
+                        nodes[node]->point( )).normalized( ));
+    steps[node] = std::max( steps[node],
+                            ringAngle( vertex0, vertex2, tangent ));
+  }
+  BOOST_CHECK_EQUAL( ringVertices, ( numNodes - 2 ) * 4 );
+
+  // The last ring meets the end joint without a twist jump
+  float maxStep = *std::max_element( steps.begin( ) + 1,
+                                     steps.end( ) - 2 );
+  BOOST_CHECK( steps[numNodes - 2] < 0.25f );
+  BOOST_CHECK( steps[numNodes - 2] <= maxStep + 0.05f );
+
+  delete mesh;
+  section->nodes( ).clear( );
+  morphology.sections( ).clear( );
+  delete section;
+  for ( auto node: nodes )
+    delete node;
+}
+
+BOOST_AUTO_TEST_CASE( meshGenerator_structure )
+{
+  std::vector< nsol::NodePtr > nodes;
+  nsol::Morphology morphology;
+  starMorphology( morphology, nodes );
+
+  // Every vertex is listed with its node, in the order the table refers to
+  NodeVertexTable table;
+  auto mesh = MeshGenerator::generateStructureMesh( &morphology, table,
+                                                    Eigen::Vector3f::Ones( ),
+                                                    true );
+  const auto& vertices =
+    static_cast< const nlgeometry::Mesh* >( mesh )->vertices( );
+  BOOST_CHECK_EQUAL( mesh->lines( ).size( ), 12 );
+  BOOST_CHECK_EQUAL( table.numberNodes( ), nodes.size( ));
+  BOOST_CHECK_EQUAL( table.vertexIds( ).size( ), vertices.size( ));
+  for ( unsigned int i = 0; i < table.numberNodes( ); i++ )
+    for ( unsigned int j = table.offsets( )[i]; j < table.offsets( )[i+1];
+          j++ )
+    {
+      auto vertex = dynamic_cast< nlgeometry::OrbitalVertexPtr >(
+        vertices[table.vertexIds( )[j]] );
+      BOOST_CHECK( vertex );
+      BOOST_CHECK_EQUAL( vertex->nodeId( ), int( table.nodeIds( )[i] ));
+    }
+
+  // The node to vertices structure is derived from the same table
+  NodeIdToVertices nodeIdToVertices;
+  auto other = MeshGenerator::generateStructureMesh(
+    &morphology, nodeIdToVertices, Eigen::Vector3f::Ones( ), true );
+  BOOST_CHECK_EQUAL( nodeIdToVertices.size( ), nodes.size( ));
+  for ( const auto& cell: nodeIdToVertices )
+  {
+    unsigned int index = table.index( cell.first );
+    BOOST_CHECK_EQUAL( cell.second.size( ), table.offsets( )[index+1] -
+                       table.offsets( )[index] );
+    for ( auto vertex: cell.second )
+      BOOST_CHECK_EQUAL( vertex->nodeId( ), int( cell.first ));
+  }
+  MeshGenerator::clearCPUData( other, nodeIdToVertices );
+  BOOST_CHECK( nodeIdToVertices.empty( ));
+
+  delete other;
+  delete mesh;
+  freeMorphology( morphology, nodes );
+}
@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <nlgenerator/nlgenerator.h>
+#include <nsol/nsol.h>
+#include "nlgeneratorTests.h"
+
+using namespace nlgenerator;
+
+BOOST_AUTO_TEST_CASE( nodeVertexTable_build )
+{
+  nlgeometry::Vertices vertices;
+  NodeIdToVertices nodeIdToVertices;
+  std::vector< float > positions;
+  for ( unsigned int nodeId: { 7u, 2u, 5u })
+    for ( unsigned int i = 0; i < nodeId % 3 + 1; i++ )
+    {
+      auto vertex = new nlgeometry::OrbitalVertex( Eigen::Vector3f::Zero( ));
+      vertex->nodeId( ) = int( nodeId );
+      vertex->store( positions, nlgeometry::POSITION );
+      vertices.push_back( vertex );
+      nodeIdToVertices[nodeId].push_back( vertex );
+    }
+  // Vertices without node are skipped
+  vertices.push_back( new nlgeometry::OrbitalVertex( Eigen::Vector3f::Zero( )));
+  vertices.push_back( new nlgeometry::Vertex( Eigen::Vector3f::Zero( )));
+
+  NodeVertexTable table;
+  BOOST_CHECK_EQUAL( table.numberNodes( ), 0 );
+  BOOST_CHECK_EQUAL( table.index( 2 ), NodeVertexTable::invalidIndex );
+
+  table.build( vertices );
+  BOOST_CHECK_EQUAL( table.numberNodes( ), 3 );
+  BOOST_CHECK( table.nodeIds( ) == std::vector< unsigned int >({ 2, 5, 7 }));
+  BOOST_CHECK( table.offsets( ) ==
+               std::vector< unsigned int >({ 0, 3, 6, 8 }));
+  BOOST_CHECK( table.vertexIds( ) ==
+               std::vector< unsigned int >({ 2, 3, 4, 5, 6, 7, 0, 1 }));
+  BOOST_CHECK_EQUAL( table.index( 5 ), 1 );
+  BOOST_CHECK_EQUAL( table.index( 3 ), NodeVertexTable::invalidIndex );
+  BOOST_CHECK_EQUAL( table.index( 100 ), NodeVertexTable::invalidIndex );
+
+  NodeIdToVerticesIds nodeIdToVerticesIds;
+  MeshGenerator::verticesToIndices( nodeIdToVertices, nodeIdToVerticesIds );
+  std::vector< unsigned int > nodeIds( { 7, 3, 5 });
+  std::vector< float > buffer( positions.size( ), 0.0f );
+  std::vector< float > expected( positions.size( ), 0.0f );
+  Eigen::Vector3f color( 1.0f, 0.5f, 0.25f );
+  MeshGenerator::conformBuffer( nodeIds, table, buffer, color );
+  MeshGenerator::conformBuffer( nodeIds, nodeIdToVerticesIds, expected,
+                                color );
+  BOOST_CHECK( buffer == expected );
+
+  for ( auto vertex: vertices )
+    delete vertex;
+}
+
+BOOST_AUTO_TEST_CASE( nodeVertexTable_sparse )
+{
+  nlgeometry::Vertices vertices;
+  // Interleaved nodes keep the relative order of their vertices
+  for ( unsigned int nodeId: { 2000000000u, 10u, 2000000000u })
+  {
+    auto vertex = new nlgeometry::OrbitalVertex( Eigen::Vector3f::Zero( ));
+    vertex->nodeId( ) = int( nodeId );
+    vertices.push_back( vertex );
+  }
+
+  NodeVertexTable table;
+  table.build( vertices );
+  BOOST_CHECK_EQUAL( table.index( 10 ), 0 );
+  BOOST_CHECK_EQUAL( table.index( 2000000000u ), 1 );
+  BOOST_CHECK_EQUAL( table.index( 11 ), NodeVertexTable::invalidIndex );
+  BOOST_CHECK( table.offsets( ) == std::vector< unsigned int >({ 0, 1, 3 }));
+  BOOST_CHECK( table.vertexIds( ) ==
+               std::vector< unsigned int >({ 1, 0, 2 }));
+
+  table.clear( );
+  BOOST_CHECK_EQUAL( table.numberNodes( ), 0 );
+  BOOST_CHECK( table.offsets( ) == std::vector< unsigned int >({ 0 }));
+
+  for ( auto vertex: vertices )
+    delete vertex;
+}
@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <nlgenerator/nlgenerator.h>
+#include <nsol/nsol.h>
+#include "nlgeneratorTests.h"
+
+using namespace nlgenerator;
+
+static nsol::SectionPtr section( const std::vector< Eigen::Vector3f >& points_,
+                                 const std::vector< float >& radii_ )
+{
+  auto section = new nsol::NeuronMorphologySection( );
+  for ( unsigned int i = 0; i < points_.size( ); i++ )
+    section->addNode( new nsol::Node( points_[i], i, radii_[i] ));
+  return section;
+}
+
+static void deleteSection( nsol::SectionPtr section_ )
+{
+  for ( auto node: section_->nodes( ))
+    delete node;
+  delete section_;
+}
+
+BOOST_AUTO_TEST_CASE( resampler_straight )
+{
+  std::vector< Eigen::Vector3f > points;
+  std::vector< float > radii;
+  for ( unsigned int i = 0; i < 10; i++ )
+  {
+    points.push_back( Eigen::Vector3f( float( i ), 0.0f, 0.0f ));
+    radii.push_back( 1.0f );
+  }
+  auto straight = section( points, radii );
+  auto first = straight->nodes( ).front( );
+  auto last = straight->nodes( ).back( );
+
+  BOOST_CHECK_EQUAL( Resampler::resample( straight ), 8 );
+  BOOST_CHECK_EQUAL( straight->nodes( ).size( ), 2 );
+  BOOST_CHECK_EQUAL( straight->nodes( ).front( ), first );
+  BOOST_CHECK_EQUAL( straight->nodes( ).back( ), last );
+  deleteSection( straight );
+}
+
+BOOST_AUTO_TEST_CASE( resampler_bend )
+{
+  std::vector< Eigen::Vector3f > points;
+  std::vector< float > radii;
+  for ( unsigned int i = 0; i < 5; i++ )
+    points.push_back( Eigen::Vector3f( float( i ), 0.0f, 0.0f ));
+  for ( unsigned int i = 1; i < 5; i++ )
+    points.push_back( Eigen::Vector3f( 4.0f, float( i ), 0.0f ));
+  radii.resize( points.size( ), 1.0f );
+  auto bent = section( points, radii );
+  auto corner = bent->nodes( )[4];
+
+  BOOST_CHECK_EQUAL( Resampler::resample( bent ), 6 );
+  BOOST_REQUIRE_EQUAL( bent->nodes( ).size( ), 3 );
+  BOOST_CHECK_EQUAL( bent->nodes( )[1], corner );
+  deleteSection( bent );
+}
+
+BOOST_AUTO_TEST_CASE( resampler_radius )
+{
+  std::vector< Eigen::Vector3f > points;
+  std::vector< float > radii;
+  for ( unsigned int i = 0; i < 7; i++ )
+    points.push_back( Eigen::Vector3f( float( i ), 0.0f, 0.0f ));
+  radii = { 1.0f, 1.0f, 1.0f, 3.0f, 1.0f, 1.0f, 1.0f };
+  auto bulge = section( points, radii );
+  auto peak = bulge->nodes( )[3];
+
+  Resampler::resample( bulge );
+  bool kept = false;
+  for ( auto node: bulge->nodes( ))
+    kept = kept || node == peak;
+  BOOST_CHECK( kept );
+  BOOST_CHECK( bulge->nodes( ).size( ) < 7 );
+  deleteSection( bulge );
+
+  // Linear radius changes are merged
+  for ( unsigned int i = 0; i < 7; i++ )
+    radii[i] = 1.0f + float( i );
+  auto cone = section( points, radii );
+  BOOST_CHECK_EQUAL( Resampler::resample( cone ), 5 );
+  deleteSection( cone );
+}
@@ -109,4 +109,36 @@ namespace nlgeometry
     _maximum = Eigen::Vector3f( minVal, minVal, minVal );
   }
 
+  bool AxisAlignedBoundingBox::isValid( void ) const
+  {
+    return ( _minimum.array( ) <= _maximum.array( )).all( );
+  }
+
+  float AxisAlignedBoundingBox::surfaceArea( void ) const
+  {
+    if ( !isValid( ))
+      return 0.0f;
+    Eigen::Vector3f size = _maximum - _minimum;
+    return 2.0f * ( size.x( ) * size.y( ) + size.y( ) * size.z( ) +
+                    size.z( ) * size.x( ));
+  }
+
+  AxisAlignedBoundingBox AxisAlignedBoundingBox::transformed(
+    const Eigen::Matrix4f& matrix_ ) const
+  {
+    if ( !isValid( ))
+      return *this;
+
+    // Arvo's method: the transformed extent is the absolute value of the
+    // linear part applied to the original extent
+    const Eigen::Matrix3f linear = matrix_.block< 3, 3 >( 0, 0 );
+    const Eigen::Vector3f translation = matrix_.block< 3, 1 >( 0, 3 );
+    Eigen::Vector3f newCenter = linear * center( ) + translation;
+    Eigen::Vector3f newExtent =
+      linear.cwiseAbs( ) * (( _maximum - _minimum ) * 0.5f );
+
+    return AxisAlignedBoundingBox( newCenter - newExtent,
+                                   newCenter + newExtent );
+  }
+
 } // namespace nlgeometry
@@ -114,6 +114,29 @@ namespace nlgeometry
     NLGEOMETRY_API
     void clear( void );
 
+    /**
+     * Method that checks if the bounding box contains at least one point
+     * @return true if the minimum is not greater than the maximum
+     */
+    NLGEOMETRY_API
+    bool isValid( void ) const;
+
+    /**
+     * Method that computes the surface area of the bounding box
+     * @return the surface area or zero if the bounding box is not valid
+     */
+    NLGEOMETRY_API
+    float surfaceArea( void ) const;
+
+    /**
+     * Method that computes the axis aligned bounding box of this bounding
+     * box transformed by the given affine matrix
+     * @param matrix_ affine transform
+     * @return the transformed axis aligned bounding box
+     */
+    NLGEOMETRY_API
+    AxisAlignedBoundingBox transformed( const Eigen::Matrix4f& matrix_ ) const;
+
   protected:
 
     //! Left bottom back axis aligned bounding box position
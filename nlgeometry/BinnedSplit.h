@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLGEOMETRY_BINNED_SPLIT__
+#define __NLGEOMETRY_BINNED_SPLIT__
+
+#include "AxisAlignedBoundingBox.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace nlgeometry
+{
+
+  /**
+   * Function that evaluates the surface area heuristic of a hierarchy node
+   * on a number of bins per axis and partitions its primitive indices by
+   * the best split found. Nodes with the centers of all their primitives in
+   * the same position are split in halves
+   * @param begin_ first primitive index of the node
+   * @param end_ end of the primitive indices of the node
+   * @param bounds_ bounding box of the node
+   * @param bins_ number of bins evaluated per axis, at least two
+   * @param leafSize_ maximum number of primitives of a leaf
+   * @param center_ accessor returning the center of a primitive index
+   * @param primitiveBounds_ accessor returning the bounding box of a
+   * primitive index
+   * @return number of indices of the left child placed first, 0 to keep the
+   * node as a leaf because splitting it does not pay off
+   */
+  template < class CENTER, class BOUNDS >
+  unsigned int binnedSplit( unsigned int* begin_, unsigned int* end_,
+                            const AxisAlignedBoundingBox& bounds_,
+                            unsigned int bins_, unsigned int leafSize_,
+                            CENTER center_, BOUNDS primitiveBounds_ )
+  {
+    unsigned int size = ( unsigned int )( end_ - begin_ );
+    Eigen::Vector3f firstCenter = center_( *begin_ );
+    AxisAlignedBoundingBox centerBounds( firstCenter, firstCenter );
+    for ( unsigned int* index = begin_; index != end_; index++ )
+      centerBounds.expand( center_( *index ));
+    Eigen::Vector3f extent = centerBounds.maximum( ) - centerBounds.minimum( );
+
+    // All the centers in the same position, split the range in halves
+    if ( extent.maxCoeff( ) <= 0.0f )
+      return size / 2;
+
+    float leafCost = bounds_.surfaceArea( ) * size;
+    float bestCost = std::numeric_limits< float >::max( );
+    unsigned int bestAxis = 0;
+    unsigned int bestBin = 0;
+
+    const AxisAlignedBoundingBox empty(
+      Eigen::Vector3f::Constant( std::numeric_limits< float >::max( )),
+      Eigen::Vector3f::Constant( std::numeric_limits< float >::lowest( )));
+    std::vector< AxisAlignedBoundingBox > binBounds( bins_ );
+    std::vector< unsigned int > binCounts( bins_ );
+    std::vector< float > rightCosts( bins_ );
+    for ( unsigned int axis = 0; axis < 3; axis++ )
+    {
+      if ( extent[axis] <= 0.0f )
+        continue;
+      float scale = bins_ / extent[axis];
+      std::fill( binCounts.begin( ), binCounts.end( ), 0 );
+      std::fill( binBounds.begin( ), binBounds.end( ), empty );
+      for ( unsigned int* index = begin_; index != end_; index++ )
+      {
+        unsigned int bin = std::min( bins_ - 1, ( unsigned int )((
+          center_( *index )[axis] - centerBounds.minimum( )[axis] ) *
+          scale ));
+        binCounts[bin]++;
+        binBounds[bin].expand( primitiveBounds_( *index ));
+      }
+
+      // Sweep from the right accumulating the cost of the right side
+      AxisAlignedBoundingBox accumulated = binBounds[bins_-1];
+      unsigned int count = binCounts[bins_-1];
+      for ( unsigned int bin = bins_ - 1; bin > 0; bin-- )
+      {
+        rightCosts[bin] = accumulated.surfaceArea( ) * count;
+        accumulated.expand( binBounds[bin-1] );
+        count += binCounts[bin-1];
+      }
+
+      // Sweep from the left, splitting after each bin
+      accumulated = binBounds[0];
+      count = binCounts[0];
+      for ( unsigned int bin = 1; bin < bins_; bin++ )
+      {
+        float cost = accumulated.surfaceArea( ) * count + rightCosts[bin];
+        if ( count > 0 && count < size && cost < bestCost )
+        {
+          bestCost = cost;
+          bestAxis = axis;
+          bestBin = bin;
+        }
+        accumulated.expand( binBounds[bin] );
+        count += binCounts[bin];
+      }
+    }
+
+    // Keep small nodes as leaves when splitting does not pay off
+    if ( bestCost >= leafCost && size <= 4 * leafSize_ )
+      return 0;
+    if ( bestCost == std::numeric_limits< float >::max( ))
+      return size / 2;
+
+    float scale = bins_ / extent[bestAxis];
+    float minimum = centerBounds.minimum( )[bestAxis];
+    unsigned int* split = std::partition( begin_, end_,
+      [ & ]( unsigned int index )
+      {
+        return std::min( bins_ - 1, ( unsigned int )((
+          center_( index )[bestAxis] - minimum ) * scale )) < bestBin;
+      });
+    return ( unsigned int )( split - begin_ );
+  }
+
+} // namespace nlgeometry
+
+#endif
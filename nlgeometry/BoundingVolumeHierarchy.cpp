@@ -0,0 +1,371 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "BoundingVolumeHierarchy.h"
+#include "BinnedSplit.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace nlgeometry
+{
+
+  static const unsigned int NO_LEAF = std::numeric_limits< unsigned int >::max( );
+
+  //! Nodes with fewer primitives are always built in the current thread
+  static const unsigned int MIN_THREAD_PRIMITIVES = 1024;
+
+  BoundingVolumeHierarchy::BoundingVolumeHierarchy( unsigned int leafSize_,
+                                                    unsigned int bins_ )
+    : _leafSize( std::max( 1u, leafSize_ ))
+    , _bins( std::max( 2u, bins_ ))
+    , _threadDepth( 0 )
+    , _numNodes( 0 )
+  {
+  }
+
+  BoundingVolumeHierarchy::~BoundingVolumeHierarchy( void )
+  {
+  }
+
+  void BoundingVolumeHierarchy::build(
+    const std::vector< AxisAlignedBoundingBox >& bounds_,
+    unsigned int threads_ )
+  {
+    _bounds = bounds_;
+    _centers.resize( _bounds.size( ));
+    _leaves.assign( _bounds.size( ), NO_LEAF );
+    _indices.clear( );
+    _unbounded.clear( );
+    _nodes.clear( );
+
+    for ( unsigned int i = 0; i < _bounds.size( ); i++ )
+    {
+      _centers[i] = _bounds[i].center( );
+      if ( _bounds[i].isValid( ))
+        _indices.push_back( i );
+      else
+        _unbounded.push_back( i );
+    }
+    if ( _indices.empty( ))
+      return;
+
+    if ( threads_ == 0 )
+      threads_ = std::max( 1u, std::thread::hardware_concurrency( ));
+    _threadDepth = 0;
+    while (( 1u << _threadDepth ) < threads_ )
+      _threadDepth++;
+
+    // A binary tree with n leaves at most has 2n - 1 nodes
+    _nodes.resize( 2 * _indices.size( ) - 1 );
+    _nodes[0].parent = 0;
+    _nodes[0].first = 0;
+    _nodes[0].count = ( unsigned int )_indices.size( );
+    _numNodes = 1;
+    _build( 0, 0 );
+    _nodes.resize( _numNodes );
+  }
+
+  void BoundingVolumeHierarchy::build(
+    const Meshes& meshes_,
+    const std::vector< Eigen::Matrix4f >& modelMatrices_,
+    unsigned int threads_ )
+  {
+    if ( meshes_.size( ) != modelMatrices_.size( ))
+      throw std::runtime_error(
+        "Meshes and model matrices have different sizes" );
+
+    std::vector< AxisAlignedBoundingBox > bounds;
+    bounds.reserve( meshes_.size( ));
+    for ( unsigned int i = 0; i < meshes_.size( ); i++ )
+      bounds.push_back(
+        meshes_[i]->aaBoundingBox( ).transformed( modelMatrices_[i] ));
+    build( bounds, threads_ );
+  }
+
+  void BoundingVolumeHierarchy::update( unsigned int primitive_,
+                                        const AxisAlignedBoundingBox& bounds_ )
+  {
+    if ( primitive_ >= _bounds.size( ))
+      throw std::runtime_error( "Invalid bounding volume hierarchy primitive" );
+    if ( bounds_.isValid( ) != ( _leaves[primitive_] != NO_LEAF ))
+      throw std::runtime_error(
+        "Primitive bounds validity changed, the hierarchy must be rebuilt" );
+
+    _bounds[primitive_] = bounds_;
+    _centers[primitive_] = bounds_.center( );
+    if ( _leaves[primitive_] == NO_LEAF )
+      return;
+
+    unsigned int node = _leaves[primitive_];
+    while ( _fitNode( node ) && node != 0 )
+      node = _nodes[node].parent;
+  }
+
+  void BoundingVolumeHierarchy::refit( void )
+  {
+    // Children are always stored after their parent
+    for ( unsigned int i = ( unsigned int )_nodes.size( ); i > 0; i-- )
+      _fitNode( i - 1 );
+  }
+
+  void BoundingVolumeHierarchy::query(
+    const Frustum& frustum_, std::vector< unsigned int >& primitives_ ) const
+  {
+    primitives_ = _unbounded;
+    if ( _nodes.empty( ))
+      return;
+
+    std::vector< unsigned int > stack( 1, 0 );
+    while ( !stack.empty( ))
+    {
+      const TNode& node = _nodes[stack.back( )];
+      stack.pop_back( );
+      if ( !frustum_.intersects( node.bounds ))
+        continue;
+      if ( frustum_.contains( node.bounds ))
+      {
+        _append( node, primitives_ );
+        continue;
+      }
+      if ( node.left == 0 )
+      {
+        for ( unsigned int i = node.first; i < node.first + node.count; i++ )
+          if ( frustum_.intersects( _bounds[_indices[i]] ))
+            primitives_.push_back( _indices[i] );
+        continue;
+      }
+      stack.push_back( node.left );
+      stack.push_back( node.left + 1 );
+    }
+  }
+
+  void BoundingVolumeHierarchy::query(
+    const AxisAlignedBoundingBox& aabb_,
+    std::vector< unsigned int >& primitives_ ) const
+  {
+    primitives_ = _unbounded;
+    if ( _nodes.empty( ) || !aabb_.isValid( ))
+      return;
+
+    auto overlaps = [ &aabb_ ]( const AxisAlignedBoundingBox& other )
+      {
+        return ( other.minimum( ).array( ) <= aabb_.maximum( ).array( )).all( )
+          && ( other.maximum( ).array( ) >= aabb_.minimum( ).array( )).all( );
+      };
+
+    std::vector< unsigned int > stack( 1, 0 );
+    while ( !stack.empty( ))
+    {
+      const TNode& node = _nodes[stack.back( )];
+      stack.pop_back( );
+      if ( !overlaps( node.bounds ))
+        continue;
+      if (( node.bounds.minimum( ).array( ) >= aabb_.minimum( ).array( )).all( )
+          && ( node.bounds.maximum( ).array( ) <=
+               aabb_.maximum( ).array( )).all( ))
+      {
+        _append( node, primitives_ );
+        continue;
+      }
+      if ( node.left == 0 )
+      {
+        for ( unsigned int i = node.first; i < node.first + node.count; i++ )
+          if ( overlaps( _bounds[_indices[i]] ))
+            primitives_.push_back( _indices[i] );
+        continue;
+      }
+      stack.push_back( node.left );
+      stack.push_back( node.left + 1 );
+    }
+  }
+
+  void BoundingVolumeHierarchy::query(
+    const Ray& ray_, std::vector< unsigned int >& primitives_ ) const
+  {
+    primitives_.clear( );
+    if ( _nodes.empty( ))
+      return;
+
+    std::vector< std::pair< float, unsigned int >> hits;
+    std::vector< unsigned int > stack( 1, 0 );
+    float distance;
+    while ( !stack.empty( ))
+    {
+      const TNode& node = _nodes[stack.back( )];
+      stack.pop_back( );
+      if ( !ray_.intersects( node.bounds, distance ))
+        continue;
+      if ( node.left == 0 )
+      {
+        for ( unsigned int i = node.first; i < node.first + node.count; i++ )
+          if ( ray_.intersects( _bounds[_indices[i]], distance ))
+            hits.push_back( std::make_pair( distance, _indices[i] ));
+        continue;
+      }
+      stack.push_back( node.left );
+      stack.push_back( node.left + 1 );
+    }
+
+    std::sort( hits.begin( ), hits.end( ));
+    primitives_.reserve( hits.size( ));
+    for ( const auto& hit: hits )
+      primitives_.push_back( hit.second );
+  }
+
+  bool BoundingVolumeHierarchy::pick(
+    const Ray& ray_, const Meshes& meshes_,
+    const std::vector< Eigen::Matrix4f >& modelMatrices_,
+    unsigned int& mesh_, Mesh::TPickResult& result_ ) const
+  {
+    if ( meshes_.size( ) != _bounds.size( ) ||
+         modelMatrices_.size( ) != _bounds.size( ))
+      throw std::runtime_error(
+        "Meshes and model matrices do not match the hierarchy" );
+
+    std::vector< unsigned int > candidates;
+    query( ray_, candidates );
+
+    // Affine transforms keep the distances along the ray
+    float closest = std::numeric_limits< float >::max( );
+    float entry;
+    for ( auto candidate: candidates )
+    {
+      if ( !ray_.intersects( _bounds[candidate], entry ) || entry > closest )
+        break;
+      Eigen::Matrix4f inverse = modelMatrices_[candidate].inverse( );
+      Ray localRay(
+        ( inverse * ray_.origin( ).homogeneous( )).head< 3 >( ),
+        inverse.block< 3, 3 >( 0, 0 ) * ray_.direction( ));
+      Mesh::TPickResult result;
+      if ( meshes_[candidate]->pick( localRay, result ) &&
+           result.distance < closest )
+      {
+        closest = result.distance;
+        mesh_ = candidate;
+        result_ = result;
+      }
+    }
+    return closest != std::numeric_limits< float >::max( );
+  }
+
+  const AxisAlignedBoundingBox& BoundingVolumeHierarchy::bounds(
+    unsigned int primitive_ ) const
+  {
+    return _bounds[primitive_];
+  }
+
+  unsigned int BoundingVolumeHierarchy::size( void ) const
+  {
+    return ( unsigned int )_bounds.size( );
+  }
+
+  const BoundingVolumeHierarchy::Nodes&
+  BoundingVolumeHierarchy::nodes( void ) const
+  {
+    return _nodes;
+  }
+
+  void BoundingVolumeHierarchy::_build( unsigned int node_,
+                                        unsigned int depth_ )
+  {
+    TNode& node = _nodes[node_];
+    node.left = 0;
+    _fitNode( node_ );
+
+    unsigned int leftCount = 0;
+    if ( node.count > _leafSize )
+    {
+      unsigned int* first = &_indices[node.first];
+      leftCount = binnedSplit( first, first + node.count, node.bounds,
+                               _bins, _leafSize,
+        [ this ]( unsigned int index ) -> const Eigen::Vector3f&
+        {
+          return _centers[index];
+        },
+        [ this ]( unsigned int index ) -> const AxisAlignedBoundingBox&
+        {
+          return _bounds[index];
+        });
+    }
+    if ( leftCount == 0 )
+    {
+      for ( unsigned int i = node.first; i < node.first + node.count; i++ )
+        _leaves[_indices[i]] = node_;
+      return;
+    }
+
+    unsigned int mid = node.first + leftCount;
+    unsigned int left = _numNodes.fetch_add( 2 );
+    _nodes[left].parent = node_;
+    _nodes[left].first = node.first;
+    _nodes[left].count = mid - node.first;
+    _nodes[left+1].parent = node_;
+    _nodes[left+1].first = mid;
+    _nodes[left+1].count = node.first + node.count - mid;
+    node.left = left;
+
+    if ( depth_ < _threadDepth && node.count >= MIN_THREAD_PRIMITIVES )
+    {
+      std::thread leftThread( &BoundingVolumeHierarchy::_build, this,
+                              left, depth_ + 1 );
+      _build( left + 1, depth_ + 1 );
+      leftThread.join( );
+    }
+    else
+    {
+      _build( left, depth_ + 1 );
+      _build( left + 1, depth_ + 1 );
+    }
+  }
+
+  bool BoundingVolumeHierarchy::_fitNode( unsigned int node_ )
+  {
+    TNode& node = _nodes[node_];
+    AxisAlignedBoundingBox bounds;
+    if ( node.left == 0 )
+    {
+      bounds = _bounds[_indices[node.first]];
+      for ( unsigned int i = node.first + 1; i < node.first + node.count; i++ )
+        bounds.expand( _bounds[_indices[i]] );
+    }
+    else
+    {
+      bounds = _nodes[node.left].bounds;
+      bounds.expand( _nodes[node.left + 1].bounds );
+    }
+
+    bool changed = bounds.minimum( ) != node.bounds.minimum( ) ||
+      bounds.maximum( ) != node.bounds.maximum( );
+    node.bounds = bounds;
+    return changed;
+  }
+
+  void BoundingVolumeHierarchy::_append(
+    const TNode& node_, std::vector< unsigned int >& primitives_ ) const
+  {
+    primitives_.insert( primitives_.end( ), _indices.begin( ) + node_.first,
+                        _indices.begin( ) + node_.first + node_.count );
+  }
+
+} // namespace nlgeometry
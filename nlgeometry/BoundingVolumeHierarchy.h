@@ -0,0 +1,233 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLGEOMETRY_BOUNDING_VOLUME_HIERARCHY__
+#define __NLGEOMETRY_BOUNDING_VOLUME_HIERARCHY__
+
+#include "AxisAlignedBoundingBox.h"
+#include "Frustum.h"
+#include "Mesh.h"
+#include "Ray.h"
+
+#include <atomic>
+
+#include <nlgeometry/api.h>
+
+namespace nlgeometry
+{
+
+  /* \class BoundingVolumeHierarchy
+   * Binary tree of axis aligned bounding boxes over a set of primitives,
+   * usually the world space bounds of the meshes of a scene, built with the
+   * binned surface area heuristic. Primitives are identified by their
+   * position in the bounds given to the build. Primitives with invalid
+   * bounds are kept out of the tree and returned by every frustum and box
+   * query
+   */
+  class BoundingVolumeHierarchy
+  {
+
+  public:
+
+    /**
+     * Node of the tree. Inner nodes have two consecutive children, leaf nodes
+     * have none. Every node references the range of primitive indices below
+     * it
+     */
+    typedef struct
+    {
+      AxisAlignedBoundingBox bounds;
+      unsigned int parent;
+      unsigned int left;
+      unsigned int first;
+      unsigned int count;
+    } TNode;
+
+    typedef std::vector< TNode > Nodes;
+
+    /**
+     * Default constructor
+     * @param leafSize_ maximum number of primitives of a leaf
+     * @param bins_ number of bins evaluated per axis when splitting a node
+     */
+    NLGEOMETRY_API
+    BoundingVolumeHierarchy( unsigned int leafSize_ = 4,
+                             unsigned int bins_ = 16 );
+
+    /**
+     * Default destructor
+     */
+    NLGEOMETRY_API
+    ~BoundingVolumeHierarchy( void );
+
+    /**
+     * Method that builds the tree over the given bounds
+     * @param bounds_ bounds of the primitives
+     * @param threads_ maximum number of threads used to build the subtrees,
+     * zero to use the hardware concurrency
+     */
+    NLGEOMETRY_API
+    void build( const std::vector< AxisAlignedBoundingBox >& bounds_,
+                unsigned int threads_ = 0 );
+
+    /**
+     * Method that builds the tree over the bounding boxes of the given meshes
+     * transformed by their model matrices
+     * @param meshes_ meshes with their bounding box computed
+     * @param modelMatrices_ model matrix of each mesh
+     * @param threads_ maximum number of threads used to build the subtrees,
+     * zero to use the hardware concurrency
+     */
+    NLGEOMETRY_API
+    void build( const Meshes& meshes_,
+                const std::vector< Eigen::Matrix4f >& modelMatrices_,
+                unsigned int threads_ = 0 );
+
+    /**
+     * Method that changes the bounds of a primitive and refits the nodes from
+     * its leaf up to the root, stopping when a node does not change. The tree
+     * topology is kept, so its quality degrades after large movements
+     * @param primitive_ primitive identifier
+     * @param bounds_ new bounds of the primitive, which validity must not
+     * change
+     */
+    NLGEOMETRY_API
+    void update( unsigned int primitive_,
+                 const AxisAlignedBoundingBox& bounds_ );
+
+    /**
+     * Method that recomputes the bounds of every node from the primitive
+     * bounds
+     */
+    NLGEOMETRY_API
+    void refit( void );
+
+    /**
+     * Method that finds the primitives which bounds intersect the frustum
+     * @param frustum_ frustum to check
+     * @param primitives_ vector filled with the primitive identifiers
+     */
+    NLGEOMETRY_API
+    void query( const Frustum& frustum_,
+                std::vector< unsigned int >& primitives_ ) const;
+
+    /**
+     * Method that finds the primitives which bounds overlap a box
+     * @param aabb_ box to check
+     * @param primitives_ vector filled with the primitive identifiers
+     */
+    NLGEOMETRY_API
+    void query( const AxisAlignedBoundingBox& aabb_,
+                std::vector< unsigned int >& primitives_ ) const;
+
+    /**
+     * Method that finds the primitives which bounds are hit by a ray
+     * @param ray_ ray to check
+     * @param primitives_ vector filled with the primitive identifiers sorted
+     * by the distance at which the ray enters their bounds
+     */
+    NLGEOMETRY_API
+    void query( const Ray& ray_,
+                std::vector< unsigned int >& primitives_ ) const;
+
+    /**
+     * Method that picks the closest mesh hit by a ray, testing the meshes in
+     * the order the ray enters their bounds and stopping when the next
+     * bounds are farther than the closest hit
+     * @param ray_ ray in world coordinates
+     * @param meshes_ meshes indexed as the primitives of the hierarchy
+     * @param modelMatrices_ model matrix of each mesh
+     * @param mesh_ index of the mesh hit
+     * @param result_ hit information in the mesh coordinates, with the
+     * distance measured along the world ray
+     * @return true if the ray hits a mesh
+     */
+    NLGEOMETRY_API
+    bool pick( const Ray& ray_, const Meshes& meshes_,
+               const std::vector< Eigen::Matrix4f >& modelMatrices_,
+               unsigned int& mesh_, Mesh::TPickResult& result_ ) const;
+
+    /**
+     * Method that returns the bounds of a primitive
+     * @param primitive_ primitive identifier
+     * @return the bounds of the primitive
+     */
+    NLGEOMETRY_API
+    const AxisAlignedBoundingBox& bounds( unsigned int primitive_ ) const;
+
+    /**
+     * Method that returns the number of primitives
+     * @return the number of primitives
+     */
+    NLGEOMETRY_API
+    unsigned int size( void ) const;
+
+    /**
+     * Method that returns the tree nodes, the first one being the root
+     * @return the tree nodes
+     */
+    NLGEOMETRY_API
+    const Nodes& nodes( void ) const;
+
+  protected:
+
+    void _build( unsigned int node_, unsigned int depth_ );
+
+    bool _fitNode( unsigned int node_ );
+
+    void _append( const TNode& node_,
+                  std::vector< unsigned int >& primitives_ ) const;
+
+    //! Maximum number of primitives of a leaf
+    unsigned int _leafSize;
+
+    //! Number of bins evaluated per axis
+    unsigned int _bins;
+
+    //! Depth up to which subtrees are built in new threads
+    unsigned int _threadDepth;
+
+    //! Bounds of the primitives
+    std::vector< AxisAlignedBoundingBox > _bounds;
+
+    //! Centers of the primitive bounds
+    std::vector< Eigen::Vector3f > _centers;
+
+    //! Primitive identifiers ordered so every node covers a range
+    std::vector< unsigned int > _indices;
+
+    //! Leaf of each primitive
+    std::vector< unsigned int > _leaves;
+
+    //! Primitives with invalid bounds
+    std::vector< unsigned int > _unbounded;
+
+    //! Tree nodes
+    Nodes _nodes;
+
+    //! Number of nodes used during the build
+    std::atomic< unsigned int > _numNodes;
+
+  }; // class BoundingVolumeHierarchy
+
+} // namespace nlgeometry
+
+#endif
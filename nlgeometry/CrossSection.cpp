@@ -0,0 +1,232 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "CrossSection.h"
+
+namespace nlgeometry
+{
+
+  CrossSection::CrossSection( void )
+  {
+    *this = identity( );
+  }
+
+  CrossSection::CrossSection( const Eigen::Vector3f& position0_,
+                              const Eigen::Vector3f& position1_,
+                              const Eigen::Vector3f& position2_,
+                              const Eigen::Vector3f& position3_,
+                              const Eigen::Vector3f& center_ )
+    : _center( center_ )
+  {
+    _positions[0] = position0_;
+    _positions[1] = position1_;
+    _positions[2] = position2_;
+    _positions[3] = position3_;
+  }
+
+  CrossSection::CrossSection( const SectionQuad& quad_ )
+    : _center( quad_.vertex0( )->center( ))
+  {
+    _positions[0] = quad_.vertex0( )->position( );
+    _positions[1] = quad_.vertex1( )->position( );
+    _positions[2] = quad_.vertex2( )->position( );
+    _positions[3] = quad_.vertex3( )->position( );
+  }
+
+  Eigen::Vector3f& CrossSection::position( unsigned int index_ )
+  {
+    return _positions[index_];
+  }
+
+  const Eigen::Vector3f& CrossSection::position( unsigned int index_ ) const
+  {
+    return _positions[index_];
+  }
+
+  Eigen::Vector3f& CrossSection::center( void )
+  {
+    return _center;
+  }
+
+  const Eigen::Vector3f& CrossSection::center( void ) const
+  {
+    return _center;
+  }
+
+  void CrossSection::inverse( void )
+  {
+    std::swap( _positions[1], _positions[3] );
+  }
+
+  CrossSection CrossSection::inversed( void ) const
+  {
+    return CrossSection( _positions[0], _positions[3], _positions[2],
+                         _positions[1], _center );
+  }
+
+  void CrossSection::displace( const Eigen::Vector3f& displacement_ )
+  {
+    for ( auto& position: _positions )
+      position += displacement_;
+    _center += displacement_;
+  }
+
+  void CrossSection::place( const Eigen::Vector3f& placement_ )
+  {
+    for ( auto& position: _positions )
+      position = placement_ + ( position - _center );
+    _center = placement_;
+  }
+
+  void CrossSection::rotate( const Eigen::Matrix3f& rotation_ )
+  {
+    for ( auto& position: _positions )
+      position = _center + rotation_ * ( position - _center );
+  }
+
+  void CrossSection::rotate( const Eigen::Quaternion< float >& rotation_ )
+  {
+    for ( auto& position: _positions )
+      position = _center + rotation_ * ( position - _center );
+  }
+
+  void CrossSection::orient( const Eigen::Vector3f& orientation_ )
+  {
+    Eigen::Quaternion< float > q;
+    q.setFromTwoVectors( this->normal( ), orientation_.normalized( ));
+    this->rotate( q );
+  }
+
+  Eigen::Vector3f CrossSection::axis0( void ) const
+  {
+    return ( _positions[0] - _positions[2] ).normalized( );
+  }
+
+  Eigen::Vector3f CrossSection::axis1( void ) const
+  {
+    return ( _positions[1] - _positions[3] ).normalized( );
+  }
+
+  void CrossSection::norm( float norm_ )
+  {
+    for ( auto& position: _positions )
+      position = ( position - _center ).normalized( ) * norm_ + _center;
+  }
+
+  void CrossSection::normalize( void )
+  {
+    Eigen::Vector3f axisA = this->axis0( );
+    Eigen::Vector3f axisB = this->axis1( );
+
+    _positions[0] = _center + axisA;
+    _positions[1] = _center + axisB;
+    _positions[2] = _center - axisA;
+    _positions[3] = _center - axisB;
+  }
+
+  Eigen::Vector3f CrossSection::normal( void ) const
+  {
+    return this->axis0( ).cross( this->axis1( ));
+  }
+
+  SectionQuadPtr CrossSection::materialize( void ) const
+  {
+    return new SectionQuad( new OrbitalVertex( _positions[0], _center ),
+                            new OrbitalVertex( _positions[1], _center ),
+                            new OrbitalVertex( _positions[2], _center ),
+                            new OrbitalVertex( _positions[3], _center ));
+  }
+
+  CrossSection CrossSection::identity( void )
+  {
+    return CrossSection( Eigen::Vector3f( 0.0f, 0.0f, -1.0f ),
+                         Eigen::Vector3f( -1.0f, 0.0f, 0.0f ),
+                         Eigen::Vector3f( 0.0f, 0.0f, 1.0f ),
+                         Eigen::Vector3f( 1.0f, 0.0f, 0.0f ),
+                         Eigen::Vector3f( 0.0f, 0.0f, 0.0f ));
+  }
+
+  Eigen::Quaternion< float > CrossSection::getZRotation(
+    const CrossSection& section0_, const CrossSection& section1_ )
+  {
+    CrossSection section0 = section0_;
+    CrossSection section1 = section1_;
+    section0.normalize( );
+    section1.normalize( );
+
+    Eigen::Quaternion< float > q;
+    q.setFromTwoVectors( section0.normal( ), section1.normal( ));
+    section0.rotate( q );
+
+    Eigen::Vector3f refDir =
+      ( section0.position( 0 ) - section0.center( )).normalized( );
+    q.setFromTwoVectors( refDir, _nearestDirection( section0, section1 ));
+    return q;
+  }
+
+  float CrossSection::getZAngle( const CrossSection& section0_,
+                                 const CrossSection& section1_ )
+  {
+    CrossSection section0 = section0_;
+    CrossSection section1 = section1_;
+    section0.normalize( );
+    section1.normalize( );
+
+    Eigen::Quaternion< float > q;
+    q.setFromTwoVectors( section0.normal( ), section1.normal( ));
+    section0.rotate( q );
+
+    Eigen::Vector3f refDir =
+      ( section0.position( 0 ) - section0.center( )).normalized( );
+    Eigen::Vector3f newDir = _nearestDirection( section0, section1 );
+
+    Eigen::Vector3f normalAxis = refDir.cross( newDir );
+    float sinNormalAxis = normalAxis.norm( );
+    if ( section0.normal( ).dot( normalAxis ) < 0.0f )
+      sinNormalAxis *= -1.0f;
+    return atan2( sinNormalAxis, refDir.dot( newDir ));
+  }
+
+  Eigen::Vector3f CrossSection::_nearestDirection(
+    const CrossSection& section0_, const CrossSection& section1_ )
+  {
+    // The second cross section is traversed in the opposite direction
+    static const unsigned int order[4] = { 0, 3, 2, 1 };
+
+    Eigen::Vector3f refDir =
+      ( section0_.position( 0 ) - section0_.center( )).normalized( );
+    Eigen::Vector3f nearestDir;
+    auto maxCos = -1.0f;
+    for ( auto i: order )
+    {
+      Eigen::Vector3f newDir =
+        ( section1_.position( i ) - section1_.center( )).normalized( );
+      auto cos = refDir.dot( newDir );
+      if ( cos > maxCos || i == 0 )
+      {
+        maxCos = cos;
+        nearestDir = newDir;
+      }
+    }
+    return nearestDir;
+  }
+
+} // namespace nlgeometry
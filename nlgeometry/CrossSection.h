@@ -0,0 +1,235 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLGEOMETRY_CROSS_SECTION__
+#define __NLGEOMETRY_CROSS_SECTION__
+
+#include "SectionQuad.h"
+
+#include <nlgeometry/api.h>
+
+namespace nlgeometry
+{
+
+  /*! \class CrossSection
+   * Value type with the four positions and the center of a section quad. It
+   * is meant to live on the stack while sweeping pipes and computing joints,
+   * so only the final quads have heap allocated orbital vertices.
+   */
+  class CrossSection
+  {
+
+  public:
+
+    /**
+     * Default constructor, an identity cross section
+     */
+    NLGEOMETRY_API
+    CrossSection( void );
+
+    /**
+     * Constructor
+     * @param position0_ first position of the cross section
+     * @param position1_ second position of the cross section
+     * @param position2_ third position of the cross section
+     * @param position3_ fourth position of the cross section
+     * @param center_ center of the cross section
+     */
+    NLGEOMETRY_API
+    CrossSection( const Eigen::Vector3f& position0_,
+                  const Eigen::Vector3f& position1_,
+                  const Eigen::Vector3f& position2_,
+                  const Eigen::Vector3f& position3_,
+                  const Eigen::Vector3f& center_ );
+
+    /**
+     * Constructor that copies the positions of a section quad. The center of
+     * its first vertex is taken as the cross section center
+     * @param quad_ section quad to copy
+     */
+    NLGEOMETRY_API
+    explicit CrossSection( const SectionQuad& quad_ );
+
+    /**
+     * Method that returns a cross section position
+     * @param index_ position index, from 0 to 3
+     * @return the cross section position
+     */
+    NLGEOMETRY_API
+    Eigen::Vector3f& position( unsigned int index_ );
+
+    NLGEOMETRY_API
+    const Eigen::Vector3f& position( unsigned int index_ ) const;
+
+    /**
+     * Method that returns the cross section center
+     * @return the cross section center
+     */
+    NLGEOMETRY_API
+    Eigen::Vector3f& center( void );
+
+    NLGEOMETRY_API
+    const Eigen::Vector3f& center( void ) const;
+
+    /**
+     * Method that inverse the cross section
+     */
+    NLGEOMETRY_API
+    void inverse( void );
+
+    /**
+     * Method that returns an inversed copy of the cross section
+     * @return an inversed copy of the cross section
+     */
+    NLGEOMETRY_API
+    CrossSection inversed( void ) const;
+
+    /**
+     * Method that displace the cross section
+     * @param displacement_ vector to displace the cross section
+     */
+    NLGEOMETRY_API
+    void displace( const Eigen::Vector3f& displacement_ );
+
+    /**
+     * Method that place the cross section
+     * @param placement_ vector to place the cross section
+     */
+    NLGEOMETRY_API
+    void place( const Eigen::Vector3f& placement_ );
+
+    /**
+     * Method to rotate the cross section
+     * @param rotation_ matrix with the rotation to be applied
+     */
+    NLGEOMETRY_API
+    void rotate( const Eigen::Matrix3f& rotation_ );
+
+    /**
+     * Method to rotate the cross section
+     * @param rotation_ quaternion with the rotation to be applied
+     */
+    NLGEOMETRY_API
+    void rotate( const Eigen::Quaternion< float >& rotation_ );
+
+    /**
+     * Method to orient the cross section
+     * @param orientation_ to be applied to the cross section
+     */
+    NLGEOMETRY_API
+    void orient( const Eigen::Vector3f& orientation_ );
+
+    /**
+     * Method that return the 0 cross section axis
+     * @return the 0 cross section axis
+     */
+    NLGEOMETRY_API
+    Eigen::Vector3f axis0( void ) const;
+
+    /**
+     * Method that return the 1 cross section axis
+     * @return the 1 cross section axis
+     */
+    NLGEOMETRY_API
+    Eigen::Vector3f axis1( void ) const;
+
+    /**
+     * Method to change the distance of the positions to the center
+     * @param norm_ new distance of the positions to the center
+     */
+    NLGEOMETRY_API
+    void norm( float norm_ );
+
+    /**
+     * Method to normalize the cross section positions along its axes
+     */
+    NLGEOMETRY_API
+    void normalize( void );
+
+    /**
+     * Method that return the cross section normal
+     * @return the cross section normal
+     */
+    NLGEOMETRY_API
+    Eigen::Vector3f normal( void ) const;
+
+    /**
+     * Method that creates a section quad with new orbital vertices at the
+     * cross section positions. The caller owns the quad and its vertices
+     * @return a pointer to the new section quad
+     */
+    NLGEOMETRY_API
+    SectionQuadPtr materialize( void ) const;
+
+    /**
+     * Static method that return a identity cross section
+     * @return a identity cross section
+     */
+    NLGEOMETRY_API
+    static CrossSection identity( void );
+
+    /**
+     * Static method that returns a quaternion with the minimum z rotation
+     * between two cross sections
+     * @param section0_ first cross section
+     * @param section1_ second cross section
+     * @return a quaterion with the minimum z rotation between the two given
+     * cross sections
+     */
+    NLGEOMETRY_API
+    static Eigen::Quaternion< float > getZRotation(
+      const CrossSection& section0_, const CrossSection& section1_ );
+
+    /**
+     * Static method that returns the minimum z rotation between two cross
+     * sections
+     * @param section0_ first cross section
+     * @param section1_ second cross section
+     * @return the minimum z rotation between the two given cross sections
+     */
+    NLGEOMETRY_API
+    static float getZAngle( const CrossSection& section0_,
+                            const CrossSection& section1_ );
+
+  protected:
+
+    /**
+     * Method that returns the unit direction of the second cross section
+     * closest to the first direction of the first one, once the first one
+     * is rotated to the normal of the second
+     * @param section0_ first cross section, normalized and rotated
+     * @param section1_ second cross section, normalized
+     * @return the nearest unit direction of the second cross section
+     */
+    static Eigen::Vector3f _nearestDirection( const CrossSection& section0_,
+                                              const CrossSection& section1_ );
+
+    //! Cross section positions
+    Eigen::Vector3f _positions[4];
+
+    //! Cross section center
+    Eigen::Vector3f _center;
+
+  };
+
+} // namespace nlgeometry
+
+#endif
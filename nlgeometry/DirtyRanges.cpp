@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "DirtyRanges.h"
+
+#include <algorithm>
+
+namespace nlgeometry
+{
+
+  DirtyRanges::DirtyRanges( unsigned int gap_ )
+    : _gap( gap_ )
+  {
+  }
+
+  void DirtyRanges::add( unsigned int first_, unsigned int count_ )
+  {
+    if ( count_ == 0 )
+      return;
+    Range range( first_, first_ + count_ );
+
+    // Updates usually come in increasing order, so try the last range first
+    if ( _ranges.empty( ) ||
+         size_t( _ranges.back( ).second ) + _gap < range.first )
+    {
+      _ranges.push_back( range );
+      return;
+    }
+
+    // First range that ends close enough to the new one to be merged
+    auto first = std::lower_bound(
+      _ranges.begin( ), _ranges.end( ), range,
+      [ this ]( const Range& current_, const Range& range_ )
+      {
+        return size_t( current_.second ) + _gap < range_.first;
+      });
+    auto last = first;
+    while ( last != _ranges.end( ) &&
+            last->first <= size_t( range.second ) + _gap )
+    {
+      range.first = std::min( range.first, last->first );
+      range.second = std::max( range.second, last->second );
+      last++;
+    }
+
+    if ( first == last )
+      _ranges.insert( first, range );
+    else
+    {
+      *first = range;
+      _ranges.erase( first + 1, last );
+    }
+  }
+
+  void DirtyRanges::clear( void )
+  {
+    _ranges.clear( );
+  }
+
+  bool DirtyRanges::empty( void ) const
+  {
+    return _ranges.empty( );
+  }
+
+  const Ranges& DirtyRanges::ranges( void ) const
+  {
+    return _ranges;
+  }
+
+  unsigned int DirtyRanges::size( void ) const
+  {
+    unsigned int size = 0;
+    for ( const auto& range: _ranges )
+      size += range.second - range.first;
+    return size;
+  }
+
+} // namespace nlgeometry
@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLGEOMETRY_DIRTY_RANGES__
+#define __NLGEOMETRY_DIRTY_RANGES__
+
+#include <utility>
+#include <vector>
+
+#include <nlgeometry/api.h>
+
+namespace nlgeometry
+{
+
+  //! Half open range of elements, first and last plus one
+  typedef std::pair< unsigned int, unsigned int > Range;
+  typedef std::vector< Range > Ranges;
+
+  /*! \class DirtyRanges
+   * Set of modified ranges of a buffer, kept sorted and coalesced so every
+   * range can be uploaded with a single call
+   */
+  class DirtyRanges
+  {
+
+  public:
+
+    /**
+     * Default constructor
+     * @param gap_ ranges separated by at most this number of elements are
+     * merged, uploading the clean elements between them
+     */
+    NLGEOMETRY_API
+    DirtyRanges( unsigned int gap_ = 0 );
+
+    /**
+     * Method that marks a range as modified
+     * @param first_ first modified element
+     * @param count_ number of modified elements
+     */
+    NLGEOMETRY_API
+    void add( unsigned int first_, unsigned int count_ = 1 );
+
+    /**
+     * Method that removes all the ranges
+     */
+    NLGEOMETRY_API
+    void clear( void );
+
+    /**
+     * Method that returns true if there is no modified range
+     * @return true if there is no modified range
+     */
+    NLGEOMETRY_API
+    bool empty( void ) const;
+
+    /**
+     * Method that returns the modified ranges, sorted and disjoint
+     * @return the modified ranges
+     */
+    NLGEOMETRY_API
+    const Ranges& ranges( void ) const;
+
+    /**
+     * Method that returns the number of elements covered by the ranges
+     * @return the number of elements covered by the ranges
+     */
+    NLGEOMETRY_API
+    unsigned int size( void ) const;
+
+  protected:
+
+    //! Sorted and disjoint modified ranges
+    Ranges _ranges;
+
+    //! Maximum number of clean elements between merged ranges
+    unsigned int _gap;
+
+  };
+
+} // namespace nlgeometry
+
+#endif
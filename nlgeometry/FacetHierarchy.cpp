@@ -0,0 +1,308 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "FacetHierarchy.h"
+#include "BinnedSplit.h"
+#include "OrbitalVertex.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+namespace nlgeometry
+{
+
+  FacetHierarchy::FacetHierarchy( unsigned int leafSize_,
+                                  unsigned int bins_ )
+    : _leafSize( std::max( 1u, leafSize_ ))
+    , _bins( std::max( 2u, bins_ ))
+  {
+  }
+
+  FacetHierarchy::~FacetHierarchy( void )
+  {
+  }
+
+  void FacetHierarchy::build( MeshPtr mesh_ )
+  {
+    _nodes.clear( );
+    _triangles.clear( );
+    _centers.clear( );
+
+    // Read only access, so the mesh keeps its own hierarchy
+    const Mesh& mesh = *mesh_;
+    std::unordered_map< VertexPtr, unsigned int > vertexIndex;
+    _centers.reserve( mesh.vertices( ).size( ));
+    for ( auto vertex: mesh.vertices( ))
+    {
+      vertexIndex[ vertex ] = ( unsigned int )_centers.size( );
+      OrbitalVertexPtr orbital = dynamic_cast< OrbitalVertexPtr >( vertex );
+      _centers.push_back( orbital ? orbital->center( ) : vertex->position( ));
+    }
+
+    std::vector< TTriangle > triangles;
+    triangles.reserve( mesh.triangles( ).size( ) +
+                       2 * mesh.quads( ).size( ));
+    auto addTriangle = [ & ]( VertexPtr v0_, VertexPtr v1_, VertexPtr v2_,
+                              unsigned int facet_ )
+      {
+        auto i0 = vertexIndex.find( v0_ );
+        auto i1 = vertexIndex.find( v1_ );
+        auto i2 = vertexIndex.find( v2_ );
+        if ( i0 == vertexIndex.end( ) || i1 == vertexIndex.end( ) ||
+             i2 == vertexIndex.end( ))
+          return;
+        TTriangle triangle;
+        Eigen::Map< Eigen::Vector3f >( triangle.vertex0 ) = v0_->position( );
+        Eigen::Map< Eigen::Vector3f >( triangle.edge1 ) =
+          v1_->position( ) - v0_->position( );
+        Eigen::Map< Eigen::Vector3f >( triangle.edge2 ) =
+          v2_->position( ) - v0_->position( );
+        triangle.vertices[0] = i0->second;
+        triangle.vertices[1] = i1->second;
+        triangle.vertices[2] = i2->second;
+        triangle.facet = facet_;
+        triangles.push_back( triangle );
+      };
+
+    // Quads are split as they are rendered when stored as triangles
+    const Facets& meshTriangles = mesh.triangles( );
+    for ( unsigned int i = 0; i < meshTriangles.size( ); i++ )
+      addTriangle( meshTriangles[i]->vertex0( ), meshTriangles[i]->vertex1( ),
+                   meshTriangles[i]->vertex2( ), i << 1 );
+    const Facets& quads = mesh.quads( );
+    for ( unsigned int i = 0; i < quads.size( ); i++ )
+    {
+      addTriangle( quads[i]->vertex0( ), quads[i]->vertex1( ),
+                   quads[i]->vertex2( ), ( i << 1 ) | 1 );
+      addTriangle( quads[i]->vertex1( ), quads[i]->vertex3( ),
+                   quads[i]->vertex2( ), ( i << 1 ) | 1 );
+    }
+    if ( triangles.empty( ))
+      return;
+
+    std::vector< AxisAlignedBoundingBox > bounds;
+    bounds.reserve( triangles.size( ));
+    for ( const auto& triangle: triangles )
+    {
+      Eigen::Map< const Eigen::Vector3f > vertex0( triangle.vertex0 );
+      AxisAlignedBoundingBox aabb( vertex0, vertex0 );
+      aabb.expand( vertex0 + Eigen::Map< const Eigen::Vector3f >(
+                     triangle.edge1 ));
+      aabb.expand( vertex0 + Eigen::Map< const Eigen::Vector3f >(
+                     triangle.edge2 ));
+      bounds.push_back( aabb );
+    }
+
+    std::vector< unsigned int > indices( triangles.size( ));
+    for ( unsigned int i = 0; i < indices.size( ); i++ )
+      indices[i] = i;
+
+    // A binary tree with n leaves at most has 2n - 1 nodes
+    _nodes.reserve( 2 * triangles.size( ) - 1 );
+    TNode root;
+    root.leftFirst = 0;
+    root.count = ( unsigned int )triangles.size( );
+    _nodes.push_back( root );
+
+    std::vector< unsigned int > stack( 1, 0 );
+    while ( !stack.empty( ))
+    {
+      unsigned int current = stack.back( );
+      stack.pop_back( );
+      TNode& node = _nodes[current];
+
+      AxisAlignedBoundingBox aabb = bounds[indices[node.leftFirst]];
+      for ( unsigned int i = node.leftFirst + 1;
+            i < node.leftFirst + node.count; i++ )
+        aabb.expand( bounds[indices[i]] );
+      Eigen::Map< Eigen::Vector3f >( node.minimum ) = aabb.minimum( );
+      Eigen::Map< Eigen::Vector3f >( node.maximum ) = aabb.maximum( );
+
+      unsigned int leftCount = 0;
+      if ( node.count > _leafSize )
+      {
+        unsigned int* first = &indices[node.leftFirst];
+        leftCount = binnedSplit( first, first + node.count, aabb, _bins,
+                                 _leafSize,
+          [ & ]( unsigned int index )
+          {
+            return bounds[index].center( );
+          },
+          [ & ]( unsigned int index ) -> const AxisAlignedBoundingBox&
+          {
+            return bounds[index];
+          });
+      }
+      if ( leftCount == 0 )
+        continue;
+      unsigned int mid = node.leftFirst + leftCount;
+
+      TNode left;
+      left.leftFirst = node.leftFirst;
+      left.count = mid - node.leftFirst;
+      TNode right;
+      right.leftFirst = mid;
+      right.count = node.leftFirst + node.count - mid;
+      node.leftFirst = ( unsigned int )_nodes.size( );
+      node.count = 0;
+      _nodes.push_back( left );
+      _nodes.push_back( right );
+      stack.push_back( _nodes[current].leftFirst );
+      stack.push_back( _nodes[current].leftFirst + 1 );
+    }
+
+    _triangles.reserve( triangles.size( ));
+    for ( auto index: indices )
+      _triangles.push_back( triangles[index] );
+  }
+
+  bool FacetHierarchy::pick( const Ray& ray_,
+                             Mesh::TPickResult& result_ ) const
+  {
+    if ( _nodes.empty( ))
+      return false;
+
+    const Eigen::Array3f origin = ray_.origin( ).array( );
+    const Eigen::Array3f invDirection = ray_.direction( ).cwiseInverse( ).array( );
+    const Eigen::Vector3f& direction = ray_.direction( );
+
+    // Slab test of a node against the ray up to the current closest hit
+    auto entry = [ & ]( const TNode& node_, float closest_ )
+      {
+        Eigen::Array3f t0 = ( Eigen::Map< const Eigen::Array3f >(
+          node_.minimum ) - origin ) * invDirection;
+        Eigen::Array3f t1 = ( Eigen::Map< const Eigen::Array3f >(
+          node_.maximum ) - origin ) * invDirection;
+        float tNear = std::max( t0.min( t1 ).maxCoeff( ), 0.0f );
+        float tFar = std::min( t0.max( t1 ).minCoeff( ), closest_ );
+        return tNear <= tFar ? tNear : std::numeric_limits< float >::max( );
+      };
+
+    const float miss = std::numeric_limits< float >::max( );
+    float closest = miss;
+    unsigned int hit = 0;
+    float hitU = 0.0f;
+    float hitV = 0.0f;
+
+    std::vector< unsigned int > stack;
+    stack.reserve( 64 );
+    unsigned int current = 0;
+    if ( entry( _nodes[0], closest ) == miss )
+      return false;
+
+    while ( true )
+    {
+      const TNode& node = _nodes[current];
+      if ( node.count > 0 )
+      {
+        // Moller-Trumbore test of the leaf triangles
+        for ( unsigned int i = node.leftFirst;
+              i < node.leftFirst + node.count; i++ )
+        {
+          const TTriangle& triangle = _triangles[i];
+          Eigen::Map< const Eigen::Vector3f > edge1( triangle.edge1 );
+          Eigen::Map< const Eigen::Vector3f > edge2( triangle.edge2 );
+          Eigen::Vector3f p = direction.cross( edge2 );
+          float determinant = edge1.dot( p );
+          if ( std::abs( determinant ) <
+               std::numeric_limits< float >::epsilon( ))
+            continue;
+          float invDeterminant = 1.0f / determinant;
+          Eigen::Vector3f s = ray_.origin( ) -
+            Eigen::Map< const Eigen::Vector3f >( triangle.vertex0 );
+          float u = s.dot( p ) * invDeterminant;
+          if ( u < 0.0f || u > 1.0f )
+            continue;
+          Eigen::Vector3f q = s.cross( edge1 );
+          float v = direction.dot( q ) * invDeterminant;
+          if ( v < 0.0f || u + v > 1.0f )
+            continue;
+          float t = edge2.dot( q ) * invDeterminant;
+          if ( t >= 0.0f && t < closest )
+          {
+            closest = t;
+            hit = i;
+            hitU = u;
+            hitV = v;
+          }
+        }
+        if ( stack.empty( ))
+          break;
+        current = stack.back( );
+        stack.pop_back( );
+        continue;
+      }
+
+      // Visit the nearest child first and keep the other one for later
+      unsigned int near = node.leftFirst;
+      unsigned int far = node.leftFirst + 1;
+      float nearEntry = entry( _nodes[near], closest );
+      float farEntry = entry( _nodes[far], closest );
+      if ( farEntry < nearEntry )
+      {
+        std::swap( near, far );
+        std::swap( nearEntry, farEntry );
+      }
+      if ( nearEntry == miss )
+      {
+        if ( stack.empty( ))
+          break;
+        current = stack.back( );
+        stack.pop_back( );
+        continue;
+      }
+      current = near;
+      if ( farEntry != miss )
+        stack.push_back( far );
+    }
+
+    if ( closest == miss )
+      return false;
+
+    const TTriangle& triangle = _triangles[hit];
+    result_.distance = closest;
+    result_.point = ray_.point( closest );
+    result_.quad = ( triangle.facet & 1 ) != 0;
+    result_.facet = triangle.facet >> 1;
+    result_.barycentrics = Eigen::Vector3f( 1.0f - hitU - hitV, hitU, hitV );
+    unsigned int nearest = 0;
+    for ( unsigned int i = 0; i < 3; i++ )
+    {
+      result_.vertices[i] = triangle.vertices[i];
+      if ( result_.barycentrics[i] > result_.barycentrics[nearest] )
+        nearest = i;
+    }
+    result_.node = _centers[triangle.vertices[nearest]];
+    return true;
+  }
+
+  unsigned int FacetHierarchy::size( void ) const
+  {
+    return ( unsigned int )_triangles.size( );
+  }
+
+  const FacetHierarchy::Nodes& FacetHierarchy::nodes( void ) const
+  {
+    return _nodes;
+  }
+
+} // namespace nlgeometry
@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLGEOMETRY_FACET_HIERARCHY__
+#define __NLGEOMETRY_FACET_HIERARCHY__
+
+#include "Mesh.h"
+#include "Ray.h"
+
+#include <nlgeometry/api.h>
+
+namespace nlgeometry
+{
+
+  /* \class FacetHierarchy
+   * Bounding volume hierarchy over the triangles and quads of a mesh, each
+   * quad split in two triangles, used to pick the mesh with rays. The
+   * triangle positions and the vertex centers are copied, so it can be used
+   * after clearing the mesh cpu data
+   */
+  class FacetHierarchy
+  {
+
+  public:
+
+    /**
+     * Node of the tree in 32 bytes. Inner nodes have no triangles and the
+     * index of their first child, the second one follows it. Leaf nodes have
+     * the index of their first triangle
+     */
+    typedef struct
+    {
+      float minimum[3];
+      unsigned int leftFirst;
+      float maximum[3];
+      unsigned int count;
+    } TNode;
+
+    typedef std::vector< TNode > Nodes;
+
+    /**
+     * Default constructor
+     * @param leafSize_ maximum number of triangles of a leaf
+     * @param bins_ number of bins evaluated per axis when splitting a node
+     */
+    NLGEOMETRY_API
+    FacetHierarchy( unsigned int leafSize_ = 4, unsigned int bins_ = 12 );
+
+    /**
+     * Default destructor
+     */
+    NLGEOMETRY_API
+    ~FacetHierarchy( void );
+
+    /**
+     * Method that builds the hierarchy over the triangles and quads of a mesh
+     * @param mesh_ mesh with its cpu data
+     */
+    NLGEOMETRY_API
+    void build( MeshPtr mesh_ );
+
+    /**
+     * Method that finds the closest triangle hit by a ray
+     * @param ray_ ray in mesh coordinates
+     * @param result_ hit information, only modified when there is a hit
+     * @return true if the ray hits the mesh
+     */
+    NLGEOMETRY_API
+    bool pick( const Ray& ray_, Mesh::TPickResult& result_ ) const;
+
+    /**
+     * Method that returns the number of triangles
+     * @return the number of triangles
+     */
+    NLGEOMETRY_API
+    unsigned int size( void ) const;
+
+    /**
+     * Method that returns the tree nodes, the first one being the root
+     * @return the tree nodes
+     */
+    NLGEOMETRY_API
+    const Nodes& nodes( void ) const;
+
+  protected:
+
+    typedef struct
+    {
+      //! First vertex position and the two edges from it
+      float vertex0[3];
+      float edge1[3];
+      float edge2[3];
+      //! Mesh vertex indices
+      unsigned int vertices[3];
+      //! Facet index, the lowest bit marks the quads
+      unsigned int facet;
+    } TTriangle;
+
+    //! Maximum number of triangles of a leaf
+    unsigned int _leafSize;
+
+    //! Number of bins evaluated per axis
+    unsigned int _bins;
+
+    //! Tree nodes
+    Nodes _nodes;
+
+    //! Triangles ordered so every leaf covers a range
+    std::vector< TTriangle > _triangles;
+
+    //! Center of each mesh vertex, or its position for non orbital vertices
+    std::vector< Eigen::Vector3f > _centers;
+
+  }; // class FacetHierarchy
+
+} // namespace nlgeometry
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "Frustum.h"
+
+namespace nlgeometry
+{
+
+  Frustum::Frustum( void )
+  {
+    for ( auto& plane: _planes )
+      plane = Eigen::Vector4f( 0.0f, 0.0f, 0.0f, 1.0f );
+  }
+
+  Frustum::Frustum( const Eigen::Matrix4f& viewProjection_ )
+  {
+    update( viewProjection_ );
+  }
+
+  Frustum::~Frustum( void )
+  {
+  }
+
+  void Frustum::update( const Eigen::Matrix4f& viewProjection_ )
+  {
+    const Eigen::Vector4f row0 = viewProjection_.row( 0 );
+    const Eigen::Vector4f row1 = viewProjection_.row( 1 );
+    const Eigen::Vector4f row2 = viewProjection_.row( 2 );
+    const Eigen::Vector4f row3 = viewProjection_.row( 3 );
+
+    _planes[LEFT_PLANE] = row3 + row0;
+    _planes[RIGHT_PLANE] = row3 - row0;
+    _planes[BOTTOM_PLANE] = row3 + row1;
+    _planes[TOP_PLANE] = row3 - row1;
+    _planes[NEAR_PLANE] = row3 + row2;
+    _planes[FAR_PLANE] = row3 - row2;
+
+    for ( auto& plane: _planes )
+    {
+      float norm = plane.head< 3 >( ).norm( );
+      if ( norm > 0.0f )
+        plane /= norm;
+    }
+  }
+
+  const Eigen::Vector4f& Frustum::plane( TPlane plane_ ) const
+  {
+    return _planes[plane_];
+  }
+
+  bool Frustum::contains( const Eigen::Vector3f& point_ ) const
+  {
+    for ( const auto& plane: _planes )
+      if ( plane.head< 3 >( ).dot( point_ ) + plane.w( ) < 0.0f )
+        return false;
+    return true;
+  }
+
+  bool Frustum::intersects( const AxisAlignedBoundingBox& aabb_ ) const
+  {
+    if ( !aabb_.isValid( ))
+      return true;
+
+    for ( const auto& plane: _planes )
+    {
+      // Corner of the box furthest along the plane normal
+      Eigen::Vector3f positive(
+        plane.x( ) >= 0.0f ? aabb_.maximum( ).x( ) : aabb_.minimum( ).x( ),
+        plane.y( ) >= 0.0f ? aabb_.maximum( ).y( ) : aabb_.minimum( ).y( ),
+        plane.z( ) >= 0.0f ? aabb_.maximum( ).z( ) : aabb_.minimum( ).z( ));
+      if ( plane.head< 3 >( ).dot( positive ) + plane.w( ) < 0.0f )
+        return false;
+    }
+    return true;
+  }
+
+  bool Frustum::contains( const AxisAlignedBoundingBox& aabb_ ) const
+  {
+    if ( !aabb_.isValid( ))
+      return false;
+
+    for ( const auto& plane: _planes )
+    {
+      // Corner of the box furthest against the plane normal
+      Eigen::Vector3f negative(
+        plane.x( ) >= 0.0f ? aabb_.minimum( ).x( ) : aabb_.maximum( ).x( ),
+        plane.y( ) >= 0.0f ? aabb_.minimum( ).y( ) : aabb_.maximum( ).y( ),
+        plane.z( ) >= 0.0f ? aabb_.minimum( ).z( ) : aabb_.maximum( ).z( ));
+      if ( plane.head< 3 >( ).dot( negative ) + plane.w( ) < 0.0f )
+        return false;
+    }
+    return true;
+  }
+
+} // namespace nlgeometry
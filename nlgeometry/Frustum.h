@@ -0,0 +1,122 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLGEOMETRY_FRUSTUM__
+#define __NLGEOMETRY_FRUSTUM__
+
+#include "AxisAlignedBoundingBox.h"
+
+#include <nlgeometry/api.h>
+
+namespace nlgeometry
+{
+
+  /*! \class Frustum
+   * Six planes of a view frustum pointing inwards, extracted from a
+   * projection and view matrix with the Gribb-Hartmann method
+   */
+  class Frustum
+  {
+
+  public:
+
+    typedef enum
+    {
+      LEFT_PLANE = 0,
+      RIGHT_PLANE,
+      BOTTOM_PLANE,
+      TOP_PLANE,
+      NEAR_PLANE,
+      FAR_PLANE
+    } TPlane;
+
+    /**
+     * Default constructor, the frustum contains everything
+     */
+    NLGEOMETRY_API
+    Frustum( void );
+
+    /**
+     * Constructor
+     * @param viewProjection_ product of the projection and view matrices
+     */
+    NLGEOMETRY_API
+    Frustum( const Eigen::Matrix4f& viewProjection_ );
+
+    /**
+     * Default destructor
+     */
+    NLGEOMETRY_API
+    ~Frustum( void );
+
+    /**
+     * Method that extracts the frustum planes from the given matrix
+     * @param viewProjection_ product of the projection and view matrices
+     */
+    NLGEOMETRY_API
+    void update( const Eigen::Matrix4f& viewProjection_ );
+
+    /**
+     * Method that returns a frustum plane as normal and distance with the
+     * normal pointing inside the frustum
+     * @param plane_ plane to return
+     * @return the plane coefficients
+     */
+    NLGEOMETRY_API
+    const Eigen::Vector4f& plane( TPlane plane_ ) const;
+
+    /**
+     * Method that checks if a point is inside the frustum
+     * @param point_ point to check
+     * @return true if the point is inside the frustum
+     */
+    NLGEOMETRY_API
+    bool contains( const Eigen::Vector3f& point_ ) const;
+
+    /**
+     * Method that conservatively checks if an axis aligned bounding box
+     * intersects the frustum. Invalid bounding boxes are considered
+     * visible
+     * @param aabb_ bounding box to check
+     * @return false if the bounding box is completely outside the frustum
+     */
+    NLGEOMETRY_API
+    bool intersects( const AxisAlignedBoundingBox& aabb_ ) const;
+
+    /**
+     * Method that checks if an axis aligned bounding box is completely inside
+     * the frustum
+     * @param aabb_ bounding box to check
+     * @return true if the bounding box is completely inside the frustum
+     */
+    NLGEOMETRY_API
+    bool contains( const AxisAlignedBoundingBox& aabb_ ) const;
+
+  protected:
+
+    //! Frustum planes
+    Eigen::Vector4f _planes[6];
+
+  }; // class Frustum
+
+} // namespace nlgeometry
+
+#endif
@@ -20,6 +20,7 @@
  *
  */
 #include "Mesh.h"
+#include "FacetHierarchy.h"
 
 //OpenGL
 #ifndef NEUROLOTS_SKIP_GLEW_INCLUDE
@@ -33,7 +34,11 @@
 #include <GL/glu.h>
 #endif
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace nlgeometry
@@ -44,7 +49,12 @@ namespace nlgeometry
     , _trianglesSize( 0 )
     , _quadsSize( 0 )
     , _verticesSize( 0 )
+    , _maxEdgeLength( 0.0f )
     , _facetType( Facet::TRIANGLES )
+    , _indexType( GL_UNSIGNED_INT )
+    , _indexSize( sizeof( unsigned int ))
+    , _facetHierarchy( nullptr )
+    , _uploadedBytes( 0 )
   {
     _modelMatrix = Eigen::Matrix4f::Identity( );
   }
@@ -60,6 +70,12 @@ namespace nlgeometry
   }
 
   Vertices& Mesh::vertices( void )
+  {
+    _resetFacetHierarchy( );
+    return _vertices;
+  }
+
+  const Vertices& Mesh::vertices( void ) const
   {
     return _vertices;
   }
@@ -70,11 +86,23 @@ namespace nlgeometry
   }
 
   Facets& Mesh::triangles( void )
+  {
+    _resetFacetHierarchy( );
+    return _triangles;
+  }
+
+  const Facets& Mesh::triangles( void ) const
   {
     return _triangles;
   }
 
   Facets& Mesh::quads( void )
+  {
+    _resetFacetHierarchy( );
+    return _quads;
+  }
+
+  const Facets& Mesh::quads( void ) const
   {
     return _quads;
   }
@@ -84,6 +112,36 @@ namespace nlgeometry
     return _verticesSize;
   }
 
+  Facet::TFacetType Mesh::facetType( void ) const
+  {
+    return _facetType;
+  }
+
+  unsigned int Mesh::trianglesSize( void ) const
+  {
+    return _trianglesSize;
+  }
+
+  unsigned int Mesh::quadsSize( void ) const
+  {
+    return _quadsSize;
+  }
+
+  float Mesh::maxEdgeLength( void ) const
+  {
+    return _maxEdgeLength;
+  }
+
+  unsigned int Mesh::indexType( void ) const
+  {
+    return _indexType;
+  }
+
+  unsigned int Mesh::indexSize( void ) const
+  {
+    return _indexSize;
+  }
+
   AxisAlignedBoundingBox& Mesh::aaBoundingBox( void )
   {
     return _aaBoundingBox;
@@ -101,12 +159,29 @@ namespace nlgeometry
 
   void Mesh::clearCPUData( void )
   {
-    for ( auto vertex: _vertices )
+    // Generated meshes may only reference their vertices from the facets
+    std::unordered_set< VertexPtr > vertices( _vertices.begin( ),
+                                              _vertices.end( ));
+    auto deleteFacets = [ &vertices ]( Facets& facets_ )
+    {
+      for ( auto facet: facets_ )
+      {
+        vertices.insert( facet->vertex0( ));
+        vertices.insert( facet->vertex1( ));
+        vertices.insert( facet->vertex2( ));
+        vertices.insert( facet->vertex3( ));
+        delete facet;
+      }
+      facets_.clear( );
+    };
+    deleteFacets( _lines );
+    deleteFacets( _triangles );
+    deleteFacets( _quads );
+    vertices.erase( nullptr );
+    for ( auto vertex: vertices )
       delete vertex;
     _vertices.clear( );
-    _lines.clear( );
-    _triangles.clear( );
-    _quads.clear( );
+    _resetFacetHierarchy( );
   }
 
   void Mesh::clearGPUData( void )
@@ -116,6 +191,8 @@ namespace nlgeometry
     if ( _vbos.size( ) > 0 )
       glDeleteBuffers( (GLsizei)_vbos.size( ), _vbos.data( ));
     _format.clear( );
+    _shadows.clear( );
+    _dirtyRanges.clear( );
     _verticesSize = 0;
   }
 
@@ -137,65 +214,247 @@ namespace nlgeometry
       {
         _createBuffer( format_[i], i );
       }
-      _conformVertices( );
     }
+    glBindVertexArray( _vao );
 
     Attribs attribs;
-    attribs.resize( format_.size( ));
     std::vector< unsigned int > indices;
+    _conformVertices( );
+    storeBuffers( format_, facetType_, attribs, indices, _linesSize,
+                  _trianglesSize, _quadsSize );
+    _maxEdgeLength = _computeMaxEdgeLength( );
 
-    for ( auto vertex: _vertices )
-      vertex->store( attribs, format_ );
+    // Merging ranges a few vertices apart costs less than an extra call
+    _shadows.assign( attribs.size( ), std::vector< float >( ));
+    _dirtyRanges.assign( attribs.size( ), DirtyRanges( 16 ));
+    for ( unsigned int i = 0; i < attribs.size( ); i++ )
+    {
+      _uploadBuffer( attribs[i], i );
+      if ( std::find( _shadowFormat.begin( ), _shadowFormat.end( ),
+                      _format[i] ) != _shadowFormat.end( ))
+        _shadows[i].swap( attribs[i] );
+      attribs[i].clear( );
+    }
+
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _vbos[attribs.size( )] );
+    if ( _vertices.size( ) <=
+         size_t( std::numeric_limits< unsigned short >::max( )) + 1 )
+    {
+      std::vector< unsigned short > shortIndices( indices.begin( ),
+                                                  indices.end( ));
+      _indexType = GL_UNSIGNED_SHORT;
+      _indexSize = sizeof( unsigned short );
+      glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof( unsigned short ) *
+                    shortIndices.size( ), shortIndices.data( ),
+                    GL_STATIC_DRAW );
+      _uploadedBytes += sizeof( unsigned short ) * shortIndices.size( );
+    }
+    else
+    {
+      _indexType = GL_UNSIGNED_INT;
+      _indexSize = sizeof( unsigned int );
+      glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof( unsigned int) *
+                    indices.size( ), indices.data( ), GL_STATIC_DRAW );
+      _uploadedBytes += sizeof( unsigned int ) * indices.size( );
+    }
+
+    glBindVertexArray( 0 );
+    indices.clear();
+  }
+
+  void Mesh::storeBuffers( const AttribsFormat& format_,
+                           Facet::TFacetType facetType_, Attribs& attribs_,
+                           std::vector< unsigned int >& indices_,
+                           unsigned int& linesSize_,
+                           unsigned int& trianglesSize_,
+                           unsigned int& quadsSize_ ) const
+  {
+    // Before the first upload the facet vertices not listed are ordered on
+    // a copy, leaving the vertex list untouched
+    Vertices conformed;
+    const Vertices* vertices = &_vertices;
+    if ( _verticesSize == 0 )
+    {
+      conformed = _vertices;
+      _appendFacetVertices( conformed );
+      vertices = &conformed;
+    }
+
+    attribs_.clear( );
+    attribs_.resize( format_.size( ));
+    indices_.clear( );
+
+    for ( auto vertex: *vertices )
+      vertex->store( attribs_, format_ );
 
     for ( auto line: _lines )
-      line->addIndicesAs( facetType_, indices );
-    _linesSize = ( unsigned int )_lines.size( ) * 2;
+      line->addIndicesAs( facetType_, indices_ );
+    linesSize_ = ( unsigned int )_lines.size( ) * 2;
 
     for ( auto triangle: _triangles )
-      triangle->addIndicesAs( facetType_, indices );
-    _trianglesSize = (unsigned int)_triangles.size( ) * 3;
+      triangle->addIndicesAs( facetType_, indices_ );
+    trianglesSize_ = (unsigned int)_triangles.size( ) * 3;
 
     for ( auto quad: _quads )
-      quad->addIndicesAs( facetType_, indices );
+      quad->addIndicesAs( facetType_, indices_ );
 
     switch( facetType_ )
     {
     case Facet::TRIANGLES:
-      _quadsSize = (unsigned int)_quads.size( ) * 6;
+      quadsSize_ = (unsigned int)_quads.size( ) * 6;
       break;
     case Facet::PATCHES:
-      _quadsSize = (unsigned int)_quads.size( ) * 4;
+      quadsSize_ = (unsigned int)_quads.size( ) * 4;
       break;
     }
+  }
 
-    for ( unsigned int i = 0; i < attribs.size( ); i++ )
+  void Mesh::uploadBuffer( TAttribType format_, std::vector< float >& buffer_ )
+  {
+    unsigned int vaoPosition = _attribPosition( format_ );
+    if ( vaoPosition == _format.size( ))
+      vaoPosition = 0;
+    _uploadBuffer( buffer_, vaoPosition );
+
+    if ( vaoPosition < _shadows.size( ) && !_shadows[vaoPosition].empty( ))
     {
-      _uploadBuffer( attribs[i], i );
-      attribs[i].clear( );
+      _shadows[vaoPosition] = buffer_;
+      _dirtyRanges[vaoPosition].clear( );
     }
+  }
 
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _vbos[attribs.size( )] );
-    glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof( unsigned int) *
-                  indices.size( ), indices.data( ), GL_STATIC_DRAW );
+  void Mesh::shadowAttrib( TAttribType type_ )
+  {
+    if ( std::find( _shadowFormat.begin( ), _shadowFormat.end( ), type_ ) ==
+         _shadowFormat.end( ))
+      _shadowFormat.push_back( type_ );
+  }
 
-    glBindVertexArray( 0 );
-    indices.clear();
+  std::vector< float >* Mesh::shadow( TAttribType type_ )
+  {
+    unsigned int vaoPosition = _attribPosition( type_ );
+    if ( vaoPosition >= _shadows.size( ) || _shadows[vaoPosition].empty( ))
+      return nullptr;
+    return &_shadows[vaoPosition];
   }
 
-  void Mesh::uploadBuffer( TAttribType format_, std::vector< float >& buffer_ )
+  void Mesh::markDirty( TAttribType type_, unsigned int firstVertex_,
+                        unsigned int count_ )
   {
-    unsigned int vaoPosition = 0;
-    for ( unsigned int i = 0; i < _format.size( ); i++ )
+    unsigned int vaoPosition = _attribPosition( type_ );
+    if ( vaoPosition < _dirtyRanges.size( ))
+      _dirtyRanges[vaoPosition].add( firstVertex_, count_ );
+  }
+
+  void Mesh::updateAttrib( TAttribType type_, const unsigned int* vertexIds_,
+                           unsigned int count_, const Eigen::Vector3f& value_ )
+  {
+    unsigned int vaoPosition = _attribPosition( type_ );
+    if ( vaoPosition >= _shadows.size( ) || _shadows[vaoPosition].empty( ))
+      throw std::runtime_error( "Mesh attribute without cpu copy" );
+    if ( Vertex::components( type_ ) != 3 )
+      throw std::runtime_error( "Mesh attribute without three components" );
+    for ( unsigned int i = 0; i < count_; i++ )
+      if ( vertexIds_[i] >= _verticesSize )
+        throw std::runtime_error( "Mesh vertex index out of range" );
+
+    float* shadow = _shadows[vaoPosition].data( );
+    auto& dirtyRanges = _dirtyRanges[vaoPosition];
+    for ( unsigned int i = 0; i < count_; i++ )
     {
-      if ( _format[i] == format_ )
+      float* value = shadow + size_t( vertexIds_[i] ) * 3;
+      value[0] = value_.x( );
+      value[1] = value_.y( );
+      value[2] = value_.z( );
+      dirtyRanges.add( vertexIds_[i] );
+    }
+  }
+
+  void Mesh::flushBuffers( void )
+  {
+    for ( unsigned int i = 0; i < _dirtyRanges.size( ); i++ )
+    {
+      if ( _dirtyRanges[i].empty( ))
+        continue;
+      size_t stride = sizeof( float ) * Vertex::components( _format[i] );
+      glBindBuffer( GL_ARRAY_BUFFER, _vbos[i] );
+      for ( const auto& range: _dirtyRanges[i].ranges( ))
       {
-        vaoPosition = i;
-        break;
+        size_t size = stride * ( range.second - range.first );
+        glBufferSubData( GL_ARRAY_BUFFER, stride * range.first, size,
+                         reinterpret_cast< const char* >(
+                           _shadows[i].data( )) + stride * range.first );
+        _uploadedBytes += size;
       }
+      _dirtyRanges[i].clear( );
     }
-    glBindBuffer( GL_ARRAY_BUFFER, _vbos[vaoPosition]);
-    glBufferData( GL_ARRAY_BUFFER, sizeof( float ) * buffer_.size( ),
-                  buffer_.data( ), GL_STATIC_DRAW );
+  }
+
+  size_t Mesh::uploadedBytes( void ) const
+  {
+    return _uploadedBytes;
+  }
+
+  void Mesh::resetUploadedBytes( void )
+  {
+    _uploadedBytes = 0;
+  }
+
+  Meshes Mesh::split( unsigned int maxVertices_ )
+  {
+    if ( maxVertices_ < 4 )
+      throw std::runtime_error(
+        "Mesh split needs at least four vertices per mesh" );
+
+    Meshes meshes;
+    MeshPtr mesh = nullptr;
+    std::unordered_map< VertexPtr, VertexPtr > clones;
+
+    auto splitFacets = [ & ]( const Facets& facets_, Facets Mesh::* target_ )
+    {
+      for ( auto facet: facets_ )
+      {
+        VertexPtr facetVertices[4] = { facet->vertex0( ), facet->vertex1( ),
+                                       facet->vertex2( ), facet->vertex3( ) };
+        unsigned int newVertices = 0;
+        for ( unsigned int i = 0; i < 4; i++ )
+          if ( facetVertices[i] && clones.count( facetVertices[i] ) == 0 &&
+               std::find( facetVertices, facetVertices + i,
+                          facetVertices[i] ) == facetVertices + i )
+            newVertices++;
+
+        if ( !mesh || mesh->_vertices.size( ) + newVertices > maxVertices_ )
+        {
+          mesh = new Mesh( );
+          mesh->_modelMatrix = _modelMatrix;
+          meshes.push_back( mesh );
+          clones.clear( );
+        }
+
+        for ( auto& vertex: facetVertices )
+        {
+          if ( !vertex )
+            continue;
+          auto clone = clones.find( vertex );
+          if ( clone == clones.end( ))
+          {
+            VertexPtr newVertex = vertex->clone( );
+            mesh->_vertices.push_back( newVertex );
+            clone = clones.insert( std::make_pair( vertex, newVertex )).first;
+          }
+          vertex = clone->second;
+        }
+        ( mesh->*target_ ).push_back(
+          new Facet( facetVertices[0], facetVertices[1], facetVertices[2],
+                     facetVertices[3] ));
+      }
+    };
+
+    splitFacets( _lines, &Mesh::_lines );
+    splitFacets( _triangles, &Mesh::_triangles );
+    splitFacets( _quads, &Mesh::_quads );
+
+    return meshes;
   }
 
   void Mesh::computeBoundingBox( void )
@@ -203,7 +462,7 @@ namespace nlgeometry
     Eigen::Array3f minimum =
       Eigen::Array3f::Constant( std::numeric_limits< float >::max( ));
     Eigen::Array3f maximum =
-      Eigen::Array3f::Constant( std::numeric_limits< float >::min( ));
+      Eigen::Array3f::Constant( std::numeric_limits< float >::lowest( ));
 
     const Eigen::Matrix3f rotMatrix = _modelMatrix.block( 0, 0, 3, 3 );
     const Eigen::Array3f trVec = _modelMatrix.block( 0, 3, 3, 1 );
@@ -257,11 +516,24 @@ namespace nlgeometry
     }
   }
 
+  void Mesh::computeFacetHierarchy( void )
+  {
+    if ( !_facetHierarchy )
+      _facetHierarchy = new FacetHierarchy( );
+    _facetHierarchy->build( this );
+  }
+
+  bool Mesh::pick( const Ray& ray_, TPickResult& result_ )
+  {
+    if ( !_facetHierarchy )
+      computeFacetHierarchy( );
+    return _facetHierarchy->pick( ray_, result_ );
+  }
+
   void Mesh::renderLines( void )
   {
     glBindVertexArray( _vao );
-    glDrawElements( GL_LINES, _linesSize, GL_UNSIGNED_INT,
-                    (void*) 0 );
+    glDrawElements( GL_LINES, _linesSize, _indexType, (void*) 0 );
   }
 
   void Mesh::renderTriangles( void )
@@ -270,14 +542,14 @@ namespace nlgeometry
     {
     case Facet::TRIANGLES:
       glBindVertexArray( _vao );
-      glDrawElements( GL_TRIANGLES, _trianglesSize, GL_UNSIGNED_INT,
-                      (void*) ( _linesSize * sizeof( unsigned int )));
+      glDrawElements( GL_TRIANGLES, _trianglesSize, _indexType,
+                      (void*) ( size_t( _linesSize ) * _indexSize ));
       break;
     case Facet::PATCHES:
       glBindVertexArray( _vao );
       glPatchParameteri( GL_PATCH_VERTICES, 3 );
-      glDrawElements( GL_PATCHES, _trianglesSize, GL_UNSIGNED_INT,
-                      (void*) ( _linesSize * sizeof( unsigned int )));
+      glDrawElements( GL_PATCHES, _trianglesSize, _indexType,
+                      (void*) ( size_t( _linesSize ) * _indexSize ));
       break;
     }
   }
@@ -288,20 +560,54 @@ namespace nlgeometry
     {
     case Facet::TRIANGLES:
       glBindVertexArray( _vao );
-      glDrawElements( GL_TRIANGLES, _quadsSize, GL_UNSIGNED_INT,
-                      (void*) (( _linesSize + _trianglesSize ) *
-                               sizeof( unsigned int )));
+      glDrawElements( GL_TRIANGLES, _quadsSize, _indexType,
+                      (void*) ( size_t( _linesSize + _trianglesSize ) *
+                                _indexSize ));
       break;
     case Facet::PATCHES:
       glBindVertexArray( _vao );
       glPatchParameteri( GL_PATCH_VERTICES, 4 );
-      glDrawElements( GL_PATCHES, _quadsSize, GL_UNSIGNED_INT,
-                      (void*) (( _linesSize + _trianglesSize ) *
-                               sizeof( unsigned int )));
+      glDrawElements( GL_PATCHES, _quadsSize, _indexType,
+                      (void*) ( size_t( _linesSize + _trianglesSize ) *
+                                _indexSize ));
       break;
     }
   }
 
+  void Mesh::renderTrianglesRange( unsigned int first_, unsigned int count_ )
+  {
+    unsigned int first = std::min( first_ * 3, _trianglesSize );
+    unsigned int size = std::min( count_ * 3, _trianglesSize - first );
+    glBindVertexArray( _vao );
+    GLenum mode = GL_TRIANGLES;
+    if ( _facetType == Facet::PATCHES )
+    {
+      glPatchParameteri( GL_PATCH_VERTICES, 3 );
+      mode = GL_PATCHES;
+    }
+    glDrawElements( mode, size, _indexType,
+                    (void*) ( size_t( _linesSize + first ) * _indexSize ));
+  }
+
+  void Mesh::renderQuadsRange( unsigned int first_, unsigned int count_ )
+  {
+    // Quads are uploaded as four patch vertices or as two triangles
+    unsigned int quadSize = 6;
+    GLenum mode = GL_TRIANGLES;
+    glBindVertexArray( _vao );
+    if ( _facetType == Facet::PATCHES )
+    {
+      glPatchParameteri( GL_PATCH_VERTICES, 4 );
+      quadSize = 4;
+      mode = GL_PATCHES;
+    }
+    unsigned int first = std::min( first_ * quadSize, _quadsSize );
+    unsigned int size = std::min( count_ * quadSize, _quadsSize - first );
+    glDrawElements( mode, size, _indexType,
+                    (void*) ( size_t( _linesSize + _trianglesSize + first ) *
+                              _indexSize ));
+  }
+
   void Mesh::render( void )
   {
     renderLines( );
@@ -313,45 +619,57 @@ namespace nlgeometry
   {
     if ( _verticesSize == 0 )
     {
-      std::unordered_set< VertexPtr > vertices;
-      for ( auto line: _lines )
-      {
-        vertices.insert( line->vertex0( ));
-        vertices.insert( line->vertex1( ));
-      }
-      for( auto triangle: _triangles )
-      {
-        vertices.insert( triangle->vertex0( ));
-        vertices.insert( triangle->vertex1( ));
-        vertices.insert( triangle->vertex2( ));
-      }
-      for( auto quad: _quads )
-      {
-        vertices.insert( quad->vertex0( ));
-        vertices.insert( quad->vertex1( ));
-        vertices.insert( quad->vertex2( ));
-        vertices.insert( quad->vertex3( ));
-      }
-      _vertices.clear( );
-      _vertices.insert( _vertices.begin( ), vertices.begin( ), vertices.end( ));
+      size_t listed = _vertices.size( );
+      _appendFacetVertices( _vertices );
+      if ( _vertices.size( ) != listed )
+        _resetFacetHierarchy( );
       _verticesSize = _vertices.size( );
     }
   }
 
-  void Mesh::_createBuffer( TAttribType type_, unsigned int vaoPosition_ )
+  void Mesh::_appendFacetVertices( Vertices& vertices_ ) const
   {
-    unsigned int numComponents;
-    switch( type_ )
+    // The listed vertices keep their order, so an order given by the
+    // optimizer is uploaded as is. Vertices only referenced by the facets
+    // follow in order of first use. The set is only a membership test, so
+    // the order is deterministic
+    std::unordered_set< VertexPtr > used( vertices_.begin( ),
+                                          vertices_.end( ));
+    auto addVertex = [ &vertices_, &used ]( VertexPtr vertex_ )
     {
-    case UV:
-      numComponents = 2;
-      break;
-    default:
-      numComponents = 3;
+      if ( vertex_ && used.insert( vertex_ ).second )
+        vertices_.push_back( vertex_ );
+    };
+    for ( auto line: _lines )
+    {
+      addVertex( line->vertex0( ));
+      addVertex( line->vertex1( ));
     }
+    for( auto triangle: _triangles )
+    {
+      addVertex( triangle->vertex0( ));
+      addVertex( triangle->vertex1( ));
+      addVertex( triangle->vertex2( ));
+    }
+    for( auto quad: _quads )
+    {
+      addVertex( quad->vertex0( ));
+      addVertex( quad->vertex1( ));
+      addVertex( quad->vertex2( ));
+      addVertex( quad->vertex3( ));
+    }
+  }
 
+  void Mesh::_resetFacetHierarchy( void )
+  {
+    delete _facetHierarchy;
+    _facetHierarchy = nullptr;
+  }
+
+  void Mesh::_createBuffer( TAttribType type_, unsigned int vaoPosition_ )
+  {
     glBindBuffer( GL_ARRAY_BUFFER, _vbos[vaoPosition_]);
-    glVertexAttribPointer( vaoPosition_, numComponents,
+    glVertexAttribPointer( vaoPosition_, Vertex::components( type_ ),
                            GL_FLOAT, GL_FALSE, 0, 0 );
     glEnableVertexAttribArray( vaoPosition_ );
   }
@@ -362,6 +680,15 @@ namespace nlgeometry
     glBindBuffer( GL_ARRAY_BUFFER, _vbos[vaoPosition_]);
     glBufferData( GL_ARRAY_BUFFER, sizeof( float ) * buffer_.size( ),
                   buffer_.data( ), GL_STATIC_DRAW );
+    _uploadedBytes += sizeof( float ) * buffer_.size( );
+  }
+
+  unsigned int Mesh::_attribPosition( TAttribType type_ ) const
+  {
+    for ( unsigned int i = 0; i < _format.size( ); i++ )
+      if ( _format[i] == type_ )
+        return i;
+    return ( unsigned int )_format.size( );
   }
 
   bool Mesh::_equalFormat( AttribsFormat format0_, AttribsFormat format1_ )
@@ -377,4 +704,29 @@ namespace nlgeometry
     return true;
   }
 
+  float Mesh::_computeMaxEdgeLength( void ) const
+  {
+    float length = 0.0f;
+    auto edge = [ &length ]( VertexPtr vertex0_, VertexPtr vertex1_ )
+    {
+      length = std::max( length, ( vertex1_->position( ) -
+                                   vertex0_->position( )).norm( ));
+    };
+    for ( auto triangle: _triangles )
+    {
+      edge( triangle->vertex0( ), triangle->vertex1( ));
+      edge( triangle->vertex1( ), triangle->vertex2( ));
+      edge( triangle->vertex2( ), triangle->vertex0( ));
+    }
+    // Edges of the quad patches as their tessellation levels use them
+    for ( auto quad: _quads )
+    {
+      edge( quad->vertex0( ), quad->vertex1( ));
+      edge( quad->vertex0( ), quad->vertex2( ));
+      edge( quad->vertex2( ), quad->vertex3( ));
+      edge( quad->vertex1( ), quad->vertex3( ));
+    }
+    return length;
+  }
+
 } // namespace nlgeometry
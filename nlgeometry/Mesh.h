@@ -24,12 +24,16 @@
 
 #include "Facet.h"
 #include "AxisAlignedBoundingBox.h"
+#include "DirtyRanges.h"
+#include "Ray.h"
 
 #include <nlgeometry/api.h>
 
 namespace nlgeometry
 {
 
+  class FacetHierarchy;
+
   class Mesh;
   typedef Mesh* MeshPtr;
   typedef std::vector< MeshPtr > Meshes;
@@ -40,6 +44,27 @@ namespace nlgeometry
 
   public:
 
+    /**
+     * Closest facet of the mesh hit by a ray
+     */
+    typedef struct
+    {
+      //! Distance along the ray in multiples of its direction length
+      float distance;
+      //! Hit point in mesh coordinates
+      Eigen::Vector3f point;
+      //! True if the facet is one of the quads and false if it is a triangle
+      bool quad;
+      //! Index of the facet in the mesh triangles or quads
+      unsigned int facet;
+      //! Indices in the mesh vertices of the triangle hit, half of a quad
+      unsigned int vertices[3];
+      //! Barycentric coordinates of the hit point in that triangle
+      Eigen::Vector3f barycentrics;
+      //! Morphology node position, the center of the nearest vertex
+      Eigen::Vector3f node;
+    } TPickResult;
+
     /**
     * Default constructor
     */
@@ -59,12 +84,20 @@ namespace nlgeometry
     virtual void init( void );
 
     /**
-     * Method that return the mesh vertices
+     * Method that return the mesh vertices. The facet hierarchy is reset, as
+     * the geometry may be modified through the returned reference
      * @return the mesh vertices
      */
     NLGEOMETRY_API
     Vertices& vertices( void );
 
+    /**
+     * Method that return the mesh vertices
+     * @return the mesh vertices
+     */
+    NLGEOMETRY_API
+    const Vertices& vertices( void ) const;
+
     /**
      * Method that return the mesh lines
      * @return the mesh lines
@@ -73,19 +106,35 @@ namespace nlgeometry
     Facets& lines( void );
 
     /**
-     * Method that return the mesh triangles
+     * Method that return the mesh triangles. The facet hierarchy is reset, as
+     * the geometry may be modified through the returned reference
      * @return the mesh triangles
      */
     NLGEOMETRY_API
     Facets& triangles( void );
 
     /**
-     * Method that return the returns the mesh quads
+     * Method that return the mesh triangles
+     * @return the mesh triangles
+     */
+    NLGEOMETRY_API
+    const Facets& triangles( void ) const;
+
+    /**
+     * Method that return the returns the mesh quads. The facet hierarchy is
+     * reset, as the geometry may be modified through the returned reference
      * @return the mesh quads
      */
     NLGEOMETRY_API
     Facets& quads( void );
 
+    /**
+     * Method that return the mesh quads
+     * @return the mesh quads
+     */
+    NLGEOMETRY_API
+    const Facets& quads( void ) const;
+
     /**
      * Method that return the uploaded vertices size
      * @return the uploades vertices size
@@ -93,6 +142,52 @@ namespace nlgeometry
     NLGEOMETRY_API
     unsigned int verticesSize( void );
 
+    /**
+     * Method that returns the facet type uploaded to the gpu
+     * @return the uploaded facet type
+     */
+    NLGEOMETRY_API
+    Facet::TFacetType facetType( void ) const;
+
+    /**
+     * Method that returns the number of uploaded indices of the triangles
+     * @return the number of triangles indices
+     */
+    NLGEOMETRY_API
+    unsigned int trianglesSize( void ) const;
+
+    /**
+     * Method that returns the number of uploaded indices of the quads
+     * @return the number of quads indices
+     */
+    NLGEOMETRY_API
+    unsigned int quadsSize( void ) const;
+
+    /**
+     * Method that returns the length of the longest edge of the uploaded
+     * triangles and quads, which bounds their tessellation levels. It is
+     * kept after clearing the cpu data
+     * @return the longest edge length
+     */
+    NLGEOMETRY_API
+    float maxEdgeLength( void ) const;
+
+    /**
+     * Method that returns the OpenGL type of the uploaded indices,
+     * GL_UNSIGNED_SHORT when the mesh has at most 65536 vertices and
+     * GL_UNSIGNED_INT otherwise
+     * @return the OpenGL type of the uploaded indices
+     */
+    NLGEOMETRY_API
+    unsigned int indexType( void ) const;
+
+    /**
+     * Method that returns the size in bytes of the uploaded indices
+     * @return the size in bytes of the uploaded indices
+     */
+    NLGEOMETRY_API
+    unsigned int indexSize( void ) const;
+
     /**
      * Method that returns the returns the mesh axis aligned bounding box
      * @return the mesh axis aligned bounding box
@@ -111,7 +206,10 @@ namespace nlgeometry
     float*  modelMatrixVectorized( void );
 
     /**
-     * Method that free the cpu geometric information of the mesh
+     * Method that free the cpu geometric information of the mesh, deleting
+     * its facets and every vertex listed or referenced by a facet. The mesh
+     * owns all of them, so vertex pointers kept elsewhere, as the node to
+     * vertices structures of the generator, must not be used afterwards
      */
     NLGEOMETRY_API
     void clearCPUData( void );
@@ -122,6 +220,27 @@ namespace nlgeometry
     NLGEOMETRY_API
     void clearGPUData( void );
 
+    /**
+     * Method that fills the cpu buffers that uploadGPU sends to the gpu. The
+     * vertices keep the order of the vertex list, followed by the facet
+     * vertices not listed in order of first use. The indices are ordered as
+     * lines, triangles and quads. The mesh is not modified, only the
+     * vertex identifiers the indices refer to
+     * @param format_ format of the attribute buffers
+     * @param facetType_ type of facet used to store the quads
+     * @param attribs_ buffers filled with the vertices attributes
+     * @param indices_ buffer filled with the facet indices
+     * @param linesSize_ number of indices used by the lines
+     * @param trianglesSize_ number of indices used by the triangles
+     * @param quadsSize_ number of indices used by the quads
+     */
+    NLGEOMETRY_API
+    void storeBuffers( const AttribsFormat& format_,
+                       Facet::TFacetType facetType_, Attribs& attribs_,
+                       std::vector< unsigned int >& indices_,
+                       unsigned int& linesSize_, unsigned int& trianglesSize_,
+                       unsigned int& quadsSize_ ) const;
+
     /**
      * Method that upload the geometric information of the mesh to the gpu
      * @param format_ format of the gpu buffers
@@ -138,6 +257,80 @@ namespace nlgeometry
     NLGEOMETRY_API
     void uploadBuffer( TAttribType format_, std::vector< float >& buffer_ );
 
+    /**
+     * Method that keeps a cpu copy of the given attribute from the next
+     * upload on, so it can be partially updated with updateAttrib and
+     * flushBuffers
+     * @param type_ attribute to keep
+     */
+    NLGEOMETRY_API
+    void shadowAttrib( TAttribType type_ );
+
+    /**
+     * Method that returns the cpu copy of an uploaded attribute. The
+     * modified ranges have to be marked with markDirty
+     * @param type_ attribute to return
+     * @return the cpu copy or nullptr if the attribute is not kept
+     */
+    NLGEOMETRY_API
+    std::vector< float >* shadow( TAttribType type_ );
+
+    /**
+     * Method that marks a range of vertices of a kept attribute to be
+     * uploaded on the next flushBuffers
+     * @param type_ modified attribute
+     * @param firstVertex_ first modified vertex index
+     * @param count_ number of modified vertices
+     */
+    NLGEOMETRY_API
+    void markDirty( TAttribType type_, unsigned int firstVertex_,
+                    unsigned int count_ = 1 );
+
+    /**
+     * Method that sets the value of a kept attribute for the given vertices
+     * and marks them to be uploaded on the next flushBuffers. Throws a
+     * std::runtime_error without modifying any vertex if an index is not
+     * lower than the number of uploaded vertices
+     * @param type_ attribute with three components to modify
+     * @param vertexIds_ vertex indices to modify
+     * @param count_ number of vertex indices
+     * @param value_ new value of the attribute
+     */
+    NLGEOMETRY_API
+    void updateAttrib( TAttribType type_, const unsigned int* vertexIds_,
+                       unsigned int count_, const Eigen::Vector3f& value_ );
+
+    /**
+     * Method that uploads the modified ranges of the kept attributes with a
+     * glBufferSubData call per coalesced range
+     */
+    NLGEOMETRY_API
+    void flushBuffers( void );
+
+    /**
+     * Method that returns the bytes uploaded to the gpu since the last reset
+     * @return the uploaded bytes
+     */
+    NLGEOMETRY_API
+    size_t uploadedBytes( void ) const;
+
+    /**
+     * Method that resets the uploaded bytes counter, usually once per frame
+     */
+    NLGEOMETRY_API
+    void resetUploadedBytes( void );
+
+    /**
+     * Method that splits the mesh into meshes of at most maxVertices_
+     * vertices so each one can be uploaded with 16 bits indices. The facets
+     * are distributed greedily in order and their vertices are cloned, so the
+     * resulting meshes are independent of this one
+     * @param maxVertices_ maximum number of vertices of each resulting mesh
+     * @return the resulting meshes
+     */
+    NLGEOMETRY_API
+    Meshes split( unsigned int maxVertices_ = 65536 );
+
     /**
      * Method that computes the axis aligned bounding box of the mesh geometry
      */
@@ -150,6 +343,24 @@ namespace nlgeometry
     NLGEOMETRY_API
     void computeNormals( void );
 
+    /**
+     * Method that builds the hierarchy of the mesh triangles and quads used
+     * to pick the mesh. The hierarchy is reset when the geometry is accessed
+     * for modification or cleared, and built again by the next pick
+     */
+    NLGEOMETRY_API
+    void computeFacetHierarchy( void );
+
+    /**
+     * Method that finds the closest facet hit by a ray, building the facet
+     * hierarchy if it was not computed or it was reset
+     * @param ray_ ray in mesh coordinates, before the model matrix transform
+     * @param result_ hit information, only modified when there is a hit
+     * @return true if the ray hits the mesh
+     */
+    NLGEOMETRY_API
+    bool pick( const Ray& ray_, TPickResult& result_ );
+
     /**
      * Method that render the mesh lines
      */
@@ -168,6 +379,22 @@ namespace nlgeometry
     NLGEOMETRY_API
     virtual void renderQuads( void );
 
+    /**
+     * Method that render a range of the mesh triangles
+     * @param first_ index of the first triangle
+     * @param count_ number of triangles, clamped to the mesh triangles
+     */
+    NLGEOMETRY_API
+    void renderTrianglesRange( unsigned int first_, unsigned int count_ );
+
+    /**
+     * Method that render a range of the mesh quads
+     * @param first_ index of the first quad
+     * @param count_ number of quads, clamped to the mesh quads
+     */
+    NLGEOMETRY_API
+    void renderQuadsRange( unsigned int first_, unsigned int count_ );
+
     /**
      * Method that render the all mesh
      */
@@ -178,13 +405,21 @@ namespace nlgeometry
 
     void _conformVertices( void );
 
+    void _appendFacetVertices( Vertices& vertices_ ) const;
+
+    void _resetFacetHierarchy( void );
+
     void _createBuffer( TAttribType type_, unsigned int vaoPosition_ );
 
     void _uploadBuffer( std::vector< float >& buffer_,
                         unsigned int vaoPosition_ );
 
+    unsigned int _attribPosition( TAttribType type_ ) const;
+
     bool _equalFormat( AttribsFormat format0_, AttribsFormat format1_ );
 
+    float _computeMaxEdgeLength( void ) const;
+
   protected:
     //! Mesh vertices
     Vertices _vertices;
@@ -219,6 +454,9 @@ namespace nlgeometry
     //! Size of uploaded vertices
     unsigned int _verticesSize;
 
+    //! Longest edge of the uploaded triangles and quads
+    float _maxEdgeLength;
+
     //! Model matrix of the mesh
     Eigen::Matrix4f _modelMatrix;
 
@@ -228,6 +466,27 @@ namespace nlgeometry
     //! Facet type uploaded to the gpu
     Facet::TFacetType _facetType;
 
+    //! OpenGL type of the uploaded indices
+    unsigned int _indexType;
+
+    //! Size in bytes of the uploaded indices
+    unsigned int _indexSize;
+
+    //! Hierarchy of the facets used to pick the mesh
+    FacetHierarchy* _facetHierarchy;
+
+    //! Attributes whose cpu copy is kept after uploading them
+    AttribsFormat _shadowFormat;
+
+    //! Cpu copy of the kept attributes, in the gpu format order
+    Attribs _shadows;
+
+    //! Modified vertices of the kept attributes, in the gpu format order
+    std::vector< DirtyRanges > _dirtyRanges;
+
+    //! Bytes uploaded to the gpu since the last reset
+    size_t _uploadedBytes;
+
   }; // class Mesh
 
 } // namespace nlgeometry
@@ -0,0 +1,249 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace nlgeometry
+{
+
+  MeshOptimizer::TOptimizationStats MeshOptimizer::optimize(
+    MeshPtr mesh_, unsigned int cacheSize_ )
+  {
+    TOptimizationStats stats;
+
+    stats.linesBefore = acmr( mesh_->lines( ), cacheSize_ );
+    stats.trianglesBefore = acmr( mesh_->triangles( ), cacheSize_ );
+    stats.quadsBefore = acmr( mesh_->quads( ), cacheSize_ );
+
+    optimizeFacets( mesh_->lines( ), cacheSize_ );
+    optimizeFacets( mesh_->triangles( ), cacheSize_ );
+    optimizeFacets( mesh_->quads( ), cacheSize_ );
+    optimizeVertices( mesh_ );
+
+    stats.linesAfter = acmr( mesh_->lines( ), cacheSize_ );
+    stats.trianglesAfter = acmr( mesh_->triangles( ), cacheSize_ );
+    stats.quadsAfter = acmr( mesh_->quads( ), cacheSize_ );
+
+    return stats;
+  }
+
+  void MeshOptimizer::optimizeFacets( Facets& facets_,
+                                      unsigned int cacheSize_ )
+  {
+    if ( facets_.size( ) < 2 || cacheSize_ == 0 )
+      return;
+
+    std::vector< unsigned int > offsets;
+    std::vector< unsigned int > indices;
+    unsigned int numVertices;
+    _indexFacets( facets_, offsets, indices, numVertices );
+    unsigned int numFacets = ( unsigned int )facets_.size( );
+
+    // Vertex to facets adjacency, ignoring repeated vertices inside a facet
+    std::vector< unsigned int > live( numVertices, 0 );
+    unsigned int maxFacetSize = 0;
+    for ( unsigned int f = 0; f < numFacets; f++ )
+    {
+      maxFacetSize = std::max( maxFacetSize, offsets[f+1] - offsets[f] );
+      for ( unsigned int i = offsets[f]; i < offsets[f+1]; i++ )
+        if ( std::find( &indices[offsets[f]], &indices[i], indices[i] ) ==
+             &indices[i] )
+          live[indices[i]]++;
+    }
+    std::vector< unsigned int > adjacencyOffsets( numVertices + 1, 0 );
+    for ( unsigned int v = 0; v < numVertices; v++ )
+      adjacencyOffsets[v+1] = adjacencyOffsets[v] + live[v];
+    std::vector< unsigned int > adjacency( adjacencyOffsets[numVertices] );
+    std::vector< unsigned int > fill( adjacencyOffsets.begin( ),
+                                      adjacencyOffsets.end( ) - 1 );
+    for ( unsigned int f = 0; f < numFacets; f++ )
+      for ( unsigned int i = offsets[f]; i < offsets[f+1]; i++ )
+        if ( std::find( &indices[offsets[f]], &indices[i], indices[i] ) ==
+             &indices[i] )
+          adjacency[fill[indices[i]]++] = f;
+
+    // Expected number of new vertices entering the cache per emitted facet
+    const unsigned int newVerticesPerFacet =
+      std::max( 1u, maxFacetSize - 1 );
+
+    std::vector< unsigned int > cacheTime( numVertices, 0 );
+    std::vector< bool > emitted( numFacets, false );
+    std::vector< unsigned int > deadEnd;
+    std::vector< unsigned int > candidates;
+    std::vector< unsigned int > order;
+    order.reserve( numFacets );
+
+    unsigned int timeStamp = cacheSize_ + 1;
+    unsigned int cursor = 1;
+    int fanning = 0;
+
+    while ( fanning >= 0 )
+    {
+      candidates.clear( );
+      for ( unsigned int a = adjacencyOffsets[fanning];
+            a < adjacencyOffsets[fanning+1]; a++ )
+      {
+        unsigned int f = adjacency[a];
+        if ( emitted[f] )
+          continue;
+        for ( unsigned int i = offsets[f]; i < offsets[f+1]; i++ )
+        {
+          unsigned int v = indices[i];
+          if ( std::find( &indices[offsets[f]], &indices[i], v ) !=
+               &indices[i] )
+            continue;
+          deadEnd.push_back( v );
+          candidates.push_back( v );
+          live[v]--;
+          if ( timeStamp - cacheTime[v] > cacheSize_ )
+            cacheTime[v] = timeStamp++;
+        }
+        emitted[f] = true;
+        order.push_back( f );
+      }
+
+      // Next fanning vertex: the candidate that stays longest in the cache
+      int next = -1;
+      int bestPriority = -1;
+      for ( auto v: candidates )
+      {
+        if ( live[v] == 0 )
+          continue;
+        int priority = 0;
+        if ( timeStamp - cacheTime[v] + newVerticesPerFacet * live[v] <=
+             cacheSize_ )
+          priority = ( int )( timeStamp - cacheTime[v] );
+        if ( priority > bestPriority )
+        {
+          bestPriority = priority;
+          next = ( int )v;
+        }
+      }
+
+      // Dead end: go back through the recently used vertices or scan forward
+      while ( next < 0 && !deadEnd.empty( ))
+      {
+        unsigned int v = deadEnd.back( );
+        deadEnd.pop_back( );
+        if ( live[v] > 0 )
+          next = ( int )v;
+      }
+      while ( next < 0 && cursor < numVertices )
+      {
+        if ( live[cursor] > 0 )
+          next = ( int )cursor;
+        cursor++;
+      }
+      fanning = next;
+    }
+
+    Facets reordered;
+    reordered.reserve( numFacets );
+    for ( auto f: order )
+      reordered.push_back( facets_[f] );
+    facets_.swap( reordered );
+  }
+
+  void MeshOptimizer::optimizeVertices( MeshPtr mesh_ )
+  {
+    std::unordered_set< VertexPtr > used;
+    Vertices vertices;
+    vertices.reserve( mesh_->vertices( ).size( ));
+
+    const Facets* facetLists[3] =
+      { &mesh_->lines( ), &mesh_->triangles( ), &mesh_->quads( ) };
+    for ( auto facets: facetLists )
+    {
+      for ( auto facet: *facets )
+      {
+        VertexPtr facetVertices[4] = { facet->vertex0( ), facet->vertex1( ),
+                                       facet->vertex2( ), facet->vertex3( ) };
+        for ( auto vertex: facetVertices )
+          if ( vertex && used.insert( vertex ).second )
+            vertices.push_back( vertex );
+      }
+    }
+    for ( auto vertex: mesh_->vertices( ))
+      if ( used.insert( vertex ).second )
+        vertices.push_back( vertex );
+
+    mesh_->vertices( ).swap( vertices );
+  }
+
+  float MeshOptimizer::acmr( const Facets& facets_, unsigned int cacheSize_ )
+  {
+    if ( facets_.empty( ))
+      return 0.0f;
+
+    std::vector< unsigned int > offsets;
+    std::vector< unsigned int > indices;
+    unsigned int numVertices;
+    _indexFacets( facets_, offsets, indices, numVertices );
+
+    const unsigned int never = std::numeric_limits< unsigned int >::max( );
+    std::vector< unsigned int > insertedAt( numVertices, never );
+    unsigned int misses = 0;
+    for ( auto v: indices )
+    {
+      if ( insertedAt[v] == never || misses - insertedAt[v] >= cacheSize_ )
+      {
+        insertedAt[v] = misses;
+        misses++;
+      }
+    }
+    return float( misses ) / float( facets_.size( ));
+  }
+
+  void MeshOptimizer::_indexFacets( const Facets& facets_,
+                                    std::vector< unsigned int >& offsets_,
+                                    std::vector< unsigned int >& indices_,
+                                    unsigned int& numVertices_ )
+  {
+    std::unordered_map< VertexPtr, unsigned int > vertexIndex;
+    offsets_.clear( );
+    indices_.clear( );
+    offsets_.reserve( facets_.size( ) + 1 );
+    indices_.reserve( facets_.size( ) * 4 );
+    offsets_.push_back( 0 );
+
+    for ( auto facet: facets_ )
+    {
+      VertexPtr facetVertices[4] = { facet->vertex0( ), facet->vertex1( ),
+                                     facet->vertex2( ), facet->vertex3( ) };
+      for ( auto vertex: facetVertices )
+      {
+        if ( !vertex )
+          continue;
+        auto inserted = vertexIndex.insert(
+          std::make_pair( vertex, ( unsigned int )vertexIndex.size( )));
+        indices_.push_back( inserted.first->second );
+      }
+      offsets_.push_back(( unsigned int )indices_.size( ));
+    }
+    numVertices_ = ( unsigned int )vertexIndex.size( );
+  }
+
+} // namespace nlgeometry
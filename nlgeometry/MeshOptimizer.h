@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLGEOMETRY_MESH_OPTIMIZER__
+#define __NLGEOMETRY_MESH_OPTIMIZER__
+
+#include "Mesh.h"
+
+#include <nlgeometry/api.h>
+
+namespace nlgeometry
+{
+
+  /* \class MeshOptimizer */
+  class MeshOptimizer
+  {
+
+  public:
+
+    /**
+     * Average cache miss ratio (vertex shader invocations per facet) of the
+     * mesh facets before and after the optimization
+     */
+    typedef struct
+    {
+      float linesBefore;
+      float linesAfter;
+      float trianglesBefore;
+      float trianglesAfter;
+      float quadsBefore;
+      float quadsAfter;
+    } TOptimizationStats;
+
+    /**
+     * Static method that reorders the mesh lines, triangles and quads to
+     * improve the post-transform vertex cache reuse and then reorders the mesh
+     * vertices by first use to improve the vertex fetch locality
+     * @param mesh_ mesh to optimize
+     * @param cacheSize_ size of the simulated post-transform vertex cache
+     * @return the average cache miss ratio before and after the optimization
+     */
+    NLGEOMETRY_API
+    static TOptimizationStats optimize( MeshPtr mesh_,
+                                        unsigned int cacheSize_ = 32 );
+
+    /**
+     * Static method that reorders the given facets to improve the
+     * post-transform vertex cache reuse using the Tipsify algorithm. The
+     * facets are treated as primitives of two, three or four vertices so
+     * quads keep their patch form
+     * @param facets_ facets to reorder
+     * @param cacheSize_ size of the simulated post-transform vertex cache
+     */
+    NLGEOMETRY_API
+    static void optimizeFacets( Facets& facets_,
+                                unsigned int cacheSize_ = 32 );
+
+    /**
+     * Static method that reorders the mesh vertices in order of first use by
+     * the mesh lines, triangles and quads. Vertices not referenced by any
+     * facet are kept at the end
+     * @param mesh_ mesh which vertices are reordered
+     */
+    NLGEOMETRY_API
+    static void optimizeVertices( MeshPtr mesh_ );
+
+    /**
+     * Static method that computes the average cache miss ratio of the given
+     * facets simulating a FIFO post-transform vertex cache
+     * @param facets_ facets to evaluate
+     * @param cacheSize_ size of the simulated post-transform vertex cache
+     * @return the number of cache misses per facet
+     */
+    NLGEOMETRY_API
+    static float acmr( const Facets& facets_, unsigned int cacheSize_ = 32 );
+
+  protected:
+
+    static void _indexFacets( const Facets& facets_,
+                              std::vector< unsigned int >& offsets_,
+                              std::vector< unsigned int >& indices_,
+                              unsigned int& numVertices_ );
+
+  }; // class MeshOptimizer
+
+} // namespace nlgeometry
+
+#endif
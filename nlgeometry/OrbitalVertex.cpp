@@ -32,6 +32,7 @@ namespace nlgeometry
     : Vertex( position_, Eigen::Vector3f( 0.0f, 0.0f, 0.0f ), color_ )
     , _center( center_ )
     , _tangent( tangent_ )
+    , _nodeId( -1 )
   {
 
   }
@@ -40,6 +41,7 @@ namespace nlgeometry
     : Vertex( other_ )
     , _center( other_.center( ))
     , _tangent( other_.tangent( ))
+    , _nodeId( other_.nodeId( ))
   {
 
   }
@@ -69,6 +71,16 @@ namespace nlgeometry
     return _tangent;
   }
 
+  int& OrbitalVertex::nodeId( void )
+  {
+    return _nodeId;
+  }
+
+  int OrbitalVertex::nodeId( void ) const
+  {
+    return _nodeId;
+  }
+
   void OrbitalVertex::displace( const Eigen::Vector3f& displacement_ )
   {
     _position += displacement_;
@@ -119,6 +131,10 @@ namespace nlgeometry
       buffer_.push_back( _tangent.y( ));
       buffer_.push_back( _tangent.z( ));
       break;
+    case NODE_ID:
+      // Exact up to 2^24 nodes
+      buffer_.push_back( float( _nodeId ));
+      break;
     default:
       Vertex::store( buffer_, attribType_ );
       break;
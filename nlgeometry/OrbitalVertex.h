@@ -83,6 +83,17 @@ namespace nlgeometry
     NLGEOMETRY_API
     const Eigen::Vector3f& tangent( void ) const;
 
+    /**
+     * Method that returns the index of the morphology node of the orbital
+     * vertex, stored as the NODE_ID attribute
+     * @return the node index or -1 if the vertex has no node
+     */
+    NLGEOMETRY_API
+    int& nodeId( void );
+
+    NLGEOMETRY_API
+    int nodeId( void ) const;
+
     /**
      * Method to displace the orbital vertex position
      * @param displacement_ displacement applied to the orbital vertex position
@@ -140,6 +151,9 @@ namespace nlgeometry
     //! Orbital Vertex tangent
     Eigen::Vector3f _tangent;
 
+    //! Morphology node index, -1 if the vertex has no node
+    int _nodeId;
+
   }; // class OrbitalVertex
 
 } // namespace nlgeomtry
@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "Ray.h"
+
+namespace nlgeometry
+{
+
+  Ray::Ray( const Eigen::Vector3f& origin_,
+            const Eigen::Vector3f& direction_ )
+    : _origin( origin_ )
+    , _direction( direction_ )
+    , _invDirection( direction_.cwiseInverse( ))
+  {
+  }
+
+  Ray::~Ray( void )
+  {
+  }
+
+  const Eigen::Vector3f& Ray::origin( void ) const
+  {
+    return _origin;
+  }
+
+  const Eigen::Vector3f& Ray::direction( void ) const
+  {
+    return _direction;
+  }
+
+  Eigen::Vector3f Ray::point( float distance_ ) const
+  {
+    return _origin + _direction * distance_;
+  }
+
+  bool Ray::intersects( const AxisAlignedBoundingBox& aabb_,
+                        float& distance_ ) const
+  {
+    if ( !aabb_.isValid( ))
+      return false;
+
+    Eigen::Vector3f t0 =
+      ( aabb_.minimum( ) - _origin ).cwiseProduct( _invDirection );
+    Eigen::Vector3f t1 =
+      ( aabb_.maximum( ) - _origin ).cwiseProduct( _invDirection );
+    float tNear = std::max( t0.cwiseMin( t1 ).maxCoeff( ), 0.0f );
+    float tFar = t0.cwiseMax( t1 ).minCoeff( );
+    if ( tNear > tFar )
+      return false;
+    distance_ = tNear;
+    return true;
+  }
+
+} // namespace nlgeometry
@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLGEOMETRY_RAY__
+#define __NLGEOMETRY_RAY__
+
+#include "AxisAlignedBoundingBox.h"
+
+#include <nlgeometry/api.h>
+
+namespace nlgeometry
+{
+
+  /* \class Ray */
+  class Ray
+  {
+
+  public:
+
+    /**
+     * Constructor
+     * @param origin_ ray origin
+     * @param direction_ ray direction, distances along the ray are measured
+     * in multiples of its length
+     */
+    NLGEOMETRY_API
+    Ray( const Eigen::Vector3f& origin_, const Eigen::Vector3f& direction_ );
+
+    /**
+     * Default destructor
+     */
+    NLGEOMETRY_API
+    ~Ray( void );
+
+    /**
+     * Method that returns the ray origin
+     * @return the ray origin
+     */
+    NLGEOMETRY_API
+    const Eigen::Vector3f& origin( void ) const;
+
+    /**
+     * Method that returns the ray direction
+     * @return the ray direction
+     */
+    NLGEOMETRY_API
+    const Eigen::Vector3f& direction( void ) const;
+
+    /**
+     * Method that returns the point of the ray at the given distance
+     * @param distance_ distance from the origin
+     * @return the point of the ray
+     */
+    NLGEOMETRY_API
+    Eigen::Vector3f point( float distance_ ) const;
+
+    /**
+     * Method that checks if the ray hits an axis aligned bounding box using
+     * the slabs method
+     * @param aabb_ bounding box to check
+     * @param distance_ distance at which the ray enters the bounding box, zero
+     * if the origin is inside
+     * @return true if the ray hits the bounding box
+     */
+    NLGEOMETRY_API
+    bool intersects( const AxisAlignedBoundingBox& aabb_,
+                     float& distance_ ) const;
+
+  protected:
+
+    //! Ray origin
+    Eigen::Vector3f _origin;
+
+    //! Ray direction
+    Eigen::Vector3f _direction;
+
+    //! Component wise inverse of the direction
+    Eigen::Vector3f _invDirection;
+
+  }; // class Ray
+
+} // namespace nlgeometry
+
+#endif
@@ -20,6 +20,7 @@
  *
  */
 #include "SectionQuad.h"
+#include "CrossSection.h"
 
 #include <nlgeometry/api.h>
 
@@ -264,115 +265,15 @@ namespace nlgeometry
   Eigen::Quaternion< float > SectionQuad::getZRotation(
     SectionQuadPtr quad0_, SectionQuadPtr quad1_ )
   {
-    Eigen::Quaternion< float > q;
-      auto quad0 = quad0_->clone( );
-      auto quad1 = quad1_->clone( );
-
-      quad0->normalize( );
-      quad1->normalize( );
-
-      std::vector< OrbitalVertexPtr > ids0( 4 );
-      std::vector< OrbitalVertexPtr > ids1( 4 );
-
-      ids0[0] = quad0->vertex0( ); ids0[1] = quad0->vertex1( );
-      ids0[2] = quad0->vertex2( ); ids0[3] = quad0->vertex3( );
-
-      ids1[0] = quad1->vertex0( ); ids1[1] = quad1->vertex3( );
-      ids1[2] = quad1->vertex2( ); ids1[3] = quad1->vertex1( );
-
-      Eigen::Vector3f normal0 = quad0->normal( );
-      Eigen::Vector3f normal1 = quad1->normal( );
-      q.setFromTwoVectors( normal0, normal1 );
-      quad0->rotate( q );
-
-      unsigned int offset = 0;
-      Eigen::Vector3f refDir = ids0[0]->position( ) - ids0[0]->center( );
-      Eigen::Vector3f newDir;
-      refDir.normalize( );
-      auto maxCos = -1.0f;
-      for ( unsigned int i = 0; i < 4; i++ )
-      {
-        newDir = ids1[i]->position( ) - ids1[i]->center( );
-        newDir.normalize( );
-        auto cos =
-          refDir.dot( newDir );
-        if ( cos > maxCos )
-        {
-          maxCos = cos;
-          offset = i;
-        }
-      }
-
-      newDir = ids1[offset]->position( ) - ids1[offset]->center( );
-      newDir.normalize( );
-      q.setFromTwoVectors( refDir, newDir );
-
-      quad0->deleteVertices( );
-      quad1->deleteVertices( );
-      delete quad0;
-      delete quad1;
-      return q;
+    return CrossSection::getZRotation( CrossSection( *quad0_ ),
+                                       CrossSection( *quad1_ ));
   }
 
   float SectionQuad::getZAngle(
     SectionQuadPtr quad0_, SectionQuadPtr quad1_ )
   {
-    Eigen::Quaternion< float > q;
-    auto quad0 = quad0_->clone( );
-    auto quad1 = quad1_->clone( );
-
-    quad0->normalize( );
-    quad1->normalize( );
-
-    std::vector< OrbitalVertexPtr > ids0( 4 );
-    std::vector< OrbitalVertexPtr > ids1( 4 );
-
-    ids0[0] = quad0->vertex0( ); ids0[1] = quad0->vertex1( );
-    ids0[2] = quad0->vertex2( ); ids0[3] = quad0->vertex3( );
-
-    ids1[0] = quad1->vertex0( ); ids1[1] = quad1->vertex3( );
-    ids1[2] = quad1->vertex2( ); ids1[3] = quad1->vertex1( );
-
-    Eigen::Vector3f normal0 = quad0->normal( );
-    Eigen::Vector3f normal1 = quad1->normal( );
-    q.setFromTwoVectors( normal0, normal1 );
-    quad0->rotate( q );
-
-    unsigned int offset = 0;
-    Eigen::Vector3f refDir = ids0[0]->position( ) - ids0[0]->center( );
-    Eigen::Vector3f newDir;
-    refDir.normalize( );
-    auto maxCos = -1.0f;
-    for ( unsigned int i = 0; i < 4; i++ )
-    {
-      newDir = ids1[i]->position( ) - ids1[i]->center( );
-      newDir.normalize( );
-      auto cos =
-        refDir.dot( newDir );
-      if ( cos > maxCos )
-      {
-        maxCos = cos;
-        offset = i;
-      }
-    }
-
-    newDir = ids1[offset]->position( ) - ids1[offset]->center( );
-    newDir.normalize( );
-
-    Eigen::Vector3f normalAxis =
-      refDir.cross( newDir );
-    float sinNormalAxis = normalAxis.norm( );
-    if ( quad0->normal( ).dot( normalAxis ) < 0.0f )
-    {
-      sinNormalAxis *= -1.0f;
-    }
-    float result = atan2( sinNormalAxis, refDir.dot( newDir ));
-
-    quad0->deleteVertices( );
-    quad1->deleteVertices( );
-    delete quad0;
-    delete quad1;
-    return result;
+    return CrossSection::getZAngle( CrossSection( *quad0_ ),
+                                    CrossSection( *quad1_ ));
   }
 
 } // namespace nlgeometry
@@ -149,6 +149,9 @@ namespace nlgeometry
       buffer_.push_back( _uv.x( ) );
       buffer_.push_back( _uv.y( ) );
       break;
+    case NODE_ID:
+      buffer_.push_back( -1.0f );
+      break;
     default:
       break;
     }
@@ -164,6 +167,19 @@ namespace nlgeometry
       store( attribs_[i], format_[i]);
     }
   }
+  unsigned int Vertex::components( const TAttribType attribType_ )
+  {
+    switch( attribType_ )
+    {
+    case UV:
+      return 2;
+    case NODE_ID:
+      return 1;
+    default:
+      return 3;
+    }
+  }
+
 
   VertexPtr Vertex::clone( void )
   {
@@ -42,7 +42,8 @@ namespace nlgeometry
       COLOR,
       CENTER,
       TANGENT,
-      UV
+      UV,
+      NODE_ID
     } TAttribType;
 
     typedef std::vector< std::vector< float >> Attribs;
@@ -180,6 +181,14 @@ namespace nlgeometry
     NLGEOMETRY_API
     void store( Attribs& attribs_, const AttribsFormat format_ );
 
+    /**
+     * Static method that returns the number of floats of an attribute
+     * @param attribType_ attribute type
+     * @return the number of floats of the attribute
+     */
+    NLGEOMETRY_API
+    static unsigned int components( const TAttribType attribType_ );
+
     /**
      * Method that return a cloned vertex
      * @return a cloned vertex from the actual vertex
@@ -0,0 +1,117 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "ObjStreamWriter.h"
+
+#include <stdexcept>
+#include <unordered_map>
+
+namespace nlgeometry
+{
+
+  ObjStreamWriter::ObjStreamWriter( const std::string& fileName_,
+                                    const std::string& headerString_ )
+    : _stream( fileName_.c_str( ))
+    , _vertices( 0 )
+    , _triangles( 0 )
+  {
+    if ( !_stream.is_open( ))
+      throw std::runtime_error( fileName_ + ": Error creating the file" );
+    _stream << headerString_ << "\n" << std::endl;
+  }
+
+  ObjStreamWriter::~ObjStreamWriter( void )
+  {
+    close( );
+  }
+
+  void ObjStreamWriter::writeMesh( const MeshPtr mesh_ )
+  {
+    if ( !_stream.is_open( ))
+      throw std::runtime_error( "Obj stream writer already closed" );
+
+    // Vertices numbered by first use in the facets, as the generated meshes
+    // only keep their vertices in the facets
+    std::unordered_map< VertexPtr, unsigned int > vertexId;
+    auto addVertex = [ & ]( VertexPtr vertex_ )
+    {
+      if ( !vertex_ )
+        throw std::runtime_error( "Obj stream writer facet without vertex" );
+      if ( !vertexId.emplace( vertex_, _vertices + 1 ).second )
+        return;
+      ++_vertices;
+      _stream << "v " << vertex_->position( ).x( ) << " "
+              << vertex_->position( ).y( ) << " "
+              << vertex_->position( ).z( ) << "\n";
+      _stream << "vn " << vertex_->normal( ).x( ) << " "
+              << vertex_->normal( ).y( ) << " "
+              << vertex_->normal( ).z( ) << "\n";
+    };
+    for ( auto triangle: mesh_->triangles( ))
+    {
+      addVertex( triangle->vertex0( ));
+      addVertex( triangle->vertex1( ));
+      addVertex( triangle->vertex2( ));
+    }
+    for ( auto quad: mesh_->quads( ))
+    {
+      addVertex( quad->vertex0( ));
+      addVertex( quad->vertex1( ));
+      addVertex( quad->vertex2( ));
+      addVertex( quad->vertex3( ));
+    }
+
+    auto face = [ & ]( VertexPtr vertex0_, VertexPtr vertex1_,
+                       VertexPtr vertex2_ )
+    {
+      unsigned int id0 = vertexId.at( vertex0_ );
+      unsigned int id1 = vertexId.at( vertex1_ );
+      unsigned int id2 = vertexId.at( vertex2_ );
+      _stream << "f " << id0 << "//" << id0 << " " << id1 << "//" << id1
+              << " " << id2 << "//" << id2 << "\n";
+      _triangles++;
+    };
+    for ( auto triangle: mesh_->triangles( ))
+      face( triangle->vertex0( ), triangle->vertex1( ), triangle->vertex2( ));
+    for ( auto quad: mesh_->quads( ))
+    {
+      face( quad->vertex0( ), quad->vertex1( ), quad->vertex2( ));
+      face( quad->vertex1( ), quad->vertex3( ), quad->vertex2( ));
+    }
+  }
+
+  unsigned int ObjStreamWriter::vertices( void ) const
+  {
+    return _vertices;
+  }
+
+  unsigned int ObjStreamWriter::triangles( void ) const
+  {
+    return _triangles;
+  }
+
+  void ObjStreamWriter::close( void )
+  {
+    if ( _stream.is_open( ))
+      _stream.close( );
+  }
+
+} // namespace nlgeometry
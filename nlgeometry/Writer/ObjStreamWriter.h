@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLGEOMETRY_OBJ_STREAM_WRITER__
+#define __NLGEOMETRY_OBJ_STREAM_WRITER__
+
+#include "../Mesh.h"
+
+#include <fstream>
+
+#include <nlgeometry/api.h>
+
+namespace nlgeometry
+{
+
+  /* \class ObjStreamWriter
+   * Writes several meshes to one obj file as they arrive, so the whole
+   * geometry never has to be kept in memory. The faces of each mesh refer to
+   * the vertices used by its facets, written just before them
+   */
+  class ObjStreamWriter
+  {
+
+  public:
+
+    /**
+     * Default constructor, creates the file and writes the header
+     * @param fileName_ path of the obj file
+     * @param headerString_ text written at the start of the file
+     */
+    NLGEOMETRY_API
+    ObjStreamWriter( const std::string& fileName_,
+                     const std::string& headerString_ = "" );
+
+    /**
+     * Default destructor, closes the file
+     */
+    NLGEOMETRY_API
+    ~ObjStreamWriter( void );
+
+    /**
+     * Method that appends the triangles and quads of a mesh and the vertices
+     * they use, numbered by first use. The mesh vertex list is not needed
+     * @param mesh_ mesh to append
+     */
+    NLGEOMETRY_API
+    void writeMesh( const MeshPtr mesh_ );
+
+    /**
+     * Method that returns the number of vertices written
+     * @return the number of vertices written
+     */
+    NLGEOMETRY_API
+    unsigned int vertices( void ) const;
+
+    /**
+     * Method that returns the number of triangles written, two per quad
+     * @return the number of triangles written
+     */
+    NLGEOMETRY_API
+    unsigned int triangles( void ) const;
+
+    /**
+     * Method that flushes and closes the file
+     */
+    NLGEOMETRY_API
+    void close( void );
+
+  protected:
+
+    //! Output file
+    std::ofstream _stream;
+
+    //! Number of vertices written
+    unsigned int _vertices;
+
+    //! Number of triangles written
+    unsigned int _triangles;
+
+  }; // class ObjStreamWriter
+
+} // namespace nlgeometry
+
+#endif
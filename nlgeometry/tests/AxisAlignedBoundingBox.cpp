@@ -51,3 +51,25 @@ BOOST_AUTO_TEST_CASE( axisAlignedBoundingbox_constructor )
     BOOST_CHECK_EQUAL( aabb.maximum( ), maximum );
   }
 }
+
+BOOST_AUTO_TEST_CASE( axisAlignedBoundingbox_transformed )
+{
+  AxisAlignedBoundingBox invalid;
+  BOOST_CHECK( !invalid.isValid( ));
+
+  AxisAlignedBoundingBox aabb( Eigen::Vector3f( -1.0f, -2.0f, -3.0f ),
+                               Eigen::Vector3f( 1.0f, 2.0f, 3.0f ));
+  BOOST_CHECK( aabb.isValid( ));
+
+  Eigen::Affine3f transform( Eigen::Translation3f( 10.0f, 0.0f, 0.0f ) *
+                             Eigen::AngleAxisf( float( M_PI ) * 0.5f,
+                                                Eigen::Vector3f::UnitZ( )));
+  AxisAlignedBoundingBox result = aabb.transformed( transform.matrix( ));
+
+  BOOST_CHECK( result.minimum( ).isApprox(
+                 Eigen::Vector3f( 8.0f, -1.0f, -3.0f ), 1e-5f ));
+  BOOST_CHECK( result.maximum( ).isApprox(
+                 Eigen::Vector3f( 12.0f, 1.0f, 3.0f ), 1e-5f ));
+
+  BOOST_CHECK( !invalid.transformed( transform.matrix( )).isValid( ));
+}
@@ -0,0 +1,224 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include <algorithm>
+#include <random>
+
+#include <nlgeometry/nlgeometry.h>
+#include "nlgeometryTests.h"
+
+using namespace nlgeometry;
+
+static std::vector< AxisAlignedBoundingBox > randomBounds( unsigned int size_ )
+{
+  std::mt19937 generator( 7 );
+  std::uniform_real_distribution< float > position( -100.0f, 100.0f );
+  std::uniform_real_distribution< float > size( 0.1f, 5.0f );
+  std::vector< AxisAlignedBoundingBox > bounds;
+  for ( unsigned int i = 0; i < size_; i++ )
+  {
+    Eigen::Vector3f minimum( position( generator ), position( generator ),
+                             position( generator ));
+    Eigen::Vector3f extent( size( generator ), size( generator ),
+                            size( generator ));
+    bounds.push_back( AxisAlignedBoundingBox( minimum, minimum + extent ));
+  }
+  return bounds;
+}
+
+static bool overlaps( const AxisAlignedBoundingBox& a_,
+                      const AxisAlignedBoundingBox& b_ )
+{
+  return ( a_.minimum( ).array( ) <= b_.maximum( ).array( )).all( ) &&
+    ( a_.maximum( ).array( ) >= b_.minimum( ).array( )).all( );
+}
+
+static void checkNodes( const BoundingVolumeHierarchy& bvh_ )
+{
+  // Every node contains its primitives and the root covers all of them
+  const BoundingVolumeHierarchy::Nodes& nodes = bvh_.nodes( );
+  unsigned int leafPrimitives = 0;
+  for ( unsigned int i = 0; i < nodes.size( ); i++ )
+  {
+    const BoundingVolumeHierarchy::TNode& node = nodes[i];
+    if ( node.left == 0 )
+    {
+      leafPrimitives += node.count;
+      continue;
+    }
+    BOOST_CHECK_EQUAL( nodes[node.left].parent, i );
+    BOOST_CHECK_EQUAL( node.count,
+                       nodes[node.left].count + nodes[node.left+1].count );
+    AxisAlignedBoundingBox children = nodes[node.left].bounds;
+    children.expand( nodes[node.left+1].bounds );
+    BOOST_CHECK_EQUAL( children.minimum( ), node.bounds.minimum( ));
+    BOOST_CHECK_EQUAL( children.maximum( ), node.bounds.maximum( ));
+  }
+  BOOST_CHECK_EQUAL( leafPrimitives, nodes[0].count );
+}
+
+BOOST_AUTO_TEST_CASE( boundingVolumeHierarchy_build )
+{
+  std::vector< AxisAlignedBoundingBox > bounds = randomBounds( 5000 );
+  bounds[10] = AxisAlignedBoundingBox( );
+
+  for ( unsigned int threads = 1; threads <= 4; threads += 3 )
+  {
+    BoundingVolumeHierarchy bvh;
+    bvh.build( bounds, threads );
+    BOOST_CHECK_EQUAL( bvh.size( ), 5000 );
+    BOOST_CHECK_EQUAL( bvh.nodes( )[0].count, 4999 );
+    BOOST_CHECK( bvh.nodes( ).size( ) < 2 * 4999 );
+    checkNodes( bvh );
+  }
+
+  BoundingVolumeHierarchy empty;
+  empty.build( std::vector< AxisAlignedBoundingBox >( ));
+  std::vector< unsigned int > result( 1, 0 );
+  empty.query( Frustum( ), result );
+  BOOST_CHECK( result.empty( ));
+}
+
+BOOST_AUTO_TEST_CASE( boundingVolumeHierarchy_query )
+{
+  std::vector< AxisAlignedBoundingBox > bounds = randomBounds( 2000 );
+  bounds[10] = AxisAlignedBoundingBox( );
+  BoundingVolumeHierarchy bvh;
+  bvh.build( bounds );
+
+  // Box query against a linear scan, the invalid bounds are always returned
+  AxisAlignedBoundingBox box( Eigen::Vector3f( -20.0f, -30.0f, -10.0f ),
+                              Eigen::Vector3f( 40.0f, 10.0f, 50.0f ));
+  std::vector< unsigned int > result;
+  std::vector< unsigned int > expected( 1, 10 );
+  bvh.query( box, result );
+  for ( unsigned int i = 0; i < bounds.size( ); i++ )
+    if ( i != 10 && overlaps( bounds[i], box ))
+      expected.push_back( i );
+  std::sort( result.begin( ), result.end( ));
+  std::sort( expected.begin( ), expected.end( ));
+  BOOST_CHECK( result == expected );
+
+  // Frustum query against a linear scan
+  Eigen::Matrix4f viewProjection = Eigen::Matrix4f::Identity( ) * 0.02f;
+  viewProjection( 3, 3 ) = 1.0f;
+  viewProjection( 0, 3 ) = 0.5f;
+  Frustum frustum( viewProjection );
+  bvh.query( frustum, result );
+  expected.clear( );
+  for ( unsigned int i = 0; i < bounds.size( ); i++ )
+    if ( frustum.intersects( bounds[i] ))
+      expected.push_back( i );
+  std::sort( result.begin( ), result.end( ));
+  BOOST_CHECK( result == expected );
+  BOOST_CHECK( result.size( ) < bounds.size( ));
+
+  // Ray query sorted by distance
+  Ray ray( Eigen::Vector3f( -150.0f, 0.0f, 0.0f ),
+           Eigen::Vector3f( 1.0f, 0.05f, 0.02f ));
+  bvh.query( ray, result );
+  expected.clear( );
+  float distance, previous = 0.0f;
+  for ( unsigned int i = 0; i < bounds.size( ); i++ )
+    if ( ray.intersects( bounds[i], distance ))
+      expected.push_back( i );
+  BOOST_CHECK_EQUAL( result.size( ), expected.size( ));
+  for ( auto primitive: result )
+  {
+    BOOST_CHECK( ray.intersects( bounds[primitive], distance ));
+    BOOST_CHECK( distance >= previous );
+    previous = distance;
+  }
+}
+
+BOOST_AUTO_TEST_CASE( boundingVolumeHierarchy_update )
+{
+  std::vector< AxisAlignedBoundingBox > bounds = randomBounds( 1000 );
+  BoundingVolumeHierarchy bvh;
+  bvh.build( bounds );
+
+  // Move a primitive far away, it is found at its new position
+  AxisAlignedBoundingBox moved( Eigen::Vector3f( 500.0f, 500.0f, 500.0f ),
+                                Eigen::Vector3f( 501.0f, 501.0f, 501.0f ));
+  bvh.update( 42, moved );
+  checkNodes( bvh );
+  BOOST_CHECK_EQUAL( bvh.nodes( )[0].bounds.maximum( ),
+                     Eigen::Vector3f( 501.0f, 501.0f, 501.0f ));
+  std::vector< unsigned int > result;
+  bvh.query( moved, result );
+  BOOST_CHECK_EQUAL( result.size( ), 1 );
+  BOOST_CHECK_EQUAL( result[0], 42 );
+
+  BOOST_CHECK_THROW( bvh.update( 42, AxisAlignedBoundingBox( )),
+                     std::runtime_error );
+
+  // Moving it back restores the root bounds
+  bvh.update( 42, bounds[42] );
+  bvh.refit( );
+  checkNodes( bvh );
+  BOOST_CHECK( bvh.nodes( )[0].bounds.maximum( ).maxCoeff( ) < 500.0f );
+
+  Meshes meshes;
+  BOOST_CHECK_THROW( bvh.build( meshes,
+                                std::vector< Eigen::Matrix4f >( 1 )),
+                     std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( boundingVolumeHierarchy_pick )
+{
+  // Rows of unit quads along the x axis, each one moved by its model matrix
+  Meshes meshes;
+  std::vector< Eigen::Matrix4f > models;
+  for ( unsigned int i = 0; i < 10; i++ )
+  {
+    MeshPtr mesh = new Mesh( );
+    auto& vertices = mesh->vertices( );
+    vertices.push_back( new Vertex( Eigen::Vector3f( 0.0f, 0.0f, 0.0f )));
+    vertices.push_back( new Vertex( Eigen::Vector3f( 1.0f, 0.0f, 0.0f )));
+    vertices.push_back( new Vertex( Eigen::Vector3f( 0.0f, 1.0f, 0.0f )));
+    vertices.push_back( new Vertex( Eigen::Vector3f( 1.0f, 1.0f, 0.0f )));
+    mesh->quads( ).push_back(
+      new Facet( vertices[0], vertices[1], vertices[2], vertices[3] ));
+    mesh->computeBoundingBox( );
+    meshes.push_back( mesh );
+    Eigen::Matrix4f model = Eigen::Matrix4f::Identity( );
+    model( 0, 3 ) = float( i % 5 ) * 2.0f;
+    model( 2, 3 ) = float( i / 5 );
+    models.push_back( model );
+  }
+  BoundingVolumeHierarchy bvh;
+  bvh.build( meshes, models );
+
+  // The mesh closer to the ray origin is hit before the one behind it
+  unsigned int mesh = 0;
+  Mesh::TPickResult result;
+  Ray ray( Eigen::Vector3f( 4.5f, 0.5f, 5.0f ), -Eigen::Vector3f::UnitZ( ));
+  BOOST_CHECK( bvh.pick( ray, meshes, models, mesh, result ));
+  BOOST_CHECK_EQUAL( mesh, 7 );
+  BOOST_CHECK_CLOSE( result.distance, 4.0f, 1e-4f );
+  BOOST_CHECK( result.point.isApprox( Eigen::Vector3f( 0.5f, 0.5f, 0.0f )));
+
+  Ray miss( Eigen::Vector3f( 1.5f, 0.5f, 5.0f ), -Eigen::Vector3f::UnitZ( ));
+  BOOST_CHECK( !bvh.pick( miss, meshes, models, mesh, result ));
+
+  for ( auto m: meshes )
+    delete m;
+}
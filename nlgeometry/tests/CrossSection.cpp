@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <limits.h>
+#include <nlgeometry/nlgeometry.h>
+#include "nlgeometryTests.h"
+
+using namespace nlgeometry;
+
+BOOST_AUTO_TEST_CASE( crossSection_constructor )
+{
+  CrossSection crossSection;
+  BOOST_CHECK_EQUAL( crossSection.position( 0 ),
+                     Eigen::Vector3f( 0.0f, 0.0f, -1.0f ));
+  BOOST_CHECK_EQUAL( crossSection.position( 1 ),
+                     Eigen::Vector3f( -1.0f, 0.0f, 0.0f ));
+  BOOST_CHECK_EQUAL( crossSection.position( 2 ),
+                     Eigen::Vector3f( 0.0f, 0.0f, 1.0f ));
+  BOOST_CHECK_EQUAL( crossSection.position( 3 ),
+                     Eigen::Vector3f( 1.0f, 0.0f, 0.0f ));
+  BOOST_CHECK_EQUAL( crossSection.center( ),
+                     Eigen::Vector3f( 0.0f, 0.0f, 0.0f ));
+
+  auto inversed = crossSection.inversed( );
+  BOOST_CHECK_EQUAL( inversed.position( 0 ), crossSection.position( 0 ));
+  BOOST_CHECK_EQUAL( inversed.position( 1 ), crossSection.position( 3 ));
+  BOOST_CHECK_EQUAL( inversed.position( 2 ), crossSection.position( 2 ));
+  BOOST_CHECK_EQUAL( inversed.position( 3 ), crossSection.position( 1 ));
+
+  crossSection.place( Eigen::Vector3f( 1.0f, 2.0f, 3.0f ));
+  crossSection.norm( 2.0f );
+  BOOST_CHECK_EQUAL( crossSection.center( ),
+                     Eigen::Vector3f( 1.0f, 2.0f, 3.0f ));
+  BOOST_CHECK_EQUAL( crossSection.position( 0 ),
+                     Eigen::Vector3f( 1.0f, 2.0f, 1.0f ));
+  BOOST_CHECK_EQUAL( crossSection.position( 3 ),
+                     Eigen::Vector3f( 3.0f, 2.0f, 3.0f ));
+}
+
+BOOST_AUTO_TEST_CASE( crossSection_section_quad )
+{
+  Eigen::Quaternion< float > q;
+  q.setFromTwoVectors( Eigen::Vector3f( 0.0f, 1.0f, 0.0f ),
+                       Eigen::Vector3f( 1.0f, 1.0f, 0.5f ).normalized( ));
+  Eigen::Vector3f position( 4.0f, -2.0f, 1.0f );
+
+  auto crossSection = CrossSection::identity( );
+  crossSection.rotate( q );
+  crossSection.place( position );
+  crossSection.norm( 0.5f );
+
+  auto quad = SectionQuad::identity( );
+  quad->rotate( q );
+  quad->place( position );
+  quad->norm( 0.5f );
+
+  auto materialized = crossSection.materialize( );
+  BOOST_CHECK_EQUAL( materialized->vertex0( )->position( ),
+                     quad->vertex0( )->position( ));
+  BOOST_CHECK_EQUAL( materialized->vertex1( )->position( ),
+                     quad->vertex1( )->position( ));
+  BOOST_CHECK_EQUAL( materialized->vertex2( )->position( ),
+                     quad->vertex2( )->position( ));
+  BOOST_CHECK_EQUAL( materialized->vertex3( )->position( ),
+                     quad->vertex3( )->position( ));
+  BOOST_CHECK_EQUAL( materialized->vertex0( )->center( ), position );
+  BOOST_CHECK( crossSection.normal( ).isApprox( quad->normal( )));
+
+  CrossSection copy( *quad );
+  BOOST_CHECK_EQUAL( copy.position( 2 ), quad->vertex2( )->position( ));
+  BOOST_CHECK_EQUAL( copy.center( ), quad->vertex2( )->center( ));
+
+  auto other = CrossSection::identity( );
+  other.rotate( Eigen::Quaternion< float >(
+    Eigen::AngleAxis< float >( 0.3f, Eigen::Vector3f( 0.0f, 1.0f, 0.0f ))));
+  BOOST_CHECK_CLOSE( CrossSection::getZAngle( other, CrossSection( )),
+                     -0.3f, 1e-3f );
+
+  materialized->deleteVertices( );
+  quad->deleteVertices( );
+  delete materialized;
+  delete quad;
+}
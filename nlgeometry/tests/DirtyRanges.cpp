@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <limits.h>
+#include <nlgeometry/nlgeometry.h>
+#include "nlgeometryTests.h"
+
+using namespace nlgeometry;
+
+BOOST_AUTO_TEST_CASE( dirtyRanges_add )
+{
+  DirtyRanges dirtyRanges;
+  BOOST_CHECK( dirtyRanges.empty( ));
+
+  dirtyRanges.add( 10, 2 );
+  dirtyRanges.add( 0 );
+  dirtyRanges.add( 20, 5 );
+  dirtyRanges.add( 5, 0 );
+  BOOST_CHECK( dirtyRanges.ranges( ) ==
+               Ranges({ Range( 0, 1 ), Range( 10, 12 ), Range( 20, 25 )}));
+  BOOST_CHECK_EQUAL( dirtyRanges.size( ), 8 );
+
+  // Adjacent and overlapping ranges are coalesced
+  dirtyRanges.add( 12, 3 );
+  dirtyRanges.add( 1 );
+  BOOST_CHECK( dirtyRanges.ranges( ) ==
+               Ranges({ Range( 0, 2 ), Range( 10, 15 ), Range( 20, 25 )}));
+
+  dirtyRanges.add( 11, 12 );
+  BOOST_CHECK( dirtyRanges.ranges( ) ==
+               Ranges({ Range( 0, 2 ), Range( 10, 25 )}));
+  BOOST_CHECK_EQUAL( dirtyRanges.size( ), 17 );
+
+  dirtyRanges.clear( );
+  BOOST_CHECK( dirtyRanges.empty( ));
+  BOOST_CHECK_EQUAL( dirtyRanges.size( ), 0 );
+}
+
+BOOST_AUTO_TEST_CASE( dirtyRanges_gap )
+{
+  DirtyRanges dirtyRanges( 4 );
+  dirtyRanges.add( 0 );
+  dirtyRanges.add( 5 );
+  dirtyRanges.add( 20 );
+  dirtyRanges.add( 14 );
+  BOOST_CHECK( dirtyRanges.ranges( ) ==
+               Ranges({ Range( 0, 6 ), Range( 14, 15 ), Range( 20, 21 )}));
+
+  dirtyRanges.add( 16 );
+  BOOST_CHECK( dirtyRanges.ranges( ) ==
+               Ranges({ Range( 0, 6 ), Range( 14, 21 )}));
+
+  dirtyRanges.add( 10 );
+  BOOST_CHECK( dirtyRanges.ranges( ) == Ranges({ Range( 0, 21 )}));
+}
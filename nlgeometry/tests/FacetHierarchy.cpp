@@ -0,0 +1,164 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include <nlgeometry/nlgeometry.h>
+#include "nlgeometryTests.h"
+
+using namespace nlgeometry;
+
+// Sphere of quads with orbital vertices around the origin and a triangle fan
+// closing each pole
+static MeshPtr sphereMesh( unsigned int rings_, unsigned int sectors_ )
+{
+  MeshPtr mesh = new Mesh( );
+  auto& vertices = mesh->vertices( );
+  for ( unsigned int i = 1; i < rings_; i++ )
+  {
+    float theta = float( M_PI ) * i / rings_;
+    for ( unsigned int j = 0; j < sectors_; j++ )
+    {
+      float phi = 2.0f * float( M_PI ) * j / sectors_;
+      Eigen::Vector3f position( std::sin( theta ) * std::cos( phi ),
+                                std::sin( theta ) * std::sin( phi ),
+                                std::cos( theta ));
+      vertices.push_back( new OrbitalVertex(
+        position, Eigen::Vector3f( 0.0f, 0.0f, position.z( ))));
+    }
+  }
+  for ( unsigned int i = 0; i + 2 < rings_; i++ )
+    for ( unsigned int j = 0; j < sectors_; j++ )
+    {
+      unsigned int next = ( j + 1 ) % sectors_;
+      mesh->quads( ).push_back( new Facet(
+        vertices[i*sectors_+j], vertices[i*sectors_+next],
+        vertices[(i+1)*sectors_+j], vertices[(i+1)*sectors_+next] ));
+    }
+  VertexPtr north = new OrbitalVertex( Eigen::Vector3f::UnitZ( ));
+  VertexPtr south = new OrbitalVertex( -Eigen::Vector3f::UnitZ( ));
+  vertices.push_back( north );
+  vertices.push_back( south );
+  unsigned int last = ( rings_ - 2 ) * sectors_;
+  for ( unsigned int j = 0; j < sectors_; j++ )
+  {
+    unsigned int next = ( j + 1 ) % sectors_;
+    mesh->triangles( ).push_back(
+      new Facet( north, vertices[j], vertices[next] ));
+    mesh->triangles( ).push_back(
+      new Facet( south, vertices[last+next], vertices[last+j] ));
+  }
+  return mesh;
+}
+
+BOOST_AUTO_TEST_CASE( facetHierarchy_pick )
+{
+  MeshPtr mesh = new Mesh( );
+  auto& vertices = mesh->vertices( );
+  vertices.push_back( new Vertex( Eigen::Vector3f( 0.0f, 0.0f, 0.0f )));
+  vertices.push_back( new Vertex( Eigen::Vector3f( 1.0f, 0.0f, 0.0f )));
+  vertices.push_back( new Vertex( Eigen::Vector3f( 0.0f, 1.0f, 0.0f )));
+  vertices.push_back( new OrbitalVertex( Eigen::Vector3f( 1.0f, 1.0f, 0.0f ),
+                                         Eigen::Vector3f( 5.0f, 5.0f, 5.0f )));
+  mesh->quads( ).push_back(
+    new Facet( vertices[0], vertices[1], vertices[2], vertices[3] ));
+  mesh->triangles( ).push_back(
+    new Facet( vertices[0], vertices[1], vertices[2] ));
+
+  // The ray misses the triangle and hits the second half of the quad
+  Mesh::TPickResult result;
+  Ray ray( Eigen::Vector3f( 0.8f, 0.9f, 1.0f ), -Eigen::Vector3f::UnitZ( ));
+  BOOST_CHECK( mesh->pick( ray, result ));
+  BOOST_CHECK( result.quad );
+  BOOST_CHECK_EQUAL( result.facet, 0 );
+  BOOST_CHECK_CLOSE( result.distance, 1.0f, 1e-4f );
+  BOOST_CHECK( result.point.isApprox( Eigen::Vector3f( 0.8f, 0.9f, 0.0f )));
+
+  // Second half of the quad: vertices 1, 3 and 2, closest to the third one
+  BOOST_CHECK_EQUAL( result.vertices[0], 1 );
+  BOOST_CHECK_EQUAL( result.vertices[1], 3 );
+  BOOST_CHECK_EQUAL( result.vertices[2], 2 );
+  Eigen::Vector3f interpolated =
+    result.barycentrics[0] * vertices[1]->position( ) +
+    result.barycentrics[1] * vertices[3]->position( ) +
+    result.barycentrics[2] * vertices[2]->position( );
+  BOOST_CHECK( interpolated.isApprox( result.point ));
+  BOOST_CHECK_EQUAL( result.node, Eigen::Vector3f( 5.0f, 5.0f, 5.0f ));
+
+  Ray miss( Eigen::Vector3f( 2.0f, 2.0f, 1.0f ), -Eigen::Vector3f::UnitZ( ));
+  BOOST_CHECK( !mesh->pick( miss, result ));
+
+  // Modifying the geometry rebuilds the hierarchy in the next pick
+  mesh->computeFacetHierarchy( );
+  for ( auto vertex: mesh->vertices( ))
+    vertex->position( ).z( ) -= 1.0f;
+  BOOST_CHECK( mesh->pick( ray, result ));
+  BOOST_CHECK_CLOSE( result.distance, 2.0f, 1e-4f );
+  BOOST_CHECK_EQUAL( result.node, Eigen::Vector3f( 5.0f, 5.0f, 5.0f ));
+
+  // Clearing the cpu data also clears the hierarchy
+  mesh->clearCPUData( );
+  BOOST_CHECK( !mesh->pick( ray, result ));
+  delete mesh;
+}
+
+BOOST_AUTO_TEST_CASE( facetHierarchy_sphere )
+{
+  MeshPtr mesh = sphereMesh( 200, 400 );
+  FacetHierarchy hierarchy;
+  hierarchy.build( mesh );
+  BOOST_CHECK_EQUAL( hierarchy.size( ),
+                     mesh->triangles( ).size( ) + 2 * mesh->quads( ).size( ));
+  BOOST_CHECK_EQUAL( sizeof( FacetHierarchy::TNode ), 32 );
+
+  std::mt19937 generator( 3 );
+  std::uniform_real_distribution< float > coordinate( -1.2f, 1.2f );
+  unsigned int hits = 0;
+  auto start = std::chrono::steady_clock::now( );
+  for ( unsigned int i = 0; i < 1000; i++ )
+  {
+    Eigen::Vector3f origin( coordinate( generator ), coordinate( generator ),
+                            5.0f );
+    Ray ray( origin, -Eigen::Vector3f::UnitZ( ));
+    Mesh::TPickResult result;
+    bool hit = hierarchy.pick( ray, result );
+    float radius = origin.head< 2 >( ).norm( );
+
+    // Rays well inside or outside the sphere silhouette
+    if ( radius < 0.95f )
+    {
+      BOOST_CHECK( hit );
+      BOOST_CHECK_CLOSE( result.point.norm( ), 1.0f, 0.1f );
+      BOOST_CHECK( result.point.z( ) > 0.0f );
+      BOOST_CHECK_CLOSE( result.node.z( ), result.point.z( ), 5.0f );
+      hits++;
+    }
+    else if ( radius > 1.0f )
+      BOOST_CHECK( !hit );
+  }
+  auto elapsed = std::chrono::duration_cast< std::chrono::microseconds >(
+    std::chrono::steady_clock::now( ) - start ).count( );
+  BOOST_CHECK( hits > 0 );
+  BOOST_TEST_MESSAGE( "Average pick time " << elapsed / 1000.0 << " us" );
+  delete mesh;
+}
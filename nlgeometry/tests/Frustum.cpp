@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include <nlgeometry/nlgeometry.h>
+#include "nlgeometryTests.h"
+
+using namespace nlgeometry;
+
+BOOST_AUTO_TEST_CASE( frustum_intersects )
+{
+  // Orthographic volume from -1 to 1 in every axis
+  Frustum frustum( Eigen::Matrix4f::Identity( ));
+
+  BOOST_CHECK( frustum.contains( Eigen::Vector3f::Zero( )));
+  BOOST_CHECK( !frustum.contains( Eigen::Vector3f( 2.0f, 0.0f, 0.0f )));
+
+  BOOST_CHECK( frustum.intersects( AxisAlignedBoundingBox(
+    Eigen::Vector3f( -0.5f, -0.5f, -0.5f ),
+    Eigen::Vector3f( 0.5f, 0.5f, 0.5f ))));
+  BOOST_CHECK( frustum.intersects( AxisAlignedBoundingBox(
+    Eigen::Vector3f( 0.5f, 0.5f, 0.5f ),
+    Eigen::Vector3f( 3.0f, 3.0f, 3.0f ))));
+  BOOST_CHECK( !frustum.intersects( AxisAlignedBoundingBox(
+    Eigen::Vector3f( 2.0f, -0.5f, -0.5f ),
+    Eigen::Vector3f( 3.0f, 0.5f, 0.5f ))));
+  BOOST_CHECK( !frustum.intersects( AxisAlignedBoundingBox(
+    Eigen::Vector3f( -0.5f, -0.5f, -3.0f ),
+    Eigen::Vector3f( 0.5f, 0.5f, -2.0f ))));
+
+  // Invalid bounding boxes are never culled
+  BOOST_CHECK( frustum.intersects( AxisAlignedBoundingBox( )));
+
+  // Moving the view brings the box inside
+  Eigen::Matrix4f view = Eigen::Matrix4f::Identity( );
+  view( 0, 3 ) = -2.5f;
+  frustum.update( view );
+  BOOST_CHECK( frustum.intersects( AxisAlignedBoundingBox(
+    Eigen::Vector3f( 2.0f, -0.5f, -0.5f ),
+    Eigen::Vector3f( 3.0f, 0.5f, 0.5f ))));
+  BOOST_CHECK( frustum.plane( Frustum::LEFT_PLANE ).head< 3 >( ).isApprox(
+                 Eigen::Vector3f::UnitX( )));
+}
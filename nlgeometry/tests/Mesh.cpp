@@ -20,6 +20,7 @@
  *
  */
 
+#include <algorithm>
 #include <limits.h>
 #include <nlgeometry/nlgeometry.h>
 #include "nlgeometryTests.h"
@@ -43,3 +44,89 @@ BOOST_AUTO_TEST_CASE( mesh_constructor )
   BOOST_CHECK_EQUAL( aabb.minimum( ), minimum );
   BOOST_CHECK_EQUAL( aabb.maximum( ), maximum );
 }
+
+BOOST_AUTO_TEST_CASE( mesh_split )
+{
+  Mesh mesh;
+  unsigned int size = 20;
+  for ( unsigned int i = 0; i <= size; i++ )
+    for ( unsigned int j = 0; j <= size; j++ )
+      mesh.vertices( ).push_back(
+        new Vertex( Eigen::Vector3f( float( i ), float( j ), 0.0f )));
+  auto& vertices = mesh.vertices( );
+  for ( unsigned int i = 0; i < size; i++ )
+    for ( unsigned int j = 0; j < size; j++ )
+      mesh.quads( ).push_back(
+        new Facet( vertices[i*(size+1)+j], vertices[i*(size+1)+j+1],
+                   vertices[(i+1)*(size+1)+j],
+                   vertices[(i+1)*(size+1)+j+1] ));
+  mesh.triangles( ).push_back(
+    new Facet( vertices[0], vertices[1], vertices[size+1] ));
+
+  BOOST_CHECK_EQUAL( mesh.indexSize( ), sizeof( unsigned int ));
+
+  Meshes meshes = mesh.split( 100 );
+  BOOST_CHECK( meshes.size( ) > 1 );
+
+  unsigned int quads = 0;
+  unsigned int triangles = 0;
+  for ( auto part: meshes )
+  {
+    BOOST_CHECK( part->vertices( ).size( ) <= 100 );
+    for ( auto quad: part->quads( ))
+    {
+      BOOST_CHECK( std::find( part->vertices( ).begin( ),
+                              part->vertices( ).end( ), quad->vertex3( )) !=
+                   part->vertices( ).end( ));
+      BOOST_CHECK_EQUAL( quad->vertex3( )->position( ) -
+                         quad->vertex0( )->position( ),
+                         Eigen::Vector3f( 1.0f, 1.0f, 0.0f ));
+    }
+    quads += ( unsigned int )part->quads( ).size( );
+    triangles += ( unsigned int )part->triangles( ).size( );
+  }
+  BOOST_CHECK_EQUAL( quads, size * size );
+  BOOST_CHECK_EQUAL( triangles, 1 );
+
+  BOOST_CHECK_EQUAL( mesh.split( ).size( ), 1 );
+  BOOST_CHECK_THROW( mesh.split( 3 ), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( mesh_vertexOrder )
+{
+  Mesh mesh;
+  auto v0 = new Vertex( Eigen::Vector3f( 0.0f, 0.0f, 0.0f ));
+  auto v1 = new Vertex( Eigen::Vector3f( 1.0f, 0.0f, 0.0f ));
+  auto v2 = new Vertex( Eigen::Vector3f( 0.0f, 1.0f, 0.0f ));
+  auto v3 = new Vertex( Eigen::Vector3f( 1.0f, 1.0f, 0.0f ));
+  mesh.vertices( ).push_back( v2 );
+  mesh.vertices( ).push_back( v1 );
+  mesh.triangles( ).push_back( new Facet( v0, v1, v2 ));
+  mesh.triangles( ).push_back( new Facet( v1, v3, v2 ));
+
+  // The listed vertices keep their order, the rest follow by first use
+  AttribsFormat format( 1, POSITION );
+  Attribs attribs;
+  std::vector< unsigned int > indices;
+  unsigned int lines, triangles, quads;
+  mesh.storeBuffers( format, Facet::TRIANGLES, attribs, indices, lines,
+                     triangles, quads );
+  BOOST_CHECK_EQUAL( attribs[0].size( ), 12 );
+  BOOST_CHECK_EQUAL( v2->id( ), 0 );
+  BOOST_CHECK_EQUAL( v1->id( ), 1 );
+  BOOST_CHECK_EQUAL( v0->id( ), 2 );
+  BOOST_CHECK_EQUAL( v3->id( ), 3 );
+
+  // Storing the buffers leaves the mesh as it was
+  BOOST_CHECK_EQUAL( mesh.verticesSize( ), 0 );
+  const Vertices& vertices =
+    static_cast< const Mesh& >( mesh ).vertices( );
+  BOOST_CHECK_EQUAL( vertices.size( ), 2 );
+  BOOST_CHECK( vertices[0] == v2 );
+  BOOST_CHECK( vertices[1] == v1 );
+  BOOST_CHECK_EQUAL( attribs[0][0], 0.0f );
+  BOOST_CHECK_EQUAL( attribs[0][1], 1.0f );
+  BOOST_CHECK_EQUAL( indices[0], 2 );
+  BOOST_CHECK_EQUAL( indices[1], 1 );
+  BOOST_CHECK_EQUAL( indices[2], 0 );
+}
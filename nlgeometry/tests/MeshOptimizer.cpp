@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <algorithm>
+#include <random>
+#include <nlgeometry/nlgeometry.h>
+#include "nlgeometryTests.h"
+
+using namespace nlgeometry;
+
+static MeshPtr shuffledGrid( unsigned int size_ )
+{
+  MeshPtr mesh = new Mesh( );
+  for ( unsigned int i = 0; i <= size_; i++ )
+    for ( unsigned int j = 0; j <= size_; j++ )
+      mesh->vertices( ).push_back(
+        new Vertex( Eigen::Vector3f( float( i ), float( j ), 0.0f )));
+
+  for ( unsigned int i = 0; i < size_; i++ )
+    for ( unsigned int j = 0; j < size_; j++ )
+    {
+      auto& v = mesh->vertices( );
+      unsigned int row = size_ + 1;
+      mesh->quads( ).push_back(
+        new Facet( v[i*row+j], v[i*row+j+1], v[(i+1)*row+j],
+                   v[(i+1)*row+j+1] ));
+    }
+
+  std::mt19937 generator( 17 );
+  std::shuffle( mesh->quads( ).begin( ), mesh->quads( ).end( ), generator );
+  std::shuffle( mesh->vertices( ).begin( ), mesh->vertices( ).end( ),
+                generator );
+  return mesh;
+}
+
+BOOST_AUTO_TEST_CASE( meshOptimizer_acmr )
+{
+  Facets facets;
+  auto v0 = new Vertex( Eigen::Vector3f( 0.0f, 0.0f, 0.0f ));
+  auto v1 = new Vertex( Eigen::Vector3f( 1.0f, 0.0f, 0.0f ));
+  auto v2 = new Vertex( Eigen::Vector3f( 0.0f, 1.0f, 0.0f ));
+  auto v3 = new Vertex( Eigen::Vector3f( 1.0f, 1.0f, 0.0f ));
+  facets.push_back( new Facet( v0, v1, v2 ));
+  facets.push_back( new Facet( v1, v3, v2 ));
+
+  BOOST_CHECK_EQUAL( MeshOptimizer::acmr( facets ), 2.0f );
+  BOOST_CHECK_EQUAL( MeshOptimizer::acmr( Facets( )), 0.0f );
+}
+
+BOOST_AUTO_TEST_CASE( meshOptimizer_optimize )
+{
+  MeshPtr mesh = shuffledGrid( 64 );
+  Facets original = mesh->quads( );
+
+  auto stats = MeshOptimizer::optimize( mesh );
+
+  BOOST_CHECK( stats.quadsAfter < stats.quadsBefore );
+  BOOST_CHECK_EQUAL( stats.quadsAfter,
+                     MeshOptimizer::acmr( mesh->quads( )));
+  BOOST_CHECK_EQUAL( mesh->quads( ).size( ), original.size( ));
+  BOOST_CHECK( std::is_permutation( original.begin( ), original.end( ),
+                                    mesh->quads( ).begin( )));
+  BOOST_CHECK_EQUAL( mesh->vertices( ).size( ), 65u * 65u );
+
+  // Vertices must appear in order of first use by the quads
+  auto& vertices = mesh->vertices( );
+  unsigned int next = 0;
+  for ( auto quad: mesh->quads( ))
+  {
+    VertexPtr quadVertices[4] = { quad->vertex0( ), quad->vertex1( ),
+                                  quad->vertex2( ), quad->vertex3( ) };
+    for ( auto vertex: quadVertices )
+    {
+      auto position = std::find( vertices.begin( ), vertices.begin( ) + next,
+                                 vertex ) - vertices.begin( );
+      if ( position == next )
+      {
+        BOOST_CHECK( vertices[next] == vertex );
+        next++;
+      }
+    }
+  }
+  BOOST_CHECK_EQUAL( next, vertices.size( ));
+}
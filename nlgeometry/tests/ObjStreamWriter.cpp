@@ -0,0 +1,127 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <nlgeometry/nlgeometry.h>
+#include "nlgeometryTests.h"
+
+using namespace nlgeometry;
+
+static MeshPtr triangleMesh( float offset_ )
+{
+  auto mesh = new Mesh( );
+  for ( unsigned int i = 0; i < 3; i++ )
+    mesh->vertices( ).push_back( new Vertex(
+      Eigen::Vector3f( offset_ + float( i % 2 ), float( i / 2 ), 0.0f ),
+      Eigen::Vector3f( 0.0f, 0.0f, 1.0f )));
+  auto& vertices = mesh->vertices( );
+  mesh->triangles( ).push_back(
+    new Facet( vertices[0], vertices[1], vertices[2] ));
+  return mesh;
+}
+
+BOOST_AUTO_TEST_CASE( objStreamWriter_offsets )
+{
+  std::string fileName( "objStreamWriter_offsets.obj" );
+  auto mesh0 = triangleMesh( 0.0f );
+  auto mesh1 = triangleMesh( 2.0f );
+  {
+    ObjStreamWriter writer( fileName, "# test" );
+    writer.writeMesh( mesh0 );
+    writer.writeMesh( mesh1 );
+    BOOST_CHECK_EQUAL( writer.vertices( ), 6 );
+    BOOST_CHECK_EQUAL( writer.triangles( ), 2 );
+  }
+
+  std::ifstream stream( fileName.c_str( ));
+  std::string line;
+  std::vector< std::string > faces;
+  unsigned int vertices = 0;
+  while ( std::getline( stream, line ))
+  {
+    if ( line.compare( 0, 2, "v " ) == 0 )
+      vertices++;
+    else if ( line.compare( 0, 2, "f " ) == 0 )
+      faces.push_back( line );
+  }
+  stream.close( );
+  std::remove( fileName.c_str( ));
+
+  BOOST_CHECK_EQUAL( vertices, 6 );
+  BOOST_REQUIRE_EQUAL( faces.size( ), 2 );
+  BOOST_CHECK_EQUAL( faces[0], "f 1//1 2//2 3//3" );
+  BOOST_CHECK_EQUAL( faces[1], "f 4//4 5//5 6//6" );
+
+  delete mesh0;
+  delete mesh1;
+}
+
+BOOST_AUTO_TEST_CASE( objStreamWriter_facetVertices )
+{
+  // Generated meshes only reference their vertices from the facets
+  std::string fileName( "objStreamWriter_facetVertices.obj" );
+  auto mesh = new Mesh( );
+  Vertices vertices;
+  for ( unsigned int i = 0; i < 4; i++ )
+    vertices.push_back( new Vertex(
+      Eigen::Vector3f( float( i % 2 ), float( i / 2 ), 0.0f ),
+      Eigen::Vector3f( 0.0f, 0.0f, 1.0f )));
+  mesh->quads( ).push_back( new Facet( vertices[0], vertices[1],
+                                       vertices[2], vertices[3] ));
+  mesh->triangles( ).push_back(
+    new Facet( vertices[3], vertices[2], vertices[1] ));
+  {
+    ObjStreamWriter writer( fileName );
+    writer.writeMesh( mesh );
+    BOOST_CHECK_EQUAL( writer.vertices( ), 4 );
+    BOOST_CHECK_EQUAL( writer.triangles( ), 3 );
+  }
+
+  std::ifstream stream( fileName.c_str( ));
+  std::string line;
+  std::vector< std::string > faces;
+  unsigned int vertexLines = 0;
+  while ( std::getline( stream, line ))
+  {
+    if ( line.compare( 0, 2, "v " ) == 0 )
+      vertexLines++;
+    else if ( line.compare( 0, 2, "f " ) == 0 )
+      faces.push_back( line );
+  }
+  stream.close( );
+  std::remove( fileName.c_str( ));
+
+  BOOST_CHECK_EQUAL( vertexLines, 4 );
+  BOOST_REQUIRE_EQUAL( faces.size( ), 3 );
+  BOOST_CHECK_EQUAL( faces[0], "f 1//1 2//2 3//3" );
+  BOOST_CHECK_EQUAL( faces[1], "f 4//4 3//3 2//2" );
+  BOOST_CHECK_EQUAL( faces[2], "f 3//3 1//1 2//2" );
+
+  delete mesh;
+}
+
+BOOST_AUTO_TEST_CASE( objStreamWriter_error )
+{
+  BOOST_CHECK_THROW( ObjStreamWriter( "/nonexistent/directory/mesh.obj" ),
+                     std::runtime_error );
+}
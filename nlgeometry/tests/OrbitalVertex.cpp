@@ -89,3 +89,25 @@ BOOST_AUTO_TEST_CASE( orbitalVertex_meythods )
   BOOST_CHECK_EQUAL( vertex.center( ), Eigen::Vector3f( 3.0f, 0.0f, 0.0f ));
   BOOST_CHECK_EQUAL( vertex.position( ), Eigen::Vector3f( 3.0f, 1.0f, 0.0f ));
 }
+
+BOOST_AUTO_TEST_CASE( orbitalVertex_nodeId )
+{
+  OrbitalVertex vertex( Eigen::Vector3f( 1.0f, 0.0f, 0.0f ));
+  BOOST_CHECK_EQUAL( vertex.nodeId( ), -1 );
+
+  vertex.nodeId( ) = 7;
+  OrbitalVertexPtr otherVertex =
+    dynamic_cast< OrbitalVertexPtr >( vertex.clone( ));
+  BOOST_CHECK_EQUAL( otherVertex->nodeId( ), 7 );
+  delete otherVertex;
+
+  std::vector< float > buffer;
+  vertex.store( buffer, NODE_ID );
+  BOOST_CHECK_EQUAL( buffer.size( ), Vertex::components( NODE_ID ));
+  BOOST_CHECK_EQUAL( buffer[0], 7.0f );
+
+  // Plain vertices have no node
+  Vertex plainVertex( Eigen::Vector3f( 0.0f, 0.0f, 0.0f ));
+  plainVertex.store( buffer, NODE_ID );
+  BOOST_CHECK_EQUAL( buffer[1], -1.0f );
+}
@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include <nlgeometry/nlgeometry.h>
+#include "nlgeometryTests.h"
+
+using namespace nlgeometry;
+
+BOOST_AUTO_TEST_CASE( ray_intersects )
+{
+  Ray ray( Eigen::Vector3f( -5.0f, 0.0f, 0.0f ), Eigen::Vector3f::UnitX( ));
+  AxisAlignedBoundingBox aabb( Eigen::Vector3f( -1.0f, -1.0f, -1.0f ),
+                               Eigen::Vector3f( 1.0f, 1.0f, 1.0f ));
+  float distance = -1.0f;
+
+  BOOST_CHECK( ray.intersects( aabb, distance ));
+  BOOST_CHECK_CLOSE( distance, 4.0f, 1e-4f );
+  BOOST_CHECK_EQUAL( ray.point( distance ),
+                     Eigen::Vector3f( -1.0f, 0.0f, 0.0f ));
+
+  // Origin inside the box
+  Ray inside( Eigen::Vector3f::Zero( ), Eigen::Vector3f( 0.0f, 1.0f, 1.0f ));
+  BOOST_CHECK( inside.intersects( aabb, distance ));
+  BOOST_CHECK_EQUAL( distance, 0.0f );
+
+  // Box behind the origin and box beside the ray
+  Ray behind( Eigen::Vector3f( 5.0f, 0.0f, 0.0f ), Eigen::Vector3f::UnitX( ));
+  BOOST_CHECK( !behind.intersects( aabb, distance ));
+  Ray beside( Eigen::Vector3f( -5.0f, 2.0f, 0.0f ), Eigen::Vector3f::UnitX( ));
+  BOOST_CHECK( !beside.intersects( aabb, distance ));
+
+  BOOST_CHECK( !ray.intersects( AxisAlignedBoundingBox( ), distance ));
+}
@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "BufferAllocator.h"
+
+#include <iterator>
+#include <stdexcept>
+
+namespace nlrender
+{
+
+  BufferAllocator::BufferAllocator( unsigned int capacity_ )
+    : _capacity( 0 )
+    , _used( 0 )
+  {
+    grow( capacity_ );
+  }
+
+  BufferAllocator::~BufferAllocator( void )
+  {
+  }
+
+  bool BufferAllocator::allocate( unsigned int size_, unsigned int& offset_ )
+  {
+    if ( size_ == 0 )
+    {
+      offset_ = 0;
+      return true;
+    }
+
+    for ( auto range = _free.begin( ); range != _free.end( ); ++range )
+    {
+      if ( range->second < size_ )
+        continue;
+      offset_ = range->first;
+      unsigned int remaining = range->second - size_;
+      _free.erase( range );
+      if ( remaining > 0 )
+        _free[offset_ + size_] = remaining;
+      _used += size_;
+      return true;
+    }
+    return false;
+  }
+
+  void BufferAllocator::release( unsigned int offset_, unsigned int size_ )
+  {
+    if ( size_ == 0 )
+      return;
+    if ( offset_ + size_ > _capacity || size_ > _used )
+      throw std::runtime_error( "Released range out of the allocated buffer" );
+
+    auto next = _free.lower_bound( offset_ );
+    if ( next != _free.end( ) && next->first < offset_ + size_ )
+      throw std::runtime_error( "Released range is already free" );
+    if ( next != _free.begin( ) &&
+         std::prev( next )->first + std::prev( next )->second > offset_ )
+      throw std::runtime_error( "Released range is already free" );
+    _used -= size_;
+
+    if ( next != _free.begin( ))
+    {
+      auto previous = std::prev( next );
+      if ( previous->first + previous->second == offset_ )
+      {
+        offset_ = previous->first;
+        size_ += previous->second;
+        _free.erase( previous );
+      }
+    }
+    if ( next != _free.end( ) && next->first == offset_ + size_ )
+    {
+      size_ += next->second;
+      _free.erase( next );
+    }
+    _free[offset_] = size_;
+  }
+
+  void BufferAllocator::grow( unsigned int capacity_ )
+  {
+    if ( capacity_ <= _capacity )
+      return;
+
+    unsigned int offset = _capacity;
+    unsigned int size = capacity_ - _capacity;
+    _capacity = capacity_;
+    // The new space is treated as a used range being released to merge it
+    // with a free range at the end of the buffer
+    _used += size;
+    release( offset, size );
+  }
+
+  unsigned int BufferAllocator::capacity( void ) const
+  {
+    return _capacity;
+  }
+
+  unsigned int BufferAllocator::used( void ) const
+  {
+    return _used;
+  }
+
+  unsigned int BufferAllocator::freeRanges( void ) const
+  {
+    return ( unsigned int )_free.size( );
+  }
+
+} // namespace nlrender
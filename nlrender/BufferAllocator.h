@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLRENDER_BUFFER_ALLOCATOR__
+#define __NLRENDER_BUFFER_ALLOCATOR__
+
+#include <map>
+
+#include <nlrender/api.h>
+
+namespace nlrender
+{
+
+  /* \class BufferAllocator
+   * First fit sub-allocator of ranges of a buffer. It only keeps track of
+   * the free ranges, the buffer itself is managed by the caller
+   */
+  class BufferAllocator
+  {
+
+  public:
+
+    /**
+     * Default constructor
+     * @param capacity_ number of elements of the managed buffer
+     */
+    NLRENDER_API
+    BufferAllocator( unsigned int capacity_ = 0 );
+
+    /**
+     * Default destructor
+     */
+    NLRENDER_API
+    ~BufferAllocator( void );
+
+    /**
+     * Method that reserves a range of the buffer using the first free range
+     * big enough to hold it
+     * @param size_ number of elements of the range
+     * @param offset_ first element of the reserved range
+     * @return true if the range was reserved and false if there is no free
+     * range big enough
+     */
+    NLRENDER_API
+    bool allocate( unsigned int size_, unsigned int& offset_ );
+
+    /**
+     * Method that releases a previously reserved range, merging it with the
+     * adjacent free ranges
+     * @param offset_ first element of the range
+     * @param size_ number of elements of the range
+     */
+    NLRENDER_API
+    void release( unsigned int offset_, unsigned int size_ );
+
+    /**
+     * Method that enlarges the managed buffer, adding the new elements as
+     * free space at its end
+     * @param capacity_ new number of elements of the managed buffer
+     */
+    NLRENDER_API
+    void grow( unsigned int capacity_ );
+
+    /**
+     * Method that returns the number of elements of the managed buffer
+     * @return the number of elements of the managed buffer
+     */
+    NLRENDER_API
+    unsigned int capacity( void ) const;
+
+    /**
+     * Method that returns the number of reserved elements
+     * @return the number of reserved elements
+     */
+    NLRENDER_API
+    unsigned int used( void ) const;
+
+    /**
+     * Method that returns the number of free ranges
+     * @return the number of free ranges
+     */
+    NLRENDER_API
+    unsigned int freeRanges( void ) const;
+
+  protected:
+
+    //! Free ranges indexed by their first element
+    std::map< unsigned int, unsigned int > _free;
+
+    //! Number of elements of the managed buffer
+    unsigned int _capacity;
+
+    //! Number of reserved elements
+    unsigned int _used;
+
+  }; // class BufferAllocator
+
+} // namespace nlrender
+
+#endif
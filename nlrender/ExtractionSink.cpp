@@ -0,0 +1,43 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "ExtractionSink.h"
+
+namespace nlrender
+{
+
+  ObjExtractionSink::ObjExtractionSink( const std::string& fileName_,
+                                        const std::string& headerString_ )
+    : _writer( fileName_, headerString_ )
+  {
+  }
+
+  void ObjExtractionSink::write( nlgeometry::MeshPtr chunk_ )
+  {
+    _writer.writeMesh( chunk_ );
+  }
+
+  nlgeometry::ObjStreamWriter& ObjExtractionSink::writer( void )
+  {
+    return _writer;
+  }
+
+} // namespace nlrender
@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLRENDER_EXTRACTION_SINK__
+#define __NLRENDER_EXTRACTION_SINK__
+
+#include "../nlgeometry/Mesh.h"
+#include "../nlgeometry/Writer/ObjStreamWriter.h"
+
+#include <nlrender/api.h>
+
+namespace nlrender
+{
+
+  /*! \class ExtractionSink
+   * Receives the chunks of a chunked extraction as they are extracted, so the
+   * whole extracted geometry never has to be kept in memory
+   */
+  class ExtractionSink
+  {
+
+  public:
+
+    NLRENDER_API
+    virtual ~ExtractionSink( void ) { }
+
+    /**
+     * Method called with each extracted chunk, which is deleted by the
+     * renderer after the call
+     * @param chunk_ extracted mesh of the chunk
+     */
+    NLRENDER_API
+    virtual void write( nlgeometry::MeshPtr chunk_ ) = 0;
+
+  }; // class ExtractionSink
+
+  /*! \class ObjExtractionSink
+   * Extraction sink that appends every chunk to an obj file
+   */
+  class ObjExtractionSink : public ExtractionSink
+  {
+
+  public:
+
+    /**
+     * Default constructor
+     * @param fileName_ path of the obj file
+     * @param headerString_ text written at the start of the file
+     */
+    NLRENDER_API
+    ObjExtractionSink( const std::string& fileName_,
+                       const std::string& headerString_ = "" );
+
+    NLRENDER_API
+    void write( nlgeometry::MeshPtr chunk_ );
+
+    /**
+     * Method that returns the writer of the obj file
+     * @return the obj writer
+     */
+    NLRENDER_API
+    nlgeometry::ObjStreamWriter& writer( void );
+
+  protected:
+
+    //! Writer of the obj file
+    nlgeometry::ObjStreamWriter _writer;
+
+  }; // class ObjExtractionSink
+
+} // namespace nlrender
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "FrustumCuller.h"
+
+#include <algorithm>
+
+namespace nlrender
+{
+
+  FrustumCuller::FrustumCuller( void )
+    : _tested( 0 )
+    , _culled( 0 )
+  {
+  }
+
+  FrustumCuller::~FrustumCuller( void )
+  {
+  }
+
+  void FrustumCuller::update( const Eigen::Matrix4f& view_,
+                              const Eigen::Matrix4f& projection_ )
+  {
+    _frustum.update( projection_ * view_ );
+    _tested = 0;
+    _culled = 0;
+  }
+
+  bool FrustumCuller::visible(
+    const void* key_, const nlgeometry::AxisAlignedBoundingBox& bounds_,
+    const Eigen::Matrix4f& model_ )
+  {
+    _tested++;
+    if ( _frustum.intersects( worldBounds( key_, bounds_, model_ )))
+      return true;
+    _culled++;
+    return false;
+  }
+
+  void FrustumCuller::visible(
+    const nlgeometry::BoundingVolumeHierarchy& hierarchy_,
+    std::vector< unsigned int >& primitives_ )
+  {
+    hierarchy_.query( _frustum, primitives_ );
+    std::sort( primitives_.begin( ), primitives_.end( ));
+    _tested += hierarchy_.size( );
+    _culled += hierarchy_.size( ) - ( unsigned int )primitives_.size( );
+  }
+
+  const nlgeometry::AxisAlignedBoundingBox& FrustumCuller::worldBounds(
+    const void* key_, const nlgeometry::AxisAlignedBoundingBox& bounds_,
+    const Eigen::Matrix4f& model_ )
+  {
+    auto inserted = _cache.insert( std::make_pair( key_, TCachedBounds( )));
+    TCachedBounds& cached = inserted.first->second;
+    if ( inserted.second || cached.model != model_ ||
+         cached.bounds.minimum( ) != bounds_.minimum( ) ||
+         cached.bounds.maximum( ) != bounds_.maximum( ))
+    {
+      cached.model = model_;
+      cached.bounds = bounds_;
+      cached.world = bounds_.transformed( model_ );
+    }
+    return cached.world;
+  }
+
+  void FrustumCuller::clearCache( void )
+  {
+    _cache.clear( );
+  }
+
+  const nlgeometry::Frustum& FrustumCuller::frustum( void ) const
+  {
+    return _frustum;
+  }
+
+  unsigned int FrustumCuller::tested( void ) const
+  {
+    return _tested;
+  }
+
+  unsigned int FrustumCuller::culled( void ) const
+  {
+    return _culled;
+  }
+
+} // namespace nlrender
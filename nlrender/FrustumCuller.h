@@ -0,0 +1,160 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLRENDER_FRUSTUM_CULLER__
+#define __NLRENDER_FRUSTUM_CULLER__
+
+#include "../nlgeometry/AxisAlignedBoundingBox.h"
+#include "../nlgeometry/BoundingVolumeHierarchy.h"
+#include "../nlgeometry/Frustum.h"
+
+#include <unordered_map>
+
+#include <nlrender/api.h>
+
+namespace nlrender
+{
+
+  /* \class FrustumCuller
+   * Visibility test of bounding boxes against the camera frustum. The world
+   * space bounds of each object are cached with the model matrix used to
+   * compute them, so static objects are only transformed once
+   */
+  class FrustumCuller
+  {
+
+  public:
+
+    /**
+     * Default constructor
+     */
+    NLRENDER_API
+    FrustumCuller( void );
+
+    /**
+     * Default destructor
+     */
+    NLRENDER_API
+    ~FrustumCuller( void );
+
+    /**
+     * Method that updates the frustum from the camera matrices and resets
+     * the culling statistics
+     * @param view_ camera view matrix
+     * @param projection_ camera projection matrix
+     */
+    NLRENDER_API
+    void update( const Eigen::Matrix4f& view_,
+                 const Eigen::Matrix4f& projection_ );
+
+    /**
+     * Method that checks if an object is inside the frustum. Invalid bounding
+     * boxes are always visible
+     * @param key_ object identifier used to cache its world space bounds
+     * @param bounds_ object bounding box before the model transform
+     * @param model_ object model matrix
+     * @return false if the object is completely outside the frustum
+     */
+    NLRENDER_API
+    bool visible( const void* key_,
+                  const nlgeometry::AxisAlignedBoundingBox& bounds_,
+                  const Eigen::Matrix4f& model_ );
+
+    /**
+     * Method that finds the primitives of a bounding volume hierarchy inside
+     * the frustum, counting all its primitives as tested
+     * @param hierarchy_ hierarchy over the world space bounds of the objects
+     * @param primitives_ vector filled with the visible primitives in
+     * ascending order
+     */
+    NLRENDER_API
+    void visible( const nlgeometry::BoundingVolumeHierarchy& hierarchy_,
+                  std::vector< unsigned int >& primitives_ );
+
+    /**
+     * Method that returns the world space bounds of an object, using the
+     * cached ones when its bounding box and model matrix have not changed
+     * @param key_ object identifier used to cache its world space bounds
+     * @param bounds_ object bounding box before the model transform
+     * @param model_ object model matrix
+     * @return the world space bounds of the object
+     */
+    NLRENDER_API
+    const nlgeometry::AxisAlignedBoundingBox& worldBounds(
+      const void* key_, const nlgeometry::AxisAlignedBoundingBox& bounds_,
+      const Eigen::Matrix4f& model_ );
+
+    /**
+     * Method that removes all the cached world space bounds
+     */
+    NLRENDER_API
+    void clearCache( void );
+
+    /**
+     * Method that returns the current frustum
+     * @return the current frustum
+     */
+    NLRENDER_API
+    const nlgeometry::Frustum& frustum( void ) const;
+
+    /**
+     * Method that returns the number of objects tested since the last update
+     * @return the number of objects tested
+     */
+    NLRENDER_API
+    unsigned int tested( void ) const;
+
+    /**
+     * Method that returns the number of objects culled since the last update
+     * @return the number of objects culled
+     */
+    NLRENDER_API
+    unsigned int culled( void ) const;
+
+  protected:
+
+    //! Unaligned so it can be stored in the standard containers
+    typedef Eigen::Matrix< float, 4, 4, Eigen::DontAlign > TUnalignedMatrix4f;
+
+    typedef struct
+    {
+      TUnalignedMatrix4f model;
+      nlgeometry::AxisAlignedBoundingBox bounds;
+      nlgeometry::AxisAlignedBoundingBox world;
+    } TCachedBounds;
+
+    //! Camera frustum
+    nlgeometry::Frustum _frustum;
+
+    //! World space bounds indexed by object
+    std::unordered_map< const void*, TCachedBounds > _cache;
+
+    //! Number of objects tested since the last update
+    unsigned int _tested;
+
+    //! Number of objects culled since the last update
+    unsigned int _culled;
+
+  }; // class FrustumCuller
+
+} // namespace nlrender
+
+#endif
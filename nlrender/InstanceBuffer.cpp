@@ -0,0 +1,190 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "InstanceBuffer.h"
+
+#ifndef NEUROLOTS_SKIP_GLEW_INCLUDE
+#include <GL/glew.h>
+#endif
+#ifdef Darwin
+#include <OpenGL/gl.h>
+#include <OpenGL/glu.h>
+#else
+#include <GL/gl.h>
+#include <GL/glu.h>
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nlrender
+{
+
+  InstanceBuffer::InstanceBuffer( void )
+    : _dirty( true )
+    , _capacity( 0 )
+    , _buffer( 0 )
+    , _texture( 0 )
+  {
+  }
+
+  InstanceBuffer::~InstanceBuffer( void )
+  {
+    if ( _texture != 0 )
+      glDeleteTextures( 1, &_texture );
+    if ( _buffer != 0 )
+      glDeleteBuffers( 1, &_buffer );
+  }
+
+  void InstanceBuffer::resize( unsigned int size_ )
+  {
+    unsigned int oldSize = size( );
+    if ( size_ == oldSize )
+      return;
+
+    _data.resize( size_t( size_ ) * FLOATS_PER_INSTANCE );
+    for ( unsigned int i = oldSize; i < size_; i++ )
+      pack( Eigen::Matrix4f::Identity( ), Eigen::Vector3f( 0.5f, 0.5f, 0.5f ),
+            Eigen::Vector4f( 0.0f, 0.0f, 0.0f, 0.0f ),
+            &_data[size_t( i ) * FLOATS_PER_INSTANCE] );
+    _dirty = true;
+  }
+
+  unsigned int InstanceBuffer::size( void ) const
+  {
+    return ( unsigned int )( _data.size( ) / FLOATS_PER_INSTANCE );
+  }
+
+  void InstanceBuffer::model( unsigned int instance_,
+                              const Eigen::Matrix4f& model_ )
+  {
+    if ( instance_ >= size( ))
+      throw std::runtime_error( "Instance index out of range" );
+    // Eigen matrices are column major as the shader expects
+    std::copy( model_.data( ), model_.data( ) + 16,
+               &_data[size_t( instance_ ) * FLOATS_PER_INSTANCE] );
+    _dirty = true;
+  }
+
+  void InstanceBuffer::baseColor( unsigned int instance_,
+                                  const Eigen::Vector3f& baseColor_ )
+  {
+    if ( instance_ >= size( ))
+      throw std::runtime_error( "Instance index out of range" );
+    float* data = &_data[size_t( instance_ ) * FLOATS_PER_INSTANCE + 16];
+    data[0] = baseColor_.x( );
+    data[1] = baseColor_.y( );
+    data[2] = baseColor_.z( );
+    _dirty = true;
+  }
+
+  void InstanceBuffer::color( unsigned int instance_,
+                              const Eigen::Vector4f& color_ )
+  {
+    if ( instance_ >= size( ))
+      throw std::runtime_error( "Instance index out of range" );
+    std::copy( color_.data( ), color_.data( ) + 4,
+               &_data[size_t( instance_ ) * FLOATS_PER_INSTANCE + 20] );
+    _dirty = true;
+  }
+
+  void InstanceBuffer::lod( unsigned int instance_, float lod_ )
+  {
+    if ( instance_ >= size( ))
+      throw std::runtime_error( "Instance index out of range" );
+    _data[size_t( instance_ ) * FLOATS_PER_INSTANCE + 19] = lod_;
+    _dirty = true;
+  }
+
+  Eigen::Matrix4f InstanceBuffer::model( unsigned int instance_ ) const
+  {
+    if ( instance_ >= size( ))
+      throw std::runtime_error( "Instance index out of range" );
+    return Eigen::Map< const Eigen::Matrix4f >(
+      &_data[size_t( instance_ ) * FLOATS_PER_INSTANCE] );
+  }
+
+  void InstanceBuffer::set( unsigned int instance_,
+                            const Eigen::Matrix4f& model_,
+                            const Eigen::Vector3f& baseColor_,
+                            const Eigen::Vector4f& color_ )
+  {
+    if ( instance_ >= size( ))
+      throw std::runtime_error( "Instance index out of range" );
+    pack( model_, baseColor_, color_,
+          &_data[size_t( instance_ ) * FLOATS_PER_INSTANCE] );
+    _dirty = true;
+  }
+
+  const std::vector< float >& InstanceBuffer::data( void ) const
+  {
+    return _data;
+  }
+
+  void InstanceBuffer::upload( void )
+  {
+    if ( _buffer == 0 )
+    {
+      glGenBuffers( 1, &_buffer );
+      glGenTextures( 1, &_texture );
+    }
+    if ( !_dirty || _data.empty( ))
+      return;
+
+    glBindBuffer( GL_TEXTURE_BUFFER, _buffer );
+    if ( _data.size( ) > _capacity )
+    {
+      _capacity = _data.size( );
+      glBufferData( GL_TEXTURE_BUFFER, sizeof( float ) * _capacity,
+                    _data.data( ), GL_DYNAMIC_DRAW );
+      glBindTexture( GL_TEXTURE_BUFFER, _texture );
+      glTexBuffer( GL_TEXTURE_BUFFER, GL_RGBA32F, _buffer );
+      glBindTexture( GL_TEXTURE_BUFFER, 0 );
+    }
+    else
+    {
+      glBufferSubData( GL_TEXTURE_BUFFER, 0, sizeof( float ) * _data.size( ),
+                       _data.data( ));
+    }
+    glBindBuffer( GL_TEXTURE_BUFFER, 0 );
+    _dirty = false;
+  }
+
+  void InstanceBuffer::bind( unsigned int textureUnit_ )
+  {
+    glActiveTexture( GL_TEXTURE0 + textureUnit_ );
+    glBindTexture( GL_TEXTURE_BUFFER, _texture );
+    glActiveTexture( GL_TEXTURE0 );
+  }
+
+  void InstanceBuffer::pack( const Eigen::Matrix4f& model_,
+                             const Eigen::Vector3f& baseColor_,
+                             const Eigen::Vector4f& color_, float* data_ )
+  {
+    std::copy( model_.data( ), model_.data( ) + 16, data_ );
+    data_[16] = baseColor_.x( );
+    data_[17] = baseColor_.y( );
+    data_[18] = baseColor_.z( );
+    data_[19] = 1.0f;
+    std::copy( color_.data( ), color_.data( ) + 4, data_ + 20 );
+  }
+
+} // namespace nlrender
@@ -0,0 +1,193 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLRENDER_INSTANCE_BUFFER__
+#define __NLRENDER_INSTANCE_BUFFER__
+
+#include <Eigen/Dense>
+#include <vector>
+
+#include <nlrender/api.h>
+
+namespace nlrender
+{
+
+  /* \class InstanceBuffer
+   * Per instance data read by the vertex shaders through a buffer texture.
+   * Each instance stores its model matrix by columns, its base color with
+   * the instance level of detail as fourth component and a dynamic color
+   * which alpha is the weight used to mix it with the base color. The data
+   * is edited on the cpu and uploaded with a single call
+   */
+  class InstanceBuffer
+  {
+
+  public:
+
+    //! Vertex attribute location of the instance index in the shaders
+    static const unsigned int ATTRIB_LOCATION = 7;
+
+    //! Number of RGBA float texels used by each instance
+    static const unsigned int TEXELS_PER_INSTANCE = 6;
+
+    //! Number of floats used by each instance
+    static const unsigned int FLOATS_PER_INSTANCE = TEXELS_PER_INSTANCE * 4;
+
+    /**
+     * Default constructor. The OpenGL objects are created on the first upload
+     */
+    NLRENDER_API
+    InstanceBuffer( void );
+
+    /**
+     * Default destructor
+     */
+    NLRENDER_API
+    ~InstanceBuffer( void );
+
+    /**
+     * Method that changes the number of instances. New instances get the
+     * identity model matrix, gray base color and no dynamic color
+     * @param size_ number of instances
+     */
+    NLRENDER_API
+    void resize( unsigned int size_ );
+
+    /**
+     * Method that returns the number of instances
+     * @return the number of instances
+     */
+    NLRENDER_API
+    unsigned int size( void ) const;
+
+    /**
+     * Method that sets the model matrix of an instance
+     * @param instance_ instance index
+     * @param model_ model matrix
+     */
+    NLRENDER_API
+    void model( unsigned int instance_, const Eigen::Matrix4f& model_ );
+
+    /**
+     * Method that sets the base color of an instance
+     * @param instance_ instance index
+     * @param baseColor_ base color
+     */
+    NLRENDER_API
+    void baseColor( unsigned int instance_,
+                    const Eigen::Vector3f& baseColor_ );
+
+    /**
+     * Method that sets the dynamic color of an instance
+     * @param instance_ instance index
+     * @param color_ dynamic color, its alpha is the weight of the mix with the
+     * base color
+     */
+    NLRENDER_API
+    void color( unsigned int instance_, const Eigen::Vector4f& color_ );
+
+    /**
+     * Method that sets the level of detail of an instance, used by the
+     * screen space tessellation criteria
+     * @param instance_ instance index
+     * @param lod_ level of detail
+     */
+    NLRENDER_API
+    void lod( unsigned int instance_, float lod_ );
+
+    /**
+     * Method that returns the model matrix of an instance
+     * @param instance_ instance index
+     * @return the model matrix
+     */
+    NLRENDER_API
+    Eigen::Matrix4f model( unsigned int instance_ ) const;
+
+    /**
+     * Method that sets all the data of an instance, with a level of detail
+     * of one
+     * @param instance_ instance index
+     * @param model_ model matrix
+     * @param baseColor_ base color
+     * @param color_ dynamic color
+     */
+    NLRENDER_API
+    void set( unsigned int instance_, const Eigen::Matrix4f& model_,
+              const Eigen::Vector3f& baseColor_,
+              const Eigen::Vector4f& color_ =
+              Eigen::Vector4f( 0.0f, 0.0f, 0.0f, 0.0f ));
+
+    /**
+     * Method that returns the packed instance data
+     * @return the packed instance data
+     */
+    NLRENDER_API
+    const std::vector< float >& data( void ) const;
+
+    /**
+     * Method that uploads the instance data to the gpu if it changed since
+     * the last upload
+     */
+    NLRENDER_API
+    void upload( void );
+
+    /**
+     * Method that binds the buffer texture to the given texture unit
+     * @param textureUnit_ texture unit index
+     */
+    NLRENDER_API
+    void bind( unsigned int textureUnit_ = 0 );
+
+    /**
+     * Static method that packs the data of an instance with a level of
+     * detail of one
+     * @param model_ model matrix
+     * @param baseColor_ base color
+     * @param color_ dynamic color
+     * @param data_ destination of FLOATS_PER_INSTANCE floats
+     */
+    NLRENDER_API
+    static void pack( const Eigen::Matrix4f& model_,
+                      const Eigen::Vector3f& baseColor_,
+                      const Eigen::Vector4f& color_, float* data_ );
+
+  protected:
+
+    //! Packed instance data
+    std::vector< float > _data;
+
+    //! True if the data changed since the last upload
+    bool _dirty;
+
+    //! Number of floats allocated in the gpu buffer
+    size_t _capacity;
+
+    //! Buffer object with the instance data
+    unsigned int _buffer;
+
+    //! Buffer texture to access the instance data
+    unsigned int _texture;
+
+  }; // class InstanceBuffer
+
+} // namespace nlrender
+
+#endif
@@ -0,0 +1,366 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "MeshPool.h"
+
+#ifndef NEUROLOTS_SKIP_GLEW_INCLUDE
+#include <GL/glew.h>
+#endif
+#ifdef Darwin
+#include <OpenGL/gl.h>
+#include <OpenGL/glu.h>
+#else
+#include <GL/gl.h>
+#include <GL/glu.h>
+#endif
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace nlrender
+{
+
+  MeshPool::MeshPool( const nlgeometry::AttribsFormat& format_,
+                      bool shortIndices_,
+                      unsigned int vertexCapacity_,
+                      unsigned int indexCapacity_ )
+    : _format( format_ )
+    , _shortIndices( shortIndices_ )
+    , _indexSize( shortIndices_ ? sizeof( unsigned short ) :
+                  sizeof( unsigned int ))
+    , _instanceIdsSize( 0 )
+    , _vertexAllocator( vertexCapacity_ )
+    , _indexAllocator( indexCapacity_ )
+  {
+    for ( auto attrib: _format )
+      _components.push_back( nlgeometry::Vertex::components( attrib ));
+
+    glGenVertexArrays( 1, &_vao );
+    _vbos.resize( _format.size( ));
+    glGenBuffers(( GLsizei )_vbos.size( ), _vbos.data( ));
+    glGenBuffers( 1, &_ibo );
+    glGenBuffers( 1, &_instanceIds );
+    glGenBuffers( 1, &_dibo );
+
+    for ( unsigned int i = 0; i < _vbos.size( ); i++ )
+    {
+      glBindBuffer( GL_COPY_WRITE_BUFFER, _vbos[i] );
+      glBufferData( GL_COPY_WRITE_BUFFER,
+                    sizeof( float ) * _components[i] * vertexCapacity_,
+                    nullptr, GL_STATIC_DRAW );
+    }
+    glBindBuffer( GL_COPY_WRITE_BUFFER, _ibo );
+    glBufferData( GL_COPY_WRITE_BUFFER, size_t( _indexSize ) * indexCapacity_,
+                  nullptr, GL_STATIC_DRAW );
+    glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+
+    _uploadInstanceIds( 64 );
+    _setUpVao( );
+  }
+
+  MeshPool::~MeshPool( void )
+  {
+    glDeleteVertexArrays( 1, &_vao );
+    if ( _vbos.size( ) > 0 )
+      glDeleteBuffers(( GLsizei )_vbos.size( ), _vbos.data( ));
+    glDeleteBuffers( 1, &_ibo );
+    glDeleteBuffers( 1, &_instanceIds );
+    glDeleteBuffers( 1, &_dibo );
+  }
+
+  unsigned int MeshPool::add( nlgeometry::MeshPtr mesh_ )
+  {
+    TMeshEntry entry;
+    nlgeometry::Attribs attribs;
+    std::vector< unsigned int > indices;
+
+    // The layout is computed without conforming the mesh, so it can still
+    // be uploaded on its own
+    const nlgeometry::Mesh& mesh = *mesh_;
+    mesh.storeBuffers( _format, nlgeometry::Facet::PATCHES, attribs,
+                       indices, entry.linesSize, entry.trianglesSize,
+                       entry.quadsSize );
+    entry.valid = true;
+    entry.bounds = mesh_->aaBoundingBox( );
+    entry.numVertices = attribs.empty( ) ? 0 :
+      ( unsigned int )( attribs[0].size( ) / _components[0] );
+    entry.numIndices = ( unsigned int )indices.size( );
+
+    if ( _shortIndices && entry.numVertices >
+         size_t( std::numeric_limits< unsigned short >::max( )) + 1 )
+      throw std::runtime_error(
+        "Mesh has too many vertices for a pool with 16 bits indices" );
+
+    _reserve( _vertexAllocator, entry.numVertices, entry.baseVertex, false );
+    _reserve( _indexAllocator, entry.numIndices, entry.firstIndex, true );
+
+    for ( unsigned int i = 0; i < attribs.size( ); i++ )
+    {
+      // Vertices that do not store an attribute leave it zeroed
+      attribs[i].resize( size_t( entry.numVertices ) * _components[i], 0.0f );
+      glBindBuffer( GL_COPY_WRITE_BUFFER, _vbos[i] );
+      glBufferSubData( GL_COPY_WRITE_BUFFER,
+                       sizeof( float ) * _components[i] * entry.baseVertex,
+                       sizeof( float ) * attribs[i].size( ),
+                       attribs[i].data( ));
+    }
+
+    glBindBuffer( GL_COPY_WRITE_BUFFER, _ibo );
+    if ( _shortIndices )
+    {
+      std::vector< unsigned short > shortIndices( indices.begin( ),
+                                                  indices.end( ));
+      glBufferSubData( GL_COPY_WRITE_BUFFER,
+                       size_t( _indexSize ) * entry.firstIndex,
+                       size_t( _indexSize ) * shortIndices.size( ),
+                       shortIndices.data( ));
+    }
+    else
+    {
+      glBufferSubData( GL_COPY_WRITE_BUFFER,
+                       size_t( _indexSize ) * entry.firstIndex,
+                       size_t( _indexSize ) * indices.size( ),
+                       indices.data( ));
+    }
+    glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+
+    unsigned int id;
+    if ( _freeIds.empty( ))
+    {
+      id = ( unsigned int )_entries.size( );
+      _entries.push_back( entry );
+      if ( _entries.size( ) > _instanceIdsSize )
+        _uploadInstanceIds( _instanceIdsSize * 2 );
+    }
+    else
+    {
+      id = _freeIds.back( );
+      _freeIds.pop_back( );
+      _entries[id] = entry;
+    }
+    return id;
+  }
+
+  void MeshPool::remove( unsigned int id_ )
+  {
+    if ( id_ >= _entries.size( ) || !_entries[id_].valid )
+      throw std::runtime_error( "Mesh identifier not found in the pool" );
+
+    TMeshEntry& entry = _entries[id_];
+    _vertexAllocator.release( entry.baseVertex, entry.numVertices );
+    _indexAllocator.release( entry.firstIndex, entry.numIndices );
+    entry.valid = false;
+    _freeIds.push_back( id_ );
+  }
+
+  const MeshPool::TMeshEntry& MeshPool::entry( unsigned int id_ ) const
+  {
+    if ( id_ >= _entries.size( ) || !_entries[id_].valid )
+      throw std::runtime_error( "Mesh identifier not found in the pool" );
+    return _entries[id_];
+  }
+
+  const MeshPool::MeshEntries& MeshPool::entries( void ) const
+  {
+    return _entries;
+  }
+
+  unsigned int MeshPool::size( void ) const
+  {
+    return ( unsigned int )( _entries.size( ) - _freeIds.size( ));
+  }
+
+  unsigned int MeshPool::indexType( void ) const
+  {
+    return _shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+  }
+
+  unsigned int MeshPool::vao( void ) const
+  {
+    return _vao;
+  }
+
+  unsigned int MeshPool::draw( TPrimitive primitive_ )
+  {
+    buildCommands( _entries, primitive_, _commands );
+    if ( _commands.empty( ))
+      return 0;
+
+    GLenum mode = GL_PATCHES;
+    switch( primitive_ )
+    {
+    case LINES:
+      mode = GL_LINES;
+      break;
+    case TRIANGLES:
+      glPatchParameteri( GL_PATCH_VERTICES, 3 );
+      break;
+    case QUADS:
+      glPatchParameteri( GL_PATCH_VERTICES, 4 );
+      break;
+    }
+
+    glBindVertexArray( _vao );
+    if ( GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect )
+    {
+      glBindBuffer( GL_DRAW_INDIRECT_BUFFER, _dibo );
+      glBufferData( GL_DRAW_INDIRECT_BUFFER,
+                    sizeof( DrawElementsIndirectCommand ) * _commands.size( ),
+                    _commands.data( ), GL_STREAM_DRAW );
+      glMultiDrawElementsIndirect( mode, indexType( ), nullptr,
+                                   ( GLsizei )_commands.size( ), 0 );
+      glBindBuffer( GL_DRAW_INDIRECT_BUFFER, 0 );
+      return 1;
+    }
+    else
+    {
+      // Without base instance support the identifier is set as the current
+      // value of the disabled instance attribute
+      glDisableVertexAttribArray( InstanceBuffer::ATTRIB_LOCATION );
+      for ( const auto& command: _commands )
+      {
+        glVertexAttribI1ui( InstanceBuffer::ATTRIB_LOCATION,
+                            command.baseInstance );
+        glDrawElementsBaseVertex(
+          mode, command.count, indexType( ),
+          ( void* )( size_t( command.firstIndex ) * _indexSize ),
+          command.baseVertex );
+      }
+      glEnableVertexAttribArray( InstanceBuffer::ATTRIB_LOCATION );
+      return ( unsigned int )_commands.size( );
+    }
+  }
+
+  void MeshPool::buildCommands( const MeshEntries& entries_,
+                                TPrimitive primitive_,
+                                DrawCommands& commands_ )
+  {
+    commands_.clear( );
+    for ( unsigned int id = 0; id < entries_.size( ); id++ )
+    {
+      const TMeshEntry& entry = entries_[id];
+      if ( !entry.valid )
+        continue;
+
+      DrawElementsIndirectCommand command;
+      command.instanceCount = 1;
+      command.baseVertex = ( int )entry.baseVertex;
+      command.baseInstance = id;
+      switch( primitive_ )
+      {
+      case LINES:
+        command.count = entry.linesSize;
+        command.firstIndex = entry.firstIndex;
+        break;
+      case TRIANGLES:
+        command.count = entry.trianglesSize;
+        command.firstIndex = entry.firstIndex + entry.linesSize;
+        break;
+      case QUADS:
+        command.count = entry.quadsSize;
+        command.firstIndex = entry.firstIndex + entry.linesSize +
+          entry.trianglesSize;
+        break;
+      }
+      if ( command.count > 0 )
+        commands_.push_back( command );
+    }
+  }
+
+  void MeshPool::_setUpVao( void )
+  {
+    glBindVertexArray( _vao );
+    for ( unsigned int i = 0; i < _vbos.size( ); i++ )
+    {
+      glBindBuffer( GL_ARRAY_BUFFER, _vbos[i] );
+      glVertexAttribPointer( i, _components[i], GL_FLOAT, GL_FALSE, 0, 0 );
+      glEnableVertexAttribArray( i );
+    }
+    glBindBuffer( GL_ARRAY_BUFFER, _instanceIds );
+    glVertexAttribIPointer( InstanceBuffer::ATTRIB_LOCATION, 1,
+                            GL_UNSIGNED_INT, 0, 0 );
+    glVertexAttribDivisor( InstanceBuffer::ATTRIB_LOCATION, 1 );
+    glEnableVertexAttribArray( InstanceBuffer::ATTRIB_LOCATION );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _ibo );
+    glBindVertexArray( 0 );
+  }
+
+  void MeshPool::_uploadInstanceIds( unsigned int size_ )
+  {
+    std::vector< unsigned int > ids( size_ );
+    for ( unsigned int i = 0; i < size_; i++ )
+      ids[i] = i;
+    glBindBuffer( GL_COPY_WRITE_BUFFER, _instanceIds );
+    glBufferData( GL_COPY_WRITE_BUFFER, sizeof( unsigned int ) * size_,
+                  ids.data( ), GL_STATIC_DRAW );
+    glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+    _instanceIdsSize = size_;
+  }
+
+  void MeshPool::_growBuffer( unsigned int& buffer_, size_t oldSize_,
+                              size_t newSize_ )
+  {
+    unsigned int buffer;
+    glGenBuffers( 1, &buffer );
+    glBindBuffer( GL_COPY_WRITE_BUFFER, buffer );
+    glBufferData( GL_COPY_WRITE_BUFFER, newSize_, nullptr, GL_STATIC_DRAW );
+    if ( oldSize_ > 0 )
+    {
+      glBindBuffer( GL_COPY_READ_BUFFER, buffer_ );
+      glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                           oldSize_ );
+      glBindBuffer( GL_COPY_READ_BUFFER, 0 );
+    }
+    glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+    glDeleteBuffers( 1, &buffer_ );
+    buffer_ = buffer;
+  }
+
+  void MeshPool::_reserve( BufferAllocator& allocator_, unsigned int size_,
+                           unsigned int& offset_, bool indices_ )
+  {
+    if ( allocator_.allocate( size_, offset_ ))
+      return;
+
+    unsigned int oldCapacity = allocator_.capacity( );
+    unsigned int newCapacity = std::max( oldCapacity * 2,
+                                         oldCapacity + size_ );
+    if ( indices_ )
+    {
+      _growBuffer( _ibo, size_t( _indexSize ) * oldCapacity,
+                   size_t( _indexSize ) * newCapacity );
+    }
+    else
+    {
+      for ( unsigned int i = 0; i < _vbos.size( ); i++ )
+        _growBuffer( _vbos[i], sizeof( float ) * _components[i] * oldCapacity,
+                     sizeof( float ) * _components[i] * newCapacity );
+    }
+    _setUpVao( );
+
+    allocator_.grow( newCapacity );
+    if ( !allocator_.allocate( size_, offset_ ))
+      throw std::runtime_error( "Mesh pool could not allocate buffer space" );
+  }
+
+} // namespace nlrender
@@ -0,0 +1,251 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLRENDER_MESH_POOL__
+#define __NLRENDER_MESH_POOL__
+
+#include "BufferAllocator.h"
+#include "InstanceBuffer.h"
+
+#include "../nlgeometry/Mesh.h"
+
+#include <nlrender/api.h>
+
+namespace nlrender
+{
+
+  /**
+   * Command read by glMultiDrawElementsIndirect, with the layout defined by
+   * the OpenGL specification
+   */
+  typedef struct
+  {
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    int baseVertex;
+    unsigned int baseInstance;
+  } DrawElementsIndirectCommand;
+
+  typedef std::vector< DrawElementsIndirectCommand > DrawCommands;
+
+  /* \class MeshPool
+   * Set of meshes which vertices and indices are sub-allocated from a few
+   * large buffers shared by all of them, so every mesh of the pool can be
+   * drawn with a single multi draw call per primitive type. Triangles and
+   * quads are stored as patches for the tessellation programs. Each mesh
+   * is drawn as the instance with its identifier, so the shaders read its
+   * data from an InstanceBuffer
+   */
+  class MeshPool
+  {
+
+  public:
+
+    typedef enum
+    {
+      LINES = 0,
+      TRIANGLES,
+      QUADS
+    } TPrimitive;
+
+    /**
+     * Ranges of the pool buffers used by a mesh. The first index and the
+     * counts are given in indices and the base vertex in vertices. The
+     * bounding box is the one of the mesh when it was added
+     */
+    typedef struct
+    {
+      bool valid;
+      nlgeometry::AxisAlignedBoundingBox bounds;
+      unsigned int baseVertex;
+      unsigned int numVertices;
+      unsigned int firstIndex;
+      unsigned int numIndices;
+      unsigned int linesSize;
+      unsigned int trianglesSize;
+      unsigned int quadsSize;
+    } TMeshEntry;
+
+    typedef std::vector< TMeshEntry > MeshEntries;
+
+    /**
+     * Default constructor
+     * @param format_ format of the vertex attributes, the attribute location
+     * of each one is its position in the format as in nlgeometry::Mesh
+     * @param shortIndices_ true to store 16 bits indices, limiting each mesh
+     * to 65536 vertices, and false to store 32 bits indices
+     * @param vertexCapacity_ initial number of vertices of the pool
+     * @param indexCapacity_ initial number of indices of the pool
+     */
+    NLRENDER_API
+    MeshPool( const nlgeometry::AttribsFormat& format_,
+              bool shortIndices_ = false,
+              unsigned int vertexCapacity_ = 65536,
+              unsigned int indexCapacity_ = 262144 );
+
+    /**
+     * Default destructor
+     */
+    NLRENDER_API
+    ~MeshPool( void );
+
+    /**
+     * Method that copies the geometry of the given mesh into the pool. The
+     * pool buffers grow when there is not enough free space. The mesh is
+     * not modified, so it can also be uploaded on its own, and its cpu data
+     * can be cleared afterwards
+     * @param mesh_ mesh to add
+     * @return the identifier of the mesh in the pool
+     */
+    NLRENDER_API
+    unsigned int add( nlgeometry::MeshPtr mesh_ );
+
+    /**
+     * Method that removes a mesh from the pool, releasing its ranges for
+     * later meshes
+     * @param id_ identifier of the mesh in the pool
+     */
+    NLRENDER_API
+    void remove( unsigned int id_ );
+
+    /**
+     * Method that returns the ranges used by a mesh of the pool
+     * @param id_ identifier of the mesh in the pool
+     * @return the ranges used by the mesh
+     */
+    NLRENDER_API
+    const TMeshEntry& entry( unsigned int id_ ) const;
+
+    /**
+     * Method that returns the ranges used by all the pool identifiers,
+     * including the invalid entries of removed meshes
+     * @return the ranges indexed by mesh identifier
+     */
+    NLRENDER_API
+    const MeshEntries& entries( void ) const;
+
+    /**
+     * Method that returns the number of meshes in the pool
+     * @return the number of meshes in the pool
+     */
+    NLRENDER_API
+    unsigned int size( void ) const;
+
+    /**
+     * Method that returns the OpenGL type of the pool indices
+     * @return the OpenGL type of the pool indices
+     */
+    NLRENDER_API
+    unsigned int indexType( void ) const;
+
+    /**
+     * Method that returns the pool vertex array object
+     * @return the pool vertex array object
+     */
+    NLRENDER_API
+    unsigned int vao( void ) const;
+
+    /**
+     * Method that draws the given primitive type of all the meshes of the
+     * pool with one glMultiDrawElementsIndirect call, or one draw call per
+     * mesh when indirect drawing is not supported
+     * @param primitive_ type of primitive to draw
+     * @return the number of draw calls issued
+     */
+    NLRENDER_API
+    unsigned int draw( TPrimitive primitive_ );
+
+    /**
+     * Static method that builds the indirect draw commands of a primitive type
+     * for the given entries. Meshes without primitives of the type are
+     * skipped and the base instance of each command is the mesh identifier
+     * @param entries_ ranges indexed by mesh identifier
+     * @param primitive_ type of primitive of the commands
+     * @param commands_ vector filled with the commands
+     */
+    NLRENDER_API
+    static void buildCommands( const MeshEntries& entries_,
+                               TPrimitive primitive_,
+                               DrawCommands& commands_ );
+
+  protected:
+
+    void _setUpVao( void );
+
+    void _uploadInstanceIds( unsigned int size_ );
+
+    void _growBuffer( unsigned int& buffer_, size_t oldSize_,
+                      size_t newSize_ );
+
+    void _reserve( BufferAllocator& allocator_, unsigned int size_,
+                   unsigned int& offset_, bool indices_ );
+
+    //! Format of the vertex attributes
+    nlgeometry::AttribsFormat _format;
+
+    //! Number of components of each vertex attribute
+    std::vector< unsigned int > _components;
+
+    //! True if the indices are stored with 16 bits
+    bool _shortIndices;
+
+    //! Size in bytes of each index
+    unsigned int _indexSize;
+
+    //! Pool vertex array object
+    unsigned int _vao;
+
+    //! One buffer per vertex attribute
+    std::vector< unsigned int > _vbos;
+
+    //! Index buffer
+    unsigned int _ibo;
+
+    //! Buffer with the identifiers read as per instance attribute
+    unsigned int _instanceIds;
+
+    //! Number of identifiers stored in the identifiers buffer
+    unsigned int _instanceIdsSize;
+
+    //! Indirect draw commands buffer
+    unsigned int _dibo;
+
+    //! Vertex ranges allocator
+    BufferAllocator _vertexAllocator;
+
+    //! Index ranges allocator
+    BufferAllocator _indexAllocator;
+
+    //! Mesh ranges indexed by identifier
+    MeshEntries _entries;
+
+    //! Identifiers of removed meshes available for new ones
+    std::vector< unsigned int > _freeIds;
+
+    //! Commands of the last draw
+    DrawCommands _commands;
+
+  }; // class MeshPool
+
+} // namespace nlrender
+
+#endif
@@ -0,0 +1,168 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "NodeColorBuffer.h"
+
+#ifndef NEUROLOTS_SKIP_GLEW_INCLUDE
+#include <GL/glew.h>
+#endif
+#ifdef Darwin
+#include <OpenGL/gl.h>
+#include <OpenGL/glu.h>
+#else
+#include <GL/gl.h>
+#include <GL/glu.h>
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nlrender
+{
+
+  // Close modified nodes are uploaded together, a node is only 16 bytes
+  static const unsigned int nodeColorGap = 64;
+
+  NodeColorBuffer::NodeColorBuffer( void )
+    : _dirtyRanges( nodeColorGap )
+    , _capacity( 0 )
+    , _uploadedBytes( 0 )
+    , _buffer( 0 )
+    , _texture( 0 )
+  {
+  }
+
+  NodeColorBuffer::~NodeColorBuffer( void )
+  {
+    if ( _texture != 0 )
+      glDeleteTextures( 1, &_texture );
+    if ( _buffer != 0 )
+      glDeleteBuffers( 1, &_buffer );
+  }
+
+  void NodeColorBuffer::resize( unsigned int size_ )
+  {
+    unsigned int oldSize = size( );
+    if ( size_ == oldSize )
+      return;
+
+    _data.resize( size_t( size_ ) * 4, 0.0f );
+    if ( size_ > oldSize )
+      _dirtyRanges.add( oldSize, size_ - oldSize );
+  }
+
+  unsigned int NodeColorBuffer::size( void ) const
+  {
+    return ( unsigned int )( _data.size( ) / 4 );
+  }
+
+  void NodeColorBuffer::color( unsigned int node_,
+                               const Eigen::Vector4f& color_ )
+  {
+    if ( node_ >= size( ))
+      throw std::runtime_error( "Node index out of range" );
+    std::copy( color_.data( ), color_.data( ) + 4,
+               &_data[size_t( node_ ) * 4] );
+    _dirtyRanges.add( node_ );
+  }
+
+  void NodeColorBuffer::color( const std::vector< unsigned int >& nodes_,
+                               const Eigen::Vector4f& color_ )
+  {
+    for ( auto node: nodes_ )
+      color( node, color_ );
+  }
+
+  Eigen::Vector4f NodeColorBuffer::color( unsigned int node_ ) const
+  {
+    if ( node_ >= size( ))
+      throw std::runtime_error( "Node index out of range" );
+    return Eigen::Map< const Eigen::Vector4f >( &_data[size_t( node_ ) * 4] );
+  }
+
+  const std::vector< float >& NodeColorBuffer::data( void ) const
+  {
+    return _data;
+  }
+
+  const nlgeometry::DirtyRanges& NodeColorBuffer::dirtyRanges( void ) const
+  {
+    return _dirtyRanges;
+  }
+
+  void NodeColorBuffer::upload( void )
+  {
+    if ( _buffer == 0 )
+    {
+      glGenBuffers( 1, &_buffer );
+      glGenTextures( 1, &_texture );
+    }
+    if ( _dirtyRanges.empty( ) || _data.empty( ))
+      return;
+
+    glBindBuffer( GL_TEXTURE_BUFFER, _buffer );
+    if ( _data.size( ) > _capacity )
+    {
+      _capacity = _data.size( );
+      glBufferData( GL_TEXTURE_BUFFER, sizeof( float ) * _capacity,
+                    _data.data( ), GL_DYNAMIC_DRAW );
+      glBindTexture( GL_TEXTURE_BUFFER, _texture );
+      glTexBuffer( GL_TEXTURE_BUFFER, GL_RGBA32F, _buffer );
+      glBindTexture( GL_TEXTURE_BUFFER, 0 );
+      _uploadedBytes += sizeof( float ) * _capacity;
+    }
+    else
+    {
+      unsigned int nodes = size( );
+      for ( const auto& range: _dirtyRanges.ranges( ))
+      {
+        if ( range.first >= nodes )
+          break;
+        unsigned int last = std::min( range.second, nodes );
+        size_t offset = sizeof( float ) * 4 * range.first;
+        size_t bytes = sizeof( float ) * 4 * ( last - range.first );
+        glBufferSubData( GL_TEXTURE_BUFFER, offset, bytes,
+                         &_data[size_t( range.first ) * 4] );
+        _uploadedBytes += bytes;
+      }
+    }
+    glBindBuffer( GL_TEXTURE_BUFFER, 0 );
+    _dirtyRanges.clear( );
+  }
+
+  void NodeColorBuffer::bind( unsigned int textureUnit_ )
+  {
+    glActiveTexture( GL_TEXTURE0 + textureUnit_ );
+    glBindTexture( GL_TEXTURE_BUFFER, _texture );
+    glActiveTexture( GL_TEXTURE0 );
+  }
+
+  size_t NodeColorBuffer::uploadedBytes( void ) const
+  {
+    return _uploadedBytes;
+  }
+
+  void NodeColorBuffer::resetUploadedBytes( void )
+  {
+    _uploadedBytes = 0;
+  }
+
+} // namespace nlrender
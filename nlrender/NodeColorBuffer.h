@@ -0,0 +1,172 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLRENDER_NODE_COLOR_BUFFER__
+#define __NLRENDER_NODE_COLOR_BUFFER__
+
+#include "../nlgeometry/DirtyRanges.h"
+
+#include <Eigen/Dense>
+#include <vector>
+
+#include <nlrender/api.h>
+
+namespace nlrender
+{
+
+  /* \class NodeColorBuffer
+   * Per morphology node color table read by the vertex shaders through a
+   * buffer texture, indexed by the NODE_ID vertex attribute. Each node stores
+   * a RGBA color which alpha is the weight used to mix it with the vertex
+   * color, so recoloring a node costs one texel instead of all its vertices.
+   * Only the modified texel ranges are uploaded
+   */
+  class NodeColorBuffer
+  {
+
+  public:
+
+    //! Vertex attribute location of the node index, the fourth attribute
+    //! of the mesh format
+    static const unsigned int ATTRIB_LOCATION = 3;
+
+    //! Texture unit of the buffer texture in the shaders
+    static const unsigned int TEXTURE_UNIT = 3;
+
+    /**
+     * Default constructor. The OpenGL objects are created on the first upload
+     */
+    NLRENDER_API
+    NodeColorBuffer( void );
+
+    /**
+     * Default destructor
+     */
+    NLRENDER_API
+    ~NodeColorBuffer( void );
+
+    /**
+     * Method that changes the number of nodes. New nodes get no color, so
+     * their vertices keep the vertex color
+     * @param size_ number of nodes
+     */
+    NLRENDER_API
+    void resize( unsigned int size_ );
+
+    /**
+     * Method that returns the number of nodes
+     * @return the number of nodes
+     */
+    NLRENDER_API
+    unsigned int size( void ) const;
+
+    /**
+     * Method that sets the color of a node
+     * @param node_ node index
+     * @param color_ node color, its alpha is the weight of the mix with the
+     * vertex color
+     */
+    NLRENDER_API
+    void color( unsigned int node_, const Eigen::Vector4f& color_ );
+
+    /**
+     * Method that sets the same color to several nodes
+     * @param nodes_ node indices
+     * @param color_ node color
+     */
+    NLRENDER_API
+    void color( const std::vector< unsigned int >& nodes_,
+                const Eigen::Vector4f& color_ );
+
+    /**
+     * Method that returns the color of a node
+     * @param node_ node index
+     * @return the node color
+     */
+    NLRENDER_API
+    Eigen::Vector4f color( unsigned int node_ ) const;
+
+    /**
+     * Method that returns the packed node colors
+     * @return the packed node colors
+     */
+    NLRENDER_API
+    const std::vector< float >& data( void ) const;
+
+    /**
+     * Method that returns the node ranges modified since the last upload
+     * @return the modified node ranges
+     */
+    NLRENDER_API
+    const nlgeometry::DirtyRanges& dirtyRanges( void ) const;
+
+    /**
+     * Method that uploads the modified node colors to the gpu
+     */
+    NLRENDER_API
+    void upload( void );
+
+    /**
+     * Method that binds the buffer texture to the given texture unit
+     * @param textureUnit_ texture unit index
+     */
+    NLRENDER_API
+    void bind( unsigned int textureUnit_ = TEXTURE_UNIT );
+
+    /**
+     * Method that returns the number of bytes uploaded to the gpu since the
+     * last reset
+     * @return the number of uploaded bytes
+     */
+    NLRENDER_API
+    size_t uploadedBytes( void ) const;
+
+    /**
+     * Method that resets the count of uploaded bytes
+     */
+    NLRENDER_API
+    void resetUploadedBytes( void );
+
+  protected:
+
+    //! Packed node colors, four floats per node
+    std::vector< float > _data;
+
+    //! Node ranges modified since the last upload
+    nlgeometry::DirtyRanges _dirtyRanges;
+
+    //! Number of floats allocated in the gpu buffer
+    size_t _capacity;
+
+    //! Bytes uploaded since the last reset
+    size_t _uploadedBytes;
+
+    //! Buffer object with the node colors
+    unsigned int _buffer;
+
+    //! Buffer texture to access the node colors
+    unsigned int _texture;
+
+  }; // class NodeColorBuffer
+
+} // namespace nlrender
+
+#endif
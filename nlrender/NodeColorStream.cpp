@@ -0,0 +1,189 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "NodeColorStream.h"
+
+#ifndef NEUROLOTS_SKIP_GLEW_INCLUDE
+#include <GL/glew.h>
+#endif
+#ifdef Darwin
+#include <OpenGL/gl.h>
+#include <OpenGL/glu.h>
+#else
+#include <GL/gl.h>
+#include <GL/glu.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+namespace nlrender
+{
+
+  NodeColorStream::NodeColorStream( unsigned int buffers_ )
+    : _size( 0 )
+    , _current( 0 )
+    , _skipped( 0 )
+  {
+    unsigned int buffers = std::max( buffers_, 1u );
+    _buffers.resize( buffers, 0 );
+    _textures.resize( buffers, 0 );
+    _mapped.resize( buffers, nullptr );
+    _fences.resize( buffers, nullptr );
+    _bound.resize( buffers, false );
+  }
+
+  NodeColorStream::~NodeColorStream( void )
+  {
+    _destroy( );
+  }
+
+  void NodeColorStream::resize( unsigned int size_ )
+  {
+    if ( size_ == _size )
+      return;
+    _destroy( );
+    _size = size_;
+  }
+
+  unsigned int NodeColorStream::size( void ) const
+  {
+    return _size;
+  }
+
+  bool NodeColorStream::upload( const float* colors_ )
+  {
+    if ( _size == 0 )
+      return true;
+    if ( _buffers[0] == 0 )
+      _create( );
+
+    // The draws issued since the last upload read the current buffer, so a
+    // fence left by a skipped upload is replaced by one after those draws
+    if ( _mapped[_current] && _bound[_current] )
+    {
+      if ( _fences[_current] )
+        glDeleteSync( static_cast< GLsync >( _fences[_current] ));
+      _fences[_current] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+    }
+    _bound[_current] = false;
+
+    unsigned int next = ( _current + 1 ) % ( unsigned int )_buffers.size( );
+    if ( _fences[next] )
+    {
+      GLsync fence = static_cast< GLsync >( _fences[next] );
+      if ( glClientWaitSync( fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0 ) ==
+           GL_TIMEOUT_EXPIRED )
+      {
+        // The render thread never waits, the bound colors are kept
+        _skipped++;
+        return false;
+      }
+      glDeleteSync( fence );
+      _fences[next] = nullptr;
+    }
+
+    size_t bytes = sizeof( float ) * 4 * _size;
+    if ( _mapped[next] )
+    {
+      std::memcpy( _mapped[next], colors_, bytes );
+    }
+    else
+    {
+      glBindBuffer( GL_TEXTURE_BUFFER, _buffers[next] );
+      glBufferSubData( GL_TEXTURE_BUFFER, 0, bytes, colors_ );
+      glBindBuffer( GL_TEXTURE_BUFFER, 0 );
+    }
+    _current = next;
+    return true;
+  }
+
+  void NodeColorStream::bind( unsigned int textureUnit_ )
+  {
+    glActiveTexture( GL_TEXTURE0 + textureUnit_ );
+    glBindTexture( GL_TEXTURE_BUFFER, _textures[_current] );
+    glActiveTexture( GL_TEXTURE0 );
+    _bound[_current] = true;
+  }
+
+  bool NodeColorStream::persistent( void ) const
+  {
+    return _mapped[0] != nullptr;
+  }
+
+  unsigned int NodeColorStream::skippedUploads( void ) const
+  {
+    return _skipped;
+  }
+
+  void NodeColorStream::_create( void )
+  {
+    GLsizei buffers = ( GLsizei )_buffers.size( );
+    GLsizeiptr bytes = GLsizeiptr( sizeof( float ) * 4 * _size );
+    glGenBuffers( buffers, _buffers.data( ));
+    glGenTextures( buffers, _textures.data( ));
+    for ( unsigned int i = 0; i < _buffers.size( ); i++ )
+    {
+      glBindBuffer( GL_TEXTURE_BUFFER, _buffers[i] );
+      if ( GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage )
+      {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+          GL_MAP_COHERENT_BIT;
+        glBufferStorage( GL_TEXTURE_BUFFER, bytes, nullptr, flags );
+        _mapped[i] = static_cast< float* >(
+          glMapBufferRange( GL_TEXTURE_BUFFER, 0, bytes, flags ));
+      }
+      else
+      {
+        glBufferData( GL_TEXTURE_BUFFER, bytes, nullptr, GL_STREAM_DRAW );
+        _mapped[i] = nullptr;
+      }
+      glBindTexture( GL_TEXTURE_BUFFER, _textures[i] );
+      glTexBuffer( GL_TEXTURE_BUFFER, GL_RGBA32F, _buffers[i] );
+      _fences[i] = nullptr;
+      _bound[i] = false;
+    }
+    glBindTexture( GL_TEXTURE_BUFFER, 0 );
+    glBindBuffer( GL_TEXTURE_BUFFER, 0 );
+    _current = 0;
+  }
+
+  void NodeColorStream::_destroy( void )
+  {
+    if ( _buffers[0] == 0 )
+      return;
+    for ( auto& fence: _fences )
+    {
+      if ( fence )
+        glDeleteSync( static_cast< GLsync >( fence ));
+      fence = nullptr;
+    }
+    // Deleting the buffers also unmaps them
+    glDeleteTextures(( GLsizei )_textures.size( ), _textures.data( ));
+    glDeleteBuffers(( GLsizei )_buffers.size( ), _buffers.data( ));
+    std::fill( _buffers.begin( ), _buffers.end( ), 0 );
+    std::fill( _textures.begin( ), _textures.end( ), 0 );
+    std::fill( _mapped.begin( ), _mapped.end( ), nullptr );
+    std::fill( _bound.begin( ), _bound.end( ), false );
+    _current = 0;
+  }
+
+} // namespace nlrender
@@ -0,0 +1,144 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLRENDER_NODE_COLOR_STREAM__
+#define __NLRENDER_NODE_COLOR_STREAM__
+
+#include "NodeColorBuffer.h"
+
+#include <vector>
+
+#include <nlrender/api.h>
+
+namespace nlrender
+{
+
+  /* \class NodeColorStream
+   * Per node color table for colors that change every frame, such as a
+   * simulation playback. The table is replaced as a whole in a ring of gpu
+   * buffers, so a new frame is written while the previous ones are still
+   * read by the gpu. With buffer storage support the buffers are
+   * persistently mapped and each one is protected by a fence placed after
+   * the draws that read it; a frame whose buffer is still in use is skipped
+   * instead of waiting. It is bound instead of the renderer node color
+   * buffer, with the same texel layout
+   */
+  class NodeColorStream
+  {
+
+  public:
+
+    /**
+     * Constructor. The OpenGL objects are created on the first upload
+     * @param buffers_ number of buffers of the ring, three by default
+     */
+    NLRENDER_API
+    NodeColorStream( unsigned int buffers_ = 3 );
+
+    /**
+     * Default destructor
+     */
+    NLRENDER_API
+    ~NodeColorStream( void );
+
+    /**
+     * Method that changes the number of nodes. The buffers are created
+     * again on the next upload
+     * @param size_ number of nodes
+     */
+    NLRENDER_API
+    void resize( unsigned int size_ );
+
+    /**
+     * Method that returns the number of nodes
+     * @return the number of nodes
+     */
+    NLRENDER_API
+    unsigned int size( void ) const;
+
+    /**
+     * Method that writes the colors of all the nodes to the next buffer of
+     * the ring, which becomes the bound one
+     * @param colors_ four floats per node, as PlaybackStream decodes them
+     * @return false if the next buffer is still in use and the colors were
+     * skipped
+     */
+    NLRENDER_API
+    bool upload( const float* colors_ );
+
+    /**
+     * Method that binds the buffer texture of the last uploaded colors to
+     * the given texture unit
+     * @param textureUnit_ texture unit index
+     */
+    NLRENDER_API
+    void bind( unsigned int textureUnit_ = NodeColorBuffer::TEXTURE_UNIT );
+
+    /**
+     * Method that returns if the buffers are persistently mapped
+     * @return true if the buffers are persistently mapped
+     */
+    NLRENDER_API
+    bool persistent( void ) const;
+
+    /**
+     * Method that returns the number of uploads skipped because their
+     * buffer was still in use
+     * @return the number of skipped uploads
+     */
+    NLRENDER_API
+    unsigned int skippedUploads( void ) const;
+
+  protected:
+
+    void _create( void );
+
+    void _destroy( void );
+
+    //! Number of nodes
+    unsigned int _size;
+
+    //! Buffer objects of the ring
+    std::vector< unsigned int > _buffers;
+
+    //! Buffer textures of the ring
+    std::vector< unsigned int > _textures;
+
+    //! Persistent mappings, null if buffer storage is not supported
+    std::vector< float* > _mapped;
+
+    //! Fences of the draws that read each buffer, null if there are none
+    std::vector< void* > _fences;
+
+    //! Buffers bound since their last fence
+    std::vector< bool > _bound;
+
+    //! Buffer of the last uploaded colors
+    unsigned int _current;
+
+    //! Number of skipped uploads
+    unsigned int _skipped;
+
+  }; // class NodeColorStream
+
+} // namespace nlrender
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "PlaybackFile.h"
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace nlrender
+{
+
+  static const char playbackMagic[4] = { 'N', 'L', 'P', 'B' };
+
+  PlaybackFile::PlaybackFile( const std::string& fileName_ )
+    : _file( nullptr )
+    , _values( nullptr )
+    , _nodes( 0 )
+    , _frames( 0 )
+    , _timeStep( 0.0f )
+  {
+    try
+    {
+      _file = new boost::iostreams::mapped_file_source( fileName_ );
+    }
+    catch ( const std::exception& )
+    {
+      throw std::runtime_error( "Unable to map playback file " + fileName_ );
+    }
+
+    const char* data = _file->data( );
+    uint32_t header[3];
+    if ( _file->size( ) < HEADER_SIZE ||
+         !std::equal( playbackMagic, playbackMagic + 4, data ))
+    {
+      delete _file;
+      throw std::runtime_error( "Invalid playback file " + fileName_ );
+    }
+    std::memcpy( header, data + 4, sizeof( header ));
+    std::memcpy( &_timeStep, data + 16, sizeof( float ));
+    _nodes = header[1];
+    _frames = header[2];
+    size_t bytes = size_t( _nodes ) * _frames * sizeof( float );
+    if ( header[0] != VERSION || _file->size( ) - HEADER_SIZE < bytes )
+    {
+      delete _file;
+      throw std::runtime_error( "Invalid playback file " + fileName_ );
+    }
+    // The mapping is page aligned and the header keeps the values aligned
+    _values = reinterpret_cast< const float* >( data + HEADER_SIZE );
+  }
+
+  PlaybackFile::~PlaybackFile( void )
+  {
+    delete _file;
+  }
+
+  unsigned int PlaybackFile::numberNodes( void ) const
+  {
+    return _nodes;
+  }
+
+  unsigned int PlaybackFile::numberFrames( void ) const
+  {
+    return _frames;
+  }
+
+  float PlaybackFile::timeStep( void ) const
+  {
+    return _timeStep;
+  }
+
+  const float* PlaybackFile::frame( unsigned int frame_ ) const
+  {
+    if ( frame_ >= _frames )
+      throw std::runtime_error( "Playback frame out of range" );
+    return _values + size_t( frame_ ) * _nodes;
+  }
+
+  unsigned int PlaybackFile::frameAt( float time_ ) const
+  {
+    if ( _frames == 0 || _timeStep <= 0.0f || time_ <= 0.0f )
+      return 0;
+    float frame = std::floor( time_ / _timeStep );
+    if ( frame >= float( _frames - 1 ))
+      return _frames - 1;
+    return ( unsigned int )frame;
+  }
+
+  void PlaybackFile::write( std::ostream& stream_, unsigned int nodes_,
+                            float timeStep_,
+                            const std::vector< float >& values_ )
+  {
+    if ( nodes_ == 0 || values_.size( ) % nodes_ != 0 )
+      throw std::runtime_error( "Playback values are not whole frames" );
+    uint32_t header[3] =
+      { VERSION, nodes_, uint32_t( values_.size( ) / nodes_ ) };
+    stream_.write( playbackMagic, sizeof( playbackMagic ));
+    stream_.write( reinterpret_cast< const char* >( header ),
+                   sizeof( header ));
+    stream_.write( reinterpret_cast< const char* >( &timeStep_ ),
+                   sizeof( float ));
+    stream_.write( reinterpret_cast< const char* >( values_.data( )),
+                   values_.size( ) * sizeof( float ));
+  }
+
+} // namespace nlrender
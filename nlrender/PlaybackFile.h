@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLRENDER_PLAYBACK_FILE__
+#define __NLRENDER_PLAYBACK_FILE__
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <nlrender/api.h>
+
+namespace boost
+{
+  namespace iostreams
+  {
+    class mapped_file_source;
+  }
+}
+
+namespace nlrender
+{
+
+  /* \class PlaybackFile
+   * Memory mapped binary time series of simulation values per morphology
+   * node, such as voltages or spikes. The file has a header with the number
+   * of nodes, the number of frames and the time between frames, followed by
+   * the values of every frame indexed by node id. Frames are read from the
+   * mapping without copies, so the operating system only loads the pages of
+   * the frames that are played
+   */
+  class PlaybackFile
+  {
+
+  public:
+
+    //! Version of the file format
+    static const unsigned int VERSION = 1;
+
+    //! Size in bytes of the file header
+    static const unsigned int HEADER_SIZE = 20;
+
+    /**
+     * Constructor that maps the given file, throws if it is not a valid
+     * playback file
+     * @param fileName_ path of the playback file
+     */
+    NLRENDER_API
+    PlaybackFile( const std::string& fileName_ );
+
+    /**
+     * Default destructor, unmaps the file
+     */
+    NLRENDER_API
+    ~PlaybackFile( void );
+
+    /**
+     * Method that returns the number of values of each frame
+     * @return the number of nodes
+     */
+    NLRENDER_API
+    unsigned int numberNodes( void ) const;
+
+    /**
+     * Method that returns the number of frames
+     * @return the number of frames
+     */
+    NLRENDER_API
+    unsigned int numberFrames( void ) const;
+
+    /**
+     * Method that returns the simulation time between frames
+     * @return the time between frames
+     */
+    NLRENDER_API
+    float timeStep( void ) const;
+
+    /**
+     * Method that returns the values of a frame, stored in the mapping
+     * @param frame_ frame index
+     * @return pointer to the values of the frame indexed by node id
+     */
+    NLRENDER_API
+    const float* frame( unsigned int frame_ ) const;
+
+    /**
+     * Method that returns the frame of a simulation time, clamped to the
+     * recorded frames
+     * @param time_ simulation time
+     * @return the frame index
+     */
+    NLRENDER_API
+    unsigned int frameAt( float time_ ) const;
+
+    /**
+     * Static method that writes a playback file to a stream
+     * @param stream_ binary output stream
+     * @param nodes_ number of values of each frame
+     * @param timeStep_ simulation time between frames
+     * @param values_ values of all the frames, frame after frame
+     */
+    NLRENDER_API
+    static void write( std::ostream& stream_, unsigned int nodes_,
+                       float timeStep_, const std::vector< float >& values_ );
+
+  protected:
+
+    //! Read only mapping of the file
+    boost::iostreams::mapped_file_source* _file;
+
+    //! First value of the first frame
+    const float* _values;
+
+    //! Number of values of each frame
+    unsigned int _nodes;
+
+    //! Number of frames
+    unsigned int _frames;
+
+    //! Simulation time between frames
+    float _timeStep;
+
+  }; // class PlaybackFile
+
+} // namespace nlrender
+
+#endif
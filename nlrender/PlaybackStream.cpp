@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "PlaybackStream.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nlrender
+{
+
+  static const unsigned int invalidFrame = ~0u;
+
+  PlaybackStream::PlaybackStream( const std::string& fileName_,
+                                  unsigned int prefetch_ )
+    : _file( fileName_ )
+    , _requested( 0 )
+    , _missed( 0 )
+    , _minimum( 0.0f )
+    , _maximum( 1.0f )
+    , _low( 0.0f, 0.0f, 1.0f )
+    , _high( 1.0f, 0.0f, 0.0f )
+    , _running( false )
+  {
+    _slots.resize( std::max( prefetch_, 1u ));
+    for ( auto& slot: _slots )
+    {
+      slot.frame = invalidFrame;
+      slot.colors.resize( size_t( _file.numberNodes( )) * 4, 0.0f );
+    }
+  }
+
+  PlaybackStream::~PlaybackStream( void )
+  {
+    stop( );
+  }
+
+  const PlaybackFile* PlaybackStream::file( void ) const
+  {
+    return &_file;
+  }
+
+  void PlaybackStream::range( float minimum_, float maximum_ )
+  {
+    std::lock_guard< std::mutex > lock( _mutex );
+    _minimum = minimum_;
+    _maximum = maximum_;
+  }
+
+  void PlaybackStream::colors( const Eigen::Vector3f& low_,
+                               const Eigen::Vector3f& high_ )
+  {
+    std::lock_guard< std::mutex > lock( _mutex );
+    _low = low_;
+    _high = high_;
+  }
+
+  void PlaybackStream::start( void )
+  {
+    std::lock_guard< std::mutex > lock( _mutex );
+    if ( _running )
+      return;
+    _running = true;
+    _thread = std::thread( &PlaybackStream::_prefetch, this );
+  }
+
+  void PlaybackStream::stop( void )
+  {
+    {
+      std::lock_guard< std::mutex > lock( _mutex );
+      if ( !_running )
+        return;
+      _running = false;
+    }
+    _condition.notify_all( );
+    _thread.join( );
+  }
+
+  bool PlaybackStream::running( void ) const
+  {
+    std::lock_guard< std::mutex > lock( _mutex );
+    return _running;
+  }
+
+  const float* PlaybackStream::frame( unsigned int frame_, bool wait_ )
+  {
+    if ( frame_ >= _file.numberFrames( ))
+      throw std::runtime_error( "Playback frame out of range" );
+
+    std::unique_lock< std::mutex > lock( _mutex );
+    TSlot& slot = _slots[ frame_ % _slots.size( )];
+    if ( !_running )
+    {
+      _requested = frame_;
+      if ( slot.frame != frame_ )
+      {
+        decode( _file.frame( frame_ ), _file.numberNodes( ), _minimum,
+                _maximum, _low, _high, slot.colors.data( ));
+        slot.frame = frame_;
+      }
+      return slot.colors.data( );
+    }
+
+    if ( _requested != frame_ )
+    {
+      _requested = frame_;
+      _condition.notify_all( );
+    }
+    if ( wait_ )
+      _condition.wait( lock, [ & ]
+        { return slot.frame == frame_ || !_running; });
+    if ( slot.frame != frame_ )
+    {
+      _missed++;
+      return nullptr;
+    }
+    return slot.colors.data( );
+  }
+
+  unsigned int PlaybackStream::missedFrames( void ) const
+  {
+    std::lock_guard< std::mutex > lock( _mutex );
+    return _missed;
+  }
+
+  void PlaybackStream::decode( const float* values_, unsigned int nodes_,
+                               float minimum_, float maximum_,
+                               const Eigen::Vector3f& low_,
+                               const Eigen::Vector3f& high_, float* colors_ )
+  {
+    float scale = maximum_ > minimum_ ? 1.0f / ( maximum_ - minimum_ ) : 0.0f;
+    Eigen::Vector3f delta = high_ - low_;
+    for ( unsigned int i = 0; i < nodes_; i++ )
+    {
+      // Infinite values are clamped to the nearest color and NaN values
+      // to the low one
+      float weight = std::min( std::max( 0.0f, ( values_[i] - minimum_ ) *
+                                         scale ), 1.0f );
+      Eigen::Map< Eigen::Vector3f >( colors_ + size_t( i ) * 4 ) =
+        low_ + delta * weight;
+      colors_[ size_t( i ) * 4 + 3 ] = weight;
+    }
+  }
+
+  void PlaybackStream::_prefetch( void )
+  {
+    std::unique_lock< std::mutex > lock( _mutex );
+    while ( _running )
+    {
+      // First frame of the window after the requested one without decoding,
+      // the window never reuses the slot of the requested frame
+      size_t last = std::min( size_t( _requested ) + _slots.size( ),
+                              size_t( _file.numberFrames( )));
+      TSlot* slot = nullptr;
+      unsigned int next = 0;
+      for ( size_t frame = _requested; frame < last; frame++ )
+      {
+        TSlot& candidate = _slots[ frame % _slots.size( )];
+        if ( candidate.frame != frame )
+        {
+          slot = &candidate;
+          next = ( unsigned int )frame;
+          break;
+        }
+      }
+      if ( !slot )
+      {
+        _condition.wait( lock );
+        continue;
+      }
+
+      slot->frame = invalidFrame;
+      float minimum = _minimum;
+      float maximum = _maximum;
+      Eigen::Vector3f low = _low;
+      Eigen::Vector3f high = _high;
+      lock.unlock( );
+      decode( _file.frame( next ), _file.numberNodes( ), minimum, maximum,
+              low, high, slot->colors.data( ));
+      lock.lock( );
+      slot->frame = next;
+      _condition.notify_all( );
+    }
+  }
+
+} // namespace nlrender
@@ -0,0 +1,197 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLRENDER_PLAYBACK_STREAM__
+#define __NLRENDER_PLAYBACK_STREAM__
+
+#include "PlaybackFile.h"
+
+#include <Eigen/Dense>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <nlrender/api.h>
+
+namespace nlrender
+{
+
+  /* \class PlaybackStream
+   * Decodes the frames of a playback file into per node RGBA colors, the
+   * layout of the NodeColorBuffer and NodeColorStream tables. Once started,
+   * a background thread decodes the frames that follow the last requested
+   * one into a ring of slots, so the render thread only picks decoded
+   * frames and never waits for the file pages. Without starting it, frames
+   * are decoded in the calling thread
+   */
+  class PlaybackStream
+  {
+
+  public:
+
+    /**
+     * Constructor
+     * @param fileName_ path of the playback file
+     * @param prefetch_ number of frames decoded ahead of the requested one
+     */
+    NLRENDER_API
+    PlaybackStream( const std::string& fileName_,
+                    unsigned int prefetch_ = 8 );
+
+    /**
+     * Default destructor, stops the prefetch thread
+     */
+    NLRENDER_API
+    ~PlaybackStream( void );
+
+    /**
+     * Method that returns the playback file
+     * @return the playback file
+     */
+    NLRENDER_API
+    const PlaybackFile* file( void ) const;
+
+    /**
+     * Method that sets the values mapped to the low and high colors. Frames
+     * already decoded keep the previous mapping
+     * @param minimum_ value of the low color
+     * @param maximum_ value of the high color
+     */
+    NLRENDER_API
+    void range( float minimum_, float maximum_ );
+
+    /**
+     * Method that sets the colors of the minimum and maximum values
+     * @param low_ color of the minimum value
+     * @param high_ color of the maximum value
+     */
+    NLRENDER_API
+    void colors( const Eigen::Vector3f& low_, const Eigen::Vector3f& high_ );
+
+    /**
+     * Method that starts the prefetch thread
+     */
+    NLRENDER_API
+    void start( void );
+
+    /**
+     * Method that stops the prefetch thread
+     */
+    NLRENDER_API
+    void stop( void );
+
+    /**
+     * Method that returns if the prefetch thread is running
+     * @return true if the prefetch thread is running
+     */
+    NLRENDER_API
+    bool running( void ) const;
+
+    /**
+     * Method that returns the decoded colors of a frame and schedules the
+     * following ones. The colors are valid until the next call
+     * @param frame_ frame index
+     * @param wait_ true to wait for the prefetch thread to decode the frame
+     * @return four floats per node or null if the frame is not decoded yet
+     */
+    NLRENDER_API
+    const float* frame( unsigned int frame_, bool wait_ = false );
+
+    /**
+     * Method that returns the number of requested frames that were not
+     * decoded yet
+     * @return the number of missed frames
+     */
+    NLRENDER_API
+    unsigned int missedFrames( void ) const;
+
+    /**
+     * Static method that decodes frame values into RGBA colors. The color
+     * mixes the low and high colors and its alpha is the normalized value,
+     * so minimum values keep the vertex colors
+     * @param values_ values of the frame
+     * @param nodes_ number of values
+     * @param minimum_ value of the low color
+     * @param maximum_ value of the high color
+     * @param low_ color of the minimum value
+     * @param high_ color of the maximum value
+     * @param colors_ destination of four floats per value
+     */
+    NLRENDER_API
+    static void decode( const float* values_, unsigned int nodes_,
+                        float minimum_, float maximum_,
+                        const Eigen::Vector3f& low_,
+                        const Eigen::Vector3f& high_, float* colors_ );
+
+  protected:
+
+    //! Slot of the decoded frames ring
+    typedef struct
+    {
+      //! Decoded frame, invalid if the slot is empty or being decoded
+      unsigned int frame;
+      std::vector< float > colors;
+    } TSlot;
+
+    void _prefetch( void );
+
+    //! Mapped playback file
+    PlaybackFile _file;
+
+    //! Ring of decoded frames, each frame goes to the slot of its index
+    std::vector< TSlot > _slots;
+
+    //! Last requested frame
+    unsigned int _requested;
+
+    //! Number of requested frames not decoded yet
+    unsigned int _missed;
+
+    //! Value of the low color
+    float _minimum;
+
+    //! Value of the high color
+    float _maximum;
+
+    //! Color of the minimum value
+    Eigen::Vector3f _low;
+
+    //! Color of the maximum value
+    Eigen::Vector3f _high;
+
+    //! True while the prefetch thread has to run
+    bool _running;
+
+    //! Prefetch thread
+    std::thread _thread;
+
+    //! Mutex of the slots and the requested frame
+    mutable std::mutex _mutex;
+
+    //! Signals new requests to the thread and decoded frames to the waits
+    std::condition_variable _condition;
+
+  }; // class PlaybackStream
+
+} // namespace nlrender
+
+#endif
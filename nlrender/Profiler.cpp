@@ -0,0 +1,373 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "Profiler.h"
+
+#ifndef NEUROLOTS_SKIP_GLEW_INCLUDE
+#include <GL/glew.h>
+#endif
+#ifdef Darwin
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+
+#include <chrono>
+#include <stdexcept>
+
+namespace nlrender
+{
+
+  // Ended frames kept before waiting for their queries, enough to hide the
+  // latency of the gpu without stalling the pipeline
+  static const unsigned int MAX_PENDING_FRAMES = 4;
+
+  double CPUProfilerBackend::now( void )
+  {
+    return std::chrono::duration< double, std::milli >(
+      std::chrono::steady_clock::now( ).time_since_epoch( )).count( );
+  }
+
+  bool CPUProfilerBackend::queries( void ) const
+  {
+    return false;
+  }
+
+  unsigned int CPUProfilerBackend::beginQuery( TQuery )
+  {
+    return 0;
+  }
+
+  void CPUProfilerBackend::endQuery( TQuery )
+  {
+  }
+
+  bool CPUProfilerBackend::result( unsigned int, uint64_t&, bool )
+  {
+    return true;
+  }
+
+  void CPUProfilerBackend::release( unsigned int )
+  {
+  }
+
+  static GLenum _queryTarget( ProfilerBackend::TQuery type_ )
+  {
+    return type_ == ProfilerBackend::TIME_ELAPSED ? GL_TIME_ELAPSED :
+      GL_PRIMITIVES_GENERATED;
+  }
+
+  GLProfilerBackend::GLProfilerBackend( void )
+  {
+  }
+
+  GLProfilerBackend::~GLProfilerBackend( void )
+  {
+    if ( !_queries.empty( ))
+      glDeleteQueries( GLsizei( _queries.size( )), _queries.data( ));
+  }
+
+  bool GLProfilerBackend::queries( void ) const
+  {
+    return true;
+  }
+
+  unsigned int GLProfilerBackend::beginQuery( TQuery type_ )
+  {
+    unsigned int query;
+    if ( _free.empty( ))
+    {
+      glGenQueries( 1, &query );
+      _queries.push_back( query );
+    }
+    else
+    {
+      query = _free.back( );
+      _free.pop_back( );
+    }
+    glBeginQuery( _queryTarget( type_ ), query );
+    return query;
+  }
+
+  void GLProfilerBackend::endQuery( TQuery type_ )
+  {
+    glEndQuery( _queryTarget( type_ ));
+  }
+
+  bool GLProfilerBackend::result( unsigned int query_, uint64_t& value_,
+                                  bool wait_ )
+  {
+    if ( !wait_ )
+    {
+      GLuint available = GL_FALSE;
+      glGetQueryObjectuiv( query_, GL_QUERY_RESULT_AVAILABLE, &available );
+      if ( available == GL_FALSE )
+        return false;
+    }
+    GLuint64 value = 0;
+    glGetQueryObjectui64v( query_, GL_QUERY_RESULT, &value );
+    value_ = value;
+    return true;
+  }
+
+  void GLProfilerBackend::release( unsigned int query_ )
+  {
+    _free.push_back( query_ );
+  }
+
+  RingSink::RingSink( unsigned int capacity_ )
+    : _capacity( capacity_ )
+  {
+  }
+
+  void RingSink::write( const TFrameStats& frame_ )
+  {
+    if ( _capacity == 0 )
+      return;
+    if ( _frames.size( ) == _capacity )
+      _frames.pop_front( );
+    _frames.push_back( frame_ );
+  }
+
+  const std::deque< TFrameStats >& RingSink::frames( void ) const
+  {
+    return _frames;
+  }
+
+  void RingSink::clear( void )
+  {
+    _frames.clear( );
+  }
+
+  JsonSink::JsonSink( std::ostream& stream_ )
+    : _stream( stream_ )
+  {
+  }
+
+  void JsonSink::write( const TFrameStats& frame_ )
+  {
+    _stream << "{\"frame\":" << frame_.frame << ",\"passes\":[";
+    for ( unsigned int i = 0; i < frame_.passes.size( ); i++ )
+    {
+      const TPassStats& pass = frame_.passes[i];
+      if ( i > 0 )
+        _stream << ",";
+      _stream << "{\"name\":\"";
+      for ( auto c: pass.name )
+      {
+        if ( c == '"' || c == '\\' )
+          _stream << '\\';
+        _stream << c;
+      }
+      _stream << "\",\"cpu\":" << pass.cpuTime << ",\"gpu\":";
+      if ( pass.gpuTime < 0.0 )
+        _stream << "null";
+      else
+        _stream << pass.gpuTime;
+      _stream << ",\"draws\":" << pass.drawCalls
+              << ",\"uniforms\":" << pass.uniformUploads
+              << ",\"subroutines\":" << pass.subroutineSwitches
+              << ",\"primitives\":" << pass.primitives << "}";
+    }
+    _stream << "]}" << std::endl;
+  }
+
+  Profiler::Profiler( ProfilerBackend* backend_ )
+    : _backend( backend_ ? backend_ : new CPUProfilerBackend( ))
+    , _inFrame( false )
+    , _depth( 0 )
+    , _passStart( 0.0 )
+    , _frame( 0 )
+  {
+  }
+
+  Profiler::~Profiler( void )
+  {
+    while ( _depth > 0 )
+      endPass( );
+    if ( _inFrame )
+      endFrame( );
+    flush( );
+    delete _backend;
+  }
+
+  void Profiler::addSink( ProfilerSink* sink_ )
+  {
+    _sinks.push_back( sink_ );
+  }
+
+  void Profiler::beginFrame( void )
+  {
+    if ( _depth > 0 )
+      throw std::runtime_error( "Profiler frame begun inside a pass" );
+    if ( _inFrame )
+      endFrame( );
+    _current = TPendingFrame( );
+    _current.stats.frame = _frame;
+    _inFrame = true;
+  }
+
+  void Profiler::endFrame( void )
+  {
+    if ( _depth > 0 )
+      throw std::runtime_error( "Profiler frame ended inside a pass" );
+    if ( !_inFrame )
+      beginFrame( );
+    _pending.push_back( _current );
+    _inFrame = false;
+    _frame++;
+    _write( false );
+  }
+
+  void Profiler::beginPass( const std::string& name_, bool primitivesQuery_ )
+  {
+    if ( !_inFrame )
+      beginFrame( );
+    if ( _depth++ > 0 )
+      return;
+
+    TPassStats pass;
+    pass.name = name_;
+    pass.cpuTime = 0.0;
+    pass.gpuTime = -1.0;
+    pass.drawCalls = 0;
+    pass.uniformUploads = 0;
+    pass.subroutineSwitches = 0;
+    pass.primitives = 0;
+    _current.stats.passes.push_back( pass );
+
+    bool queries = _backend->queries( );
+    _current.timers.push_back(
+      queries ? _backend->beginQuery( ProfilerBackend::TIME_ELAPSED ) : 0 );
+    _current.primitives.push_back( queries && primitivesQuery_ ?
+      _backend->beginQuery( ProfilerBackend::PRIMITIVES_GENERATED ) : 0 );
+    _passStart = _backend->now( );
+  }
+
+  void Profiler::endPass( void )
+  {
+    if ( _depth == 0 )
+      throw std::runtime_error( "Profiler pass ended without beginning it" );
+    if ( --_depth > 0 )
+      return;
+
+    _current.stats.passes.back( ).cpuTime = _backend->now( ) - _passStart;
+    if ( _current.timers.back( ) != 0 )
+      _backend->endQuery( ProfilerBackend::TIME_ELAPSED );
+    if ( _current.primitives.back( ) != 0 )
+      _backend->endQuery( ProfilerBackend::PRIMITIVES_GENERATED );
+  }
+
+  void Profiler::drawCalls( unsigned int count_ )
+  {
+    if ( _depth > 0 )
+      _current.stats.passes.back( ).drawCalls += count_;
+  }
+
+  void Profiler::uniformUploads( unsigned int count_ )
+  {
+    if ( _depth > 0 )
+      _current.stats.passes.back( ).uniformUploads += count_;
+  }
+
+  void Profiler::subroutineSwitches( unsigned int count_ )
+  {
+    if ( _depth > 0 )
+      _current.stats.passes.back( ).subroutineSwitches += count_;
+  }
+
+  void Profiler::primitives( uint64_t count_ )
+  {
+    if ( _depth > 0 )
+      _current.stats.passes.back( ).primitives += count_;
+  }
+
+  void Profiler::flush( void )
+  {
+    _write( true );
+  }
+
+  unsigned int Profiler::pendingFrames( void ) const
+  {
+    return ( unsigned int )_pending.size( );
+  }
+
+  unsigned int Profiler::frame( void ) const
+  {
+    return _frame;
+  }
+
+  void Profiler::_write( bool wait_ )
+  {
+    while ( !_pending.empty( ))
+    {
+      TPendingFrame& pending = _pending.front( );
+      bool wait = wait_ || _pending.size( ) > MAX_PENDING_FRAMES;
+      unsigned int size = ( unsigned int )pending.stats.passes.size( );
+
+      // The frame is written only when all its queries are available
+      std::vector< uint64_t > times( size, 0 );
+      std::vector< uint64_t > primitives( size, 0 );
+      for ( unsigned int i = 0; i < size; i++ )
+      {
+        if (( pending.timers[i] != 0 &&
+              !_backend->result( pending.timers[i], times[i], wait )) ||
+            ( pending.primitives[i] != 0 &&
+              !_backend->result( pending.primitives[i], primitives[i],
+                                 wait )))
+          return;
+      }
+
+      for ( unsigned int i = 0; i < size; i++ )
+      {
+        TPassStats& pass = pending.stats.passes[i];
+        if ( pending.timers[i] != 0 )
+        {
+          pass.gpuTime = double( times[i] ) * 1e-6;
+          _backend->release( pending.timers[i] );
+        }
+        if ( pending.primitives[i] != 0 )
+        {
+          pass.primitives += primitives[i];
+          _backend->release( pending.primitives[i] );
+        }
+      }
+      for ( auto sink: _sinks )
+        sink->write( pending.stats );
+      _pending.pop_front( );
+    }
+  }
+
+  ProfilerPass::ProfilerPass( Profiler* profiler_, const std::string& name_,
+                              bool primitivesQuery_ )
+    : _profiler( profiler_ )
+  {
+    if ( _profiler )
+      _profiler->beginPass( name_, primitivesQuery_ );
+  }
+
+  ProfilerPass::~ProfilerPass( void )
+  {
+    if ( _profiler )
+      _profiler->endPass( );
+  }
+
+} // namespace nlrender
@@ -0,0 +1,455 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLRENDER_PROFILER__
+#define __NLRENDER_PROFILER__
+
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <nlrender/api.h>
+
+namespace nlrender
+{
+
+  /* \class ProfilerBackend
+   * Clock and GPU queries used by the profiler, so the profiler can be used
+   * and tested without an OpenGL context
+   */
+  class ProfilerBackend
+  {
+
+  public:
+
+    typedef enum
+    {
+      TIME_ELAPSED = 0,
+      PRIMITIVES_GENERATED
+    } TQuery;
+
+    NLRENDER_API
+    virtual ~ProfilerBackend( void ) { }
+
+    /**
+     * Method that returns the current time of a monotonic clock
+     * @return the current time in milliseconds
+     */
+    NLRENDER_API
+    virtual double now( void ) = 0;
+
+    /**
+     * Method that returns if the backend measures the gpu with queries
+     * @return true if the queries are supported
+     */
+    NLRENDER_API
+    virtual bool queries( void ) const = 0;
+
+    /**
+     * Method that starts a query. Only one query of each type can be active
+     * @param type_ type of the query
+     * @return identifier of the query
+     */
+    NLRENDER_API
+    virtual unsigned int beginQuery( TQuery type_ ) = 0;
+
+    /**
+     * Method that ends the active query of the given type
+     * @param type_ type of the query
+     */
+    NLRENDER_API
+    virtual void endQuery( TQuery type_ ) = 0;
+
+    /**
+     * Method that reads the result of an ended query
+     * @param query_ identifier of the query
+     * @param value_ nanoseconds or primitives, set only when available
+     * @param wait_ true to wait until the result is available
+     * @return true if the result is available
+     */
+    NLRENDER_API
+    virtual bool result( unsigned int query_, uint64_t& value_,
+                         bool wait_ ) = 0;
+
+    /**
+     * Method that releases a query after reading its result
+     * @param query_ identifier of the query
+     */
+    NLRENDER_API
+    virtual void release( unsigned int query_ ) = 0;
+
+  }; // class ProfilerBackend
+
+  /* \class CPUProfilerBackend
+   * Backend that only measures the cpu time
+   */
+  class CPUProfilerBackend : public ProfilerBackend
+  {
+
+  public:
+
+    NLRENDER_API
+    virtual double now( void );
+
+    NLRENDER_API
+    virtual bool queries( void ) const;
+
+    NLRENDER_API
+    virtual unsigned int beginQuery( TQuery type_ );
+
+    NLRENDER_API
+    virtual void endQuery( TQuery type_ );
+
+    NLRENDER_API
+    virtual bool result( unsigned int query_, uint64_t& value_, bool wait_ );
+
+    NLRENDER_API
+    virtual void release( unsigned int query_ );
+
+  }; // class CPUProfilerBackend
+
+  /* \class GLProfilerBackend
+   * Backend that measures the gpu with OpenGL timer and primitive queries.
+   * It has to be created and destroyed with the OpenGL context current
+   */
+  class GLProfilerBackend : public CPUProfilerBackend
+  {
+
+  public:
+
+    /**
+     * Default constructor
+     */
+    NLRENDER_API
+    GLProfilerBackend( void );
+
+    /**
+     * Default destructor, deletes the OpenGL queries
+     */
+    NLRENDER_API
+    virtual ~GLProfilerBackend( void );
+
+    NLRENDER_API
+    virtual bool queries( void ) const;
+
+    NLRENDER_API
+    virtual unsigned int beginQuery( TQuery type_ );
+
+    NLRENDER_API
+    virtual void endQuery( TQuery type_ );
+
+    NLRENDER_API
+    virtual bool result( unsigned int query_, uint64_t& value_, bool wait_ );
+
+    NLRENDER_API
+    virtual void release( unsigned int query_ );
+
+  protected:
+
+    //! Queries released to be reused
+    std::vector< unsigned int > _free;
+
+    //! All the queries created
+    std::vector< unsigned int > _queries;
+
+  }; // class GLProfilerBackend
+
+  /**
+   * Measures of a pass of a frame
+   */
+  typedef struct
+  {
+    //! Name of the pass
+    std::string name;
+    //! Cpu time in milliseconds
+    double cpuTime;
+    //! Gpu time in milliseconds, negative if it was not measured
+    double gpuTime;
+    //! Number of draw calls
+    unsigned int drawCalls;
+    //! Number of uniform uploads
+    unsigned int uniformUploads;
+    //! Number of subroutine uniform switches
+    unsigned int subroutineSwitches;
+    //! Number of primitives generated
+    uint64_t primitives;
+  } TPassStats;
+
+  /**
+   * Measures of a frame
+   */
+  typedef struct
+  {
+    //! Frame number
+    unsigned int frame;
+    //! Passes in the order they began
+    std::vector< TPassStats > passes;
+  } TFrameStats;
+
+  /* \class ProfilerSink
+   * Destination of the frames measured by the profiler
+   */
+  class ProfilerSink
+  {
+
+  public:
+
+    NLRENDER_API
+    virtual ~ProfilerSink( void ) { }
+
+    /**
+     * Method that receives a frame once all its measures are available
+     * @param frame_ measures of the frame
+     */
+    NLRENDER_API
+    virtual void write( const TFrameStats& frame_ ) = 0;
+
+  }; // class ProfilerSink
+
+  /* \class RingSink
+   * Sink that keeps the last frames in memory
+   */
+  class RingSink : public ProfilerSink
+  {
+
+  public:
+
+    /**
+     * Default constructor
+     * @param capacity_ maximum number of frames kept
+     */
+    NLRENDER_API
+    RingSink( unsigned int capacity_ = 128 );
+
+    NLRENDER_API
+    virtual void write( const TFrameStats& frame_ );
+
+    /**
+     * Method that returns the frames kept, from the oldest to the newest
+     * @return the frames kept
+     */
+    NLRENDER_API
+    const std::deque< TFrameStats >& frames( void ) const;
+
+    /**
+     * Method that removes all the frames kept
+     */
+    NLRENDER_API
+    void clear( void );
+
+  protected:
+
+    //! Maximum number of frames kept
+    unsigned int _capacity;
+
+    //! Frames kept
+    std::deque< TFrameStats > _frames;
+
+  }; // class RingSink
+
+  /* \class JsonSink
+   * Sink that writes each frame as a JSON object in its own line
+   */
+  class JsonSink : public ProfilerSink
+  {
+
+  public:
+
+    /**
+     * Default constructor
+     * @param stream_ stream where the frames are written
+     */
+    NLRENDER_API
+    JsonSink( std::ostream& stream_ );
+
+    NLRENDER_API
+    virtual void write( const TFrameStats& frame_ );
+
+  protected:
+
+    //! Stream where the frames are written
+    std::ostream& _stream;
+
+  }; // class JsonSink
+
+  /* \class Profiler
+   * Per frame measures of named passes: cpu and gpu time, draw calls,
+   * uniform uploads, subroutine switches and primitives generated. The gpu
+   * results arrive some frames later, so each frame is written to the sinks
+   * once all its queries are available
+   */
+  class Profiler
+  {
+
+  public:
+
+    /**
+     * Default constructor
+     * @param backend_ backend owned by the profiler, or null to only measure
+     * the cpu time
+     */
+    NLRENDER_API
+    Profiler( ProfilerBackend* backend_ = nullptr );
+
+    /**
+     * Default destructor, writes the pending frames
+     */
+    NLRENDER_API
+    ~Profiler( void );
+
+    /**
+     * Method that adds a sink. The sink is not owned by the profiler
+     * @param sink_ sink to add
+     */
+    NLRENDER_API
+    void addSink( ProfilerSink* sink_ );
+
+    /**
+     * Method that begins a frame. Passes outside a frame begin one implicitly
+     */
+    NLRENDER_API
+    void beginFrame( void );
+
+    /**
+     * Method that ends the current frame and writes the frames which
+     * measures are available
+     */
+    NLRENDER_API
+    void endFrame( void );
+
+    /**
+     * Method that begins a pass. Passes begun inside another pass are
+     * counted as part of the outer one
+     * @param name_ name of the pass
+     * @param primitivesQuery_ false if the pass uses its own primitives
+     * query, so it reports the primitives with primitives( )
+     */
+    NLRENDER_API
+    void beginPass( const std::string& name_, bool primitivesQuery_ = true );
+
+    /**
+     * Method that ends the current pass
+     */
+    NLRENDER_API
+    void endPass( void );
+
+    /**
+     * Methods that count the work of the current pass. They are ignored
+     * outside a pass
+     */
+    NLRENDER_API
+    void drawCalls( unsigned int count_ = 1 );
+
+    NLRENDER_API
+    void uniformUploads( unsigned int count_ = 1 );
+
+    NLRENDER_API
+    void subroutineSwitches( unsigned int count_ = 1 );
+
+    NLRENDER_API
+    void primitives( uint64_t count_ );
+
+    /**
+     * Method that waits for the pending queries and writes all the ended
+     * frames
+     */
+    NLRENDER_API
+    void flush( void );
+
+    /**
+     * Method that returns the number of ended frames not written yet
+     * @return the number of pending frames
+     */
+    NLRENDER_API
+    unsigned int pendingFrames( void ) const;
+
+    /**
+     * Method that returns the number of the current or next frame
+     * @return the frame number
+     */
+    NLRENDER_API
+    unsigned int frame( void ) const;
+
+  protected:
+
+    typedef struct
+    {
+      TFrameStats stats;
+      //! Timer and primitives queries of each pass, zero if not issued
+      std::vector< unsigned int > timers;
+      std::vector< unsigned int > primitives;
+    } TPendingFrame;
+
+    void _write( bool wait_ );
+
+    //! Backend of the clock and the queries
+    ProfilerBackend* _backend;
+
+    //! Sinks of the frames
+    std::vector< ProfilerSink* > _sinks;
+
+    //! Variable to determine if a frame is begun
+    bool _inFrame;
+
+    //! Depth of nested passes
+    unsigned int _depth;
+
+    //! Start time of the current pass
+    double _passStart;
+
+    //! Current frame number
+    unsigned int _frame;
+
+    //! Frame being recorded
+    TPendingFrame _current;
+
+    //! Ended frames waiting for their queries
+    std::deque< TPendingFrame > _pending;
+
+  }; // class Profiler
+
+  /* \class ProfilerPass
+   * Scoped pass of a profiler, which may be null
+   */
+  class ProfilerPass
+  {
+
+  public:
+
+    NLRENDER_API
+    ProfilerPass( Profiler* profiler_, const std::string& name_,
+                  bool primitivesQuery_ = true );
+
+    NLRENDER_API
+    ~ProfilerPass( void );
+
+  protected:
+
+    //! Profiler of the pass or null
+    Profiler* _profiler;
+
+  }; // class ProfilerPass
+
+} // namespace nlrender
+
+#endif
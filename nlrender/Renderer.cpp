@@ -23,6 +23,7 @@
 
 #include "Shaders.h"
 
+#include "../nlgeometry/MeshOptimizer.h"
 #include "../nlgeometry/SpatialHashTable.h"
 
 #ifndef NEUROLOTS_SKIP_GLEW_INCLUDE
@@ -36,7 +37,8 @@
 #include <GL/glu.h>
 #endif
 
-#define UNUSED(x) (void)(x)
+#include <algorithm>
+#include <cmath>
 
 namespace nlrender
 {
@@ -47,15 +49,28 @@ namespace nlrender
         , _tng( 0.2f )
         , _maximumDistance( 100.0f )
         , _alpha( 0.5f )
+        , _edgePixels( 8.0f )
         , _tessCriteria( HOMOGENEOUS )
         , _colorFunc( GLOBAL )
         , _transparencyStatus( DISABLE )
+        , _frustumCulling( true )
+        , _hierarchy( nullptr )
+        , _profiler( nullptr )
+        , _nodeColorStream( nullptr )
+        , _nextExtraction( 1 )
+        , _feedbackBufferLimit( size_t( 256 ) << 20 )
+        , _singlePassExtraction( true )
+        , _optimizeExtraction( false )
         , _transSystemInit( false )
         , _transSystemWidth( 0 )
         , _transSystemHeight( 0 )
     {
         _viewMatrix = Eigen::Matrix4f::Identity( );
         _projectionMatrix = Eigen::Matrix4f::Identity( );
+        int viewport[4] = { 0, 0, 0, 0 };
+        glGetIntegerv( GL_VIEWPORT, viewport );
+        _viewportWidth = ( unsigned int )viewport[2];
+        _viewportHeight = ( unsigned int )viewport[3];
         _programLines = new reto::ShaderProgram( );
         _programQuads = new reto::ShaderProgram( );
         _programQuadsFB = new reto::ShaderProgram( );
@@ -154,6 +169,8 @@ namespace nlrender
                 GL_VERTEX_SHADER, "linear" );
         _tHomogeDistInd = glGetSubroutineIndex( _programTriangles->program( ),
                 GL_VERTEX_SHADER, "homogeneous" );
+        _tScreenDistInd = glGetSubroutineIndex( _programTriangles->program( ),
+                GL_VERTEX_SHADER, "screenSpace" );
         _tGlobalColorInd = glGetSubroutineIndex( _programTriangles->program( ),
                 GL_FRAGMENT_SHADER, "globalColor" );
         _tVertexColorInd = glGetSubroutineIndex( _programTriangles->program( ),
@@ -167,11 +184,15 @@ namespace nlrender
                 GL_VERTEX_SHADER, "linear" );
         _tFBHomogeDistInd = glGetSubroutineIndex( _programTrianglesFB->program( ),
                 GL_VERTEX_SHADER, "homogeneous" );
+        _tFBScreenDistInd = glGetSubroutineIndex( _programTrianglesFB->program( ),
+                GL_VERTEX_SHADER, "screenSpace" );
 
         _qLinearDistInd = glGetSubroutineIndex( _programQuads->program( ),
                 GL_VERTEX_SHADER, "linear" );
         _qHomogeDistInd = glGetSubroutineIndex( _programQuads->program( ),
                 GL_VERTEX_SHADER, "homogeneous" );
+        _qScreenDistInd = glGetSubroutineIndex( _programQuads->program( ),
+                GL_VERTEX_SHADER, "screenSpace" );
         _qGlobalColorInd = glGetSubroutineIndex( _programQuads->program( ),
                 GL_FRAGMENT_SHADER, "globalColor" );
         _qVertexColorInd = glGetSubroutineIndex( _programQuads->program( ),
@@ -185,6 +206,8 @@ namespace nlrender
                 GL_VERTEX_SHADER, "linear" );
         _qFBHomogeDistInd = glGetSubroutineIndex( _programQuadsFB->program( ),
                 GL_VERTEX_SHADER, "homogeneous" );
+        _qFBScreenDistInd = glGetSubroutineIndex( _programQuadsFB->program( ),
+                GL_VERTEX_SHADER, "screenSpace" );
 
         _tVertexSubroutines.resize( 1 );
         _qVertexSubroutines.resize( 1 );
@@ -197,6 +220,28 @@ namespace nlrender
         _composeVertexSubroutines( );
         _composeFragmentSubroutines( );
 
+        reto::ShaderProgram* instancedPrograms[ ] = { _programLines,
+          _programTriangles, _programQuads, _programTrianglesFB,
+          _programQuadsFB };
+        for ( auto program: instancedPrograms )
+        {
+            program->use( );
+            glUniform1i( glGetUniformLocation( program->program( ),
+                                               "instanceData" ), 0 );
+            glUniform1i( glGetUniformLocation( program->program( ),
+                                               "nodeColorData" ),
+                         NodeColorBuffer::TEXTURE_UNIT );
+        }
+        _instances = new InstanceBuffer( );
+        _nodeColors = new NodeColorBuffer( );
+        _culler = new FrustumCuller( );
+
+        // Uniform locations are queried once, the programs are not relinked
+        _state = new StateCache( );
+        for ( auto program: instancedPrograms )
+            _state->addProgram( program->program( ),
+              StateCache::queryLocations( program->program( )));
+
         _tbos.resize( 2 );
         glGenBuffers( 2, _tbos.data( ));
 
@@ -207,6 +252,8 @@ namespace nlrender
         glBindBufferBase( GL_TRANSFORM_FEEDBACK_BUFFER, 1, _tbos[1] );
 
         glBindTransformFeedback( GL_TRANSFORM_FEEDBACK, 0 );
+
+        glGenTransformFeedbacks( 1, &_asyncTfo );
     }
 
     Renderer::~Renderer( void )
@@ -216,11 +263,37 @@ namespace nlrender
         delete _programQuads;
         delete _programTrianglesFB;
         delete _programQuadsFB;
+        delete _instances;
+        delete _nodeColors;
+        delete _culler;
+        delete _state;
 
         if ( _tfo != GL_INVALID_VALUE )
-          glDeleteVertexArrays( 1, &_tfo );
+          glDeleteTransformFeedbacks( 1, &_tfo );
         if ( _tbos.size( ) > 0 )
           glDeleteBuffers( static_cast<GLsizei>(_tbos.size( )), _tbos.data( ));
+
+        for ( auto& extraction: _extractions )
+        {
+            TExtraction& pending = extraction.second;
+            for ( unsigned int i = 0; i < 2; i++ )
+            {
+                if ( pending.countQueries[i] != 0 )
+                    glDeleteQueries( 1, &pending.countQueries[i] );
+                if ( pending.writtenQueries[i] != 0 )
+                    glDeleteQueries( 1, &pending.writtenQueries[i] );
+                if ( pending.generatedQueries[i] != 0 )
+                    glDeleteQueries( 1, &pending.generatedQueries[i] );
+            }
+            if ( pending.fence )
+                glDeleteSync( static_cast< GLsync >( pending.fence ));
+            if ( pending.buffer.capacity > 0 )
+                _feedbackBuffers.push_back( pending.buffer );
+            delete pending.result;
+        }
+        for ( auto& buffer: _feedbackBuffers )
+            glDeleteBuffers( 2, buffer.buffers );
+        glDeleteTransformFeedbacks( 1, &_asyncTfo );
     }
 
     Eigen::Matrix4f& Renderer::viewMatrix( void )
@@ -253,6 +326,41 @@ namespace nlrender
         return _alpha;
     }
 
+    float& Renderer::edgePixels( void )
+    {
+        return _edgePixels;
+    }
+
+    void Renderer::viewport( unsigned int width_, unsigned int height_ )
+    {
+        _viewportWidth = width_;
+        _viewportHeight = height_;
+    }
+
+    float Renderer::meshLod( nlgeometry::MeshPtr mesh_,
+                             const Eigen::Matrix4f& modelMatrix_ ) const
+    {
+        return _screenSpaceLod( mesh_->aaBoundingBox( ), modelMatrix_ );
+    }
+
+    float Renderer::screenSpaceLod(
+        const nlgeometry::AxisAlignedBoundingBox& bounds_,
+        const Eigen::Matrix4f& view_, const Eigen::Matrix4f& projection_,
+        float viewportHeight_, float edgePixels_ )
+    {
+        Eigen::Vector4f center = view_ * bounds_.center( ).homogeneous( );
+        float radius = bounds_.radius( );
+
+        // Clip w of the sphere point nearest to the camera, clamped so the
+        // level stays finite when the camera is inside the sphere
+        float w = projection_.row( 3 ).dot( center ) -
+            radius * std::abs( projection_( 3, 2 ));
+        w = std::max( w, 1e-3f );
+
+        float pixelsPerUnit = projection_( 1, 1 ) * 0.5f * viewportHeight_ / w;
+        return pixelsPerUnit / std::max( edgePixels_, 1e-3f );
+    }
+
     Renderer::TTessCriteria Renderer::tessCriteria( void )
     {
         return _tessCriteria;
@@ -280,6 +388,52 @@ namespace nlrender
         return _transparencyStatus;
     }
 
+    bool& Renderer::frustumCulling( void )
+    {
+        return _frustumCulling;
+    }
+
+    unsigned int Renderer::culledMeshes( void ) const
+    {
+        return _culler->culled( );
+    }
+
+    void Renderer::boundingVolumeHierarchy(
+        const nlgeometry::BoundingVolumeHierarchy* hierarchy_ )
+    {
+        _hierarchy = hierarchy_;
+    }
+
+    void Renderer::profiler( Profiler* profiler_ )
+    {
+        _profiler = profiler_;
+    }
+
+    Profiler* Renderer::profiler( void ) const
+    {
+        return _profiler;
+    }
+
+    NodeColorBuffer* Renderer::nodeColors( void ) const
+    {
+        return _nodeColors;
+    }
+
+    void Renderer::nodeColorStream( NodeColorStream* stream_ )
+    {
+        _nodeColorStream = stream_;
+    }
+
+    NodeColorStream* Renderer::nodeColorStream( void ) const
+    {
+        return _nodeColorStream;
+    }
+
+    unsigned int Renderer::elidedStateCalls( void ) const
+    {
+        return _state->elided( );
+    }
+
     void Renderer::render( nlgeometry::MeshPtr mesh_,
             const Eigen::Matrix4f& modelMatrix_,
             const Eigen::Vector3f& color_,
@@ -287,55 +441,39 @@ namespace nlrender
             bool renderTriangles_,
             bool renderQuads_ ) const
     {
+        ProfilerPass pass( _profiler, "render" );
+        _state->invalidate( );
         if ( _keepOpenGLServerStack )
           glPushAttrib( GL_ALL_ATTRIB_BITS );
 
-        const Eigen::Matrix4f viewModel = _viewMatrix * modelMatrix_;
+        _instances->resize( 1 );
+        _instances->set( 0, modelMatrix_, color_ );
+        if ( _tessCriteria == SCREEN_SPACE )
+            _instances->lod( 0, meshLod( mesh_, modelMatrix_ ));
+        _instances->upload( );
+        _instances->bind( );
+        glVertexAttribI1ui( InstanceBuffer::ATTRIB_LOCATION, 0 );
+        _bindNodeColors( );
 
         if ( renderLines_ )
         {
-            _programLines->use( );
-            _programLines->sendUniform4m( "proy", _projectionMatrix.data( ));
-            _programLines->sendUniform4m( "viewModel", viewModel.data( ));
-            _programLines->sendUniform3v( "color", color_.data( ));
-            _programLines->sendUniformf( "alpha", _alpha );
-            glUniformSubroutinesuiv( GL_FRAGMENT_SHADER, 2,
-                  _lFragmentSubroutines.data( ));
+            _useLinesProgram( );
             mesh_->renderLines( );
+            _countDraws( 1 );
         }
 
         if( renderTriangles_ )
         {
-            _programTriangles->use( );
-            _programTriangles->sendUniform4m( "proy", _projectionMatrix.data( ));
-            _programTriangles->sendUniform4m( "viewModel", viewModel.data( ));
-            _programTriangles->sendUniform3v( "color", color_.data( ));
-            _programTriangles->sendUniformf( "lod", _lod );
-            _programTriangles->sendUniformf( "maxDist", _maximumDistance );
-            _programTriangles->sendUniformf( "tng", _tng );
-            _programTriangles->sendUniformf( "alpha", _alpha );
-            glUniformSubroutinesuiv( GL_VERTEX_SHADER, 1,
-                  _tVertexSubroutines.data( ));
-            glUniformSubroutinesuiv( GL_FRAGMENT_SHADER, 2,
-                  _tFragmentSubroutines.data( ));
+            _useTrianglesProgram( );
             mesh_->renderTriangles( );
+            _countDraws( 1 );
         }
 
         if ( renderQuads_ )
         {
-            _programQuads->use( );
-            _programQuads->sendUniform4m( "proy", _projectionMatrix.data( ));
-            _programQuads->sendUniform4m( "viewModel", viewModel.data( ));
-            _programQuads->sendUniform3v( "color", color_.data( ));
-            _programQuads->sendUniformf( "lod", _lod);
-            _programQuads->sendUniformf( "maxDist", _maximumDistance);
-            _programQuads->sendUniformf( "tng", _tng);
-            _programQuads->sendUniformf( "alpha", _alpha );
-            glUniformSubroutinesuiv( GL_VERTEX_SHADER, 1,
-                  _qVertexSubroutines.data( ) );
-            glUniformSubroutinesuiv( GL_FRAGMENT_SHADER, 2,
-                  _qFragmentSubroutines.data( ));
+            _useQuadsProgram( );
             mesh_->renderQuads( );
+            _countDraws( 1 );
         }
 
         if ( _keepOpenGLServerStack )
@@ -352,65 +490,13 @@ namespace nlrender
         if ( meshes_.size( ) != modelMatrices_.size( ))
             throw std::runtime_error( "Meshes and model matrices have different sizes" );
 
-        if ( _keepOpenGLServerStack )
-            glPushAttrib( GL_ALL_ATTRIB_BITS );
-
-        if ( renderLines_ )
-        {
-            _programLines->use( );
-            _programLines->sendUniform4m( "proy", _projectionMatrix.data( ));
-            _programLines->sendUniform3v( "color", color_.data( ));
-            _programLines->sendUniformf( "alpha", _alpha );
-            for ( size_t i = 0; i < meshes_.size( ); i++ )
-            {
-              const Eigen::Matrix4f viewModel = _viewMatrix * modelMatrices_[i];
-              _programLines->sendUniform4m( "viewModel", viewModel.data( ));
-              glUniformSubroutinesuiv( GL_FRAGMENT_SHADER, 2, _lFragmentSubroutines.data( ));
-              meshes_[i]->renderLines( );
-            }
-        }
-
-        if( renderTriangles_ )
-        {
-            _programTriangles->use( );
-            _programTriangles->sendUniform4m( "proy", _projectionMatrix.data( ));
-            _programTriangles->sendUniform3v( "color", color_.data( ));
-            _programTriangles->sendUniformf( "lod", _lod );
-            _programTriangles->sendUniformf( "maxDist", _maximumDistance );
-            _programTriangles->sendUniformf( "tng", _tng );
-            _programTriangles->sendUniformf( "alpha", _alpha );
-            for ( size_t i = 0; i < meshes_.size( ); i++ )
-            {
-              const Eigen::Matrix4f viewModel = _viewMatrix * modelMatrices_[i];
-              _programTriangles->sendUniform4m( "viewModel", viewModel.data( ));
-              glUniformSubroutinesuiv( GL_VERTEX_SHADER, 1, _tVertexSubroutines.data( ));
-              glUniformSubroutinesuiv( GL_FRAGMENT_SHADER, 2, _tFragmentSubroutines.data( ));
-              meshes_[i]->renderTriangles( );
-            }
-        }
-
-        if ( renderQuads_ )
-        {
-            _programQuads->use( );
-            _programQuads->sendUniform4m( "proy", _projectionMatrix.data( ));
-            _programQuads->sendUniform3v( "color", color_.data( ));
-            _programQuads->sendUniformf( "lod", _lod);
-            _programQuads->sendUniformf( "maxDist", _maximumDistance);
-            _programQuads->sendUniformf( "tng", _tng);
-            _programQuads->sendUniformf( "alpha", _alpha );
+        ProfilerPass pass( _profiler, "render" );
+        _instances->resize(( unsigned int )meshes_.size( ));
+        for ( unsigned int i = 0; i < meshes_.size( ); i++ )
+            _instances->set( i, modelMatrices_[i], color_ );
 
-            for ( size_t i = 0; i < meshes_.size( ); i++ )
-            {
-              const Eigen::Matrix4f viewModel = _viewMatrix * modelMatrices_[i];
-              _programQuads->sendUniform4m( "viewModel", viewModel.data( ));
-              glUniformSubroutinesuiv( GL_VERTEX_SHADER, 1, _qVertexSubroutines.data( ));
-              glUniformSubroutinesuiv( GL_FRAGMENT_SHADER, 2, _qFragmentSubroutines.data( ));
-              meshes_[i]->renderQuads( );
-            }
-        }
-
-        if ( _keepOpenGLServerStack )
-            glPopAttrib( );
+        _renderInstances( meshes_, modelMatrices_, renderLines_,
+                          renderTriangles_, renderQuads_ );
     }
 
 
@@ -422,73 +508,89 @@ namespace nlrender
             bool renderTriangles_,
             bool renderQuads_ ) const
     {
-      // TODO: @felix 2023-06-28 Manage colors_ != baseColors...
-      // @felix 2023-10-05 Pending a working method for spike
-      // representations.
-      UNUSED(colors_);
-
         if ( meshes_.size( ) != modelMatrices_.size( ) ||
             modelMatrices_.size( ) != baseColors.size( ))
             throw std::runtime_error(
                     "Meshes, model matrices and colors have different sizes" );
+        if ( !colors_.empty( ) && colors_.size( ) != baseColors.size( ))
+            throw std::runtime_error(
+                    "Base colors and colors have different sizes" );
+
+        ProfilerPass pass( _profiler, "render" );
+        // Dynamic colors, such as spike representations, fully replace the
+        // base colors. An empty vector renders the base colors
+        _instances->resize(( unsigned int )meshes_.size( ));
+        for ( unsigned int i = 0; i < meshes_.size( ); i++ )
+        {
+            Eigen::Vector4f color( 0.0f, 0.0f, 0.0f, 0.0f );
+            if ( !colors_.empty( ))
+              color << colors_[i], 1.0f;
+            _instances->set( i, modelMatrices_[i], baseColors[i], color );
+        }
+
+        _renderInstances( meshes_, modelMatrices_, renderLines_,
+                          renderTriangles_, renderQuads_ );
+    }
+
+    void Renderer::render( MeshPool* pool_,
+            const Eigen::Matrix4f& modelMatrix_,
+            const Eigen::Vector3f& color_,
+            bool renderLines_,
+            bool renderTriangles_,
+            bool renderQuads_ ) const
+    {
+        _instances->resize(( unsigned int )pool_->entries( ).size( ));
+        for ( unsigned int i = 0; i < _instances->size( ); i++ )
+            _instances->set( i, modelMatrix_, color_ );
+
+        render( pool_, _instances, renderLines_, renderTriangles_,
+                renderQuads_ );
+    }
+
+    void Renderer::render( MeshPool* pool_,
+            InstanceBuffer* instances_,
+            bool renderLines_,
+            bool renderTriangles_,
+            bool renderQuads_ ) const
+    {
+        if ( instances_->size( ) < pool_->entries( ).size( ))
+            throw std::runtime_error(
+                    "Instance buffer smaller than the mesh pool" );
+
+        ProfilerPass pass( _profiler, "render" );
+        if ( _tessCriteria == SCREEN_SPACE )
+        {
+            const MeshPool::MeshEntries& entries = pool_->entries( );
+            for ( unsigned int i = 0; i < entries.size( ); i++ )
+                if ( entries[i].valid )
+                    instances_->lod( i, _screenSpaceLod(
+                        entries[i].bounds, instances_->model( i )));
+        }
 
         if ( _keepOpenGLServerStack )
-            glPushAttrib( GL_ALL_ATTRIB_BITS );
+          glPushAttrib( GL_ALL_ATTRIB_BITS );
+
+        _state->invalidate( );
+        instances_->upload( );
+        instances_->bind( );
+        _bindNodeColors( );
+
+        if ( renderLines_ )
+        {
+            _useLinesProgram( );
+            _countDraws( pool_->draw( MeshPool::LINES ));
+        }
+
+        if( renderTriangles_ )
+        {
+            _useTrianglesProgram( );
+            _countDraws( pool_->draw( MeshPool::TRIANGLES ));
+        }
 
-        _programLines->use( );
-        _programLines->sendUniform4m( "proy", _projectionMatrix.data( ));
-        for (size_t i = 0; i < meshes_.size(); i++)
-        {
-          if( !renderLines_ ) continue;
-          // else if( colors_[i] == baseColors[i] ) continue;
-
-          const Eigen::Matrix4f viewModel = _viewMatrix * modelMatrices_[i];
-          _programLines->sendUniform4m("viewModel", viewModel.data());
-          _programLines->sendUniform3v("color", baseColors[i].data());
-          _programLines->sendUniformf("alpha", _alpha);
-          glUniformSubroutinesuiv( GL_FRAGMENT_SHADER, 2,
-              _lFragmentSubroutines.data());
-          meshes_[i]->renderLines();
-        }
-
-        _programTriangles->use();
-        _programTriangles->sendUniform4m("proy", _projectionMatrix.data());
-        _programTriangles->sendUniformf("lod", _lod);
-        _programTriangles->sendUniformf("maxDist", _maximumDistance);
-        _programTriangles->sendUniformf("tng", _tng);
-        _programTriangles->sendUniformf("alpha", _alpha);
-        for (size_t i = 0; i < meshes_.size(); i++)
-        {
-          if (!renderTriangles_ ) continue;
-          // else if( colors_[i] == baseColors[i] ) continue;
-
-          const Eigen::Matrix4f viewModel = _viewMatrix * modelMatrices_[i];
-          _programTriangles->sendUniform4m("viewModel", viewModel.data());
-          _programTriangles->sendUniform3v("color", baseColors[i].data());
-          glUniformSubroutinesuiv( GL_VERTEX_SHADER, 1, _tVertexSubroutines.data());
-          glUniformSubroutinesuiv( GL_FRAGMENT_SHADER, 2,
-              _tFragmentSubroutines.data());
-          meshes_[i]->renderTriangles();
-        }
-
-        _programQuads->use();
-        _programQuads->sendUniform4m("proy", _projectionMatrix.data());
-        _programQuads->sendUniformf("lod", _lod);
-        _programQuads->sendUniformf("maxDist", _maximumDistance);
-        _programQuads->sendUniformf("tng", _tng);
-        _programQuads->sendUniformf("alpha", _alpha);
-        for (size_t i = 0; i < meshes_.size(); i++)
-        {
-          if (!renderQuads_ ) continue;
-          // else if( colors_[i] == baseColors[i] ) continue;
-
-          const Eigen::Matrix4f viewModel = _viewMatrix * modelMatrices_[i];
-          _programQuads->sendUniform4m("viewModel", viewModel.data());
-          _programQuads->sendUniform3v("color", baseColors[i].data());
-          glUniformSubroutinesuiv( GL_VERTEX_SHADER, 1, _qVertexSubroutines.data());
-          glUniformSubroutinesuiv( GL_FRAGMENT_SHADER, 2,
-              _qFragmentSubroutines.data());
-          meshes_[i]->renderQuads();
+        if ( renderQuads_ )
+        {
+            _useQuadsProgram( );
+            _countDraws( pool_->draw( MeshPool::QUADS ));
         }
 
         if ( _keepOpenGLServerStack )
@@ -499,143 +601,236 @@ namespace nlrender
             const Eigen::Matrix4f& modelMatrix_,
             bool extractTriangles_, bool extractQuads_ ) const
     {
+        // The extraction uses its own primitives queries and reports them
+        ProfilerPass pass( _profiler, "extract", false );
+        _state->invalidate( );
         if ( _keepOpenGLServerStack )
             glPushAttrib( GL_ALL_ATTRIB_BITS );
 
         Eigen::Matrix4f viewModel = ( _viewMatrix * modelMatrix_ ).transpose( );
+        float lod = _extractionLod( mesh_, modelMatrix_ );
+        _bindExtractionInstance( lod );
         Eigen::Matrix4f projection = _projectionMatrix.transpose( );
 
         glDisable( GL_CULL_FACE );
         glEnable( GL_RASTERIZER_DISCARD );
 
-        unsigned int query = 0;
-        unsigned int numPrimitives = 0;
-        unsigned int trianglesSize = 0;
-        unsigned int quadsSize = 0;
-
         std::vector< float > _extractedVertices;
         std::vector< float > _extractedNormals;
 
-        glGenQueries( 1, &query );
-
         if( extractTriangles_ )
-        {
-            glBeginQuery( GL_PRIMITIVES_GENERATED, query );
-            _programTrianglesFB->use( );
-            _programTrianglesFB->sendUniform4m( "proy", projection.data( ));
-            _programTrianglesFB->sendUniform4m( "viewModel", viewModel.data( ));
-            _programTrianglesFB->sendUniformf( "lod", _lod );
-            _programTrianglesFB->sendUniformf( "maxDist", _maximumDistance );
-            _programTrianglesFB->sendUniformf( "tng", _tng );
-            glUniformSubroutinesuiv( GL_VERTEX_SHADER, 1,
-                  _tFBVertexSubroutines.data( ) );
-            mesh_->renderTriangles( );
+            _extractFeedback( mesh_, false, 0, mesh_->trianglesSize( ) / 3,
+                              _primitivesBound( mesh_, modelMatrix_, lod, false ),
+                              projection, viewModel,
+                              _extractedVertices, _extractedNormals );
+        if ( extractQuads_ )
+            _extractFeedback( mesh_, true, 0, mesh_->quadsSize( ) / 4,
+                              _primitivesBound( mesh_, modelMatrix_, lod, true ),
+                              projection, viewModel,
+                              _extractedVertices, _extractedNormals );
+        glDisable( GL_RASTERIZER_DISCARD );
 
-            glEndQuery( GL_PRIMITIVES_GENERATED );
-            glGetQueryObjectuiv( query, GL_QUERY_RESULT, &numPrimitives );
-            trianglesSize = numPrimitives * 9;
-            if ( trianglesSize > 0 )
-            {
-                glBindBuffer( GL_ARRAY_BUFFER, _tbos[0] );
-                glBufferData( GL_ARRAY_BUFFER, sizeof( float ) * trianglesSize, nullptr,
-                              GL_STATIC_READ );
-                glBindBuffer( GL_ARRAY_BUFFER, _tbos[1] );
-                glBufferData( GL_ARRAY_BUFFER, sizeof( float ) * trianglesSize, nullptr,
-                              GL_STATIC_READ );
-
-                glBeginQuery( GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, query );
-                glBindTransformFeedback( GL_TRANSFORM_FEEDBACK, _tfo );
-                glBeginTransformFeedback( GL_TRIANGLES );
+        auto mesh = _vectorToMesh( _extractedVertices, _extractedNormals );
+        // Transform feedback emits triangles in tessellation order, reorder them
+        // so the extracted mesh is cache friendly when rendered or exported
+        if ( _optimizeExtraction )
+            nlgeometry::MeshOptimizer::optimize( mesh );
 
-                glUniformSubroutinesuiv( GL_VERTEX_SHADER, 1,
-                        _tFBVertexSubroutines.data( ) );
-                mesh_->renderTriangles( );
+        if ( _keepOpenGLServerStack )
+          glPopAttrib( );
 
-                glEndTransformFeedback( );
-                glFlush( );
+        return mesh;
+    }
 
-                glEndQuery( GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN );
-                glGetQueryObjectuiv( query, GL_QUERY_RESULT, &numPrimitives );
-                trianglesSize = numPrimitives * 9;
+    unsigned int Renderer::extractChunks( nlgeometry::MeshPtr mesh_,
+            ExtractionSink* sink_, const Eigen::Matrix4f& modelMatrix_,
+            bool extractTriangles_, bool extractQuads_, size_t chunkBytes_ ) const
+    {
+        ProfilerPass pass( _profiler, "extractChunks", false );
+        _state->invalidate( );
+        if ( _keepOpenGLServerStack )
+            glPushAttrib( GL_ALL_ATTRIB_BITS );
 
-                glBindVertexArray( 0 );
-                glBindTransformFeedback( GL_TRANSFORM_FEEDBACK, 0 );
-                _extractedVertices.resize( trianglesSize );
-                _extractedNormals.resize( trianglesSize );
-
-                glBindBuffer( GL_ARRAY_BUFFER, _tbos[0] );
-                glGetBufferSubData( GL_ARRAY_BUFFER, 0, sizeof( float ) * trianglesSize,
-                                    _extractedVertices.data( ));
-                glBindBuffer( GL_ARRAY_BUFFER, _tbos[1] );
-                glGetBufferSubData( GL_ARRAY_BUFFER, 0, sizeof( float ) * trianglesSize,
-                                    _extractedNormals.data( ));
-            }
-        }
-        if ( extractQuads_ )
-        {
-            glBeginQuery( GL_PRIMITIVES_GENERATED, query );
-            _programQuadsFB->use( );
-            _programQuadsFB->sendUniform4m( "proy", projection.data() );
-            _programQuadsFB->sendUniform4m( "viewModel", viewModel.data( ));
-            _programQuadsFB->sendUniformf( "lod", _lod);
-            _programQuadsFB->sendUniformf( "maxDist", _maximumDistance);
-            _programQuadsFB->sendUniformf( "tng", _tng);
+        Eigen::Matrix4f viewModel = ( _viewMatrix * modelMatrix_ ).transpose( );
+        float lod = _extractionLod( mesh_, modelMatrix_ );
+        _bindExtractionInstance( lod );
+        Eigen::Matrix4f projection = _projectionMatrix.transpose( );
+        size_t chunkBytes = chunkBytes_ > 0 ? chunkBytes_ : _feedbackBufferLimit;
 
-            glUniformSubroutinesuiv( GL_VERTEX_SHADER, 1,
-                  _qFBVertexSubroutines.data( ) );
-            mesh_->renderQuads( );
+        glDisable( GL_CULL_FACE );
 
-            glEndQuery( GL_PRIMITIVES_GENERATED );
-            glGetQueryObjectuiv( query, GL_QUERY_RESULT, &numPrimitives );
-            quadsSize = numPrimitives * 9;
-            if ( quadsSize > 0 )
+        unsigned int chunks = 0;
+        bool extract[2] = { extractTriangles_, extractQuads_ };
+        for ( unsigned int i = 0; i < 2; i++ )
+        {
+            bool quads = i == 1;
+            unsigned int patches = quads ? mesh_->quadsSize( ) / 4 :
+                mesh_->trianglesSize( ) / 3;
+            if ( !extract[i] || patches == 0 )
+                continue;
+
+            size_t perPatch =
+                _primitivesBound( mesh_, modelMatrix_, lod, quads ) / patches;
+            size_t chunkPatches = std::max( size_t( 1 ),
+                chunkBytes / ( perPatch * 9 * sizeof( float )));
+
+            for ( unsigned int first = 0; first < patches;
+                  first += ( unsigned int ) chunkPatches )
             {
-                glBindBuffer( GL_ARRAY_BUFFER, _tbos[0] );
-                glBufferData( GL_ARRAY_BUFFER, sizeof( float ) * quadsSize, nullptr,
-                              GL_STATIC_READ );
-                glBindBuffer( GL_ARRAY_BUFFER, _tbos[1] );
-                glBufferData( GL_ARRAY_BUFFER, sizeof( float ) * quadsSize, nullptr,
-                              GL_STATIC_READ );
-
-                glBeginQuery( GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, query );
-                glBindTransformFeedback( GL_TRANSFORM_FEEDBACK, _tfo );
-                glBeginTransformFeedback( GL_TRIANGLES );
+                unsigned int count = ( unsigned int ) std::min(
+                    chunkPatches, size_t( patches - first ));
+                std::vector< float > vertices;
+                std::vector< float > normals;
+                glEnable( GL_RASTERIZER_DISCARD );
+                _extractFeedback( mesh_, quads, first, count, count * perPatch,
+                                  projection, viewModel, vertices, normals );
+                glDisable( GL_RASTERIZER_DISCARD );
+
+                auto chunk = _vectorToMesh( vertices, normals );
+                if ( _optimizeExtraction )
+                    nlgeometry::MeshOptimizer::optimize( chunk );
+                sink_->write( chunk );
+                delete chunk;
+                chunks++;
+            }
+        }
 
-                glUniformSubroutinesuiv( GL_VERTEX_SHADER, 1,
-                        _qFBVertexSubroutines.data( ) );
-                mesh_->renderQuads( );
+        if ( _keepOpenGLServerStack )
+          glPopAttrib( );
 
-                glEndTransformFeedback( );
-                glFlush( );
+        return chunks;
+    }
 
-                glEndQuery( GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN );
-                glGetQueryObjectuiv( query, GL_QUERY_RESULT, &numPrimitives );
-                quadsSize = numPrimitives * 9;
+    unsigned int Renderer::extractAsync( nlgeometry::MeshPtr mesh_,
+            const Eigen::Matrix4f& modelMatrix_,
+            bool extractTriangles_, bool extractQuads_ )
+    {
+        ProfilerPass pass( _profiler, "extractAsync", false );
+        _state->invalidate( );
+
+        TExtraction extraction;
+        extraction.mesh = mesh_;
+        extraction.viewModel = ( _viewMatrix * modelMatrix_ ).transpose( );
+        extraction.projection = _projectionMatrix.transpose( );
+        extraction.lod = _extractionLod( mesh_, modelMatrix_ );
+        extraction.extract[0] = extractTriangles_;
+        extraction.extract[1] = extractQuads_;
+        extraction.buffer.capacity = 0;
+        extraction.fence = nullptr;
+        extraction.result = nullptr;
+        extraction.ready = false;
+
+        size_t bound = 0;
+        for ( unsigned int i = 0; i < 2; i++ )
+        {
+            extraction.countQueries[i] = 0;
+            extraction.writtenQueries[i] = 0;
+            extraction.generatedQueries[i] = 0;
+            extraction.primitives[i] = extraction.extract[i] ?
+                _primitivesBound( mesh_, modelMatrix_, extraction.lod, i == 1 ) :
+                0;
+            bound += extraction.primitives[i];
+        }
 
-                glBindVertexArray( 0 );
-                glBindTransformFeedback( GL_TRANSFORM_FEEDBACK, 0 );
-                _extractedVertices.resize( quadsSize + trianglesSize );
-                _extractedNormals.resize( quadsSize + trianglesSize );
-
-                glBindBuffer( GL_ARRAY_BUFFER, _tbos[0] );
-                glGetBufferSubData( GL_ARRAY_BUFFER, 0, sizeof( float ) * quadsSize,
-                                    &_extractedVertices[trianglesSize]);
-                glBindBuffer( GL_ARRAY_BUFFER, _tbos[1] );
-                glGetBufferSubData( GL_ARRAY_BUFFER, 0, sizeof( float ) * quadsSize,
-                                    &_extractedNormals[trianglesSize]);
+        if ( _keepOpenGLServerStack )
+            glPushAttrib( GL_ALL_ATTRIB_BITS );
+
+        if ( bound * 9 * sizeof( float ) <= _feedbackBufferLimit )
+            _issueFeedback( extraction );
+        else
+        {
+            // Count the primitives without waiting for the result, the
+            // feedback draws are issued once it is available
+            _bindExtractionInstance( extraction.lod );
+            glDisable( GL_CULL_FACE );
+            glEnable( GL_RASTERIZER_DISCARD );
+            reto::ShaderProgram* programs[2] =
+                { _programTrianglesFB, _programQuadsFB };
+            const std::vector< unsigned int >* subroutines[2] =
+                { &_tFBVertexSubroutines, &_qFBVertexSubroutines };
+            for ( unsigned int i = 0; i < 2; i++ )
+            {
+                if ( !extraction.extract[i] )
+                    continue;
+                glGenQueries( 1, &extraction.countQueries[i] );
+                glBeginQuery( GL_PRIMITIVES_GENERATED,
+                              extraction.countQueries[i] );
+                _useFeedbackProgram( programs[i], extraction.projection,
+                                     extraction.viewModel, *subroutines[i] );
+                if ( i == 0 )
+                    mesh_->renderTriangles( );
+                else
+                    mesh_->renderQuads( );
+                _countDraws( 1 );
+                glEndQuery( GL_PRIMITIVES_GENERATED );
             }
+            glDisable( GL_RASTERIZER_DISCARD );
         }
-        glDisable( GL_RASTERIZER_DISCARD );
-        glDeleteQueries( 1, &query );
-
-        auto mesh = _vectorToMesh( _extractedVertices, _extractedNormals );
 
         if ( _keepOpenGLServerStack )
-          glPopAttrib( );
+            glPopAttrib( );
+
+        unsigned int id = _nextExtraction++;
+        _extractions[id] = extraction;
+        return id;
+    }
 
+    unsigned int Renderer::updateExtractions( void )
+    {
+        ProfilerPass pass( _profiler, "updateExtractions", false );
+        unsigned int pending = 0;
+        for ( auto& extraction: _extractions )
+            if ( !_advanceExtraction( extraction.second, false ))
+                pending++;
+        return pending;
+    }
+
+    bool Renderer::extractionReady( unsigned int extraction_ ) const
+    {
+        auto extraction = _extractions.find( extraction_ );
+        if ( extraction == _extractions.end( ))
+            throw std::runtime_error( "Unknown extraction" );
+        return extraction->second.ready;
+    }
+
+    nlgeometry::MeshPtr Renderer::extractionResult( unsigned int extraction_ )
+    {
+        auto extraction = _extractions.find( extraction_ );
+        if ( extraction == _extractions.end( ))
+            throw std::runtime_error( "Unknown extraction" );
+        _advanceExtraction( extraction->second, true );
+        nlgeometry::MeshPtr mesh = extraction->second.result;
+        _extractions.erase( extraction );
         return mesh;
     }
 
+    size_t& Renderer::feedbackBufferLimit( void )
+    {
+        return _feedbackBufferLimit;
+    }
+
+    bool& Renderer::singlePassExtraction( void )
+    {
+        return _singlePassExtraction;
+    }
+
+    bool& Renderer::optimizeExtraction( void )
+    {
+        return _optimizeExtraction;
+    }
+
+    unsigned int Renderer::maxPrimitivesPerPatch( float level_, bool quad_ )
+    {
+        // Equal spacing rounds the levels up. A uniform level n generates n^2
+        // triangles in a triangle and 2n^2 in a quad, and each outer edge
+        // adds at most its level to its ring
+        unsigned int level = ( unsigned int )std::ceil(
+            std::min( std::max( level_, 1.0f ), 64.0f ));
+        if ( quad_ )
+            return 2 * level * level + 4 * level;
+        return level * level + 3 * level;
+    }
+
     void Renderer::initTransparencySystem( unsigned int width_,
             unsigned int height_ )
     {
@@ -692,6 +887,7 @@ namespace nlrender
             Eigen::Vector3f backgroundColor_, unsigned int width_,
             unsigned int height_ )
     {
+        ProfilerPass pass( _profiler, "opaqueSetUp" );
         if ( _transSystemInit )
         {
             if ( _transSystemWidth != width_ || _transSystemHeight != height_ )
@@ -718,6 +914,7 @@ namespace nlrender
 
     void Renderer::setUpTransparentTransparencyScene( void )
     {
+        ProfilerPass pass( _profiler, "transparentSetUp" );
         if ( _transSystemInit )
         {
             _transparencyStatus = TTransparencyStatus::ENABLE;
@@ -742,6 +939,7 @@ namespace nlrender
 
     void Renderer::composeTransparencyScene( unsigned int finalFbo_ )
     {
+        ProfilerPass pass( _profiler, "compose" );
         glBindFramebuffer( GL_FRAMEBUFFER, finalFbo_ );
         glDisable( GL_DEPTH_TEST );
         glDisable( GL_BLEND );
@@ -753,11 +951,85 @@ namespace nlrender
         _accumTexture->bind( 1 );
         _revealageTexture->bind( 2 );
         glDrawElements( GL_TRIANGLES, 6, GL_UNSIGNED_INT, static_cast<void*>(0) );
+        _countDraws( 1 );
     }
 
 
 
 
+    void Renderer::_renderInstances( nlgeometry::Meshes& meshes_,
+            const std::vector< Eigen::Matrix4f >& modelMatrices_,
+            bool renderLines_,
+            bool renderTriangles_,
+            bool renderQuads_ ) const
+    {
+        // Indices of the meshes inside the camera frustum
+        std::vector< unsigned int > visible;
+        visible.reserve( meshes_.size( ));
+        _culler->update( _viewMatrix, _projectionMatrix );
+        if ( _frustumCulling && _hierarchy &&
+             _hierarchy->size( ) == meshes_.size( ))
+            _culler->visible( *_hierarchy, visible );
+        else
+            for ( unsigned int i = 0; i < meshes_.size( ); i++ )
+                if ( !_frustumCulling || _culler->visible( meshes_[i],
+                       meshes_[i]->aaBoundingBox( ), modelMatrices_[i] ))
+                    visible.push_back( i );
+        if ( visible.empty( ))
+            return;
+
+        if ( _tessCriteria == SCREEN_SPACE )
+            for ( auto i: visible )
+                _instances->lod( i, meshLod( meshes_[i], modelMatrices_[i] ));
+
+        if ( _keepOpenGLServerStack )
+            glPushAttrib( GL_ALL_ATTRIB_BITS );
+
+        // Other code may have used its programs since the last render
+        _state->invalidate( );
+
+        // One upload for all the meshes, each draw only selects its instance
+        _instances->upload( );
+        _instances->bind( );
+        _bindNodeColors( );
+
+        if ( renderLines_ )
+        {
+            _useLinesProgram( );
+            for ( auto i: visible )
+            {
+              glVertexAttribI1ui( InstanceBuffer::ATTRIB_LOCATION, i );
+              meshes_[i]->renderLines( );
+            }
+            _countDraws(( unsigned int )visible.size( ));
+        }
+
+        if( renderTriangles_ )
+        {
+            _useTrianglesProgram( );
+            for ( auto i: visible )
+            {
+              glVertexAttribI1ui( InstanceBuffer::ATTRIB_LOCATION, i );
+              meshes_[i]->renderTriangles( );
+            }
+            _countDraws(( unsigned int )visible.size( ));
+        }
+
+        if ( renderQuads_ )
+        {
+            _useQuadsProgram( );
+            for ( auto i: visible )
+            {
+              glVertexAttribI1ui( InstanceBuffer::ATTRIB_LOCATION, i );
+              meshes_[i]->renderQuads( );
+            }
+            _countDraws(( unsigned int )visible.size( ));
+        }
+
+        if ( _keepOpenGLServerStack )
+            glPopAttrib( );
+    }
+
     nlgeometry::MeshPtr Renderer::_vectorToMesh(
             std::vector< float > positions_,
             std::vector< float > normals_ ) const
@@ -830,6 +1102,502 @@ namespace nlrender
         glBindVertexArray( 0 );
     }
 
+    float Renderer::_screenSpaceLod(
+        const nlgeometry::AxisAlignedBoundingBox& bounds_,
+        const Eigen::Matrix4f& modelMatrix_ ) const
+    {
+        if ( !bounds_.isValid( ))
+            return _lod;
+        return screenSpaceLod( bounds_.transformed( modelMatrix_ ),
+                               _viewMatrix, _projectionMatrix,
+                               float( _viewportHeight ), _edgePixels );
+    }
+
+    float Renderer::_extractionLod( nlgeometry::MeshPtr mesh_,
+        const Eigen::Matrix4f& modelMatrix_ ) const
+    {
+        if ( _tessCriteria == SCREEN_SPACE )
+            return meshLod( mesh_, modelMatrix_ );
+        return _lod;
+    }
+
+    size_t Renderer::_primitivesBound( nlgeometry::MeshPtr mesh_,
+        const Eigen::Matrix4f& modelMatrix_, float lod_, bool quads_ ) const
+    {
+        // Tessellation level bound from the longest edge in view space, the
+        // linear criteria only lowers the level of detail
+        Eigen::Matrix3f linear =
+            ( _viewMatrix * modelMatrix_ ).topLeftCorner< 3, 3 >( );
+        float level = lod_ * mesh_->maxEdgeLength( ) * linear.norm( );
+        size_t patches = quads_ ? mesh_->quadsSize( ) / 4 :
+            mesh_->trianglesSize( ) / 3;
+        return patches * maxPrimitivesPerPatch( level, quads_ );
+    }
+
+    void Renderer::_extractFeedback( nlgeometry::MeshPtr mesh_, bool quads_,
+        unsigned int firstPatch_, unsigned int patches_, size_t bound_, const Eigen::Matrix4f& projection_,
+        const Eigen::Matrix4f& viewModel_, std::vector< float >& vertices_,
+        std::vector< float >& normals_ ) const
+    {
+        _useFeedbackProgram( quads_ ? _programQuadsFB : _programTrianglesFB,
+                             projection_, viewModel_,
+                             quads_ ? _qFBVertexSubroutines :
+                             _tFBVertexSubroutines );
+
+        // The primitives generated are counted along with the ones written,
+        // so a feedback that overflows its buffers is repeated once with
+        // buffers of the exact size. Without the single pass the first draw
+        // only counts
+        size_t capacity = 0;
+        if ( _singlePassExtraction &&
+             bound_ * 9 * sizeof( float ) <= _feedbackBufferLimit )
+            capacity = bound_;
+
+        GLuint queries[2];
+        glGenQueries( 2, queries );
+        GLuint generated = 0;
+        GLuint written = 0;
+        for ( unsigned int pass = 0; pass < 2; pass++ )
+        {
+            GLint size = 0;
+            glBindBuffer( GL_ARRAY_BUFFER, _tbos[0] );
+            glGetBufferParameteriv( GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &size );
+            if ( size_t( size ) < capacity * 9 * sizeof( float ))
+            {
+                for ( unsigned int i = 0; i < 2; i++ )
+                {
+                    glBindBuffer( GL_ARRAY_BUFFER, _tbos[i] );
+                    glBufferData( GL_ARRAY_BUFFER,
+                                  sizeof( float ) * capacity * 9, nullptr,
+                                  GL_STREAM_READ );
+                }
+            }
+
+            glBeginQuery( GL_PRIMITIVES_GENERATED, queries[0] );
+            if ( capacity > 0 )
+            {
+                glBindTransformFeedback( GL_TRANSFORM_FEEDBACK, _tfo );
+                glBeginQuery( GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN,
+                              queries[1] );
+                glBeginTransformFeedback( GL_TRIANGLES );
+            }
+            if ( quads_ )
+                mesh_->renderQuadsRange( firstPatch_, patches_ );
+            else
+                mesh_->renderTrianglesRange( firstPatch_, patches_ );
+            _countDraws( 1 );
+            if ( capacity > 0 )
+            {
+                glEndTransformFeedback( );
+                glEndQuery( GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN );
+                glBindTransformFeedback( GL_TRANSFORM_FEEDBACK, 0 );
+            }
+            glEndQuery( GL_PRIMITIVES_GENERATED );
+
+            glGetQueryObjectuiv( queries[0], GL_QUERY_RESULT, &generated );
+            written = 0;
+            if ( capacity > 0 )
+                glGetQueryObjectuiv( queries[1], GL_QUERY_RESULT, &written );
+            if ( generated <= written )
+                break;
+            capacity = generated;
+        }
+        glDeleteQueries( 2, queries );
+        if ( _profiler )
+            _profiler->primitives( generated );
+
+        size_t first = vertices_.size( );
+        size_t size = size_t( written ) * 9;
+        vertices_.resize( first + size );
+        normals_.resize( first + size );
+        if ( size > 0 )
+        {
+            glBindBuffer( GL_ARRAY_BUFFER, _tbos[0] );
+            glGetBufferSubData( GL_ARRAY_BUFFER, 0, sizeof( float ) * size,
+                                &vertices_[first] );
+            glBindBuffer( GL_ARRAY_BUFFER, _tbos[1] );
+            glGetBufferSubData( GL_ARRAY_BUFFER, 0, sizeof( float ) * size,
+                                &normals_[first] );
+        }
+        glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    }
+
+    void Renderer::_bindExtractionInstance( float lod_ ) const
+    {
+        // The model transform is part of the view uniform when extracting
+        _instances->resize( 1 );
+        _instances->set( 0, Eigen::Matrix4f::Identity( ),
+                         Eigen::Vector3f( 0.5f, 0.5f, 0.5f ));
+        _instances->lod( 0, lod_ );
+        _instances->upload( );
+        _instances->bind( );
+        glVertexAttribI1ui( InstanceBuffer::ATTRIB_LOCATION, 0 );
+    }
+
+    void Renderer::_issueFeedback( TExtraction& extraction_ )
+    {
+        size_t floats = ( extraction_.primitives[0] +
+                          extraction_.primitives[1] ) * 9;
+        nlgeometry::MeshPtr mesh = extraction_.mesh;
+        if ( floats == 0 )
+        {
+            extraction_.mesh = nullptr;
+            extraction_.result = new nlgeometry::Mesh( );
+            extraction_.ready = true;
+            return;
+        }
+        extraction_.buffer = _acquireFeedbackBuffer( floats );
+
+        _bindExtractionInstance( extraction_.lod );
+        glDisable( GL_CULL_FACE );
+        glEnable( GL_RASTERIZER_DISCARD );
+        glBindTransformFeedback( GL_TRANSFORM_FEEDBACK, _asyncTfo );
+
+        reto::ShaderProgram* programs[2] =
+            { _programTrianglesFB, _programQuadsFB };
+        const std::vector< unsigned int >* subroutines[2] =
+            { &_tFBVertexSubroutines, &_qFBVertexSubroutines };
+        size_t offset = 0;
+        for ( unsigned int i = 0; i < 2; i++ )
+        {
+            size_t size = extraction_.primitives[i] * 9;
+            if ( size == 0 )
+                continue;
+            for ( unsigned int j = 0; j < 2; j++ )
+                glBindBufferRange( GL_TRANSFORM_FEEDBACK_BUFFER, j,
+                                   extraction_.buffer.buffers[j],
+                                   GLintptr( offset * sizeof( float )),
+                                   GLsizeiptr( size * sizeof( float )));
+            _useFeedbackProgram( programs[i], extraction_.projection,
+                                 extraction_.viewModel, *subroutines[i] );
+            glGenQueries( 1, &extraction_.generatedQueries[i] );
+            glGenQueries( 1, &extraction_.writtenQueries[i] );
+            glBeginQuery( GL_PRIMITIVES_GENERATED,
+                          extraction_.generatedQueries[i] );
+            glBeginQuery( GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN,
+                          extraction_.writtenQueries[i] );
+            glBeginTransformFeedback( GL_TRIANGLES );
+            if ( i == 0 )
+                mesh->renderTriangles( );
+            else
+                mesh->renderQuads( );
+            _countDraws( 1 );
+            glEndTransformFeedback( );
+            glEndQuery( GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN );
+            glEndQuery( GL_PRIMITIVES_GENERATED );
+            offset += size;
+        }
+
+        glBindTransformFeedback( GL_TRANSFORM_FEEDBACK, 0 );
+        glDisable( GL_RASTERIZER_DISCARD );
+        extraction_.fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+    }
+
+    bool Renderer::_advanceExtraction( TExtraction& extraction_, bool wait_ )
+    {
+        if ( extraction_.ready )
+            return true;
+
+        if ( !extraction_.fence )
+        {
+            // Counted extraction, waiting for the primitives generated
+            for ( unsigned int i = 0; i < 2; i++ )
+            {
+                if ( extraction_.countQueries[i] == 0 )
+                    continue;
+                GLuint available = GL_TRUE;
+                if ( !wait_ )
+                    glGetQueryObjectuiv( extraction_.countQueries[i],
+                                         GL_QUERY_RESULT_AVAILABLE,
+                                         &available );
+                if ( available == GL_FALSE )
+                    return false;
+            }
+            for ( unsigned int i = 0; i < 2; i++ )
+            {
+                if ( extraction_.countQueries[i] == 0 )
+                    continue;
+                GLuint primitives = 0;
+                glGetQueryObjectuiv( extraction_.countQueries[i],
+                                     GL_QUERY_RESULT, &primitives );
+                glDeleteQueries( 1, &extraction_.countQueries[i] );
+                extraction_.countQueries[i] = 0;
+                extraction_.primitives[i] = primitives;
+            }
+            _state->invalidate( );
+            if ( _keepOpenGLServerStack )
+                glPushAttrib( GL_ALL_ATTRIB_BITS );
+            _issueFeedback( extraction_ );
+            if ( _keepOpenGLServerStack )
+                glPopAttrib( );
+            if ( extraction_.ready )
+                return true;
+        }
+
+        GLsync fence = static_cast< GLsync >( extraction_.fence );
+        GLuint64 timeout = wait_ ? GLuint64( 1000000000 ) : 0;
+        GLenum status;
+        do
+        {
+            status = glClientWaitSync( fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                       timeout );
+        } while ( wait_ && status == GL_TIMEOUT_EXPIRED );
+        if ( status == GL_TIMEOUT_EXPIRED )
+            return false;
+        glDeleteSync( fence );
+        extraction_.fence = nullptr;
+
+        // The draws are complete, so the results are available
+        GLuint written[2] = { 0, 0 };
+        bool overflow = false;
+        for ( unsigned int i = 0; i < 2; i++ )
+        {
+            if ( extraction_.writtenQueries[i] == 0 )
+                continue;
+            GLuint generated = 0;
+            glGetQueryObjectuiv( extraction_.generatedQueries[i],
+                                 GL_QUERY_RESULT, &generated );
+            glGetQueryObjectuiv( extraction_.writtenQueries[i],
+                                 GL_QUERY_RESULT, &written[i] );
+            glDeleteQueries( 1, &extraction_.generatedQueries[i] );
+            glDeleteQueries( 1, &extraction_.writtenQueries[i] );
+            extraction_.generatedQueries[i] = 0;
+            extraction_.writtenQueries[i] = 0;
+            if ( generated > written[i] )
+            {
+                extraction_.primitives[i] = generated;
+                overflow = true;
+            }
+        }
+
+        TFeedbackBuffer& buffer = extraction_.buffer;
+        if ( overflow )
+        {
+            // The bound fell short, so the feedback draws are repeated with
+            // buffers sized from the primitives generated
+            _feedbackBuffers.push_back( buffer );
+            buffer.capacity = 0;
+            _state->invalidate( );
+            if ( _keepOpenGLServerStack )
+                glPushAttrib( GL_ALL_ATTRIB_BITS );
+            _issueFeedback( extraction_ );
+            if ( _keepOpenGLServerStack )
+                glPopAttrib( );
+            return _advanceExtraction( extraction_, wait_ );
+        }
+        extraction_.mesh = nullptr;
+
+        std::vector< float > vertices;
+        std::vector< float > normals;
+        size_t offset = 0;
+        for ( unsigned int i = 0; i < 2; i++ )
+        {
+            if ( extraction_.primitives[i] == 0 )
+                continue;
+
+            size_t size = size_t( written[i] ) * 9;
+            size_t first = vertices.size( );
+            vertices.resize( first + size );
+            normals.resize( first + size );
+            if ( buffer.mapped[0] )
+            {
+                std::copy( buffer.mapped[0] + offset,
+                           buffer.mapped[0] + offset + size,
+                           vertices.begin( ) + first );
+                std::copy( buffer.mapped[1] + offset,
+                           buffer.mapped[1] + offset + size,
+                           normals.begin( ) + first );
+            }
+            else if ( size > 0 )
+            {
+                glBindBuffer( GL_COPY_READ_BUFFER, buffer.buffers[0] );
+                glGetBufferSubData( GL_COPY_READ_BUFFER,
+                                    GLintptr( offset * sizeof( float )),
+                                    GLsizeiptr( size * sizeof( float )),
+                                    &vertices[first] );
+                glBindBuffer( GL_COPY_READ_BUFFER, buffer.buffers[1] );
+                glGetBufferSubData( GL_COPY_READ_BUFFER,
+                                    GLintptr( offset * sizeof( float )),
+                                    GLsizeiptr( size * sizeof( float )),
+                                    &normals[first] );
+                glBindBuffer( GL_COPY_READ_BUFFER, 0 );
+            }
+            offset += extraction_.primitives[i] * 9;
+        }
+        _feedbackBuffers.push_back( buffer );
+        buffer.capacity = 0;
+
+        extraction_.result = _vectorToMesh( vertices, normals );
+        if ( _optimizeExtraction )
+            nlgeometry::MeshOptimizer::optimize( extraction_.result );
+        extraction_.ready = true;
+        return true;
+    }
+
+    Renderer::TFeedbackBuffer Renderer::_acquireFeedbackBuffer(
+        size_t floats_ )
+    {
+        // Reuse the smallest free buffer that fits
+        auto best = _feedbackBuffers.end( );
+        for ( auto buffer = _feedbackBuffers.begin( );
+              buffer != _feedbackBuffers.end( ); buffer++ )
+            if ( buffer->capacity >= floats_ &&
+                 ( best == _feedbackBuffers.end( ) ||
+                   buffer->capacity < best->capacity ))
+                best = buffer;
+        if ( best != _feedbackBuffers.end( ))
+        {
+            TFeedbackBuffer buffer = *best;
+            _feedbackBuffers.erase( best );
+            return buffer;
+        }
+
+        // Power of two capacities so later extractions can reuse them
+        TFeedbackBuffer buffer;
+        buffer.capacity = 1 << 16;
+        while ( buffer.capacity < floats_ )
+            buffer.capacity <<= 1;
+        GLsizeiptr bytes = GLsizeiptr( buffer.capacity * sizeof( float ));
+        glGenBuffers( 2, buffer.buffers );
+        for ( unsigned int i = 0; i < 2; i++ )
+        {
+            glBindBuffer( GL_COPY_WRITE_BUFFER, buffer.buffers[i] );
+            if ( GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage )
+            {
+                GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT |
+                    GL_MAP_COHERENT_BIT;
+                glBufferStorage( GL_COPY_WRITE_BUFFER, bytes, nullptr, flags );
+                buffer.mapped[i] = static_cast< float* >(
+                    glMapBufferRange( GL_COPY_WRITE_BUFFER, 0, bytes, flags ));
+            }
+            else
+            {
+                glBufferData( GL_COPY_WRITE_BUFFER, bytes, nullptr,
+                              GL_STREAM_READ );
+                buffer.mapped[i] = nullptr;
+            }
+        }
+        glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+        return buffer;
+    }
+
+    void Renderer::_useLinesProgram( void ) const
+    {
+        _useProgram( _programLines );
+        _uniform( StateCache::PROJECTION, _projectionMatrix );
+        _uniform( StateCache::VIEW, _viewMatrix );
+        _uniform( StateCache::ALPHA, _alpha );
+        _uniform( StateCache::NODE_COLORED,
+                  _colorFunc == PERNODE ? 1.0f : 0.0f );
+        _subroutines( GL_FRAGMENT_SHADER, _lFragmentSubroutines );
+    }
+
+    void Renderer::_useTrianglesProgram( void ) const
+    {
+        _useProgram( _programTriangles );
+        _uniform( StateCache::PROJECTION, _projectionMatrix );
+        _uniform( StateCache::VIEW, _viewMatrix );
+        _uniform( StateCache::LOD, _lod );
+        _uniform( StateCache::MAXIMUM_DISTANCE, _maximumDistance );
+        _uniform( StateCache::TANGENT_MODULUS, _tng );
+        _uniform( StateCache::ALPHA, _alpha );
+        _uniform( StateCache::NODE_COLORED,
+                  _colorFunc == PERNODE ? 1.0f : 0.0f );
+        _subroutines( GL_VERTEX_SHADER, _tVertexSubroutines );
+        _subroutines( GL_FRAGMENT_SHADER, _tFragmentSubroutines );
+    }
+
+    void Renderer::_useQuadsProgram( void ) const
+    {
+        _useProgram( _programQuads );
+        _uniform( StateCache::PROJECTION, _projectionMatrix );
+        _uniform( StateCache::VIEW, _viewMatrix );
+        _uniform( StateCache::LOD, _lod );
+        _uniform( StateCache::MAXIMUM_DISTANCE, _maximumDistance );
+        _uniform( StateCache::TANGENT_MODULUS, _tng );
+        _uniform( StateCache::ALPHA, _alpha );
+        _uniform( StateCache::NODE_COLORED,
+                  _colorFunc == PERNODE ? 1.0f : 0.0f );
+        _subroutines( GL_VERTEX_SHADER, _qVertexSubroutines );
+        _subroutines( GL_FRAGMENT_SHADER, _qFragmentSubroutines );
+    }
+
+    void Renderer::_useFeedbackProgram( reto::ShaderProgram* program_,
+        const Eigen::Matrix4f& projection_, const Eigen::Matrix4f& view_,
+        const std::vector< unsigned int >& vertexSubroutines_ ) const
+    {
+        _useProgram( program_ );
+        _uniform( StateCache::PROJECTION, projection_ );
+        _uniform( StateCache::VIEW, view_ );
+        _uniform( StateCache::LOD, _lod );
+        _uniform( StateCache::MAXIMUM_DISTANCE, _maximumDistance );
+        _uniform( StateCache::TANGENT_MODULUS, _tng );
+        _subroutines( GL_VERTEX_SHADER, vertexSubroutines_ );
+    }
+
+    void Renderer::_useProgram( reto::ShaderProgram* program_ ) const
+    {
+        if ( _state->useProgram( program_->program( )))
+            program_->use( );
+    }
+
+    void Renderer::_uniform( StateCache::TUniform uniform_,
+                             float value_ ) const
+    {
+        if ( _state->uniform( uniform_, value_ ))
+        {
+            glUniform1f( _state->location( uniform_ ), value_ );
+            if ( _profiler )
+                _profiler->uniformUploads( );
+        }
+    }
+
+    void Renderer::_uniform( StateCache::TUniform uniform_,
+                             const Eigen::Matrix4f& matrix_ ) const
+    {
+        if ( _state->uniform( uniform_, matrix_.data( )))
+        {
+            glUniformMatrix4fv( _state->location( uniform_ ), 1, GL_FALSE,
+                                matrix_.data( ));
+            if ( _profiler )
+                _profiler->uniformUploads( );
+        }
+    }
+
+    void Renderer::_subroutines( unsigned int shader_,
+        const std::vector< unsigned int >& indices_ ) const
+    {
+        if ( !_state->subroutines( shader_, indices_ ))
+            return;
+        glUniformSubroutinesuiv( shader_, GLsizei( indices_.size( )),
+                                 indices_.data( ));
+        if ( _profiler )
+            _profiler->subroutineSwitches( );
+    }
+
+    void Renderer::_countDraws( unsigned int count_ ) const
+    {
+        if ( _profiler )
+            _profiler->drawCalls( count_ );
+    }
+
+    void Renderer::_bindNodeColors( void ) const
+    {
+        if ( _nodeColorStream )
+        {
+            // The stream is uploaded by its owner once per frame
+            _nodeColorStream->bind( );
+        }
+        else
+        {
+            // Only the nodes recolored since the last frame are uploaded
+            _nodeColors->upload( );
+            _nodeColors->bind( );
+        }
+        // Meshes without the node attribute keep their vertex colors
+        glVertexAttrib1f( NodeColorBuffer::ATTRIB_LOCATION, -1.0f );
+    }
+
     void Renderer::_composeVertexSubroutines( void )
     {
         switch (_tessCriteria)
@@ -846,6 +1614,12 @@ namespace nlrender
                 _tFBVertexSubroutines[0] = _tFBLinearDistInd;
                 _qFBVertexSubroutines[0] = _qFBLinearDistInd;
             break;
+            case SCREEN_SPACE:
+                _tVertexSubroutines[0] = _tScreenDistInd;
+                _qVertexSubroutines[0] = _qScreenDistInd;
+                _tFBVertexSubroutines[0] = _tFBScreenDistInd;
+                _qFBVertexSubroutines[0] = _qFBScreenDistInd;
+            break;
         }
     }
 
@@ -854,6 +1628,7 @@ namespace nlrender
         switch ( _colorFunc )
         {
             case PERVERTEX:
+            case PERNODE:
                 _lFragmentSubroutines[_ulColorSub] = _lVertexColorInd;
                 _tFragmentSubroutines[_utColorSub] = _tVertexColorInd;
                 _qFragmentSubroutines[_uqColorSub] = _qVertexColorInd;
@@ -22,10 +22,21 @@
 #ifndef __NLRENDER_RENDERER__
 #define __NLRENDER_RENDERER__
 
+#include "ExtractionSink.h"
+#include "FrustumCuller.h"
+#include "InstanceBuffer.h"
+#include "NodeColorBuffer.h"
+#include "NodeColorStream.h"
+#include "MeshPool.h"
+#include "Profiler.h"
+#include "StateCache.h"
+
 #include "../nlgeometry/Mesh.h"
 
 #include <reto/reto.h>
 
+#include <map>
+
 #include <nlrender/api.h>
 
 namespace nlrender
@@ -37,13 +48,15 @@ namespace nlrender
         typedef enum
         {
             HOMOGENEOUS = 0,
-            LINEAR
+            LINEAR,
+            SCREEN_SPACE
         }TTessCriteria;
 
         typedef enum
         {
             PERVERTEX = 0,
-            GLOBAL
+            GLOBAL,
+            PERNODE
         }TColorFunc;
 
         typedef enum
@@ -106,6 +119,55 @@ namespace nlrender
         NLRENDER_API
         float& alpha( void );
 
+        /**
+         * Method that return the target length in pixels of the tessellated
+         * edges for the screen space tessellation criteria
+         * @return the target edge length in pixels
+         */
+        NLRENDER_API
+        float& edgePixels( void );
+
+        /**
+         * Method that sets the viewport size used by the screen space
+         * tessellation criteria. By default it is the OpenGL viewport when
+         * the renderer is created
+         * @param width_ viewport width in pixels
+         * @param height_ viewport height in pixels
+         */
+        NLRENDER_API
+        void viewport( unsigned int width_, unsigned int height_ );
+
+        /**
+         * Method that computes the level of detail of a mesh for the screen
+         * space tessellation criteria. Meshes without a valid bounding box
+         * use the global level of detail
+         * @param mesh_ mesh with its bounding box computed
+         * @param modelMatrix_ model matrix transform
+         * @return the level of detail of the mesh
+         */
+        NLRENDER_API
+        float meshLod( nlgeometry::MeshPtr mesh_,
+                       const Eigen::Matrix4f& modelMatrix_ ) const;
+
+        /**
+         * Static method that computes the level of detail, in tessellation
+         * levels per unit of length, that makes the tessellated edges of an
+         * object project to the given length in pixels. It projects the
+         * bounding sphere radius at its point nearest to the camera and
+         * divides the projected radius by the radius and the edge length
+         * @param bounds_ world space bounding box of the object
+         * @param view_ camera view matrix
+         * @param projection_ camera projection matrix
+         * @param viewportHeight_ viewport height in pixels
+         * @param edgePixels_ target edge length in pixels
+         * @return the level of detail
+         */
+        NLRENDER_API
+        static float screenSpaceLod(
+          const nlgeometry::AxisAlignedBoundingBox& bounds_,
+          const Eigen::Matrix4f& view_, const Eigen::Matrix4f& projection_,
+          float viewportHeight_, float edgePixels_ );
+
         /**
          * Method that return the tessellation criteria
          * @return the tessellation criteria
@@ -126,6 +188,32 @@ namespace nlrender
         NLRENDER_API
         void colorFunc( TColorFunc colorFunc_ );
 
+        /**
+         * Method that return the per node color table used by the PERNODE
+         * color function. The vertex colors are mixed with the color of their
+         * node, read from the NODE_ID attribute that must be the fourth
+         * attribute of the mesh format
+         * @return the per node color table
+         */
+        NLRENDER_API
+        NodeColorBuffer* nodeColors( void ) const;
+
+        /**
+         * Method that sets a streamed node color table, such as a simulation
+         * playback, read instead of the node color table by the PERNODE color
+         * function. The stream is not owned by the renderer
+         * @param stream_ node color stream or null to use the node colors
+         */
+        NLRENDER_API
+        void nodeColorStream( NodeColorStream* stream_ );
+
+        /**
+         * Method that return the streamed node color table
+         * @return the node color stream or null if not used
+         */
+        NLRENDER_API
+        NodeColorStream* nodeColorStream( void ) const;
+
         /**
          * Method that return the transparency status
          * @return the transparency status
@@ -133,6 +221,59 @@ namespace nlrender
         NLRENDER_API
         TTransparencyStatus transparencyStatus( void );
 
+        /**
+         * Method that return if the meshes outside the camera frustum are
+         * skipped when rendering several meshes
+         * @return true if the frustum culling is enabled
+         */
+        NLRENDER_API
+        bool& frustumCulling( void );
+
+        /**
+         * Method that return the number of meshes culled by the last render
+         * of several meshes
+         * @return the number of culled meshes
+         */
+        NLRENDER_API
+        unsigned int culledMeshes( void ) const;
+
+        /**
+         * Method that sets a bounding volume hierarchy over the world space
+         * bounds of the meshes to render, used by the frustum culling instead
+         * of testing every mesh. It is used while it has as many primitives
+         * as meshes are rendered, and the caller keeps it updated with the
+         * model matrices
+         * @param hierarchy_ hierarchy indexed as the rendered meshes or null
+         * to test every mesh
+         */
+        NLRENDER_API
+        void boundingVolumeHierarchy(
+          const nlgeometry::BoundingVolumeHierarchy* hierarchy_ );
+
+        /**
+         * Method that sets the profiler that measures the render passes,
+         * extractions and transparency passes. The profiler is not owned by
+         * the renderer
+         * @param profiler_ profiler or null to disable the measures
+         */
+        NLRENDER_API
+        void profiler( Profiler* profiler_ );
+
+        /**
+         * Method that return the profiler of the renderer
+         * @return the profiler or null if disabled
+         */
+        NLRENDER_API
+        Profiler* profiler( void ) const;
+
+        /**
+         * Method that return the number of program, uniform and subroutine
+         * updates skipped because the state had not changed
+         * @return the number of elided calls
+         */
+        NLRENDER_API
+        unsigned int elidedStateCalls( void ) const;
+
         /**
          * Method that renderize the given mesh
          * @param mesh_ mesh to renderize
@@ -151,7 +292,9 @@ namespace nlrender
           bool renderTriangles_ = true, bool renderQuads_ = true,
           bool renderLines = true ) const;
         /**
-         * Method that renderize the given meshes
+         * Method that renderize the given meshes. Meshes which bounding box,
+         * transformed by its model matrix, is outside the camera frustum are
+         * skipped
          * @param meshes_ meshes to renderize
          * @param modelMatrices Model matrices transform.
          * @param color_ Rendering color of the meshes, default gray.
@@ -169,11 +312,14 @@ namespace nlrender
           bool renderQuads_ = true) const;
 
         /**
-         * Method that renderize the given meshes
+         * Method that renderize the given meshes. Meshes which bounding box,
+         * transformed by its model matrix, is outside the camera frustum are
+         * skipped
          * @param meshes_ meshes to renderize
          * @param modelMatrices Model matrices transform.
          * @param baseColors Default mesh colors.
-         * @param color_ Rendering color of the meshes, default gray.
+         * @param colors_ Dynamic mesh colors replacing the base colors, or
+         * empty to render the base colors.
          * @param renderTriangles_ True to render mesh triangles and false otherwise.
          * @param renderQuads_ True to render mesh quads and false otherwise.
          * @param renderLines_ True to render mesh lines and false otherwise.
@@ -189,7 +335,48 @@ namespace nlrender
           bool renderQuads_ = true) const;
 
         /**
-         * Method that extract the given mesh
+         * Method that renderize all the meshes of the given pool with one
+         * multi draw call per primitive type
+         * @param pool_ pool of meshes to renderize
+         * @param modelMatrix_ model matrix transform shared by all the meshes.
+         * @param color_ Rendering color of the meshes, default gray.
+         * @param renderLines_ True to render mesh lines and false otherwise.
+         * @param renderTriangles_ True to render mesh triangles and false otherwise.
+         * @param renderQuads_ True to render mesh quads and false otherwise.
+         *
+         */
+        NLRENDER_API
+        void render(
+          MeshPool* pool_,
+          const Eigen::Matrix4f& modelMatrix_ = Eigen::Matrix4f::Identity( ),
+          const Eigen::Vector3f& color_ = Eigen::Vector3f( 0.5f, 0.5f, 0.5f ),
+          bool renderLines_ = true, bool renderTriangles_ = true,
+          bool renderQuads_ = true ) const;
+
+        /**
+         * Method that renderize all the meshes of the given pool with one
+         * multi draw call per primitive type, reading the model matrix and
+         * colors of each mesh from the instance with its pool identifier. With
+         * the screen space tessellation criteria the level of detail of each
+         * instance is computed from its model matrix and the mesh bounds
+         * @param pool_ pool of meshes to renderize
+         * @param instances_ per mesh data indexed by pool identifier
+         * @param renderLines_ True to render mesh lines and false otherwise.
+         * @param renderTriangles_ True to render mesh triangles and false otherwise.
+         * @param renderQuads_ True to render mesh quads and false otherwise.
+         *
+         */
+        NLRENDER_API
+        void render(
+          MeshPool* pool_,
+          InstanceBuffer* instances_,
+          bool renderLines_ = true, bool renderTriangles_ = true,
+          bool renderQuads_ = true ) const;
+
+        /**
+         * Method that extract the given mesh. With the single pass extraction
+         * the feedback buffers are sized from a bound of the primitives
+         * generated, and only grown and drawn again when they overflow
          * @param mesh_ mesh to extract
          * @return the extracted mesh
          */
@@ -210,6 +397,115 @@ namespace nlrender
           const std::vector< Eigen::Matrix4f >& modelMatrices_,
           bool extractTriangles_ = true, bool extractQuads_ = true ) const;
 
+        /**
+         * Method that extract the given mesh in chunks of patches, passing each
+         * extracted chunk to the sink and deleting it afterwards. The feedback
+         * buffers of each chunk are sized from a bound of its primitives, so
+         * the memory used does not depend on the size of the extracted mesh.
+         * Vertices shared by patches of different chunks are repeated
+         * @param mesh_ mesh to extract, uploaded as patches
+         * @param sink_ sink that receives the extracted chunks
+         * @param modelMatrix_ model matrix transform
+         * @param extractTriangles_ true to extract the mesh triangles
+         * @param extractQuads_ true to extract the mesh quads
+         * @param chunkBytes_ maximum size in bytes of the feedback buffers of
+         * a chunk, 0 to use the feedback buffer limit. A chunk has at least
+         * one patch
+         * @return the number of chunks passed to the sink
+         */
+        NLRENDER_API
+        unsigned int extractChunks(
+          nlgeometry::MeshPtr mesh_, ExtractionSink* sink_,
+          const Eigen::Matrix4f& modelMatrix_ = Eigen::Matrix4f::Identity( ),
+          bool extractTriangles_ = true, bool extractQuads_ = true,
+          size_t chunkBytes_ = 0 ) const;
+
+        /**
+         * Method that starts the extraction of the given mesh without waiting
+         * for the gpu. The tessellated triangles are written to reused
+         * persistently mapped buffers sized from a bound of the primitives
+         * generated, and read in a later call to updateExtractions once a
+         * fence signals them. When the bound exceeds the feedback buffer
+         * limit the primitives are counted first, also without waiting. If
+         * the feedback overflows the bound its draws are repeated with the
+         * primitives generated, so the mesh must not be deleted until the
+         * extraction is ready
+         * @param mesh_ mesh to extract, uploaded as patches
+         * @param modelMatrix_ model matrix transform
+         * @param extractTriangles_ true to extract the mesh triangles
+         * @param extractQuads_ true to extract the mesh quads
+         * @return identifier of the extraction
+         */
+        NLRENDER_API
+        unsigned int extractAsync(
+          nlgeometry::MeshPtr mesh_,
+          const Eigen::Matrix4f& modelMatrix_ = Eigen::Matrix4f::Identity( ),
+          bool extractTriangles_ = true, bool extractQuads_ = true );
+
+        /**
+         * Method that advances the pending extractions without blocking. It
+         * has to be called with the OpenGL context current, for example once
+         * per frame
+         * @return the number of extractions not ready yet
+         */
+        NLRENDER_API
+        unsigned int updateExtractions( void );
+
+        /**
+         * Method that returns if an extraction is ready
+         * @param extraction_ identifier of the extraction
+         * @return true if the extracted mesh is available
+         */
+        NLRENDER_API
+        bool extractionReady( unsigned int extraction_ ) const;
+
+        /**
+         * Method that returns the mesh of an extraction and forgets it,
+         * waiting for the gpu if it is not ready
+         * @param extraction_ identifier of the extraction
+         * @return the extracted mesh
+         */
+        NLRENDER_API
+        nlgeometry::MeshPtr extractionResult( unsigned int extraction_ );
+
+        /**
+         * Method that return the maximum size in bytes of each feedback
+         * buffer sized from the primitives bound
+         * @return the feedback buffer limit
+         */
+        NLRENDER_API
+        size_t& feedbackBufferLimit( void );
+
+        /**
+         * Method that return if the extraction sizes its feedback buffers
+         * from the primitives bound and draws each mesh once, instead of
+         * counting the primitives with a first draw. Meshes which bound
+         * exceeds the feedback buffer limit are always counted first
+         * @return true if the single pass extraction is enabled
+         */
+        NLRENDER_API
+        bool& singlePassExtraction( void );
+
+        /**
+         * Method that return if the extracted meshes are reordered with the
+         * mesh optimizer before they are returned or passed to a sink. It is
+         * disabled by default, as the reorder only pays off for extracted
+         * meshes that are rendered afterwards
+         * @return true if the extracted meshes are optimized
+         */
+        NLRENDER_API
+        bool& optimizeExtraction( void );
+
+        /**
+         * Static method that bounds the triangles generated by a patch with
+         * equal spacing tessellation, whose levels are clamped to 64
+         * @param level_ maximum tessellation level of the patch edges
+         * @param quad_ true for quad patches and false for triangle patches
+         * @return the maximum number of triangles of the patch
+         */
+        NLRENDER_API
+        static unsigned int maxPrimitivesPerPatch( float level_, bool quad_ );
+
         NLRENDER_API
         void initTransparencySystem( unsigned int width_, unsigned int height_ );
 
@@ -230,6 +526,82 @@ namespace nlrender
                                            std::vector< float > normals_  ) const;
         void _uploadQuad( void );
 
+        void _renderInstances( nlgeometry::Meshes& meshes_,
+                               const std::vector< Eigen::Matrix4f >& modelMatrices_,
+                               bool renderLines_, bool renderTriangles_,
+                               bool renderQuads_ ) const;
+
+        float _screenSpaceLod( const nlgeometry::AxisAlignedBoundingBox& bounds_,
+                               const Eigen::Matrix4f& modelMatrix_ ) const;
+
+        void _useLinesProgram( void ) const;
+        void _useTrianglesProgram( void ) const;
+        void _useQuadsProgram( void ) const;
+        void _useFeedbackProgram( reto::ShaderProgram* program_,
+                                  const Eigen::Matrix4f& projection_,
+                                  const Eigen::Matrix4f& view_,
+                                  const std::vector< unsigned int >&
+                                    vertexSubroutines_ ) const;
+        void _subroutines( unsigned int shader_,
+                           const std::vector< unsigned int >& indices_ ) const;
+        void _useProgram( reto::ShaderProgram* program_ ) const;
+        void _uniform( StateCache::TUniform uniform_, float value_ ) const;
+        void _uniform( StateCache::TUniform uniform_,
+                       const Eigen::Matrix4f& matrix_ ) const;
+        void _countDraws( unsigned int count_ ) const;
+        void _bindNodeColors( void ) const;
+
+        //! Feedback buffers of the asynchronous extractions
+        typedef struct
+        {
+          unsigned int buffers[2];
+          //! Persistent mappings, null if buffer storage is not supported
+          float* mapped[2];
+          //! Capacity in floats of each buffer
+          size_t capacity;
+        } TFeedbackBuffer;
+
+        //! Asynchronous extraction in progress
+        typedef struct
+        {
+          //! Source mesh, needed to repeat the feedback draws on overflow
+          nlgeometry::MeshPtr mesh;
+          Eigen::Matrix< float, 4, 4, Eigen::DontAlign > viewModel;
+          Eigen::Matrix< float, 4, 4, Eigen::DontAlign > projection;
+          float lod;
+          bool extract[2];
+          //! Primitives generated queries when counting, zero otherwise
+          unsigned int countQueries[2];
+          //! Primitives written queries of the triangles and quads
+          unsigned int writtenQueries[2];
+          //! Primitives generated queries of the feedback draws
+          unsigned int generatedQueries[2];
+          //! Primitives reserved for the triangles and quads
+          size_t primitives[2];
+          TFeedbackBuffer buffer;
+          //! Fence of the feedback draws, null until they are issued
+          void* fence;
+          nlgeometry::MeshPtr result;
+          bool ready;
+        } TExtraction;
+
+        float _extractionLod( nlgeometry::MeshPtr mesh_,
+                              const Eigen::Matrix4f& modelMatrix_ ) const;
+        size_t _primitivesBound( nlgeometry::MeshPtr mesh_,
+                                 const Eigen::Matrix4f& modelMatrix_,
+                                 float lod_, bool quads_ ) const;
+        void _extractFeedback( nlgeometry::MeshPtr mesh_, bool quads_,
+                               unsigned int firstPatch_, unsigned int patches_,
+                               size_t bound_,
+                               const Eigen::Matrix4f& projection_,
+                               const Eigen::Matrix4f& viewModel_,
+                               std::vector< float >& vertices_,
+                               std::vector< float >& normals_ ) const;
+        void _bindExtractionInstance( float lod_ ) const;
+        void _issueFeedback( TExtraction& extraction_ );
+        bool _advanceExtraction( TExtraction& extraction_, bool wait_ );
+        TFeedbackBuffer _acquireFeedbackBuffer( size_t floats_ );
+
         void _composeVertexSubroutines( void );
         void _composeFragmentSubroutines( void );
 
@@ -247,6 +619,7 @@ namespace nlrender
         reto::ShaderProgram* _programTriangles;
         unsigned int _tLinearDistInd;
         unsigned int _tHomogeDistInd;
+        unsigned int _tScreenDistInd;
         unsigned int _tGlobalColorInd;
         unsigned int _tVertexColorInd;
         unsigned int _tTransEnableInd;
@@ -256,6 +629,7 @@ namespace nlrender
         reto::ShaderProgram* _programQuads;
         unsigned int _qLinearDistInd;
         unsigned int _qHomogeDistInd;
+        unsigned int _qScreenDistInd;
         unsigned int _qGlobalColorInd;
         unsigned int _qVertexColorInd;
         unsigned int _qTransEnableInd;
@@ -265,11 +639,13 @@ namespace nlrender
         reto::ShaderProgram* _programTrianglesFB;
         unsigned int _tFBLinearDistInd;
         unsigned int _tFBHomogeDistInd;
+        unsigned int _tFBScreenDistInd;
 
         //! Program to extract tessellated quads
         reto::ShaderProgram* _programQuadsFB;
         unsigned int _qFBLinearDistInd;
         unsigned int _qFBHomogeDistInd;
+        unsigned int _qFBScreenDistInd;
 
 
         unsigned int _ulColorSub;
@@ -287,6 +663,12 @@ namespace nlrender
         std::vector< unsigned int > _tFragmentSubroutines;
         std::vector< unsigned int > _qFragmentSubroutines;
 
+        //! Per mesh data of the meshes rendered without an external buffer
+        InstanceBuffer* _instances;
+
+        //! Per node colors of the PERNODE color function
+        NodeColorBuffer* _nodeColors;
+
         //! Program to compose the transparency scene
         reto::ShaderProgram* _programTransCompose;
 
@@ -308,6 +690,15 @@ namespace nlrender
         //! Transparency factor
         float _alpha;
 
+        //! Target edge length in pixels of the screen space criteria
+        float _edgePixels;
+
+        //! Viewport width in pixels
+        unsigned int _viewportWidth;
+
+        //! Viewport height in pixels
+        unsigned int _viewportHeight;
+
         //! Tessellation level of detail criteria
         TTessCriteria _tessCriteria;
 
@@ -317,12 +708,51 @@ namespace nlrender
         //! Status of transparency render
         TTransparencyStatus _transparencyStatus;
 
+        //! Visibility test of the meshes against the camera frustum
+        FrustumCuller* _culler;
+
+        //! Variable to determine if the frustum culling is enabled
+        bool _frustumCulling;
+
+        //! Scene hierarchy used by the frustum culling
+        const nlgeometry::BoundingVolumeHierarchy* _hierarchy;
+
+        //! Profiler of the passes or null if disabled
+        Profiler* _profiler;
+
+        //! Streamed node colors or null to use the node color table
+        NodeColorStream* _nodeColorStream;
+
+        //! Program, uniform and subroutine state sent to OpenGL
+        StateCache* _state;
+
         //! Vertex array object index to mesh extraction
         unsigned int _tfo;
 
         //! Vertex buffers object indices to mesh extraction
         std::vector< unsigned int > _tbos;
 
+        //! Transform feedback object of the asynchronous extractions
+        unsigned int _asyncTfo;
+
+        //! Asynchronous extractions by identifier
+        std::map< unsigned int, TExtraction > _extractions;
+
+        //! Identifier of the next asynchronous extraction
+        unsigned int _nextExtraction;
+
+        //! Feedback buffers free to be reused
+        std::vector< TFeedbackBuffer > _feedbackBuffers;
+
+        //! Maximum size in bytes of a feedback buffer sized from the bound
+        size_t _feedbackBufferLimit;
+
+        //! Variable to determine if the extraction draws each mesh once
+        bool _singlePassExtraction;
+
+        //! Variable to determine if the extracted meshes are optimized
+        bool _optimizeExtraction;
+
         //! Vertex array object index to quad
         unsigned int _quadVao;
 
@@ -0,0 +1,155 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "StateCache.h"
+
+#ifndef NEUROLOTS_SKIP_GLEW_INCLUDE
+#include <GL/glew.h>
+#endif
+#ifdef Darwin
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nlrender
+{
+
+  StateCache::StateCache( void )
+    : _current( nullptr )
+    , _elided( 0 )
+  {
+  }
+
+  StateCache::~StateCache( void )
+  {
+  }
+
+  const char* StateCache::name( TUniform uniform_ )
+  {
+    static const char* names[ ] =
+      { "proy", "view", "lod", "maxDist", "tng", "alpha", "nodeColored" };
+    return names[ uniform_ ];
+  }
+
+  std::vector< int > StateCache::queryLocations( unsigned int program_ )
+  {
+    std::vector< int > locations( UNIFORMS );
+    for ( unsigned int i = 0; i < UNIFORMS; i++ )
+      locations[i] = glGetUniformLocation( program_,
+                                           name( TUniform( i )));
+    return locations;
+  }
+
+  void StateCache::addProgram( unsigned int program_,
+                               const std::vector< int >& locations_ )
+  {
+    if ( locations_.size( ) != UNIFORMS )
+      throw std::runtime_error( "Wrong number of uniform locations" );
+    _current = nullptr;
+    TProgram& program = _programs[ program_ ];
+    program.locations = locations_;
+    program.values.assign( UNIFORMS, std::vector< float >( ));
+  }
+
+  bool StateCache::useProgram( unsigned int program_ )
+  {
+    auto program = _programs.find( program_ );
+    if ( program == _programs.end( ))
+      throw std::runtime_error( "Program not added to the state cache" );
+    if ( _current == &program->second )
+    {
+      _elided++;
+      return false;
+    }
+    _current = &program->second;
+    _subroutines.clear( );
+    return true;
+  }
+
+  int StateCache::location( TUniform uniform_ ) const
+  {
+    return _current ? _current->locations[ uniform_ ] : -1;
+  }
+
+  bool StateCache::uniform( TUniform uniform_, float value_ )
+  {
+    return _uniform( uniform_, &value_, 1 );
+  }
+
+  bool StateCache::uniform( TUniform uniform_, const float* matrix_ )
+  {
+    return _uniform( uniform_, matrix_, 16 );
+  }
+
+  bool StateCache::subroutines( unsigned int shader_,
+                                const std::vector< unsigned int >& indices_ )
+  {
+    auto current = _subroutines.find( shader_ );
+    if ( current != _subroutines.end( ) && current->second == indices_ )
+    {
+      _elided++;
+      return false;
+    }
+    _subroutines[ shader_ ] = indices_;
+    return true;
+  }
+
+  void StateCache::invalidate( void )
+  {
+    _current = nullptr;
+    _subroutines.clear( );
+  }
+
+  void StateCache::reset( void )
+  {
+    invalidate( );
+    for ( auto& program: _programs )
+      program.second.values.assign( UNIFORMS, std::vector< float >( ));
+  }
+
+  unsigned int StateCache::elided( void ) const
+  {
+    return _elided;
+  }
+
+  bool StateCache::_uniform( TUniform uniform_, const float* data_,
+                             unsigned int size_ )
+  {
+    if ( !_current )
+      throw std::runtime_error( "Uniform set without a program in use" );
+    if ( _current->locations[ uniform_ ] < 0 )
+      return false;
+    std::vector< float >& value = _current->values[ uniform_ ];
+    if ( value.size( ) == size_ &&
+         std::equal( data_, data_ + size_, value.begin( )))
+    {
+      _elided++;
+      return false;
+    }
+    value.assign( data_, data_ + size_ );
+    return true;
+  }
+
+} // namespace nlrender
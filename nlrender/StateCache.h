@@ -0,0 +1,189 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef __NLRENDER_STATE_CACHE__
+#define __NLRENDER_STATE_CACHE__
+
+#include <unordered_map>
+#include <vector>
+
+#include <nlrender/api.h>
+
+namespace nlrender
+{
+
+  /* \class StateCache
+   * Tracks the program in use, the uniform values of each program and the
+   * subroutines of the program in use, so the renderer only sends the state
+   * that changed. Uniform values are stored in the program objects, so they
+   * are kept between uses, while the subroutines are lost each time a program
+   * is used. The methods only decide what has to be sent, the caller sends it
+   */
+  class StateCache
+  {
+
+  public:
+
+    typedef enum
+    {
+      PROJECTION = 0,
+      VIEW,
+      LOD,
+      MAXIMUM_DISTANCE,
+      TANGENT_MODULUS,
+      ALPHA,
+      NODE_COLORED,
+      UNIFORMS
+    } TUniform;
+
+    /**
+     * Default constructor
+     */
+    NLRENDER_API
+    StateCache( void );
+
+    /**
+     * Default destructor
+     */
+    NLRENDER_API
+    ~StateCache( void );
+
+    /**
+     * Static method that returns the name of a uniform in the shaders
+     * @param uniform_ uniform
+     * @return the name of the uniform
+     */
+    NLRENDER_API
+    static const char* name( TUniform uniform_ );
+
+    /**
+     * Static method that queries the locations of the uniforms of a linked
+     * program. It needs the OpenGL context current
+     * @param program_ OpenGL program
+     * @return the location of each uniform, -1 if the program lacks it
+     */
+    NLRENDER_API
+    static std::vector< int > queryLocations( unsigned int program_ );
+
+    /**
+     * Method that adds a program with the locations of its uniforms
+     * @param program_ OpenGL program
+     * @param locations_ location of each uniform, -1 if the program lacks it
+     */
+    NLRENDER_API
+    void addProgram( unsigned int program_,
+                     const std::vector< int >& locations_ );
+
+    /**
+     * Method that changes the program in use
+     * @param program_ program added before
+     * @return true if the program has to be used
+     */
+    NLRENDER_API
+    bool useProgram( unsigned int program_ );
+
+    /**
+     * Method that returns the location of a uniform of the program in use
+     * @param uniform_ uniform
+     * @return the location or -1 if the program lacks it
+     */
+    NLRENDER_API
+    int location( TUniform uniform_ ) const;
+
+    /**
+     * Method that stores a uniform value of the program in use
+     * @param uniform_ uniform
+     * @param value_ value of the uniform
+     * @return true if the value has to be sent
+     */
+    NLRENDER_API
+    bool uniform( TUniform uniform_, float value_ );
+
+    /**
+     * Method that stores a matrix uniform of the program in use
+     * @param uniform_ uniform
+     * @param matrix_ 16 floats of the matrix
+     * @return true if the matrix has to be sent
+     */
+    NLRENDER_API
+    bool uniform( TUniform uniform_, const float* matrix_ );
+
+    /**
+     * Method that stores the subroutines of a shader stage of the program in
+     * use
+     * @param shader_ OpenGL shader type
+     * @param indices_ subroutine indices
+     * @return true if the subroutines have to be sent
+     */
+    NLRENDER_API
+    bool subroutines( unsigned int shader_,
+                      const std::vector< unsigned int >& indices_ );
+
+    /**
+     * Method that forgets the program in use and its subroutines, to be
+     * called when other code may have used another program
+     */
+    NLRENDER_API
+    void invalidate( void );
+
+    /**
+     * Method that forgets all the state, including the uniform values
+     */
+    NLRENDER_API
+    void reset( void );
+
+    /**
+     * Method that returns the number of calls skipped because the state had
+     * not changed
+     * @return the number of elided calls
+     */
+    NLRENDER_API
+    unsigned int elided( void ) const;
+
+  protected:
+
+    typedef struct
+    {
+      //! Location of each uniform
+      std::vector< int > locations;
+      //! Last value of each uniform, up to 16 floats
+      std::vector< std::vector< float >> values;
+    } TProgram;
+
+    bool _uniform( TUniform uniform_, const float* data_, unsigned int size_ );
+
+    //! Programs by OpenGL identifier
+    std::unordered_map< unsigned int, TProgram > _programs;
+
+    //! Program in use or null if unknown
+    TProgram* _current;
+
+    //! Subroutines of the program in use by shader type
+    std::unordered_map< unsigned int, std::vector< unsigned int >> _subroutines;
+
+    //! Number of elided calls
+    unsigned int _elided;
+
+  }; // class StateCache
+
+} // namespace nlrender
+
+#endif
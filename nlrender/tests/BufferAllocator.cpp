@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <nlrender/nlrender.h>
+
+#include "nlrenderTests.h"
+
+using namespace nlrender;
+
+BOOST_AUTO_TEST_CASE( bufferAllocator_allocate )
+{
+  BufferAllocator allocator( 100 );
+  unsigned int offset0, offset1, offset2;
+
+  BOOST_CHECK( allocator.allocate( 40, offset0 ));
+  BOOST_CHECK( allocator.allocate( 40, offset1 ));
+  BOOST_CHECK_EQUAL( offset0, 0 );
+  BOOST_CHECK_EQUAL( offset1, 40 );
+  BOOST_CHECK_EQUAL( allocator.used( ), 80 );
+  BOOST_CHECK( !allocator.allocate( 30, offset2 ));
+
+  allocator.release( offset0, 40 );
+  BOOST_CHECK_EQUAL( allocator.freeRanges( ), 2 );
+  BOOST_CHECK( allocator.allocate( 30, offset2 ));
+  BOOST_CHECK_EQUAL( offset2, 0 );
+  BOOST_CHECK( allocator.allocate( 15, offset2 ));
+  BOOST_CHECK_EQUAL( offset2, 80 );
+}
+
+BOOST_AUTO_TEST_CASE( bufferAllocator_release )
+{
+  BufferAllocator allocator( 90 );
+  unsigned int offsets[3];
+  for ( unsigned int i = 0; i < 3; i++ )
+    allocator.allocate( 30, offsets[i] );
+  BOOST_CHECK_EQUAL( allocator.freeRanges( ), 0 );
+
+  allocator.release( offsets[0], 30 );
+  allocator.release( offsets[2], 30 );
+  BOOST_CHECK_EQUAL( allocator.freeRanges( ), 2 );
+  allocator.release( offsets[1], 30 );
+  BOOST_CHECK_EQUAL( allocator.freeRanges( ), 1 );
+  BOOST_CHECK_EQUAL( allocator.used( ), 0 );
+
+  BOOST_CHECK_THROW( allocator.release( 0, 10 ), std::runtime_error );
+  BOOST_CHECK_THROW( allocator.release( 80, 20 ), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( bufferAllocator_grow )
+{
+  BufferAllocator allocator( 10 );
+  unsigned int offset;
+  BOOST_CHECK( allocator.allocate( 5, offset ));
+  BOOST_CHECK( !allocator.allocate( 10, offset ));
+
+  allocator.grow( 20 );
+  BOOST_CHECK_EQUAL( allocator.capacity( ), 20 );
+  BOOST_CHECK_EQUAL( allocator.freeRanges( ), 1 );
+  BOOST_CHECK( allocator.allocate( 15, offset ));
+  BOOST_CHECK_EQUAL( offset, 5 );
+}
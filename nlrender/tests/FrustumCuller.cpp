@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include <nlrender/nlrender.h>
+
+#include "nlrenderTests.h"
+
+using namespace nlrender;
+
+BOOST_AUTO_TEST_CASE( frustumCuller_visible )
+{
+  // Orthographic camera looking at the cube from -1 to 1
+  FrustumCuller culler;
+  culler.update( Eigen::Matrix4f::Identity( ), Eigen::Matrix4f::Identity( ));
+
+  nlgeometry::AxisAlignedBoundingBox bounds(
+    Eigen::Vector3f( -0.5f, -0.5f, -0.5f ),
+    Eigen::Vector3f( 0.5f, 0.5f, 0.5f ));
+  int first, second, third;
+
+  Eigen::Matrix4f model = Eigen::Matrix4f::Identity( );
+  BOOST_CHECK( culler.visible( &first, bounds, model ));
+
+  model( 0, 3 ) = 5.0f;
+  BOOST_CHECK( !culler.visible( &second, bounds, model ));
+
+  // Invalid bounds are never culled
+  BOOST_CHECK( culler.visible( &third, nlgeometry::AxisAlignedBoundingBox( ),
+                               model ));
+
+  BOOST_CHECK_EQUAL( culler.tested( ), 3 );
+  BOOST_CHECK_EQUAL( culler.culled( ), 1 );
+
+  // Moving the camera brings the second object inside and resets the
+  // statistics
+  Eigen::Matrix4f view = Eigen::Matrix4f::Identity( );
+  view( 0, 3 ) = -5.0f;
+  culler.update( view, Eigen::Matrix4f::Identity( ));
+  BOOST_CHECK_EQUAL( culler.tested( ), 0 );
+  BOOST_CHECK( culler.visible( &second, bounds, model ));
+  BOOST_CHECK( !culler.visible( &first, bounds,
+                                Eigen::Matrix4f::Identity( )));
+  BOOST_CHECK_EQUAL( culler.culled( ), 1 );
+}
+
+BOOST_AUTO_TEST_CASE( frustumCuller_cache )
+{
+  FrustumCuller culler;
+  int object;
+  nlgeometry::AxisAlignedBoundingBox bounds(
+    Eigen::Vector3f( -1.0f, -1.0f, -1.0f ),
+    Eigen::Vector3f( 1.0f, 1.0f, 1.0f ));
+
+  Eigen::Matrix4f model = Eigen::Matrix4f::Identity( );
+  model( 1, 3 ) = 2.0f;
+  const nlgeometry::AxisAlignedBoundingBox* world =
+    &culler.worldBounds( &object, bounds, model );
+  BOOST_CHECK_EQUAL( world->minimum( ), Eigen::Vector3f( -1.0f, 1.0f, -1.0f ));
+
+  // The same model matrix reuses the cached bounds
+  BOOST_CHECK_EQUAL( &culler.worldBounds( &object, bounds, model ), world );
+
+  // A new model matrix or new bounds recompute them
+  model( 1, 3 ) = 4.0f;
+  BOOST_CHECK_EQUAL( culler.worldBounds( &object, bounds, model ).minimum( ),
+                     Eigen::Vector3f( -1.0f, 3.0f, -1.0f ));
+  bounds.maximum( ).x( ) = 3.0f;
+  BOOST_CHECK_EQUAL( culler.worldBounds( &object, bounds, model ).maximum( ),
+                     Eigen::Vector3f( 3.0f, 5.0f, 1.0f ));
+
+  culler.clearCache( );
+  BOOST_CHECK_EQUAL( culler.worldBounds( &object, bounds, model ).maximum( ),
+                     Eigen::Vector3f( 3.0f, 5.0f, 1.0f ));
+}
+
+BOOST_AUTO_TEST_CASE( frustumCuller_hierarchy )
+{
+  std::vector< nlgeometry::AxisAlignedBoundingBox > bounds;
+  for ( unsigned int i = 0; i < 10; i++ )
+    bounds.push_back( nlgeometry::AxisAlignedBoundingBox(
+      Eigen::Vector3f( i * 0.5f - 0.1f, -0.1f, -0.1f ),
+      Eigen::Vector3f( i * 0.5f + 0.1f, 0.1f, 0.1f )));
+  nlgeometry::BoundingVolumeHierarchy hierarchy( 2 );
+  hierarchy.build( bounds );
+
+  FrustumCuller culler;
+  culler.update( Eigen::Matrix4f::Identity( ), Eigen::Matrix4f::Identity( ));
+  std::vector< unsigned int > visible;
+  culler.visible( hierarchy, visible );
+
+  BOOST_CHECK_EQUAL( visible.size( ), 3 );
+  BOOST_CHECK_EQUAL( visible[0], 0 );
+  BOOST_CHECK_EQUAL( visible[2], 2 );
+  BOOST_CHECK_EQUAL( culler.tested( ), 10 );
+  BOOST_CHECK_EQUAL( culler.culled( ), 7 );
+}
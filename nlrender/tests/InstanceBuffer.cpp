@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <nlrender/nlrender.h>
+
+#include "nlrenderTests.h"
+
+using namespace nlrender;
+
+BOOST_AUTO_TEST_CASE( instanceBuffer_pack )
+{
+  Eigen::Matrix4f model = Eigen::Matrix4f::Identity( );
+  model.block< 3, 1 >( 0, 3 ) = Eigen::Vector3f( 1.0f, 2.0f, 3.0f );
+  float data[InstanceBuffer::FLOATS_PER_INSTANCE];
+
+  InstanceBuffer::pack( model, Eigen::Vector3f( 0.1f, 0.2f, 0.3f ),
+                        Eigen::Vector4f( 1.0f, 0.0f, 0.0f, 0.5f ), data );
+
+  // Columns of the matrix, translation in the fourth texel
+  BOOST_CHECK_EQUAL( data[0], 1.0f );
+  BOOST_CHECK_EQUAL( data[5], 1.0f );
+  BOOST_CHECK_EQUAL( data[12], 1.0f );
+  BOOST_CHECK_EQUAL( data[13], 2.0f );
+  BOOST_CHECK_EQUAL( data[14], 3.0f );
+  BOOST_CHECK_EQUAL( data[15], 1.0f );
+  BOOST_CHECK_EQUAL( data[16], 0.1f );
+  BOOST_CHECK_EQUAL( data[18], 0.3f );
+  BOOST_CHECK_EQUAL( data[19], 1.0f );
+  BOOST_CHECK_EQUAL( data[20], 1.0f );
+  BOOST_CHECK_EQUAL( data[23], 0.5f );
+}
+
+BOOST_AUTO_TEST_CASE( instanceBuffer_edit )
+{
+  InstanceBuffer instances;
+  instances.resize( 3 );
+  BOOST_CHECK_EQUAL( instances.size( ), 3 );
+  BOOST_CHECK_EQUAL( instances.data( ).size( ),
+                     3 * InstanceBuffer::FLOATS_PER_INSTANCE );
+
+  const float* second = &instances.data( )[InstanceBuffer::FLOATS_PER_INSTANCE];
+  BOOST_CHECK_EQUAL( second[0], 1.0f );
+  BOOST_CHECK_EQUAL( second[16], 0.5f );
+  BOOST_CHECK_EQUAL( second[23], 0.0f );
+
+  instances.baseColor( 1, Eigen::Vector3f( 1.0f, 0.0f, 0.0f ));
+  instances.color( 1, Eigen::Vector4f( 0.0f, 1.0f, 0.0f, 1.0f ));
+  second = &instances.data( )[InstanceBuffer::FLOATS_PER_INSTANCE];
+  BOOST_CHECK_EQUAL( second[16], 1.0f );
+  BOOST_CHECK_EQUAL( second[17], 0.0f );
+  BOOST_CHECK_EQUAL( second[21], 1.0f );
+  BOOST_CHECK_EQUAL( second[23], 1.0f );
+
+  // The level of detail is kept when the base color changes
+  instances.lod( 1, 4.0f );
+  instances.baseColor( 1, Eigen::Vector3f( 0.0f, 0.0f, 1.0f ));
+  second = &instances.data( )[InstanceBuffer::FLOATS_PER_INSTANCE];
+  BOOST_CHECK_EQUAL( second[18], 1.0f );
+  BOOST_CHECK_EQUAL( second[19], 4.0f );
+
+  Eigen::Matrix4f model = Eigen::Matrix4f::Identity( );
+  model( 0, 3 ) = 2.0f;
+  instances.model( 2, model );
+  BOOST_CHECK_EQUAL( instances.model( 2 ), model );
+
+  BOOST_CHECK_THROW( instances.model( 3, Eigen::Matrix4f::Identity( )),
+                     std::runtime_error );
+  BOOST_CHECK_THROW( instances.lod( 3, 1.0f ), std::runtime_error );
+}
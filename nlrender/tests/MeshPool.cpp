@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <nlrender/nlrender.h>
+
+#include "nlrenderTests.h"
+
+using namespace nlrender;
+
+static MeshPool::TMeshEntry entry( unsigned int baseVertex_,
+                                   unsigned int firstIndex_,
+                                   unsigned int linesSize_,
+                                   unsigned int trianglesSize_,
+                                   unsigned int quadsSize_ )
+{
+  MeshPool::TMeshEntry entry;
+  entry.valid = true;
+  entry.baseVertex = baseVertex_;
+  entry.numVertices = 10;
+  entry.firstIndex = firstIndex_;
+  entry.linesSize = linesSize_;
+  entry.trianglesSize = trianglesSize_;
+  entry.quadsSize = quadsSize_;
+  entry.numIndices = linesSize_ + trianglesSize_ + quadsSize_;
+  return entry;
+}
+
+BOOST_AUTO_TEST_CASE( meshPool_buildCommands )
+{
+  MeshPool::MeshEntries entries;
+  entries.push_back( entry( 0, 0, 4, 6, 8 ));
+  entries.push_back( entry( 10, 18, 0, 3, 4 ));
+  entries.push_back( entry( 20, 25, 2, 0, 12 ));
+  entries[1].valid = false;
+
+  DrawCommands commands;
+  MeshPool::buildCommands( entries, MeshPool::LINES, commands );
+  BOOST_CHECK_EQUAL( commands.size( ), 2 );
+  BOOST_CHECK_EQUAL( commands[1].count, 2 );
+  BOOST_CHECK_EQUAL( commands[1].firstIndex, 25 );
+  BOOST_CHECK_EQUAL( commands[1].baseVertex, 20 );
+  BOOST_CHECK_EQUAL( commands[1].baseInstance, 2 );
+  BOOST_CHECK_EQUAL( commands[1].instanceCount, 1 );
+
+  MeshPool::buildCommands( entries, MeshPool::TRIANGLES, commands );
+  BOOST_CHECK_EQUAL( commands.size( ), 1 );
+  BOOST_CHECK_EQUAL( commands[0].count, 6 );
+  BOOST_CHECK_EQUAL( commands[0].firstIndex, 4 );
+
+  entries[1].valid = true;
+  MeshPool::buildCommands( entries, MeshPool::QUADS, commands );
+  BOOST_CHECK_EQUAL( commands.size( ), 3 );
+  BOOST_CHECK_EQUAL( commands[0].firstIndex, 10 );
+  BOOST_CHECK_EQUAL( commands[1].firstIndex, 21 );
+  BOOST_CHECK_EQUAL( commands[1].baseVertex, 10 );
+  BOOST_CHECK_EQUAL( commands[2].count, 12 );
+  BOOST_CHECK_EQUAL( commands[2].firstIndex, 27 );
+}
+
+BOOST_AUTO_TEST_CASE( meshPool_commandLayout )
+{
+  BOOST_CHECK_EQUAL( sizeof( DrawElementsIndirectCommand ),
+                     5 * sizeof( unsigned int ));
+}
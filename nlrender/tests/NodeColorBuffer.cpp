@@ -0,0 +1,54 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <nlrender/nlrender.h>
+
+#include "nlrenderTests.h"
+
+using namespace nlrender;
+
+BOOST_AUTO_TEST_CASE( nodeColorBuffer_edit )
+{
+  NodeColorBuffer nodeColors;
+  nodeColors.resize( 300 );
+  BOOST_CHECK_EQUAL( nodeColors.size( ), 300 );
+  BOOST_CHECK_EQUAL( nodeColors.data( ).size( ), 1200 );
+  BOOST_CHECK_EQUAL( nodeColors.color( 10 ),
+                     Eigen::Vector4f( 0.0f, 0.0f, 0.0f, 0.0f ));
+
+  // New nodes are pending of upload
+  BOOST_CHECK_EQUAL( nodeColors.dirtyRanges( ).size( ), 300 );
+
+  Eigen::Vector4f red( 1.0f, 0.0f, 0.0f, 1.0f );
+  nodeColors.color( 10, red );
+  BOOST_CHECK_EQUAL( nodeColors.color( 10 ), red );
+  BOOST_CHECK_EQUAL( nodeColors.data( )[40], 1.0f );
+  BOOST_CHECK_EQUAL( nodeColors.data( )[43], 1.0f );
+
+  std::vector< unsigned int > nodes = { 1, 2, 299 };
+  nodeColors.color( nodes, red );
+  BOOST_CHECK_EQUAL( nodeColors.color( 299 ), red );
+
+  BOOST_CHECK_THROW( nodeColors.color( 300, red ), std::runtime_error );
+  BOOST_CHECK_THROW( nodeColors.color( 300 ), std::runtime_error );
+  BOOST_CHECK_EQUAL( nodeColors.uploadedBytes( ), 0 );
+}
@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <nlrender/nlrender.h>
+
+#include "nlrenderTests.h"
+
+using namespace nlrender;
+
+BOOST_AUTO_TEST_CASE( playbackFile_map )
+{
+  std::string fileName( "playbackFile_map.nlpb" );
+  std::vector< float > values = { 0.0f, 1.0f, 2.0f,
+                                  3.0f, 4.0f, 5.0f };
+  {
+    std::ofstream stream( fileName.c_str( ), std::ios::binary );
+    PlaybackFile::write( stream, 3, 0.5f, values );
+  }
+
+  {
+    PlaybackFile file( fileName );
+    BOOST_CHECK_EQUAL( file.numberNodes( ), 3 );
+    BOOST_CHECK_EQUAL( file.numberFrames( ), 2 );
+    BOOST_CHECK_EQUAL( file.timeStep( ), 0.5f );
+    BOOST_CHECK_EQUAL( file.frame( 0 )[1], 1.0f );
+    BOOST_CHECK_EQUAL( file.frame( 1 )[2], 5.0f );
+    BOOST_CHECK_THROW( file.frame( 2 ), std::runtime_error );
+
+    // Times are clamped to the recorded frames
+    BOOST_CHECK_EQUAL( file.frameAt( -1.0f ), 0 );
+    BOOST_CHECK_EQUAL( file.frameAt( 0.4f ), 0 );
+    BOOST_CHECK_EQUAL( file.frameAt( 0.6f ), 1 );
+    BOOST_CHECK_EQUAL( file.frameAt( 10.0f ), 1 );
+  }
+
+  // Truncated files are rejected
+  {
+    std::ofstream stream( fileName.c_str( ), std::ios::binary );
+    std::ostringstream data;
+    PlaybackFile::write( data, 3, 0.5f, values );
+    std::string bytes = data.str( );
+    stream.write( bytes.data( ), bytes.size( ) - 4 );
+  }
+  BOOST_CHECK_THROW( PlaybackFile file( fileName ), std::runtime_error );
+  BOOST_CHECK_THROW( PlaybackFile file( "missing.nlpb" ),
+                     std::runtime_error );
+
+  std::ostringstream data;
+  BOOST_CHECK_THROW( PlaybackFile::write( data, 4, 0.5f, values ),
+                     std::runtime_error );
+
+  std::remove( fileName.c_str( ));
+}
@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <nlrender/nlrender.h>
+
+#include "nlrenderTests.h"
+
+using namespace nlrender;
+
+static void writePlayback( const std::string& fileName_,
+                           unsigned int nodes_, unsigned int frames_ )
+{
+  std::vector< float > values;
+  for ( unsigned int frame = 0; frame < frames_; frame++ )
+    for ( unsigned int node = 0; node < nodes_; node++ )
+      values.push_back( float( frame ));
+  std::ofstream stream( fileName_.c_str( ), std::ios::binary );
+  PlaybackFile::write( stream, nodes_, 0.1f, values );
+}
+
+BOOST_AUTO_TEST_CASE( playbackStream_decode )
+{
+  float values[3] = { -1.0f, 5.0f, 20.0f };
+  float colors[12];
+  PlaybackStream::decode( values, 3, 0.0f, 10.0f,
+                          Eigen::Vector3f( 0.0f, 0.0f, 1.0f ),
+                          Eigen::Vector3f( 1.0f, 0.0f, 0.0f ), colors );
+
+  // Values out of the range are clamped, the alpha is the weight
+  BOOST_CHECK_EQUAL( colors[0], 0.0f );
+  BOOST_CHECK_EQUAL( colors[2], 1.0f );
+  BOOST_CHECK_EQUAL( colors[3], 0.0f );
+  BOOST_CHECK_CLOSE( colors[4], 0.5f, 1e-4f );
+  BOOST_CHECK_CLOSE( colors[6], 0.5f, 1e-4f );
+  BOOST_CHECK_CLOSE( colors[7], 0.5f, 1e-4f );
+  BOOST_CHECK_EQUAL( colors[8], 1.0f );
+  BOOST_CHECK_EQUAL( colors[10], 0.0f );
+  BOOST_CHECK_EQUAL( colors[11], 1.0f );
+
+  // Infinite values take the nearest color and NaN values the low one
+  float special[3] = { std::numeric_limits< float >::infinity( ),
+                       -std::numeric_limits< float >::infinity( ),
+                       std::numeric_limits< float >::quiet_NaN( )};
+  PlaybackStream::decode( special, 3, 0.0f, 10.0f,
+                          Eigen::Vector3f( 0.0f, 0.0f, 1.0f ),
+                          Eigen::Vector3f( 1.0f, 0.0f, 0.0f ), colors );
+  BOOST_CHECK_EQUAL( colors[0], 1.0f );
+  BOOST_CHECK_EQUAL( colors[3], 1.0f );
+  BOOST_CHECK_EQUAL( colors[4], 0.0f );
+  BOOST_CHECK_EQUAL( colors[7], 0.0f );
+  BOOST_CHECK_EQUAL( colors[8], 0.0f );
+  BOOST_CHECK_EQUAL( colors[10], 1.0f );
+  BOOST_CHECK_EQUAL( colors[11], 0.0f );
+}
+
+BOOST_AUTO_TEST_CASE( playbackStream_frames )
+{
+  std::string fileName( "playbackStream_frames.nlpb" );
+  writePlayback( fileName, 4, 32 );
+
+  {
+    PlaybackStream stream( fileName, 4 );
+    stream.range( 0.0f, 31.0f );
+    BOOST_CHECK_EQUAL( stream.file( )->numberFrames( ), 32 );
+
+    // Without the prefetch thread frames are decoded when requested
+    const float* colors = stream.frame( 31 );
+    BOOST_REQUIRE( colors );
+    BOOST_CHECK_EQUAL( colors[3], 1.0f );
+    BOOST_CHECK_THROW( stream.frame( 32 ), std::runtime_error );
+
+    stream.start( );
+    BOOST_CHECK( stream.running( ));
+    for ( unsigned int frame = 0; frame < 32; frame++ )
+    {
+      colors = stream.frame( frame, true );
+      BOOST_REQUIRE( colors );
+      BOOST_CHECK_CLOSE( colors[15] + 1.0f, frame / 31.0f + 1.0f, 1e-4f );
+    }
+
+    // Seeking backwards decodes the new window
+    colors = stream.frame( 3, true );
+    BOOST_REQUIRE( colors );
+    BOOST_CHECK_CLOSE( colors[15] * 31.0f, 3.0f, 1e-4f );
+    stream.stop( );
+    BOOST_CHECK( !stream.running( ));
+  }
+
+  std::remove( fileName.c_str( ));
+}
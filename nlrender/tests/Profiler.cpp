@@ -0,0 +1,206 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include <nlrender/nlrender.h>
+
+#include <map>
+#include <sstream>
+
+#include "nlrenderTests.h"
+
+using namespace nlrender;
+
+// Backend with a manual clock and queries which results are set by the test
+class MockBackend : public ProfilerBackend
+{
+public:
+
+  MockBackend( void )
+    : time( 0.0 )
+    , next( 1 )
+    , released( 0 )
+  {
+  }
+
+  double now( void )
+  {
+    return time;
+  }
+
+  bool queries( void ) const
+  {
+    return true;
+  }
+
+  unsigned int beginQuery( TQuery type_ )
+  {
+    BOOST_CHECK( active.find( type_ ) == active.end( ));
+    active[type_] = next;
+    return next++;
+  }
+
+  void endQuery( TQuery type_ )
+  {
+    BOOST_CHECK( active.find( type_ ) != active.end( ));
+    active.erase( type_ );
+  }
+
+  bool result( unsigned int query_, uint64_t& value_, bool wait_ )
+  {
+    auto result = results.find( query_ );
+    if ( result == results.end( ))
+    {
+      if ( !wait_ )
+        return false;
+      value_ = 0;
+      return true;
+    }
+    value_ = result->second;
+    return true;
+  }
+
+  void release( unsigned int )
+  {
+    released++;
+  }
+
+  double time;
+  unsigned int next;
+  unsigned int released;
+  std::map< TQuery, unsigned int > active;
+  std::map< unsigned int, uint64_t > results;
+};
+
+BOOST_AUTO_TEST_CASE( profiler_passes )
+{
+  MockBackend* backend = new MockBackend( );
+  RingSink ring( 2 );
+  Profiler profiler( backend );
+  profiler.addSink( &ring );
+
+  profiler.beginFrame( );
+  profiler.beginPass( "render" );
+  backend->time = 2.0;
+  profiler.drawCalls( 3 );
+  profiler.uniformUploads( 6 );
+  profiler.subroutineSwitches( 2 );
+  // Nested passes are counted in the outer one
+  profiler.beginPass( "inner" );
+  profiler.drawCalls( );
+  profiler.endPass( );
+  backend->time = 5.0;
+  profiler.endPass( );
+
+  profiler.beginPass( "extract", false );
+  profiler.primitives( 10 );
+  profiler.endPass( );
+  // Counters outside a pass are ignored
+  profiler.drawCalls( 100 );
+  profiler.endFrame( );
+
+  // The gpu results are not available yet
+  BOOST_CHECK_EQUAL( profiler.pendingFrames( ), 1 );
+  BOOST_CHECK( ring.frames( ).empty( ));
+
+  // Timer and primitives of the first pass, timer of the second pass
+  backend->results[1] = 1500000;
+  backend->results[2] = 42;
+  backend->results[3] = 250000;
+  // The empty frame has no queries, so both frames are written
+  profiler.beginFrame( );
+  profiler.endFrame( );
+  BOOST_CHECK_EQUAL( profiler.pendingFrames( ), 0 );
+  BOOST_CHECK_EQUAL( backend->released, 3 );
+
+  BOOST_REQUIRE_EQUAL( ring.frames( ).size( ), 2 );
+  const TFrameStats& frame = ring.frames( ).front( );
+  BOOST_CHECK_EQUAL( frame.frame, 0 );
+  BOOST_REQUIRE_EQUAL( frame.passes.size( ), 2 );
+
+  const TPassStats& render = frame.passes[0];
+  BOOST_CHECK_EQUAL( render.name, "render" );
+  BOOST_CHECK_CLOSE( render.cpuTime, 5.0, 1e-6 );
+  BOOST_CHECK_CLOSE( render.gpuTime, 1.5, 1e-6 );
+  BOOST_CHECK_EQUAL( render.drawCalls, 4 );
+  BOOST_CHECK_EQUAL( render.uniformUploads, 6 );
+  BOOST_CHECK_EQUAL( render.subroutineSwitches, 2 );
+  BOOST_CHECK_EQUAL( render.primitives, 42 );
+
+  const TPassStats& extract = frame.passes[1];
+  BOOST_CHECK_EQUAL( extract.name, "extract" );
+  BOOST_CHECK_CLOSE( extract.gpuTime, 0.25, 1e-6 );
+  BOOST_CHECK_EQUAL( extract.drawCalls, 0 );
+  BOOST_CHECK_EQUAL( extract.primitives, 10 );
+
+  BOOST_CHECK_EQUAL( ring.frames( ).back( ).frame, 1 );
+
+  // Flushing waits for the queries, and the ring keeps the last frames
+  profiler.beginPass( "render" );
+  profiler.endPass( );
+  profiler.endFrame( );
+  BOOST_CHECK_EQUAL( profiler.pendingFrames( ), 1 );
+  profiler.flush( );
+  BOOST_CHECK_EQUAL( profiler.pendingFrames( ), 0 );
+  BOOST_CHECK_EQUAL( ring.frames( ).size( ), 2 );
+  BOOST_CHECK_EQUAL( ring.frames( ).front( ).frame, 1 );
+  BOOST_CHECK_EQUAL( ring.frames( ).back( ).passes[0].gpuTime, 0.0 );
+  BOOST_CHECK_EQUAL( profiler.frame( ), 3 );
+
+  BOOST_CHECK_THROW( profiler.endPass( ), std::runtime_error );
+}
+
+BOOST_AUTO_TEST_CASE( profiler_latency )
+{
+  // Frames are written after waiting when too many are pending
+  MockBackend* backend = new MockBackend( );
+  RingSink ring;
+  Profiler profiler( backend );
+  profiler.addSink( &ring );
+  for ( unsigned int i = 0; i < 10; i++ )
+  {
+    profiler.beginPass( "render" );
+    profiler.endPass( );
+    profiler.endFrame( );
+  }
+  BOOST_CHECK( profiler.pendingFrames( ) <= 4 );
+  BOOST_CHECK_EQUAL( ring.frames( ).size( ) + profiler.pendingFrames( ), 10 );
+}
+
+BOOST_AUTO_TEST_CASE( profiler_json )
+{
+  std::ostringstream stream;
+  JsonSink json( stream );
+  Profiler profiler;
+  profiler.addSink( &json );
+
+  profiler.beginPass( "compose" );
+  profiler.drawCalls( );
+  profiler.endPass( );
+  profiler.endFrame( );
+
+  // Without gpu queries the frames are written when they end
+  std::string line = stream.str( );
+  BOOST_CHECK_EQUAL( line.find( "{\"frame\":0,\"passes\":[{\"name\":\"compose\"" ),
+                     0 );
+  BOOST_CHECK( line.find( "\"gpu\":null,\"draws\":1,\"uniforms\":0,"
+                          "\"subroutines\":0,\"primitives\":0}]}\n" ) !=
+               std::string::npos );
+}
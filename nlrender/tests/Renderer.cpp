@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include <nlrender/nlrender.h>
+
+#include "nlrenderTests.h"
+
+using namespace nlrender;
+
+static Eigen::Matrix4f perspective( float fovy_, float near_, float far_ )
+{
+  float f = 1.0f / std::tan( fovy_ * 0.5f );
+  Eigen::Matrix4f projection = Eigen::Matrix4f::Zero( );
+  projection( 0, 0 ) = f;
+  projection( 1, 1 ) = f;
+  projection( 2, 2 ) = ( far_ + near_ ) / ( near_ - far_ );
+  projection( 2, 3 ) = 2.0f * far_ * near_ / ( near_ - far_ );
+  projection( 3, 2 ) = -1.0f;
+  return projection;
+}
+
+BOOST_AUTO_TEST_CASE( renderer_screenSpaceLod )
+{
+  Eigen::Matrix4f projection = perspective( float( M_PI ) * 0.5f,
+                                            0.1f, 1000.0f );
+  Eigen::Matrix4f view = Eigen::Matrix4f::Identity( );
+  nlgeometry::AxisAlignedBoundingBox bounds(
+    Eigen::Vector3f( -1.0f, -1.0f, -1.0f ),
+    Eigen::Vector3f( 1.0f, 1.0f, 1.0f ));
+  float radius = bounds.radius( );
+
+  // A unit of length at distance d projects to height / ( 2 d ) pixels
+  // with a 90 degrees field of view
+  Eigen::Matrix4f model = Eigen::Matrix4f::Identity( );
+  model( 2, 3 ) = -100.0f;
+  float lod = Renderer::screenSpaceLod( bounds.transformed( model ), view,
+                                        projection, 1000.0f, 5.0f );
+  float distance = 100.0f - radius;
+  BOOST_CHECK_CLOSE( lod, 1000.0f / ( 2.0f * distance ) / 5.0f, 1e-3f );
+
+  // Farther meshes get lower levels, smaller target edges higher levels
+  model( 2, 3 ) = -400.0f;
+  float farLod = Renderer::screenSpaceLod( bounds.transformed( model ), view,
+                                           projection, 1000.0f, 5.0f );
+  BOOST_CHECK( farLod < lod * 0.3f );
+  BOOST_CHECK_CLOSE( Renderer::screenSpaceLod( bounds.transformed( model ),
+                                               view, projection, 1000.0f,
+                                               2.5f ), farLod * 2.0f, 1e-3f );
+  BOOST_CHECK_CLOSE( Renderer::screenSpaceLod( bounds.transformed( model ),
+                                               view, projection, 500.0f,
+                                               5.0f ), farLod * 0.5f, 1e-3f );
+
+  // The camera moving away has the same effect as the mesh
+  Eigen::Matrix4f cameraView = Eigen::Matrix4f::Identity( );
+  cameraView( 2, 3 ) = -300.0f;
+  model( 2, 3 ) = -100.0f;
+  BOOST_CHECK_CLOSE( Renderer::screenSpaceLod( bounds.transformed( model ),
+                                               cameraView, projection,
+                                               1000.0f, 5.0f ), farLod, 1e-3f );
+
+  // The level stays finite with the camera inside the bounding sphere
+  model( 2, 3 ) = 0.0f;
+  float insideLod = Renderer::screenSpaceLod( bounds.transformed( model ),
+                                              view, projection, 1000.0f, 5.0f );
+  BOOST_CHECK( std::isfinite( insideLod ));
+  BOOST_CHECK( insideLod > lod );
+
+  // Orthographic projections do not depend on the distance
+  Eigen::Matrix4f ortho = Eigen::Matrix4f::Identity( ) * 0.01f;
+  ortho( 3, 3 ) = 1.0f;
+  model( 2, 3 ) = -50.0f;
+  BOOST_CHECK_CLOSE( Renderer::screenSpaceLod( bounds.transformed( model ),
+                                               view, ortho, 1000.0f, 5.0f ),
+                     0.01f * 500.0f / 5.0f, 1e-3f );
+}
+
+BOOST_AUTO_TEST_CASE( renderer_maxPrimitivesPerPatch )
+{
+  // Uniform level n generates n^2 triangles in a triangle patch and 2n^2 in
+  // a quad patch, the bound adds the outer edges
+  BOOST_CHECK_EQUAL( Renderer::maxPrimitivesPerPatch( 4.0f, false ),
+                     16 + 12 );
+  BOOST_CHECK_EQUAL( Renderer::maxPrimitivesPerPatch( 4.0f, true ),
+                     32 + 16 );
+
+  // Levels are rounded up and clamped as the tessellator does
+  BOOST_CHECK_EQUAL( Renderer::maxPrimitivesPerPatch( 3.2f, false ),
+                     Renderer::maxPrimitivesPerPatch( 4.0f, false ));
+  BOOST_CHECK_EQUAL( Renderer::maxPrimitivesPerPatch( 0.1f, false ), 4 );
+  BOOST_CHECK_EQUAL( Renderer::maxPrimitivesPerPatch( 1000.0f, true ),
+                     2 * 64 * 64 + 4 * 64 );
+}
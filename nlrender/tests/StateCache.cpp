@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2015-2017 VG-Lab/URJC.
+ *
+ * Authors: Juan Jose Garcia Cantero <juanjose.garcia@urjc.es>
+ *
+ * This file is part of neurolots <https://github.com/vg-lab/neurolots>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include <nlrender/nlrender.h>
+
+#include "nlrenderTests.h"
+
+using namespace nlrender;
+
+BOOST_AUTO_TEST_CASE( stateCache_uniforms )
+{
+  StateCache state;
+  std::vector< int > locations = { 0, 1, 2, 3, 4, -1, 5 };
+  state.addProgram( 1, locations );
+  state.addProgram( 2, locations );
+
+  BOOST_CHECK_THROW( state.uniform( StateCache::LOD, 1.0f ),
+                     std::runtime_error );
+  BOOST_CHECK_THROW( state.useProgram( 3 ), std::runtime_error );
+
+  BOOST_CHECK( state.useProgram( 1 ));
+  BOOST_CHECK( !state.useProgram( 1 ));
+  BOOST_CHECK_EQUAL( state.location( StateCache::TANGENT_MODULUS ), 4 );
+
+  Eigen::Matrix4f matrix = Eigen::Matrix4f::Identity( );
+  BOOST_CHECK( state.uniform( StateCache::LOD, 10.0f ));
+  BOOST_CHECK( !state.uniform( StateCache::LOD, 10.0f ));
+  BOOST_CHECK( state.uniform( StateCache::LOD, 5.0f ));
+  BOOST_CHECK( state.uniform( StateCache::VIEW, matrix.data( )));
+  BOOST_CHECK( !state.uniform( StateCache::VIEW, matrix.data( )));
+  matrix( 0, 3 ) = 1.0f;
+  BOOST_CHECK( state.uniform( StateCache::VIEW, matrix.data( )));
+  // Uniforms missing in the program are never sent
+  BOOST_CHECK( !state.uniform( StateCache::ALPHA, 0.5f ));
+
+  // Each program keeps its own values, also after being used again
+  BOOST_CHECK( state.useProgram( 2 ));
+  BOOST_CHECK( state.uniform( StateCache::LOD, 5.0f ));
+  BOOST_CHECK( state.useProgram( 1 ));
+  BOOST_CHECK( !state.uniform( StateCache::LOD, 5.0f ));
+
+  state.reset( );
+  BOOST_CHECK( state.useProgram( 1 ));
+  BOOST_CHECK( state.uniform( StateCache::LOD, 5.0f ));
+
+  BOOST_CHECK_EQUAL( state.elided( ), 4 );
+}
+
+BOOST_AUTO_TEST_CASE( stateCache_subroutines )
+{
+  StateCache state;
+  state.addProgram( 1, std::vector< int >( StateCache::UNIFORMS, 0 ));
+  state.addProgram( 2, std::vector< int >( StateCache::UNIFORMS, 0 ));
+  std::vector< unsigned int > vertex = { 1 };
+  std::vector< unsigned int > fragment = { 0, 2 };
+
+  state.useProgram( 1 );
+  BOOST_CHECK( state.subroutines( GL_VERTEX_SHADER, vertex ));
+  BOOST_CHECK( state.subroutines( GL_FRAGMENT_SHADER, fragment ));
+  BOOST_CHECK( !state.subroutines( GL_VERTEX_SHADER, vertex ));
+  fragment[1] = 3;
+  BOOST_CHECK( state.subroutines( GL_FRAGMENT_SHADER, fragment ));
+
+  // Subroutines are lost when another program is used
+  state.useProgram( 2 );
+  state.useProgram( 1 );
+  BOOST_CHECK( state.subroutines( GL_VERTEX_SHADER, vertex ));
+
+  // Invalidating forgets the program in use but keeps the uniform values
+  state.uniform( StateCache::LOD, 1.0f );
+  state.invalidate( );
+  BOOST_CHECK( state.useProgram( 1 ));
+  BOOST_CHECK( state.subroutines( GL_VERTEX_SHADER, vertex ));
+  BOOST_CHECK( !state.uniform( StateCache::LOD, 1.0f ));
+}
@@ -0,0 +1,20 @@
+mat4 instanceModel( int instance )
+{
+  int texel = instance * 6;
+  return mat4( texelFetch( instanceData, texel ),
+               texelFetch( instanceData, texel + 1 ),
+               texelFetch( instanceData, texel + 2 ),
+               texelFetch( instanceData, texel + 3 ));
+}
+
+vec3 instanceColor( int instance )
+{
+  vec4 baseColor = texelFetch( instanceData, instance * 6 + 4 );
+  vec4 color = texelFetch( instanceData, instance * 6 + 5 );
+  return mix( baseColor.rgb, color.rgb, color.a );
+}
+
+float instanceLod( int instance )
+{
+  return texelFetch( instanceData, instance * 6 + 4 ).a;
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+vec3 nodeColor( vec3 color, float nodeId )
+{
+  if ( nodeColored == 0.0 || nodeId < 0.0 )
+    return color;
+  vec4 node = texelFetch( nodeColorData, int( nodeId ));
+  return mix( color, node.rgb, node.a );
+}
\ No newline at end of file
@@ -0,0 +1,5 @@
+subroutine( levelDistType )
+float screenSpace( vec3 position )
+{
+  return instanceLod( int( inInstance ));
+}
\ No newline at end of file
@@ -9,12 +9,12 @@ layout( location = 0 ) out vec4 accum;
 layout( location = 1 ) out vec4 revealage;
 
 in vec3 vColor;
+in vec3 vGlobalColor;
 
-uniform vec3 color;
 uniform float alpha;
 
 subroutine( colorFuncType )
-vec3 globalColor( void ){ return color; }
+vec3 globalColor( void ){ return vGlobalColor; }
 
 subroutine( colorFuncType )
 vec3 vertexColor( void ){ return vColor; }
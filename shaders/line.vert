@@ -2,14 +2,25 @@
 
 layout( location = 0 ) in vec3 inVertex;
 layout( location = 1 ) in vec3 inColor;
+layout( location = 3 ) in float inNodeId;
+layout( location = 7 ) in uint inInstance;
 
 out vec3 vColor;
+out vec3 vGlobalColor;
 
-uniform mat4 viewModel;
+uniform mat4 view;
 uniform mat4 proy;
+uniform samplerBuffer instanceData;
+uniform samplerBuffer nodeColorData;
+uniform float nodeColored;
+
+#include("_functions/_instance.glsl")
+#include("_functions/_nodeColor.glsl")
 
 void main( void )
 {
-  vColor = inColor;
+  mat4 viewModel = view * instanceModel( int( inInstance ));
+  vColor = nodeColor( inColor, inNodeId );
+  vGlobalColor = instanceColor( int( inInstance ));
   gl_Position = proy * viewModel * vec4( inVertex , 1.0 );
 }
@@ -5,23 +5,34 @@ subroutine uniform levelDistType levelDist;
 layout( location = 0 ) in vec3 inVertex;
 layout( location = 1 ) in vec3 inColor;
 layout( location = 2 ) in vec3 inCenter;
+layout( location = 3 ) in float inNodeId;
+layout( location = 7 ) in uint inInstance;
 
 out vec3 vPosition;
 out vec3 vCenter;
 out vec3 vColor;
+out vec3 vGlobalColor;
 out float vlot;
 
-uniform mat4 viewModel;
+uniform mat4 view;
+uniform samplerBuffer instanceData;
+uniform samplerBuffer nodeColorData;
+uniform float nodeColored;
 uniform float lod;
 uniform float maxDist;
 
 #include("_functions/_linearDist.glsl")
 #include("_functions/_homogeneousDist.glsl")
+#include("_functions/_instance.glsl")
+#include("_functions/_nodeColor.glsl")
+#include("_functions/_screenSpaceDist.glsl")
 
 void main( void )
 {
+  mat4 viewModel = view * instanceModel( int( inInstance ));
   vPosition = ( viewModel * vec4(inVertex, 1.0 )).xyz;
   vCenter = ( viewModel * vec4( inCenter, 1.0 )).xyz;
-  vColor = inColor;
+  vColor = nodeColor( inColor, inNodeId );
+  vGlobalColor = instanceColor( int( inInstance ));
   vlot = levelDist( vCenter );
 }
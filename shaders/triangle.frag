@@ -10,15 +10,15 @@ layout( location = 1 ) out vec4 revealage;
 
 in vec3 normal;
 in vec3 vColor;
+in vec3 vGlobalColor;
 in vec3 L;
 
-uniform vec3 color;
 uniform float alpha;
 
 #include("_functions/_illuminate.glsl")
 
 subroutine( colorFuncType )
-vec3 globalColor( void ){ return color; }
+vec3 globalColor( void ){ return vGlobalColor; }
 
 subroutine( colorFuncType )
 vec3 vertexColor( void ){ return vColor; }